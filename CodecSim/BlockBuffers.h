@@ -0,0 +1,88 @@
+#pragma once
+
+//==============================================================================
+// BlockBuffers.h
+// Host block <-> pipeline buffer conversion used by CodecSim::ProcessBlock
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+
+// Header-only so the benchmarks time exactly what the plugin runs.
+// 'Sample' is the host's sample type (iPlug2's sample: double or float).
+
+/**
+ * Planar host input -> interleaved pipeline input. Mono downmixes L+R;
+ * stereo duplicates a mono host input into both channels.
+ */
+template <typename Sample>
+inline void InterleaveHostBlock(Sample** inputs, int nInChans, int numFrames, int numCh, float* dst)
+{
+  if (numCh == 1)
+  {
+    for (int s = 0; s < numFrames; s++)
+    {
+      float L = (nInChans > 0) ? static_cast<float>(inputs[0][s]) : 0.f;
+      float R = (nInChans > 1) ? static_cast<float>(inputs[1][s]) : L;
+      dst[s] = (L + R) * 0.5f;
+    }
+  }
+  else
+  {
+    for (int s = 0; s < numFrames; s++)
+    {
+      dst[s * 2]     = (nInChans > 0) ? static_cast<float>(inputs[0][s]) : 0.f;
+      dst[s * 2 + 1] = (nInChans > 1) ? static_cast<float>(inputs[1][s]) : dst[s * 2];
+    }
+  }
+}
+
+// Append decoded interleaved frames to the accumulation buffer (absorbs bursty pipelines)
+inline void AccumulateDecoded(std::deque<float>& buffer, const float* decoded, int numFrames, int numCh)
+{
+  for (int i = 0; i < numFrames * numCh; i++)
+    buffer.push_back(decoded[i]);
+}
+
+// Discard up to maxFrames from the front of the accumulation buffer; returns frames discarded
+inline size_t DropDecoded(std::deque<float>& buffer, size_t maxFrames, int numCh)
+{
+  const size_t frames = std::min(buffer.size() / numCh, maxFrames);
+  buffer.erase(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(frames * numCh));
+  return frames;
+}
+
+/**
+ * Move up to maxFrames from the accumulation buffer to planar host output
+ * (mono is duplicated to L and R). Frames not written are left untouched.
+ * @return Frames written
+ */
+template <typename Sample>
+inline size_t DrainToHostBlock(std::deque<float>& buffer, Sample** outputs, int nOutChans, int maxFrames, int numCh)
+{
+  const size_t availableFrames = buffer.size() / numCh;
+  const size_t framesToOutput = (availableFrames < static_cast<size_t>(maxFrames)) ? availableFrames
+                                                                                  : static_cast<size_t>(maxFrames);
+  if (numCh == 1)
+  {
+    for (size_t s = 0; s < framesToOutput; s++)
+    {
+      float M = buffer.front(); buffer.pop_front();
+      if (nOutChans > 0) outputs[0][s] = static_cast<Sample>(M);
+      if (nOutChans > 1) outputs[1][s] = static_cast<Sample>(M);
+    }
+  }
+  else
+  {
+    for (size_t s = 0; s < framesToOutput; s++)
+    {
+      float L = buffer.front(); buffer.pop_front();
+      float R = buffer.front(); buffer.pop_front();
+      if (nOutChans > 0) outputs[0][s] = static_cast<Sample>(L);
+      if (nOutChans > 1) outputs[1][s] = static_cast<Sample>(R);
+    }
+  }
+  return framesToOutput;
+}
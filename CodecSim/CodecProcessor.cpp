@@ -5,48 +5,41 @@
 //==============================================================================
 
 #include "CodecProcessor.h"
+#include "DebugLog.h"
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
 #ifdef _WIN32
 #include <windows.h>
-#include <debugapi.h>
-
-static void DebugLogCodec(const std::string& msg)
-{
-  FILE* f = fopen("D:\ffmpeg_codec_debug.log", "a");
-  if (f) {
-    fprintf(f, "[CodecProcessor] %s\n", msg.c_str());
-    fflush(f);
-    fclose(f);
-  }
-  OutputDebugStringA(("[CodecProcessor] " + msg + "\n").c_str());
-}
-#else
-static void DebugLogCodec(const std::string& msg) { (void)msg; }
 #endif
 
+#define DebugLogCodec(msg) CODECSIM_LOG(LogLevel::Debug, "CodecProcessor", msg)
+
 //==============================================================================
 // GenericCodecProcessor Implementation
 //==============================================================================
 
 GenericCodecProcessor::GenericCodecProcessor(const CodecInfo& codecInfo)
   : mCodecInfo(codecInfo)
+  , mAdditionalArgs(codecInfo.additionalArgs)
   , mSampleRate(44100)
   , mChannels(2)
   , mBitrate(codecInfo.defaultBitrate * 1000)
   , mFrameSize(codecInfo.frameSize)
   , mLatencySamples(codecInfo.latencySamples)
   , mInitialized(false)
+  , mSharedWorker(false)
+  , mOfflineMode(false)
 {
-  DebugLogCodec("GenericCodecProcessor created for: " + codecInfo.displayName +
-                " (encoder=" + codecInfo.encoderName + ")");
+  DebugLogCodec("GenericCodecProcessor created for: " + std::string(codecInfo.displayName) +
+                " (encoder=" + std::string(codecInfo.encoderName) + ")");
   mPipeManager = std::make_unique<FFmpegPipeManager>();
 }
 
 GenericCodecProcessor::~GenericCodecProcessor()
 {
-  DebugLogCodec("GenericCodecProcessor destructor: " + mCodecInfo.displayName);
+  DebugLogCodec("GenericCodecProcessor destructor: " + std::string(mCodecInfo.displayName));
   Shutdown();
 }
 
@@ -54,7 +47,7 @@ bool GenericCodecProcessor::Initialize(int sampleRate, int channels)
 {
   std::lock_guard<std::recursive_mutex> lock(mMutex);
 
-  DebugLogCodec("Initialize: " + mCodecInfo.displayName +
+  DebugLogCodec("Initialize: " + std::string(mCodecInfo.displayName) +
                 " sampleRate=" + std::to_string(sampleRate) +
                 " channels=" + std::to_string(channels) +
                 " bitrate=" + std::to_string(mBitrate));
@@ -68,37 +61,19 @@ bool GenericCodecProcessor::Initialize(int sampleRate, int channels)
     mBitrate = mCodecInfo.defaultBitrate * 1000;
 
   // Snap bitrate for codecs that require specific values
-  if (mCodecInfo.encoderName == "libtwolame")
+  if (!GetValidBitrates(mCodecInfo).empty())
   {
-    // MPEG-1 Layer 2 valid bitrates for stereo (kbps)
-    static const int validBitrates[] = {64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384};
-    int bitrateKbps = mBitrate / 1000;
-    int best = validBitrates[0];
-    int bestDiff = std::abs(bitrateKbps - best);
-    for (int vb : validBitrates)
-    {
-      int diff = std::abs(bitrateKbps - vb);
-      if (diff < bestDiff) { best = vb; bestDiff = diff; }
-    }
+    const int best = SnapBitrate(mCodecInfo, mBitrate / 1000);
     mBitrate = best * 1000;
-    DebugLogCodec("MP2 bitrate snapped to " + std::to_string(best) + " kbps");
+    DebugLogCodec(std::string(mCodecInfo.displayName) + " bitrate snapped to " + std::to_string(best) + " kbps");
   }
 
-  // Configure FFmpegPipeManager
-  FFmpegPipeManager::Config config;
-  config.ffmpegPath = FFmpegPipeManager::ResolveFFmpegPath();
-  config.codecName = mCodecInfo.encoderName;
-  config.sampleRate = mSampleRate;
-  config.channels = mChannels;
-  config.bitrate = mBitrate;
-  config.additionalArgs = mCodecInfo.additionalArgs;
-  config.muxerFormat = mCodecInfo.muxerFormat;
-  config.demuxerFormat = mCodecInfo.demuxerFormat;
-  config.bufferSize = 65536;
+  const FFmpegPipeManager::Config config = BuildPipeConfig();
 
   DebugLogCodec("Starting FFmpegPipeManager: codec=" + config.codecName +
                 " muxer=" + config.muxerFormat + " demuxer=" + config.demuxerFormat);
 
+  mPipeManager->SetMetrics(mMetrics);
   if (!mPipeManager->Start(config))
   {
     std::string error = mPipeManager->GetLastErrorMessage();
@@ -108,16 +83,119 @@ bool GenericCodecProcessor::Initialize(int sampleRate, int channels)
 
   mProcessBuffer.resize(mFrameSize * mChannels * 2);
   mLatencySamples = mCodecInfo.latencySamples;
+  mRunningConfig = config;
   mInitialized = true;
 
+  // A batch render must not be restarted mid-file: it fails instead
+  if (mWatchdogConfig.enabled && !mOfflineMode)
+    StartWatchdog();
+
   DebugLogCodec("Initialized successfully");
   return true;
 }
 
+FFmpegPipeManager::Config GenericCodecProcessor::BuildPipeConfig() const
+{
+  return BuildPipeConfig(mSampleRate, mChannels, mBitrate, mAdditionalArgs);
+}
+
+FFmpegPipeManager::Config GenericCodecProcessor::BuildPipeConfig(int sampleRate, int channels, int bitrate,
+                                                                 const std::string& additionalArgs) const
+{
+  FFmpegPipeManager::Config config;
+  config.ffmpegPath = mFFmpegPath.empty() ? FFmpegPipeManager::ResolveFFmpegPath() : mFFmpegPath;
+  config.codecName = mCodecInfo.encoderName;
+  config.sampleRate = sampleRate;
+  config.channels = channels;
+  config.bitrate = bitrate > 0 ? bitrate : mCodecInfo.defaultBitrate * 1000;
+  if (!GetValidBitrates(mCodecInfo).empty())
+    config.bitrate = SnapBitrate(mCodecInfo, config.bitrate / 1000) * 1000;
+  config.additionalArgs = additionalArgs;
+  config.muxerFormat = mCodecInfo.muxerFormat;
+  config.demuxerFormat = mCodecInfo.demuxerFormat;
+  config.bufferSize = 65536;
+  config.sharedWorker = mSharedWorker && !mOfflineMode;
+  config.lowDelayMux = mOfflineMode;
+  config.scheduling = mScheduling;
+  return config;
+}
+
+void GenericCodecProcessor::BeginUpdate()
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  ++mUpdateDepth;
+}
+
+PipelineConfigDiff GenericCodecProcessor::CommitUpdate(bool allowRespawn)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  if (mUpdateDepth > 0 && --mUpdateDepth > 0)
+    return PipelineConfigDiff();
+
+  PipelineConfigDiff diff;
+  if (!mInitialized)
+  {
+    diff.change = ConfigChange::Respawn;
+    diff.respawnFields.push_back("not running");
+    return diff;
+  }
+
+  const FFmpegPipeManager::Config next = BuildPipeConfig();
+  diff = DiffPipelineConfig(mRunningConfig, next);
+
+  switch (diff.change)
+  {
+    case ConfigChange::None:
+      DebugLogCodec("Update: no-op, pipeline kept");
+      break;
+
+    case ConfigChange::InPlace:
+      DebugLogCodec("Update: " + diff.Describe());
+      mPipeManager->Reconfigure(next);
+      mRunningConfig = next;
+      break;
+
+    case ConfigChange::Respawn:
+      if (!allowRespawn)
+      {
+        DebugLogCodec("Update: " + diff.Describe() + " deferred to the next Initialize()");
+        break;
+      }
+      DebugLogCodec("Update: " + diff.Describe());
+      Initialize(mSampleRate, mChannels);
+      break;
+  }
+  return diff;
+}
+
+PipelineConfigDiff GenericCodecProcessor::PreviewUpdate(int sampleRate, int channels, int bitrateKbps,
+                                                        const std::string& additionalArgs) const
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  PipelineConfigDiff diff;
+  if (!mInitialized)
+  {
+    diff.change = ConfigChange::Respawn;
+    diff.respawnFields.push_back("not running");
+    return diff;
+  }
+
+  // Same clamp as SetBitrate
+  const int bitrate = bitrateKbps > 0
+                        ? std::clamp(bitrateKbps, mCodecInfo.minBitrate, mCodecInfo.maxBitrate) * 1000
+                        : mBitrate;
+  return DiffPipelineConfig(mRunningConfig, BuildPipeConfig(sampleRate, channels, bitrate, additionalArgs));
+}
+
 void GenericCodecProcessor::Shutdown()
 {
   std::lock_guard<std::recursive_mutex> lock(mMutex);
 
+  // The watchdog only try_locks mMutex, so joining it here cannot deadlock
+  StopWatchdog();
+
   if (mPipeManager && mPipeManager->IsRunning())
     mPipeManager->Stop();
 
@@ -147,6 +225,11 @@ int GenericCodecProcessor::Decode(const uint8_t* input, int inputBytes, float* o
 
 int GenericCodecProcessor::Process(const float* input, int numSamples, float* output, int maxOutputSamples)
 {
+  // Busy = the pipeline is being restarted; the caller treats it as an underrun
+  std::unique_lock<std::recursive_mutex> lock(mMutex, std::try_to_lock);
+  if (!lock.owns_lock())
+    return 0;
+
   if (!mInitialized || !mPipeManager || !mPipeManager->IsRunning())
     return 0;
 
@@ -155,6 +238,34 @@ int GenericCodecProcessor::Process(const float* input, int numSamples, float* ou
   return static_cast<int>(samplesRead);
 }
 
+int GenericCodecProcessor::ProcessBlocking(const float* input, int numSamples, float* output,
+                                           int minOutputSamples, int maxOutputSamples, int timeoutMs)
+{
+  std::unique_lock<std::recursive_mutex> lock(mMutex, std::try_to_lock);
+  if (!lock.owns_lock())
+    return 0;
+
+  if (!mInitialized || !mPipeManager || !mPipeManager->IsRunning())
+    return 0;
+
+  mPipeManager->WriteSamples(input, numSamples);
+
+  size_t samplesRead = 0;
+  if (minOutputSamples > 0)
+    samplesRead = mPipeManager->ReadSamples(output, minOutputSamples, static_cast<uint32_t>(timeoutMs));
+  if (samplesRead < static_cast<size_t>(maxOutputSamples))
+    samplesRead += mPipeManager->ReadSamples(output + samplesRead * mChannels, maxOutputSamples - samplesRead, 0);
+  return static_cast<int>(samplesRead);
+}
+
+bool GenericCodecProcessor::Finish(int timeoutMs)
+{
+  if (!mInitialized || !mPipeManager || !mPipeManager->IsRunning())
+    return false;
+
+  return mPipeManager->Finish(static_cast<uint32_t>(timeoutMs));
+}
+
 int GenericCodecProcessor::GetLatencySamples() const
 {
   return mLatencySamples;
@@ -172,39 +283,52 @@ bool GenericCodecProcessor::IsInitialized() const
 
 void GenericCodecProcessor::SetLogCallback(std::function<void(const std::string&)> callback)
 {
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mLogCallback = callback;
   if (mPipeManager)
     mPipeManager->SetLogCallback(callback);
 }
 
+void GenericCodecProcessor::SetParked(bool parked)
+{
+  // No lock: called from the audio thread, the pipe manager only sets a flag
+  if (mPipeManager)
+    mPipeManager->SetParked(parked);
+}
+
 void GenericCodecProcessor::SetBitrate(int bitrateKbps)
 {
   std::lock_guard<std::recursive_mutex> lock(mMutex);
 
   int clamped = std::clamp(bitrateKbps, mCodecInfo.minBitrate, mCodecInfo.maxBitrate);
-  mBitrate = clamped * 1000;
   DebugLogCodec("SetBitrate: " + std::to_string(clamped) + " kbps (clamped from " +
                 std::to_string(bitrateKbps) + ")");
 
-  if (mInitialized)
-  {
-    int savedSR = mSampleRate;
-    int savedCh = mChannels;
-    Initialize(savedSR, savedCh);
-  }
+  BeginUpdate();
+  mBitrate = clamped * 1000;
+  CommitUpdate();
 }
 
 void GenericCodecProcessor::SetSampleRate(int sampleRate)
 {
   std::lock_guard<std::recursive_mutex> lock(mMutex);
 
-  mSampleRate = sampleRate;
   DebugLogCodec("SetSampleRate: " + std::to_string(sampleRate));
 
-  if (mInitialized)
-  {
-    int savedCh = mChannels;
-    Initialize(mSampleRate, savedCh);
-  }
+  BeginUpdate();
+  mSampleRate = sampleRate;
+  CommitUpdate();
+}
+
+void GenericCodecProcessor::SetChannels(int channels)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+  DebugLogCodec("SetChannels: " + std::to_string(channels));
+
+  BeginUpdate();
+  mChannels = channels;
+  CommitUpdate();
 }
 
 bool GenericCodecProcessor::HasFirstAudioArrived() const
@@ -216,5 +340,110 @@ bool GenericCodecProcessor::HasFirstAudioArrived() const
 void GenericCodecProcessor::SetAdditionalArgs(const std::string& args)
 {
   std::lock_guard<std::recursive_mutex> lock(mMutex);
-  mCodecInfo.additionalArgs = args;
+  mAdditionalArgs = args;
+}
+
+void GenericCodecProcessor::SetSharedWorker(bool shared)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mSharedWorker = shared;
+}
+
+void GenericCodecProcessor::SetOfflineMode(bool offline)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mOfflineMode = offline;
+}
+
+void GenericCodecProcessor::SetFFmpegPath(const std::string& path)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mFFmpegPath = path;
+}
+
+void GenericCodecProcessor::SetSchedulingPolicy(const SchedulingPolicy& policy)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mScheduling = policy;
+}
+
+void GenericCodecProcessor::SetMetrics(std::shared_ptr<PipelineMetrics> metrics)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mMetrics = std::move(metrics);
+}
+
+void GenericCodecProcessor::SetWatchdog(const WatchdogConfig& config)
+{
+  std::lock_guard<std::recursive_mutex> lock(mMutex);
+  mWatchdogConfig = config;
+}
+
+//==============================================================================
+// Watchdog
+//==============================================================================
+
+void GenericCodecProcessor::StartWatchdog()
+{
+  mWatchdogStop = false;
+  mWatchdogThread = std::thread(&GenericCodecProcessor::WatchdogThread, this);
+}
+
+void GenericCodecProcessor::StopWatchdog()
+{
+  if (!mWatchdogThread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mWatchdogStopMutex);
+    mWatchdogStop = true;
+  }
+  mWatchdogStopCv.notify_all();
+  mWatchdogThread.join();
+}
+
+void GenericCodecProcessor::WatchdogThread()
+{
+  constexpr auto kPollInterval = std::chrono::milliseconds(100);
+  const auto epoch = std::chrono::steady_clock::now();
+  auto nowMs = [epoch] {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - epoch).count());
+  };
+
+  PipelineWatchdog watchdog(mWatchdogConfig);
+
+  std::unique_lock<std::mutex> stopLock(mWatchdogStopMutex);
+  while (!mWatchdogStopCv.wait_for(stopLock, kPollInterval, [this] { return mWatchdogStop; }))
+  {
+    // Start/Stop only run under mMutex, and Shutdown() joins this thread before
+    // stopping, so reading the counters without the lock is safe here
+    if (!watchdog.Update(mPipeManager->GetProgress(), nowMs()))
+      continue;
+
+    // Initialize/Shutdown in progress: they stop this thread, or the next poll retries
+    std::unique_lock<std::recursive_mutex> lock(mMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+      continue;
+
+    const std::string message = "Watchdog: " + watchdog.GetReason() + "; restarting pipeline (attempt " +
+                                std::to_string(watchdog.GetConsecutiveRestarts() + 1) + ")";
+    DebugLogCodec(message);
+    if (mLogCallback)
+      mLogCallback(message);
+
+    const bool restarted = mPipeManager->Restart();
+    watchdog.OnRestarted(restarted, nowMs());
+    if (mMetrics)
+      PipelineMetrics::Add(mMetrics->watchdogRestarts, 1);
+
+    if (!restarted)
+    {
+      const std::string error = "Watchdog: restart failed (" + mPipeManager->GetLastErrorMessage() +
+                                "), retrying in " + std::to_string(watchdog.GetBackoffMs()) + " ms";
+      DebugLogCodec(error);
+      if (mLogCallback)
+        mLogCallback(error);
+    }
+  }
 }
@@ -6,12 +6,16 @@
 // Copyright 2025 MouseSoft
 //==============================================================================
 
-#include "CodecSim.h"
+#include "ICodecProcessor.h"
 #include "CodecRegistry.h"
 #include "FFmpegPipeManager.h"
+#include "PipelineConfigDiff.h"
+#include "PipelineWatchdog.h"
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 //==============================================================================
@@ -32,22 +36,68 @@ public:
   int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) override;
   int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) override;
   int Process(const float* input, int numSamples, float* output, int maxOutputSamples) override;
+  int ProcessBlocking(const float* input, int numSamples, float* output,
+                      int minOutputSamples, int maxOutputSamples, int timeoutMs) override;
 
   int GetLatencySamples() const override;
   int GetFrameSize() const override;
   bool IsInitialized() const override;
   void SetLogCallback(std::function<void(const std::string&)> callback) override;
+  void SetParked(bool parked) override;
 
-  // Configuration
+  // Configuration. SetBitrate/SetSampleRate/SetChannels apply to a running
+  // pipeline at once (respawning only if the value changed); the other setters
+  // wait for the next Initialize() unless they are part of an update.
   void SetBitrate(int bitrateKbps);
   void SetSampleRate(int sampleRate);
+  void SetChannels(int channels);
   void SetAdditionalArgs(const std::string& args);
+  void SetSharedWorker(bool shared); // Takes effect on the next Initialize()
+  void SetOfflineMode(bool offline); // Low-delay muxing, never shared; next Initialize()
+  void SetFFmpegPath(const std::string& path);            // Empty = ResolveFFmpegPath(); next Initialize()
+  void SetSchedulingPolicy(const SchedulingPolicy& policy); // Takes effect on the next Initialize()
+  void SetMetrics(std::shared_ptr<PipelineMetrics> metrics);  // Takes effect on the next Initialize()
+  void SetWatchdog(const WatchdogConfig& config);              // Realtime only; next Initialize()
 
-  bool HasFirstAudioArrived() const;
+  // Batched reconfiguration: setters between BeginUpdate() and CommitUpdate()
+  // only record their values, so any number of changes costs at most one respawn
+  void BeginUpdate();
+
+  /**
+   * Apply everything recorded since BeginUpdate() the cheapest way: nothing,
+   * in place on the running pipeline, or one respawn. Updates nest; only the
+   * outermost commit applies (inner ones return a no-op).
+   * @param allowRespawn false leaves changes that need new processes for the next Initialize()
+   * @return What the changes needed; Respawn if the processor is not initialized
+   */
+  PipelineConfigDiff CommitUpdate(bool allowRespawn = true);
+
+  /**
+   * What an update to these settings would need, without recording or
+   * applying anything (the running pipeline and its settings are untouched)
+   * @param bitrateKbps 0 keeps the current bitrate
+   * @return Respawn if the processor is not initialized
+   */
+  PipelineConfigDiff PreviewUpdate(int sampleRate, int channels, int bitrateKbps,
+                                   const std::string& additionalArgs) const;
+
+  // Batch end of input: wait until everything written so far is decoded
+  // (the tail is then returned by Process with numSamples = 0)
+  bool Finish(int timeoutMs) override;
+
+  bool HasFirstAudioArrived() const override;
   const CodecInfo& GetCodecInfo() const { return mCodecInfo; }
 
 private:
+  FFmpegPipeManager::Config BuildPipeConfig() const;  // From the current settings
+  FFmpegPipeManager::Config BuildPipeConfig(int sampleRate, int channels, int bitrate,
+                                            const std::string& additionalArgs) const;
+  void StartWatchdog();
+  void StopWatchdog();
+  void WatchdogThread();
+
   CodecInfo mCodecInfo;
+  std::string mAdditionalArgs; // CodecInfo::additionalArgs plus user option args
   std::unique_ptr<FFmpegPipeManager> mPipeManager;
 
   int mSampleRate;
@@ -56,7 +106,22 @@ private:
   int mFrameSize;
   int mLatencySamples;
   bool mInitialized;
+  bool mSharedWorker;
+  bool mOfflineMode;
+  std::string mFFmpegPath;
+  SchedulingPolicy mScheduling;
+  std::shared_ptr<PipelineMetrics> mMetrics;
+  std::function<void(const std::string&)> mLogCallback;
+  FFmpegPipeManager::Config mRunningConfig;   // What the pipeline was started/reconfigured with
+  int mUpdateDepth = 0;                       // Open BeginUpdate() calls
+
+  // Restarts the pipeline when it dies or stalls (realtime pipelines only)
+  WatchdogConfig mWatchdogConfig;
+  std::thread mWatchdogThread;
+  std::mutex mWatchdogStopMutex;
+  std::condition_variable mWatchdogStopCv;
+  bool mWatchdogStop = false;
 
-  mutable std::recursive_mutex mMutex;
+  mutable std::recursive_mutex mMutex;  // Process/ProcessBlocking only try_lock it
   std::vector<float> mProcessBuffer;
 };
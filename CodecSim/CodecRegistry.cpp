@@ -4,24 +4,749 @@
 // Copyright 2025 MouseSoft
 //==============================================================================
 #include "CodecRegistry.h"
+#include "DebugLog.h"
 #include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #ifdef _WIN32
 #include <windows.h>
-#include <debugapi.h>
-static void DebugLogRegistry(const std::string& msg)
+#endif
+
+#define DebugLogRegistry(msg) CODECSIM_LOG(LogLevel::Debug, "CodecRegistry", msg)
+
+//==============================================================================
+// Built-in codec options
+//==============================================================================
+namespace
+{
+constexpr CodecOptionChoice kMp3ChannelChoices[] = {{"Joint Stereo", "1"}, {"Stereo", "0"}};
+constexpr CodecOptionChoice kMp3VbrChoices[] = {
+  {"Off (CBR)", ""}, {"Extreme (~245k)", "0"}, {"Standard (~190k)", "2"}, {"Medium (~165k)", "4"}, {"Low (~115k)", "6"}, {"Minimum (~65k)", "9"}};
+constexpr CodecOptionDef kMp3Options[] = {
+  {"mp3_channel", "Channel Mode", "-joint_stereo", CodecOptionType::Choice, 0, 0, 0, kMp3ChannelChoices},
+  {"mp3_abr", "ABR Mode", "-abr", CodecOptionType::Toggle, 0, 0, 1, {}},
+  {"mp3_vbr", "VBR Quality", "-q:a", CodecOptionType::Choice, 0, 0, 0, kMp3VbrChoices},
+};
+
+constexpr CodecOptionChoice kAacCoderChoices[] = {{"Two-loop", "twoloop"}, {"Fast", "fast"}};
+constexpr CodecOptionDef kAacOptions[] = {
+  {"aac_coder", "Coder", "-aac_coder", CodecOptionType::Choice, 0, 0, 0, kAacCoderChoices},
+};
+
+constexpr CodecOptionChoice kHeaacVbrChoices[] = {
+  {"CBR", "0"}, {"VBR 1", "1"}, {"VBR 2", "2"}, {"VBR 3", "3"}, {"VBR 4", "4"}, {"VBR 5", "5"}};
+constexpr CodecOptionDef kHeaacOptions[] = {
+  {"heaac_vbr", "VBR Mode", "-vbr", CodecOptionType::Choice, 0, 0, 0, kHeaacVbrChoices},
+};
+
+constexpr CodecOptionChoice kOpusAppChoices[] = {{"VoIP", "voip"}, {"Audio", "audio"}, {"Low Delay", "lowdelay"}};
+constexpr CodecOptionChoice kOpusVbrChoices[] = {{"Off", "off"}, {"On", "on"}, {"Constrained", "constrained"}};
+// Frame durations libopus accepts; the choice index is read by LibOpusProcessor too
+constexpr CodecOptionChoice kOpusFrameChoices[] = {{"2.5 ms", "2.5"}, {"5 ms", "5"},   {"10 ms", "10"},
+                                                   {"20 ms", "20"},   {"40 ms", "40"}, {"60 ms", "60"}};
+constexpr CodecOptionDef kOpusOptions[] = {
+  {"opus_app", "Application", "-application", CodecOptionType::Choice, 1, 0, 0, kOpusAppChoices},
+  {"opus_vbr", "VBR Mode", "-vbr", CodecOptionType::Choice, 1, 0, 0, kOpusVbrChoices},
+  {"opus_frame", "Frame Duration", "-frame_duration", CodecOptionType::Choice, 3, 0, 0, kOpusFrameChoices},
+  {"opus_complexity", "Complexity", "-compression_level", CodecOptionType::IntRange, 10, 0, 10, {}},
+};
+
+constexpr CodecOptionDef kAc3Options[] = {
+  {"ac3_dialnorm", "Dialogue Norm", "-dialnorm", CodecOptionType::IntRange, -31, -31, -1, {}},
+};
+
+// Shared by the lossless codecs and read by the processor (no ffmpeg argument):
+// passthrough returns the input, optionally delayed, instead of encoding and
+// decoding it; verification encodes in the background to report the size
+constexpr CodecOptionChoice kLosslessModeChoices[] = {{"Passthrough", ""}, {"Encode/Decode", ""}};
+
+constexpr CodecOptionDef kFlacOptions[] = {
+  {"flac_compression", "Compression", "-compression_level", CodecOptionType::IntRange, 5, 0, 12, {}},
+  {"lossless_mode", "Processing", "", CodecOptionType::Choice, 0, 0, 0, kLosslessModeChoices},
+  {"lossless_delay", "Delay (samples)", "", CodecOptionType::IntRange, 0, 0, 32768, {}},
+  {"lossless_verify", "Verify Size", "", CodecOptionType::Toggle, 0, 0, 1, {}},
+};
+
+constexpr CodecOptionChoice kMp2ModeChoices[] = {
+  {"Auto", "auto"}, {"Stereo", "stereo"}, {"Joint", "joint_stereo"}, {"Mono", "mono"}};
+constexpr CodecOptionDef kMp2Options[] = {
+  {"mp2_mode", "Stereo Mode", "-mode", CodecOptionType::Choice, 0, 0, 0, kMp2ModeChoices},
+};
+
+constexpr CodecOptionDef kSpeexOptions[] = {
+  {"speex_quality", "CBR Quality", "-cbr_quality", CodecOptionType::IntRange, 8, 0, 10, {}},
+  {"speex_vad", "VAD", "-vad", CodecOptionType::Toggle, 0, 0, 1, {}},
+};
+
+constexpr CodecOptionChoice kIlbcModeChoices[] = {{"20ms", "20"}, {"30ms", "30"}};
+constexpr CodecOptionDef kIlbcOptions[] = {
+  {"ilbc_mode", "Frame Mode", "-mode", CodecOptionType::Choice, 1, 0, 0, kIlbcModeChoices},
+};
+
+constexpr CodecOptionChoice kG726CodeChoices[] = {{"2 (16k)", "2"}, {"3 (24k)", "3"}, {"4 (32k)", "4"}, {"5 (40k)", "5"}};
+constexpr CodecOptionDef kG726Options[] = {
+  {"g726_code", "Code Size", "-code_size", CodecOptionType::Choice, 2, 0, 0, kG726CodeChoices},
+};
+
+constexpr CodecOptionDef kWavpackOptions[] = {
+  {"wavpack_comp", "Compression", "-compression_level", CodecOptionType::IntRange, 1, 0, 8, {}},
+  {"lossless_mode", "Processing", "", CodecOptionType::Choice, 0, 0, 0, kLosslessModeChoices},
+  {"lossless_delay", "Delay (samples)", "", CodecOptionType::IntRange, 0, 0, 32768, {}},
+  {"lossless_verify", "Verify Size", "", CodecOptionType::Toggle, 0, 0, 1, {}},
+};
+
+//==============================================================================
+// Built-in codec definitions
+//==============================================================================
+constexpr CodecInfo kBuiltinCodecs[] = {
+    // MP3
+  {
+    "mp3",              // id
+    "MP3",              // displayName
+    "libmp3lame",       // encoderName
+    "mp3",              // muxerFormat
+    "mp3",              // demuxerFormat
+    128,                // defaultBitrate
+    8,                  // minBitrate
+    320,                // maxBitrate
+    1152,               // frameSize
+    576,                // latencySamples
+    "",                 // additionalArgs
+    false,              // isLossless
+    false,              // monoOnly
+    kMp3Options         // options
+  },
+  // AAC (LC)
+  {
+    "aac",
+    "AAC",
+    "aac",
+    "adts",
+    "aac",
+    128,
+    32,
+    512,
+    1024,
+    2048,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    kAacOptions         // options
+  },
+  // HE-AAC (libfdk_aac)
+  {
+    "heaac",
+    "HE-AAC",
+    "libfdk_aac",
+    "adts",
+    "aac",
+    64,
+    24,
+    128,
+    1024,
+    2048,
+    "-profile:a aac_he -afterburner 1",
+    false,              // isLossless
+    false,              // monoOnly
+    kHeaacOptions       // options
+  },
+  // Opus
+  {
+    "opus",
+    "Opus",
+    "libopus",
+    "ogg",
+    "ogg",
+    128,
+    6,
+    510,
+    960,
+    312,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    kOpusOptions,       // options
+#if CODECSIM_HAS_LIBOPUS
+    NativeCodec::Opus
+#endif
+  },
+  // Vorbis
+  {
+    "vorbis",
+    "Vorbis",
+    "libvorbis",
+    "ogg",
+    "ogg",
+    128,
+    64,
+    500,
+    1024,
+    512,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // AC-3
+  {
+    "ac3",
+    "AC-3",
+    "ac3",
+    "ac3",
+    "ac3",
+    192,
+    32,
+    640,
+    1536,
+    1536,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    kAc3Options         // options
+  },
+  // E-AC-3
+  {
+    "eac3",
+    "E-AC-3",
+    "eac3",
+    "eac3",
+    "eac3",
+    192,
+    32,
+    6144,
+    1536,
+    1536,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // FLAC (lossless)
+  {
+    "flac",
+    "FLAC",
+    "flac",
+    "flac",
+    "flac",
+    0,
+    0,
+    0,
+    4096,
+    4096,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    kFlacOptions,       // options
+    NativeCodec::Passthrough
+  },
+  // MP2
+  {
+    "mp2",
+    "MP2",
+    "libtwolame",
+    "mp2",
+    "mp3",
+    192,
+    64,
+    384,
+    1152,
+    576,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    kMp2Options         // options
+  },
+  // WMA v2
+  {
+    "wma",
+    "WMA v2",
+    "wmav2",
+    "asf",
+    "asf",
+    128,
+    32,
+    192,
+    2048,
+    2048,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // G.711 A-law
+  {
+    "alaw",
+    "G.711 A-law",
+    "pcm_alaw",
+    "wav",
+    "wav",
+    64,
+    64,
+    64,
+    160,
+    160,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::G711ALaw
+  },
+  // G.711 mu-law
+  {
+    "mulaw",
+    "G.711 mu-law",
+    "pcm_mulaw",
+    "wav",
+    "wav",
+    64,
+    64,
+    64,
+    160,
+    160,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::G711MuLaw
+  },
+  // Speex (speech codec)
+  {
+    "speex",
+    "Speex",
+    "libspeex",
+    "ogg",
+    "ogg",
+    24,
+    2,
+    44,
+    320,
+    320,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    kSpeexOptions       // options
+  },
+  // GSM 06.10 (8kHz mono only)
+  {
+    "gsm",
+    "GSM 06.10",
+    "libgsm",
+    "gsm",
+    "gsm",
+    13,
+    13,
+    13,
+    160,
+    160,
+    "-ar 8000 -ac 1",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    {}                  // options
+  },
+  //==========================================================================
+  // Tier 1: Bluetooth / Mobile / Surround
+  //==========================================================================
+  // AMR-NB (mobile phone call codec, 3GPP, 8kHz mono only)
+  // Discrete modes: 4.75/5.15/5.90/6.70/7.40/7.95/10.20/12.20 kbps
+  {
+    "amrnb",
+    "AMR-NB",
+    "libopencore_amrnb",
+    "amr",
+    "amr",
+    12,
+    12,
+    12,
+    160,
+    160,
+    "-ar 8000 -ac 1 -b:a 12200",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    {}                  // options
+  },
+  // AMR-WB (HD Voice / VoLTE, 3GPP, 16kHz mono only)
+  // Discrete modes: 6.60/8.85/12.65/14.25/15.85/18.25/19.85/23.05/23.85 kbps
+  {
+    "amrwb",
+    "AMR-WB",
+    "libvo_amrwbenc",
+    "amr",
+    "amr",
+    24,
+    24,
+    24,
+    320,
+    320,
+    "-ar 16000 -ac 1 -b:a 23850",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    {}                  // options
+  },
+  // aptX (Bluetooth, fixed 4:1 ratio)
+  {
+    "aptx",
+    "aptX",
+    "aptx",
+    "aptx",
+    "aptx",
+    352,
+    352,
+    352,
+    4,
+    4,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // aptX HD (Bluetooth HD, fixed ratio)
+  {
+    "aptxhd",
+    "aptX HD",
+    "aptx_hd",
+    "aptx_hd",
+    "aptx_hd",
+    576,
+    576,
+    576,
+    4,
+    4,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // SBC (Bluetooth A2DP mandatory codec)
+  {
+    "sbc",
+    "SBC",
+    "sbc",
+    "sbc",
+    "sbc",
+    328,
+    128,
+    512,
+    128,
+    128,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // DTS (surround sound)
+  {
+    "dts",
+    "DTS",
+    "dca",
+    "dts",
+    "dts",
+    768,
+    320,
+    6144,
+    512,
+    512,
+    "-strict experimental",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  //==========================================================================
+  // Tier 2: Telephony / VoIP / ADPCM
+  //==========================================================================
+  // iLBC (WebRTC / VoIP, 8kHz mono only)
+  {
+    "ilbc",
+    "iLBC",
+    "libilbc",
+    "ilbc",
+    "ilbc",
+    13,
+    13,
+    15,
+    160,
+    160,
+    "-ar 8000 -ac 1",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    kIlbcOptions        // options
+  },
+  // G.723.1 (ultra-low bitrate telephony, 8kHz mono, 6.3/5.3 kbps only)
+  {
+    "g7231",
+    "G.723.1",
+    "g723_1",
+    "matroska",
+    "matroska",
+    6,
+    5,
+    6,
+    240,
+    240,
+    "-ar 8000 -ac 1 -b:a 6300",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    {}                  // options
+  },
+  // G.722 ADPCM (ISDN wideband telephony)
+  {
+    "g722",
+    "G.722",
+    "g722",
+    "matroska",
+    "matroska",
+    64,
+    64,
+    64,
+    320,
+    320,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // G.726 ADPCM (classic telephony, 8kHz mono only)
+  {
+    "g726",
+    "G.726",
+    "g726",
+    "matroska",
+    "matroska",
+    32,
+    16,
+    40,
+    160,
+    160,
+    "-ar 8000 -ac 1",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    kG726Options        // options
+  },
+  // ADPCM IMA WAV (game audio, fixed 4:1 ratio)
+  {
+    "adpcm_ima",
+    "ADPCM IMA",
+    "adpcm_ima_wav",
+    "wav",
+    "wav",
+    0,
+    0,
+    0,
+    1024,
+    1024,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::AdpcmIma
+  },
+  // ADPCM Microsoft (classic Windows, fixed ratio)
+  {
+    "adpcm_ms",
+    "ADPCM MS",
+    "adpcm_ms",
+    "wav",
+    "wav",
+    0,
+    0,
+    0,
+    1024,
+    1024,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::AdpcmMs
+  },
+  // Nellymoser (Flash-era streaming, mono only, max 44100Hz)
+  {
+    "nellymoser",
+    "Nellymoser",
+    "nellymoser",
+    "flv",
+    "flv",
+    64,
+    16,
+    64,
+    256,
+    256,
+    "-ar 44100 -ac 1",
+    false,              // isLossless
+    true,               // monoOnly (mono only codec)
+    {}                  // options
+  },
+  //==========================================================================
+  // Tier 3: Retro / Novelty / Extra
+  //==========================================================================
+  // RealAudio 1.0 (1995, 14.4k modem era)
+  {
+    "ra144",
+    "RealAudio 1.0",
+    "real_144",
+    "rm",
+    "rm",
+    8,
+    8,
+    8,
+    160,
+    160,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // DFPWM (1-bit audio, Minecraft ComputerCraft)
+  {
+    "dfpwm",
+    "DFPWM",
+    "dfpwm",
+    "dfpwm",
+    "dfpwm",
+    48,
+    48,
+    48,
+    1024,
+    1024,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::Dfpwm
+  },
+  // WMA v1 (Windows Media Audio 1)
+  {
+    "wmav1",
+    "WMA v1",
+    "wmav1",
+    "asf",
+    "asf",
+    128,
+    32,
+    192,
+    2048,
+    2048,
+    "",
+    false,              // isLossless
+    false,              // monoOnly
+    {}                  // options
+  },
+  // WavPack (lossless)
+  {
+    "wavpack",
+    "WavPack",
+    "wavpack",
+    "wv",
+    "wv",
+    0,
+    0,
+    0,
+    4096,
+    4096,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    kWavpackOptions,    // options
+    NativeCodec::Passthrough
+  },
+  // ADPCM Yamaha (console / synth)
+  {
+    "adpcm_yamaha",
+    "ADPCM Yamaha",
+    "adpcm_yamaha",
+    "wav",
+    "wav",
+    0,
+    0,
+    0,
+    1024,
+    1024,
+    "",
+    true,               // isLossless
+    false,              // monoOnly
+    {},                 // options
+    NativeCodec::AdpcmYamaha
+  },
+};
+constexpr int kNumBuiltinCodecs = static_cast<int>(sizeof(kBuiltinCodecs) / sizeof(kBuiltinCodecs[0]));
+
+//==============================================================================
+// Compile-time perfect hash: codec id -> table index
+// FNV-1a with a seed searched at compile time so that every built-in id lands
+// in its own slot. Lookups hash once, then confirm with a single compare.
+//==============================================================================
+constexpr uint32_t kIdSlotCount = 128; // power of two, ~4x the table size
+static_assert(kIdSlotCount >= 2 * kNumBuiltinCodecs, "grow kIdSlotCount");
+
+constexpr uint32_t HashCodecId(std::string_view id, uint32_t seed)
 {
-  FILE* f = fopen("D:\\ffmpeg_codec_debug.log", "a");
-  if (f) {
-    fprintf(f, "[CodecRegistry] %s\n", msg.c_str());
-    fflush(f);
-    fclose(f);
+  uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+  for (char c : id)
+  {
+    h ^= static_cast<uint8_t>(c);
+    h *= 16777619u;
   }
-  OutputDebugStringA(("[CodecRegistry] " + msg + "\n").c_str());
+  return h ^ (h >> 15);
 }
-#else
-static void DebugLogRegistry(const std::string& msg) { (void)msg; }
-#endif
+
+struct CodecIdMap
+{
+  uint32_t seed = ~0u; // ~0u = no collision-free seed found
+  int8_t slots[kIdSlotCount] = {};
+};
+
+constexpr CodecIdMap BuildCodecIdMap()
+{
+  for (uint32_t seed = 0; seed < 4096; seed++)
+  {
+    CodecIdMap map;
+    map.seed = seed;
+    for (uint32_t s = 0; s < kIdSlotCount; s++)
+      map.slots[s] = -1;
+
+    bool collision = false;
+    for (int i = 0; i < kNumBuiltinCodecs && !collision; i++)
+    {
+      uint32_t slot = HashCodecId(kBuiltinCodecs[i].id, seed) & (kIdSlotCount - 1);
+      if (map.slots[slot] >= 0)
+        collision = true;
+      else
+        map.slots[slot] = static_cast<int8_t>(i);
+    }
+    if (!collision)
+      return map;
+  }
+  return CodecIdMap{};
+}
+
+constexpr CodecIdMap kCodecIdMap = BuildCodecIdMap();
+static_assert(kCodecIdMap.seed != ~0u, "no perfect hash seed found for the built-in codec ids");
+
+// Table index for id, or -1
+int FindTableIndex(std::string_view id)
+{
+  int idx = kCodecIdMap.slots[HashCodecId(id, kCodecIdMap.seed) & (kIdSlotCount - 1)];
+  return (idx >= 0 && kBuiltinCodecs[idx].id == id) ? idx : -1;
+}
+} // namespace
+
+//==============================================================================
+// Snapshot - immutable result of one detection pass
+//==============================================================================
+struct CodecRegistry::Snapshot
+{
+  int count = 0;                                // number of available codecs
+  uint8_t tableIndexOf[kNumBuiltinCodecs] = {};  // available index -> table index
+  int8_t availableIndexOf[kNumBuiltinCodecs] = {}; // table index -> available index (-1 if unavailable)
+
+  Snapshot()
+  {
+    std::fill(std::begin(availableIndexOf), std::end(availableIndexOf), static_cast<int8_t>(-1));
+  }
+  bool SameAs(const Snapshot& other) const
+  {
+    return std::equal(std::begin(availableIndexOf), std::end(availableIndexOf), std::begin(other.availableIndexOf));
+  }
+};
+
 //==============================================================================
 // Singleton
 //==============================================================================
@@ -32,617 +757,9 @@ CodecRegistry& CodecRegistry::Instance()
 }
 CodecRegistry::CodecRegistry()
 {
-  RegisterBuiltinCodecs();
-}
-//==============================================================================
-// Built-in codec definitions
-//==============================================================================
-void CodecRegistry::RegisterBuiltinCodecs()
-{
-  mCodecs = {
-    // MP3
-    {
-      "mp3",              // id
-      "MP3",              // displayName
-      "libmp3lame",       // encoderName
-      "mp3",              // muxerFormat
-      "mp3",              // demuxerFormat
-      128,                // defaultBitrate
-      8,                  // minBitrate
-      320,                // maxBitrate
-      1152,               // frameSize
-      576,                // latencySamples
-      "",                 // additionalArgs
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available (detected later)
-      // options
-      {
-        {"mp3_channel", "Channel Mode", "-joint_stereo", CodecOptionType::Choice, 0, 0, 0,
-          {{"Joint Stereo", "1"}, {"Stereo", "0"}}},
-        {"mp3_abr", "ABR Mode", "-abr", CodecOptionType::Toggle, 0, 0, 1, {}},
-        {"mp3_vbr", "VBR Quality", "-q:a", CodecOptionType::Choice, 0, 0, 0,
-          {{"Off (CBR)", ""}, {"Extreme (~245k)", "0"}, {"Standard (~190k)", "2"}, {"Medium (~165k)", "4"}, {"Low (~115k)", "6"}, {"Minimum (~65k)", "9"}}},
-      }
-    },
-    // AAC (LC)
-    {
-      "aac",
-      "AAC",
-      "aac",
-      "adts",
-      "aac",
-      128,
-      32,
-      512,
-      1024,
-      2048,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"aac_coder", "Coder", "-aac_coder", CodecOptionType::Choice, 0, 0, 0,
-          {{"Two-loop", "twoloop"}, {"Fast", "fast"}}},
-      }
-    },
-    // HE-AAC (libfdk_aac)
-    {
-      "heaac",
-      "HE-AAC",
-      "libfdk_aac",
-      "adts",
-      "aac",
-      64,
-      24,
-      128,
-      1024,
-      2048,
-      "-profile:a aac_he -afterburner 1",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"heaac_vbr", "VBR Mode", "-vbr", CodecOptionType::Choice, 0, 0, 0,
-          {{"CBR", "0"}, {"VBR 1", "1"}, {"VBR 2", "2"}, {"VBR 3", "3"}, {"VBR 4", "4"}, {"VBR 5", "5"}}},
-      }
-    },
-    // Opus
-    {
-      "opus",
-      "Opus",
-      "libopus",
-      "ogg",
-      "ogg",
-      128,
-      6,
-      510,
-      960,
-      312,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"opus_app", "Application", "-application", CodecOptionType::Choice, 1, 0, 0,
-          {{"VoIP", "voip"}, {"Audio", "audio"}, {"Low Delay", "lowdelay"}}},
-        {"opus_vbr", "VBR Mode", "-vbr", CodecOptionType::Choice, 1, 0, 0,
-          {{"Off", "off"}, {"On", "on"}, {"Constrained", "constrained"}}},
-      }
-    },
-    // Vorbis
-    {
-      "vorbis",
-      "Vorbis",
-      "libvorbis",
-      "ogg",
-      "ogg",
-      128,
-      64,
-      500,
-      1024,
-      512,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // AC-3
-    {
-      "ac3",
-      "AC-3",
-      "ac3",
-      "ac3",
-      "ac3",
-      192,
-      32,
-      640,
-      1536,
-      1536,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"ac3_dialnorm", "Dialogue Norm", "-dialnorm", CodecOptionType::IntRange, -31, -31, -1, {}},
-      }
-    },
-    // E-AC-3
-    {
-      "eac3",
-      "E-AC-3",
-      "eac3",
-      "eac3",
-      "eac3",
-      192,
-      32,
-      6144,
-      1536,
-      1536,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // FLAC (lossless)
-    {
-      "flac",
-      "FLAC",
-      "flac",
-      "flac",
-      "flac",
-      0,
-      0,
-      0,
-      4096,
-      4096,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"flac_compression", "Compression", "-compression_level", CodecOptionType::IntRange, 5, 0, 12, {}},
-      }
-    },
-    // MP2
-    {
-      "mp2",
-      "MP2",
-      "libtwolame",
-      "mp2",
-      "mp3",
-      192,
-      64,
-      384,
-      1152,
-      576,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"mp2_mode", "Stereo Mode", "-mode", CodecOptionType::Choice, 0, 0, 0,
-          {{"Auto", "auto"}, {"Stereo", "stereo"}, {"Joint", "joint_stereo"}, {"Mono", "mono"}}},
-      }
-    },
-    // WMA v2
-    {
-      "wma",
-      "WMA v2",
-      "wmav2",
-      "asf",
-      "asf",
-      128,
-      32,
-      192,
-      2048,
-      2048,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // G.711 A-law
-    {
-      "alaw",
-      "G.711 A-law",
-      "pcm_alaw",
-      "wav",
-      "wav",
-      64,
-      64,
-      64,
-      160,
-      160,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // G.711 mu-law
-    {
-      "mulaw",
-      "G.711 mu-law",
-      "pcm_mulaw",
-      "wav",
-      "wav",
-      64,
-      64,
-      64,
-      160,
-      160,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // Speex (speech codec)
-    {
-      "speex",
-      "Speex",
-      "libspeex",
-      "ogg",
-      "ogg",
-      24,
-      2,
-      44,
-      320,
-      320,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"speex_quality", "CBR Quality", "-cbr_quality", CodecOptionType::IntRange, 8, 0, 10, {}},
-        {"speex_vad", "VAD", "-vad", CodecOptionType::Toggle, 0, 0, 1, {}},
-      }
-    },
-    // GSM 06.10 (8kHz mono only)
-    {
-      "gsm",
-      "GSM 06.10",
-      "libgsm",
-      "gsm",
-      "gsm",
-      13,
-      13,
-      13,
-      160,
-      160,
-      "-ar 8000 -ac 1",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false               // available
-    },
-    //==========================================================================
-    // Tier 1: Bluetooth / Mobile / Surround
-    //==========================================================================
-    // AMR-NB (mobile phone call codec, 3GPP, 8kHz mono only)
-    // Discrete modes: 4.75/5.15/5.90/6.70/7.40/7.95/10.20/12.20 kbps
-    {
-      "amrnb",
-      "AMR-NB",
-      "libopencore_amrnb",
-      "amr",
-      "amr",
-      12,
-      12,
-      12,
-      160,
-      160,
-      "-ar 8000 -ac 1 -b:a 12200",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false               // available
-    },
-    // AMR-WB (HD Voice / VoLTE, 3GPP, 16kHz mono only)
-    // Discrete modes: 6.60/8.85/12.65/14.25/15.85/18.25/19.85/23.05/23.85 kbps
-    {
-      "amrwb",
-      "AMR-WB",
-      "libvo_amrwbenc",
-      "amr",
-      "amr",
-      24,
-      24,
-      24,
-      320,
-      320,
-      "-ar 16000 -ac 1 -b:a 23850",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false               // available
-    },
-    // aptX (Bluetooth, fixed 4:1 ratio)
-    {
-      "aptx",
-      "aptX",
-      "aptx",
-      "aptx",
-      "aptx",
-      352,
-      352,
-      352,
-      4,
-      4,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // aptX HD (Bluetooth HD, fixed ratio)
-    {
-      "aptxhd",
-      "aptX HD",
-      "aptx_hd",
-      "aptx_hd",
-      "aptx_hd",
-      576,
-      576,
-      576,
-      4,
-      4,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // SBC (Bluetooth A2DP mandatory codec)
-    {
-      "sbc",
-      "SBC",
-      "sbc",
-      "sbc",
-      "sbc",
-      328,
-      128,
-      512,
-      128,
-      128,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // DTS (surround sound)
-    {
-      "dts",
-      "DTS",
-      "dca",
-      "dts",
-      "dts",
-      768,
-      320,
-      6144,
-      512,
-      512,
-      "-strict experimental",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    //==========================================================================
-    // Tier 2: Telephony / VoIP / ADPCM
-    //==========================================================================
-    // iLBC (WebRTC / VoIP, 8kHz mono only)
-    {
-      "ilbc",
-      "iLBC",
-      "libilbc",
-      "ilbc",
-      "ilbc",
-      13,
-      13,
-      15,
-      160,
-      160,
-      "-ar 8000 -ac 1",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false,              // available
-      {
-        {"ilbc_mode", "Frame Mode", "-mode", CodecOptionType::Choice, 1, 0, 0,
-          {{"20ms", "20"}, {"30ms", "30"}}},
-      }
-    },
-    // G.723.1 (ultra-low bitrate telephony, 8kHz mono, 6.3/5.3 kbps only)
-    {
-      "g7231",
-      "G.723.1",
-      "g723_1",
-      "matroska",
-      "matroska",
-      6,
-      5,
-      6,
-      240,
-      240,
-      "-ar 8000 -ac 1 -b:a 6300",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false               // available
-    },
-    // G.722 ADPCM (ISDN wideband telephony)
-    {
-      "g722",
-      "G.722",
-      "g722",
-      "matroska",
-      "matroska",
-      64,
-      64,
-      64,
-      320,
-      320,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // G.726 ADPCM (classic telephony, 8kHz mono only)
-    {
-      "g726",
-      "G.726",
-      "g726",
-      "matroska",
-      "matroska",
-      32,
-      16,
-      40,
-      160,
-      160,
-      "-ar 8000 -ac 1",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false,              // available
-      {
-        {"g726_code", "Code Size", "-code_size", CodecOptionType::Choice, 2, 0, 0,
-          {{"2 (16k)", "2"}, {"3 (24k)", "3"}, {"4 (32k)", "4"}, {"5 (40k)", "5"}}},
-      }
-    },
-    // ADPCM IMA WAV (game audio, fixed 4:1 ratio)
-    {
-      "adpcm_ima",
-      "ADPCM IMA",
-      "adpcm_ima_wav",
-      "wav",
-      "wav",
-      0,
-      0,
-      0,
-      1024,
-      1024,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // ADPCM Microsoft (classic Windows, fixed ratio)
-    {
-      "adpcm_ms",
-      "ADPCM MS",
-      "adpcm_ms",
-      "wav",
-      "wav",
-      0,
-      0,
-      0,
-      1024,
-      1024,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // Nellymoser (Flash-era streaming, mono only, max 44100Hz)
-    {
-      "nellymoser",
-      "Nellymoser",
-      "nellymoser",
-      "flv",
-      "flv",
-      64,
-      16,
-      64,
-      256,
-      256,
-      "-ar 44100 -ac 1",
-      false,              // isLossless
-      true,               // monoOnly (mono only codec)
-      false               // available
-    },
-    //==========================================================================
-    // Tier 3: Retro / Novelty / Extra
-    //==========================================================================
-    // RealAudio 1.0 (1995, 14.4k modem era)
-    {
-      "ra144",
-      "RealAudio 1.0",
-      "real_144",
-      "rm",
-      "rm",
-      8,
-      8,
-      8,
-      160,
-      160,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // DFPWM (1-bit audio, Minecraft ComputerCraft)
-    {
-      "dfpwm",
-      "DFPWM",
-      "dfpwm",
-      "dfpwm",
-      "dfpwm",
-      48,
-      48,
-      48,
-      1024,
-      1024,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // WMA v1 (Windows Media Audio 1)
-    {
-      "wmav1",
-      "WMA v1",
-      "wmav1",
-      "asf",
-      "asf",
-      128,
-      32,
-      192,
-      2048,
-      2048,
-      "",
-      false,              // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-    // WavPack (lossless)
-    {
-      "wavpack",
-      "WavPack",
-      "wavpack",
-      "wv",
-      "wv",
-      0,
-      0,
-      0,
-      4096,
-      4096,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false,              // available
-      {
-        {"wavpack_comp", "Compression", "-compression_level", CodecOptionType::IntRange, 1, 0, 8, {}},
-      }
-    },
-    // ADPCM Yamaha (console / synth)
-    {
-      "adpcm_yamaha",
-      "ADPCM Yamaha",
-      "adpcm_yamaha",
-      "wav",
-      "wav",
-      0,
-      0,
-      0,
-      1024,
-      1024,
-      "",
-      true,               // isLossless
-      false,              // monoOnly
-      false               // available
-    },
-  };
+  // Start with an empty snapshot so readers never see null
+  mSnapshots.push_back(std::make_unique<const Snapshot>());
+  mSnapshot.store(mSnapshots.back().get(), std::memory_order_release);
 }
 //==============================================================================
 // Detection
@@ -653,7 +770,11 @@ void CodecRegistry::DetectAvailable(const std::string& ffmpegPath)
   DebugLogRegistry("DetectAvailable: running " + ffmpegPath + " -encoders");
   // Run ffmpeg -encoders and capture output
   std::string command = "\"" + ffmpegPath + "\" -encoders 2>&1";
+#ifdef _WIN32
   FILE* pipe = _popen(command.c_str(), "r");
+#else
+  FILE* pipe = popen(command.c_str(), "r");
+#endif
   if (!pipe)
   {
     DebugLogRegistry("DetectAvailable: _popen failed");
@@ -663,85 +784,168 @@ void CodecRegistry::DetectAvailable(const std::string& ffmpegPath)
   std::string result;
   while (fgets(buffer, sizeof(buffer), pipe))
     result += buffer;
+#ifdef _WIN32
   _pclose(pipe);
+#else
+  pclose(pipe);
+#endif
   DebugLogRegistry("DetectAvailable: got " + std::to_string(result.size()) + " bytes of output");
-  // Check each codec's encoder name against the output
-  for (auto& codec : mCodecs)
+  // Check each codec's encoder name against the output and build the new snapshot
+  auto snapshot = std::make_unique<Snapshot>();
+  for (int i = 0; i < kNumBuiltinCodecs; i++)
   {
-    codec.available = (result.find(codec.encoderName) != std::string::npos);
-    DebugLogRegistry("  " + codec.displayName + " (" + codec.encoderName + "): " +
-                     (codec.available ? "AVAILABLE" : "not found"));
+    const CodecInfo& codec = kBuiltinCodecs[i];
+    const bool native = codec.native != NativeCodec::None;
+    bool available = native || (result.find(codec.encoderName) != std::string::npos);
+    if (available)
+    {
+      snapshot->availableIndexOf[i] = static_cast<int8_t>(snapshot->count);
+      snapshot->tableIndexOf[snapshot->count++] = static_cast<uint8_t>(i);
+    }
+    DebugLogRegistry("  " + std::string(codec.displayName) + " (" + std::string(codec.encoderName) + "): " +
+                     (native ? "AVAILABLE (native)" : available ? "AVAILABLE" : "not found"));
   }
-  mDetected = true;
 
-  // Count available codecs inline (mMutex already held, can't call GetAvailableCount())
-  int availCount = 0;
-  for (const auto& codec : mCodecs)
-    if (codec.available) availCount++;
-  DebugLogRegistry("DetectAvailable: " + std::to_string(availCount) + " codecs available");
+  // Publish only if the result differs (every plugin instance re-runs detection)
+  if (!snapshot->SameAs(*LoadSnapshot()))
+  {
+    mSnapshots.push_back(std::move(snapshot));
+    mSnapshot.store(mSnapshots.back().get(), std::memory_order_release);
+  }
+  mDetected.store(true, std::memory_order_release);
+
+  DebugLogRegistry("DetectAvailable: " + std::to_string(LoadSnapshot()->count) + " codecs available");
 }
 //==============================================================================
-// Accessors
+// Option Arguments
 //==============================================================================
-std::vector<const CodecInfo*> CodecRegistry::GetAvailable() const
+std::string BuildCodecArgs(const CodecInfo& info, const CodecOptionValues& optionValues)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  std::vector<const CodecInfo*> available;
-  for (const auto& codec : mCodecs)
+  std::string result(info.additionalArgs);
+
+  for (const auto& opt : info.options)
   {
-    if (codec.available)
-      available.push_back(&codec);
+    if (opt.argName.empty())
+      continue;  // Processor option
+    auto it = optionValues.find(opt.key);
+    int val = (it != optionValues.end()) ? it->second : opt.defaultValue;
+
+    switch (opt.type)
+    {
+      case CodecOptionType::Toggle:
+        result.append(" ").append(opt.argName).append(" ").append(std::to_string(val));
+        break;
+      case CodecOptionType::Choice:
+        if (val >= 0 && val < static_cast<int>(opt.choices.size()) && !opt.choices[val].argValue.empty())
+          result.append(" ").append(opt.argName).append(" ").append(opt.choices[val].argValue);
+        break;
+      case CodecOptionType::IntRange:
+        result.append(" ").append(opt.argName).append(" ").append(std::to_string(val));
+        break;
+    }
   }
-  return available;
+
+  return result;
 }
-int CodecRegistry::GetAvailableCount() const
+
+int GetCodecOptionValue(const CodecInfo& info, const CodecOptionValues& optionValues, std::string_view key,
+                        int fallback)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  int count = 0;
-  for (const auto& codec : mCodecs)
+  for (const auto& opt : info.options)
   {
-    if (codec.available)
-      count++;
+    if (opt.key != key)
+      continue;
+    auto it = optionValues.find(opt.key);
+    return (it != optionValues.end()) ? it->second : opt.defaultValue;
   }
-  return count;
+  return fallback;
 }
-const CodecInfo* CodecRegistry::GetAvailableByIndex(int index) const
+std::vector<int> GetBitrateLadder(const CodecInfo& info)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  int current = 0;
-  for (const auto& codec : mCodecs)
+  std::vector<int> ladder;
+  if (info.isLossless)
+    return ladder;
+  if (info.minBitrate == info.maxBitrate)
   {
-    if (codec.available)
-    {
-      if (current == index)
-        return &codec;
-      current++;
-    }
+    ladder.push_back(info.minBitrate);
+    return ladder;
   }
-  return nullptr;
+
+  for (int preset : kBitratePresets)
+  {
+    if (preset >= info.minBitrate && preset <= info.maxBitrate)
+      ladder.push_back(preset);
+  }
+  if (info.defaultBitrate > 0 && std::find(ladder.begin(), ladder.end(), info.defaultBitrate) == ladder.end())
+  {
+    ladder.push_back(info.defaultBitrate);
+    std::sort(ladder.begin(), ladder.end());
+  }
+  return ladder;
 }
-int CodecRegistry::GetAvailableIndexById(const std::string& id) const
+std::vector<int> GetValidBitrates(const CodecInfo& info)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  int current = 0;
-  for (const auto& codec : mCodecs)
+  std::vector<int> valid;
+  if (info.encoderName == "libtwolame")
   {
-    if (codec.available)
+    // MPEG-1 Layer 2 valid bitrates for stereo (kbps)
+    static constexpr int kMp2Bitrates[] = {64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384};
+    for (int kbps : kMp2Bitrates)
     {
-      if (codec.id == id)
-        return current;
-      current++;
+      if (kbps >= info.minBitrate && kbps <= info.maxBitrate)
+        valid.push_back(kbps);
     }
   }
-  return -1;
+  return valid;
 }
-const CodecInfo* CodecRegistry::GetById(const std::string& id) const
+int SnapBitrate(const CodecInfo& info, int kbps)
 {
-  std::lock_guard<std::mutex> lock(mMutex);
-  for (const auto& codec : mCodecs)
+  const std::vector<int> valid = GetValidBitrates(info);
+  if (valid.empty())
+    return kbps;
+
+  int best = valid[0];
+  for (int vb : valid)
   {
-    if (codec.id == id)
-      return &codec;
+    if (std::abs(kbps - vb) < std::abs(kbps - best))
+      best = vb;
   }
-  return nullptr;
-}
\ No newline at end of file
+  return best;
+}
+//==============================================================================
+// Accessors
+//==============================================================================
+CodecTableView<CodecInfo> CodecRegistry::GetAll() const
+{
+  return CodecTableView<CodecInfo>(kBuiltinCodecs);
+}
+std::vector<const CodecInfo*> CodecRegistry::GetAvailable() const
+{
+  const Snapshot* snap = LoadSnapshot();
+  std::vector<const CodecInfo*> available;
+  available.reserve(snap->count);
+  for (int i = 0; i < snap->count; i++)
+    available.push_back(&kBuiltinCodecs[snap->tableIndexOf[i]]);
+  return available;
+}
+int CodecRegistry::GetAvailableCount() const
+{
+  return LoadSnapshot()->count;
+}
+const CodecInfo* CodecRegistry::GetAvailableByIndex(int index) const
+{
+  const Snapshot* snap = LoadSnapshot();
+  if (index < 0 || index >= snap->count)
+    return nullptr;
+  return &kBuiltinCodecs[snap->tableIndexOf[index]];
+}
+int CodecRegistry::GetAvailableIndexById(std::string_view id) const
+{
+  int tableIdx = FindTableIndex(id);
+  return (tableIdx >= 0) ? LoadSnapshot()->availableIndexOf[tableIdx] : -1;
+}
+const CodecInfo* CodecRegistry::GetById(std::string_view id) const
+{
+  int tableIdx = FindTableIndex(id);
+  return (tableIdx >= 0) ? &kBuiltinCodecs[tableIdx] : nullptr;
+}
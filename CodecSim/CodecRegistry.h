@@ -4,11 +4,41 @@
 // Dynamic codec detection and registry for CodecSim
 // Copyright 2025 MouseSoft
 //==============================================================================
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <mutex>
 //==============================================================================
+// CodecTableView - read-only view over a constexpr array
+// (std::span stand-in; the built-in tables are static so views never dangle)
+//==============================================================================
+template <typename T>
+struct CodecTableView
+{
+  const T* ptr = nullptr;
+  size_t count = 0;
+
+  constexpr CodecTableView() = default;
+  constexpr CodecTableView(const T* p, size_t n) : ptr(p), count(n) {}
+  template <size_t N>
+  constexpr CodecTableView(const T (&arr)[N]) : ptr(arr), count(N) {}
+
+  constexpr const T* begin() const { return ptr; }
+  constexpr const T* end() const { return ptr + count; }
+  constexpr size_t size() const { return count; }
+  constexpr bool empty() const { return count == 0; }
+  constexpr const T& operator[](size_t i) const { return ptr[i]; }
+};
+//==============================================================================
 // CodecOptionDef - describes a configurable codec option
+// All strings point at literals in the built-in table, so data() is
+// always null-terminated and safe to hand to C APIs.
 //==============================================================================
 enum class CodecOptionType
 {
@@ -19,55 +49,117 @@ enum class CodecOptionType
 
 struct CodecOptionChoice
 {
-  std::string label;    // Display text: "VoIP", "Audio", etc.
-  std::string argValue; // ffmpeg arg value: "voip", "audio", etc.
+  std::string_view label;    // Display text: "VoIP", "Audio", etc.
+  std::string_view argValue; // ffmpeg arg value: "voip", "audio", etc.
 };
 
 struct CodecOptionDef
 {
-  std::string key;                        // Unique identifier
-  std::string label;                      // UI display label
-  std::string argName;                    // ffmpeg arg name (e.g., "-application")
+  std::string_view key;                       // Unique identifier
+  std::string_view label;                     // UI display label
+  std::string_view argName;                   // ffmpeg arg name (e.g., "-application"); empty: read by the processor
   CodecOptionType type;
-  int defaultValue;                       // Default index (Choice/Toggle) or int value (IntRange)
-  int minValue;                           // For IntRange only
-  int maxValue;                           // For IntRange only
-  std::vector<CodecOptionChoice> choices; // For Choice type only
+  int defaultValue;                           // Default index (Choice/Toggle) or int value (IntRange)
+  int minValue;                               // For IntRange only
+  int maxValue;                               // For IntRange only
+  CodecTableView<CodecOptionChoice> choices;  // For Choice type only
+};
+
+//==============================================================================
+// NativeCodec - in-process implementation (NativeCodecProcessor) preferred
+// over the ffmpeg pipeline, which stays the fallback
+//==============================================================================
+
+// Compile-time switch for the libopus backend: with CODECSIM_HAS_LIBOPUS=0
+// (default) Opus runs through ffmpeg only. CMake: -DCODECSIM_LIBOPUS=ON.
+#ifndef CODECSIM_HAS_LIBOPUS
+#define CODECSIM_HAS_LIBOPUS 0
+#endif
+
+enum class NativeCodec : uint8_t
+{
+  None,        // ffmpeg only
+  G711ALaw,
+  G711MuLaw,
+  Dfpwm,
+  AdpcmIma,    // Block codecs: one block of latency
+  AdpcmMs,
+  AdpcmYamaha,
+  Passthrough, // Lossless codecs: decoded output is the input ("lossless_mode" option)
+  Opus         // libopus, no container (LibOpusProcessor; CODECSIM_HAS_LIBOPUS builds only)
 };
 
 //==============================================================================
 // CodecInfo - describes a single codec configuration
+// Immutable descriptor; availability is tracked by the registry snapshot.
 //==============================================================================
 struct CodecInfo
 {
-  std::string id;             // Internal identifier: "mp3", "aac", "opus", etc.
-  std::string displayName;    // UI display name: "MP3", "AAC (LC)", "Opus", etc.
-  std::string encoderName;    // ffmpeg encoder name: "libmp3lame", "aac", "libopus"
-  std::string muxerFormat;    // ffmpeg -f for encoder output: "mp3", "adts", "ogg"
-  std::string demuxerFormat;  // ffmpeg -f for decoder input: "mp3", "aac", "ogg"
-  int defaultBitrate;         // Default bitrate in kbps
-  int minBitrate;             // Minimum bitrate in kbps
-  int maxBitrate;             // Maximum bitrate in kbps
-  int frameSize;              // Codec frame size in samples
-  int latencySamples;         // Estimated latency in samples
-  std::string additionalArgs; // Extra ffmpeg encoder arguments
-  bool isLossless;            // If true, bitrate control is disabled
-  bool monoOnly;              // If true, codec only supports mono (1 channel)
-  bool available;             // Detected at runtime via ffmpeg -encoders
-  std::vector<CodecOptionDef> options;    // Codec-specific configurable options
+  std::string_view id;             // Internal identifier: "mp3", "aac", "opus", etc.
+  std::string_view displayName;    // UI display name: "MP3", "AAC (LC)", "Opus", etc.
+  std::string_view encoderName;    // ffmpeg encoder name: "libmp3lame", "aac", "libopus"
+  std::string_view muxerFormat;    // ffmpeg -f for encoder output: "mp3", "adts", "ogg"
+  std::string_view demuxerFormat;  // ffmpeg -f for decoder input: "mp3", "aac", "ogg"
+  int defaultBitrate;              // Default bitrate in kbps
+  int minBitrate;                  // Minimum bitrate in kbps
+  int maxBitrate;                  // Maximum bitrate in kbps
+  int frameSize;                   // Codec frame size in samples
+  int latencySamples;              // Estimated latency in samples
+  std::string_view additionalArgs; // Extra ffmpeg encoder arguments
+  bool isLossless;                 // If true, bitrate control is disabled
+  bool monoOnly;                   // If true, codec only supports mono (1 channel)
+  CodecTableView<CodecOptionDef> options; // Codec-specific configurable options
+  NativeCodec native = NativeCodec::None;  // Built-in encoder/decoder, if any
 };
+//==============================================================================
+// Option values keyed by CodecOptionDef::key: choice index (Choice), 0/1
+// (Toggle) or the value itself (IntRange); missing keys use the default
+//==============================================================================
+using CodecOptionValues = std::map<std::string, int, std::less<>>;
+
+// ffmpeg encoder arguments: CodecInfo::additionalArgs plus one per option
+// (options without an argName are skipped)
+std::string BuildCodecArgs(const CodecInfo& info, const CodecOptionValues& optionValues);
+
+// Value of one of the codec's options (its default if unset); fallback if the codec has no such option
+int GetCodecOptionValue(const CodecInfo& info, const CodecOptionValues& optionValues, std::string_view key,
+                        int fallback = 0);
+
+//==============================================================================
+// Bitrate presets (kbps) offered for variable-bitrate codecs
+//==============================================================================
+inline constexpr int kBitratePresets[] = {32, 48, 64, 96, 128, 160, 192, 256, 320};
+inline constexpr int kNumBitratePresets = sizeof(kBitratePresets) / sizeof(kBitratePresets[0]);
+
+// Bitrates (kbps) selectable for a codec: the presets inside its range plus
+// its default, a fixed-rate codec's single rate, or none for lossless codecs
+std::vector<int> GetBitrateLadder(const CodecInfo& info);
+
+// Bitrates (kbps) an encoder accepts when it only takes a fixed set (MPEG-1
+// Layer 2); empty when any value in [minBitrate, maxBitrate] is valid
+std::vector<int> GetValidBitrates(const CodecInfo& info);
+
+// Nearest bitrate the encoder accepts (kbps unchanged for continuous codecs)
+int SnapBitrate(const CodecInfo& info, int kbps);
+
 //==============================================================================
 // CodecRegistry - singleton registry of all supported codecs
+//
+// The built-in table is a constexpr array. DetectAvailable() publishes an
+// immutable snapshot through an atomic pointer, so every accessor below is
+// O(1) (or O(n) only for the list-building GetAvailable), lock-free and
+// allocation-free. Safe to call from the audio thread.
 //==============================================================================
 class CodecRegistry
 {
 public:
   static CodecRegistry& Instance();
-  // Detect available codecs by running ffmpeg -encoders
+  // Detect available codecs by running ffmpeg -encoders (codecs with a
+  // native implementation are available without ffmpeg)
   // Should be called once at startup
   void DetectAvailable(const std::string& ffmpegPath = "ffmpeg.exe");
   // Get all registered codecs (including unavailable)
-  const std::vector<CodecInfo>& GetAll() const { return mCodecs; }
+  CodecTableView<CodecInfo> GetAll() const;
   // Get only available codecs
   std::vector<const CodecInfo*> GetAvailable() const;
   // Get available codec count
@@ -75,18 +167,27 @@ public:
   // Get codec by index into available-only list (0-based)
   const CodecInfo* GetAvailableByIndex(int index) const;
   // Get available codec index by internal id (-1 if not found)
-  int GetAvailableIndexById(const std::string& id) const;
+  int GetAvailableIndexById(std::string_view id) const;
   // Get codec by internal id
-  const CodecInfo* GetById(const std::string& id) const;
+  const CodecInfo* GetById(std::string_view id) const;
+  // Check whether a codec was found by the last detection
+  bool IsAvailable(std::string_view id) const { return GetAvailableIndexById(id) >= 0; }
   // Check if detection has been performed
-  bool IsDetected() const { return mDetected; }
+  bool IsDetected() const { return mDetected.load(std::memory_order_acquire); }
 private:
   CodecRegistry();
   ~CodecRegistry() = default;
   CodecRegistry(const CodecRegistry&) = delete;
   CodecRegistry& operator=(const CodecRegistry&) = delete;
-  void RegisterBuiltinCodecs();
-  std::vector<CodecInfo> mCodecs;
-  bool mDetected = false;
-  mutable std::mutex mMutex;
-};
\ No newline at end of file
+
+  struct Snapshot;
+  const Snapshot* LoadSnapshot() const { return mSnapshot.load(std::memory_order_acquire); }
+
+  // Current published snapshot (never null; starts as the empty snapshot)
+  std::atomic<const Snapshot*> mSnapshot;
+  // Retired snapshots stay alive for the registry's lifetime so readers never
+  // see a dangling pointer. Detection results rarely change, so this stays tiny.
+  std::vector<std::unique_ptr<const Snapshot>> mSnapshots;
+  std::atomic<bool> mDetected{false};
+  std::mutex mMutex; // serializes DetectAvailable only
+};
@@ -1,9 +1,18 @@
 #include "CodecSim.h"
 #include "IPlug_include_in_plug_src.h"
+#include "BlockBuffers.h"
 #include "CodecProcessor.h"
+#include "NativeCodecProcessor.h"
+#include "LibOpusProcessor.h"
+#include "LosslessPassthrough.h"
 #include "CodecRegistry.h"
+#include "DebugLog.h"
+#include "StatePersistence.h"
+#include "TraceRecorder.h"
 #include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <ctime>
 
 #if IPLUG_EDITOR
 #include "IControls.h"
@@ -12,23 +21,11 @@
 #ifdef _WIN32
 #include <windows.h>
 #include <shellapi.h>
-#include <debugapi.h>
 #include <cstdio>
-
-static void DebugLogCodecSim(const std::string& msg)
-{
-  FILE* f = fopen("D:\\ffmpeg_debug.log", "a");
-  if (f) {
-    fprintf(f, "[CodecSim] %s\n", msg.c_str());
-    fflush(f);
-    fclose(f);
-  }
-  OutputDebugStringA(("[CodecSim] " + msg + "\n").c_str());
-}
-#else
-static void DebugLogCodecSim(const std::string& msg) { (void)msg; }
 #endif
 
+#define DebugLogCodecSim(msg) CODECSIM_LOG(LogLevel::Debug, "CodecSim", msg)
+
 //==============================================================================
 // Color Definitions
 //==============================================================================
@@ -63,13 +60,96 @@ namespace Layout
 //==============================================================================
 // Bitrate & Sample Rate Presets
 //==============================================================================
-static const int kBitratePresets[] = {32, 48, 64, 96, 128, 160, 192, 256, 320};
-static const int kNumBitratePresets = sizeof(kBitratePresets) / sizeof(kBitratePresets[0]);
+// kBitratePresets / kNumBitratePresets live in CodecRegistry.h
 // Index kNumBitratePresets = "Other" (custom input)
 
 static const int kSampleRatePresets[] = {8000, 16000, 22050, 32000, 44100, 48000, 88200, 96000};
 static const int kNumSampleRatePresets = sizeof(kSampleRatePresets) / sizeof(kSampleRatePresets[0]);
 
+//==============================================================================
+// Lazy Pipeline Start
+//==============================================================================
+// When enabled, no ffmpeg process is spawned until the first non-silent block
+// (or the editor opens). The blocks played while the pipeline starts come out
+// silent, so the onset of the first sound is dropped: delaying it instead would
+// break the latency reported to the host. Input from that stretch is kept in a
+// pre-roll buffer and fed first only to warm the codec up; its decode is
+// discarded (see FeedPreRoll).
+static constexpr bool kLazyPipelineStart = true;
+
+// The first start also waits for the host to restore the project state, so a
+// loaded instance never spawns ffmpeg for the defaults it is about to replace.
+// Hosts that create an instance without restoring anything are covered by the
+// grace period, counted from construction.
+static constexpr int kRestoreGraceMs = 1000;
+static constexpr int kPreRollMaxFrames = 32768;    // ~0.7 s at 48 kHz
+static constexpr float kSilenceThreshold = 1.0e-5f; // ~-100 dBFS
+
+static float BlockPeak(sample** inputs, int nChans, int nFrames)
+{
+  float peak = 0.f;
+  for (int c = 0; c < nChans; c++)
+    for (int s = 0; s < nFrames; s++)
+      peak = std::max(peak, std::abs(static_cast<float>(inputs[c][s])));
+  return peak;
+}
+
+static bool IsBlockSilent(sample** inputs, int nChans, int nFrames)
+{
+  return BlockPeak(inputs, nChans, nFrames) <= kSilenceThreshold;
+}
+
+//==============================================================================
+// Silence-Aware Parking
+//==============================================================================
+// After mParkAfterSeconds (kDefaultParkAfterSeconds unless the state or the
+// Metrics tab's selector says otherwise; 0 never parks) of input below
+// kSilenceThreshold the pipeline is parked (ffmpeg no longer fed, processes
+// suspended). It wakes as soon as a
+// block exceeds kWakeThreshold; the gap between the two thresholds is the
+// hysteresis that keeps noise-floor material from toggling the state.
+// Neither feeding nor draining happens while parked, so the pipeline latency
+// is preserved across a park/resume cycle.
+static constexpr double kDefaultParkAfterSeconds = 5.0;
+static constexpr double kParkAfterChoices[] = {0.0, 2.0, 5.0, 10.0, 30.0};  // Metrics tab selector
+static constexpr int kNumParkAfterChoices = static_cast<int>(sizeof(kParkAfterChoices) / sizeof(kParkAfterChoices[0]));
+static constexpr float kWakeThreshold = 3.2e-5f;    // ~-90 dBFS
+
+//==============================================================================
+// Offline Rendering
+//==============================================================================
+// When the host bounces offline, the pipeline is restarted in blocking mode:
+// every block waits until the decoded stream can fill it, so the render runs
+// as fast as ffmpeg encodes and the result does not depend on timing. The
+// decoded stream is primed with a fixed hold-back of silence that covers the
+// encoder's frame buffering, and the hold-back is added to the reported
+// latency (and tail), so host delay compensation keeps the bounce aligned.
+static constexpr int kOfflineReadTimeoutMs = 2000;
+// How long an offline block waits for the render-mode thread to build its pipeline
+static constexpr int kRenderModeSwitchTimeoutMs = 10000;
+
+static int OfflineHoldbackFrames(const CodecInfo& info, int sampleRate)
+{
+  return std::max(4 * info.frameSize, sampleRate / 2);
+}
+
+//==============================================================================
+// Shared ffmpeg Workers
+//==============================================================================
+// When enabled, instances with identical codec settings share one encoder/
+// decoder process pair (one -map'ed stream each) instead of spawning their
+// own (Windows only). Off by default: a crash of the shared pair takes down
+// every stream on it. Opt in with CODECSIM_SHARED_WORKERS=1 in the host's
+// environment, read once per process.
+static bool UseSharedWorkers()
+{
+  static const bool enabled = [] {
+    const char* value = std::getenv("CODECSIM_SHARED_WORKERS");
+    return value && value[0] == '1' && value[1] == '\0';
+  }();
+  return enabled;
+}
+
 //==============================================================================
 // Spinner Overlay Control (full-screen overlay + centered rotating arc)
 //==============================================================================
@@ -167,13 +247,25 @@ CodecSim::CodecSim(const InstanceInfo& info)
 , mSampleRate(48000)
 , mNumChannels(2)
 , mLatencySamples(0)
+, mParkAfterSeconds(kDefaultParkAfterSeconds)
 {
+  // Diagnostics: Windows keeps a file next to the saved state, elsewhere only CODECSIM_DEBUG_LOG
+#ifdef _WIN32
+  CreateDirectoryA(GetAppDataPath().c_str(), NULL);
+  DebugLogger::Start(GetAppDataPath() + "debug.log");
+#else
+  DebugLogger::Start("");
+#endif
   DebugLogCodecSim("Constructor - START");
 
   // Pre-allocate interleaved buffers (ensures valid even before codec init)
   const int maxFrames = 8192;
   mInterleavedInput.resize(maxFrames * 2, 0.f);
   mInterleavedOutput.resize(maxFrames * 2, 0.f);
+  mMetrics = std::make_shared<PipelineMetrics>();
+  mMetricsPublisher = std::make_unique<PipelineMetricsPublisher>(mMetrics);
+  if (kLazyPipelineStart)
+    mPreRollBuffer.resize(kPreRollMaxFrames * 2, 0.f);
 
   // Detect available codecs from ffmpeg
   CodecRegistry::Instance().DetectAvailable(FFmpegPipeManager::ResolveFFmpegPath());
@@ -192,7 +284,7 @@ CodecSim::CodecSim(const InstanceInfo& info)
   mCurrentCodecIndex = 0;
   GetParam(kParamCodec)->InitEnum("Codec", 0, numAvailable);
   for (int i = 0; i < static_cast<int>(availableCodecs.size()); i++)
-    GetParam(kParamCodec)->SetDisplayText(i, availableCodecs[i]->displayName.c_str());
+    GetParam(kParamCodec)->SetDisplayText(i, availableCodecs[i]->displayName.data());
 
   // Bitrate preset selector (temporary init, will be re-initialized by UpdateBitrateForCodec)
   GetParam(kParamBitrate)->InitEnum("Bitrate", 4, kNumBitratePresets + 1);
@@ -232,6 +324,14 @@ CodecSim::CodecSim(const InstanceInfo& info)
 
   // Load standalone state (for VST3 the host handles state via SerializeState/UnserializeState)
   LoadStandaloneState();
+  mConstructedTime = std::chrono::steady_clock::now();
+#ifdef APP_API
+  mStateRestored.store(true);  // Nothing else will restore the standalone app
+#endif
+
+  // Background writer for standalone state: it only ever sees finished
+  // snapshots, serialized on the idle thread (see SubmitStandaloneState)
+  mStatePersistence = std::make_unique<StatePersistence>(GetAppDataPath(), "state.dat");
 
 #if IPLUG_EDITOR
   mMakeGraphicsFunc = [&]() {
@@ -517,7 +617,7 @@ CodecSim::CodecSim(const InstanceInfo& info)
     auto codecList = CodecRegistry::Instance().GetAvailable();
     std::vector<const char*> codecNames;
     for (const auto* c : codecList)
-      codecNames.push_back(c->displayName.c_str());
+      codecNames.push_back(c->displayName.data());
 
     if (codecNames.empty())
       codecNames.push_back("(none)");
@@ -625,7 +725,7 @@ CodecSim::CodecSim(const InstanceInfo& info)
     pGraphics->AttachControl(pApplyBtn, kCtrlTagApplyButton);
 
     //==========================================================================
-    // Detail Settings Panel (Right Side) - Tabbed: Options / Log
+    // Detail Settings Panel (Right Side) - Tabbed: Options / Log / Metrics
     //==========================================================================
     const IRECT detailPanelBounds = contentArea.GetFromRight(Layout::DetailPanelWidth);
     pGraphics->AttachControl(new IPanelControl(detailPanelBounds, Colors::Panel));
@@ -638,8 +738,13 @@ CodecSim::CodecSim(const InstanceInfo& info)
                                    detailPanelInner.R, detailPanelInner.T + kTabHeight);
 
     auto* pTabSwitch = new IVTabSwitchControl(tabBounds, kNoParameter,
-      {"Options", "Log"}, "", tabStyle);
+      {"Options", "Log", "Metrics"}, "", tabStyle);
     pTabSwitch->SetValue(0.0); // Default to Options tab
+    pTabSwitch->SetActionFunction([this](IControl* pCaller) {
+      int tabIdx = static_cast<int>(pCaller->GetValue() * 2.0 + 0.5); // 0=Options, 1=Log, 2=Metrics
+      if (tabIdx != mDetailTabIndex)
+        SetDetailTab(tabIdx);
+    });
     pGraphics->AttachControl(pTabSwitch, kCtrlTagDetailTabSwitch);
 
     // Content area below tabs
@@ -683,6 +788,40 @@ CodecSim::CodecSim(const InstanceInfo& info)
       kCtrlTagLogDisplay
     );
 
+    // --- Metrics tab ---
+    // Park-after-silence selector along the bottom (above Save Trace)
+    constexpr float kParkSelectorH = 24.f;
+#if CODECSIM_TRACE
+    constexpr float kTraceButtonH = 24.f;
+    const IRECT metricsArea = tabContentBounds.GetReducedFromBottom(kTraceButtonH + 5.f);
+    auto* pTraceBtn = new IVButtonControl(tabContentBounds.GetFromBottom(kTraceButtonH),
+      [this](IControl* pCaller) {
+        SaveTrace();
+      },
+      "Save Trace", tabStyle);
+    pTraceBtn->Hide(true);
+    pGraphics->AttachControl(pTraceBtn, kCtrlTagTraceSaveButton);
+#else
+    const IRECT metricsArea = tabContentBounds;
+#endif
+    const IRECT metricsBounds = metricsArea.GetReducedFromBottom(kParkSelectorH + 5.f);
+    auto* pParkSelector = new IVTabSwitchControl(metricsArea.GetFromBottom(kParkSelectorH), kNoParameter,
+      {"Park: never", "2 s", "5 s", "10 s", "30 s"}, "", tabStyle);
+    pParkSelector->SetActionFunction([this](IControl* pCaller) {
+      const int idx = static_cast<int>(pCaller->GetValue() * (kNumParkAfterChoices - 1) + 0.5);
+      if (idx >= 0 && idx < kNumParkAfterChoices && kParkAfterChoices[idx] != mParkAfterSeconds)
+      {
+        SetParkAfterSeconds(kParkAfterChoices[idx]);
+        SaveStandaloneState();
+      }
+    });
+    pParkSelector->Hide(true);
+    pGraphics->AttachControl(pParkSelector, kCtrlTagParkSelector);
+    auto* pMetrics = new IMultiLineTextControl(metricsBounds, "No pipeline running",
+      IText(10.f, Colors::TextGray, "Roboto-Regular", EAlign::Near, EVAlign::Top));
+    pMetrics->Hide(true);
+    pGraphics->AttachControl(pMetrics, kCtrlTagMetricsDisplay);
+
     //==========================================================================
     // Loading Overlay (full-screen, rendered last = on top of everything)
     //==========================================================================
@@ -691,6 +830,8 @@ CodecSim::CodecSim(const InstanceInfo& info)
       kCtrlTagSpinner
     );
 
+    BindUi(pGraphics);
+
     // Initialize options UI for the current codec (may have been restored from saved state)
     UpdateOptionsForCodec(mCurrentCodecIndex);
   };
@@ -698,28 +839,46 @@ CodecSim::CodecSim(const InstanceInfo& info)
 
   // Log detected codecs
   for (const auto* c : availableCodecs)
-    AddLogMessage("Detected: " + c->displayName + " (" + c->encoderName + ")");
+    AddLogMessage("Detected: " + std::string(c->displayName) + " (" + std::string(c->encoderName) + ")");
+  if (UseSharedWorkers())
+    AddLogMessage("Shared ffmpeg workers enabled (CODECSIM_SHARED_WORKERS=1)");
 
   mConstructed = true;
 
   DebugLogCodecSim("Host detected: " + std::to_string(static_cast<int>(GetHost())));
 
-  // Auto-initialize codec with default settings
-  ApplyCodecSettings();
+  // First start: after state restore, and in lazy mode not before audio flows
+  ArmLazyStart();
+  if (!kLazyPipelineStart)
+    RequestLazyStart();
+
+  mRenderModeThread = std::thread(&CodecSim::RenderModeThread, this);
 
   DebugLogCodecSim("Constructor - END");
 }
 
 CodecSim::~CodecSim()
 {
-  SaveStandaloneState();
-  if (mInitThread.joinable())
-    mInitThread.join();
+  // Flushes any pending state write before members go away
+  if (mStateSavePending.exchange(false))
+    SubmitStandaloneState();
+  mStatePersistence.reset();
+  mRenderModeStop.store(true);
+  mRenderModeCv.notify_all();
+  if (mRenderModeThread.joinable())
+    mRenderModeThread.join();
+  {
+    std::lock_guard<std::recursive_mutex> threadLock(mThreadMutex);
+    CancelLazyStart();
+    if (mInitThread.joinable())
+      mInitThread.join();
+  }
   std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
   if (mCodecProcessor) {
     mCodecProcessor->Shutdown();
     mCodecProcessor.reset();
   }
+  DebugLogger::Stop();
 }
 
 // Helper: get effective bitrate from preset or custom input
@@ -746,17 +905,21 @@ void CodecSim::OnReset()
     mSampleRate = kSampleRatePresets[sampleRateIndex];
   else
     mSampleRate = 48000;
-  {
-    int channelMode = GetParam(kParamChannels)->Int();
-    mNumChannels = (channelMode == 0) ? 2 : 1;
-  }
 
-  // Note: Do NOT call InitializeCodec here.
+  // Note: Do NOT call InitializeCodec here for realtime playback.
   // OnReset is called by the host on playback start, sample rate change, and
   // after SetLatency triggers a restart. Calling InitializeCodec here causes
   // recursive re-initialization (SetLatency -> OnReset -> InitializeCodec -> SetLatency).
   // Codec init is handled by the Apply button (ApplyCodecSettings) and auto-init in constructor.
-
+  //
+  // Offline renders are the exception: each bounce needs a fresh blocking
+  // pipeline before its first block. A nested OnReset from SetLatency lands
+  // in InitializeCodec's re-entrancy guard and is skipped.
+  if (mConstructed && (GetRenderingOffline() || mOfflineMode.load()))
+  {
+    mPreRollCapturing = false;  // Processing is stopped while the host resets
+    SetOfflineMode(GetRenderingOffline());
+  }
 }
 
 void CodecSim::OnParamChange(int paramIdx)
@@ -784,7 +947,7 @@ void CodecSim::OnParamChange(int paramIdx)
           SendParameterValueFromDelegate(kParamCodec,
             GetParam(kParamCodec)->ToNormalized(static_cast<double>(mp3Index)), false);
           mCurrentCodecIndex = mp3Index;
-          mPendingCodecUpdate.store(true);
+          PostUiEvents(kUiEventCodecChanged);
           if (!mTrialDialogShown)
           {
             mTrialDialogShown = true;
@@ -805,9 +968,9 @@ void CodecSim::OnParamChange(int paramIdx)
         mCurrentCodecIndex = newCodecIndex;
         const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
         if (info)
-          AddLogMessage("Codec: " + info->displayName + ". Press Apply.");
+          AddLogMessage("Codec: " + std::string(info->displayName) + ". Press Apply.");
         // Defer UpdateBitrateForCodec/UpdateOptionsForCodec to OnIdle (UI thread).
-        mPendingCodecUpdate.store(true);
+        PostUiEvents(kUiEventCodecChanged);
       }
     }
     break;
@@ -821,6 +984,7 @@ void CodecSim::OnParamChange(int paramIdx)
         AddLogMessage("Bitrate: Other (custom). Press Apply.");
       else if (presetIdx < numPresets)
         AddLogMessage("Bitrate: " + std::to_string(mCurrentBitratePresets[presetIdx]) + " kbps. Press Apply.");
+      PostUiEvents(kUiEventBitrate);
     }
     break;
     case kParamBitrateCustom:
@@ -841,18 +1005,19 @@ void CodecSim::OnParamChange(int paramIdx)
     break;
     case kParamChannels:
     {
+      // Takes effect on Apply; the running pipeline keeps mNumChannels
       int channelMode = GetParam(kParamChannels)->Int();
-      mNumChannels = (channelMode == 0) ? 2 : 1;
+      int numChannels = (channelMode == 0) ? 2 : 1;
       // Guard: force mono for mono-only codecs
       const CodecInfo* chInfo = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
-      if (chInfo && chInfo->monoOnly && mNumChannels != 1)
+      if (chInfo && chInfo->monoOnly && numChannels != 1)
       {
-        mNumChannels = 1;
+        numChannels = 1;
         GetParam(kParamChannels)->Set(1);
         SendParameterValueFromDelegate(kParamChannels,
           GetParam(kParamChannels)->ToNormalized(1.0), false);
       }
-      AddLogMessage("Channels: " + std::string(mNumChannels == 1 ? "Mono" : "Stereo") + ". Press Apply.");
+      AddLogMessage("Channels: " + std::string(numChannels == 1 ? "Mono" : "Stereo") + ". Press Apply.");
     }
     break;
     case kParamEnabled:
@@ -868,25 +1033,46 @@ void CodecSim::OnParamChange(int paramIdx)
       paramIdx == kParamChannels)
   {
     mPendingApply.store(true);
+    PostUiEvents(kUiEventPendingApply);
   }
 
-  // Save state on parameter change (standalone persistence)
+  // Schedule a state save (written later on the persistence thread)
   if (paramIdx != kParamEnabled && mConstructed)
     SaveStandaloneState();
 }
 
 void CodecSim::OnIdle()
 {
+  // Quality scoring (a thread plus FFTs) only runs while the Metrics tab shows it
+  const bool qualityWanted = GetUI() && mDetailTabIndex == 2;
+  mQualityWanted.store(qualityWanted);
+  if (qualityWanted != mQualityAnalyzer.IsRunning())
+  {
+    std::unique_lock<std::recursive_mutex> lock(mCodecMutex, std::try_to_lock);
+    if (lock.owns_lock())  // Busy: a pipeline is starting (it reads the flag) or the next tick retries
+      UpdateQualityAnalyzer();
+  }
+
+  // Snapshot state scheduled since the last tick (also while the editor is closed).
+  // Serializing here, on the thread that edits the option map, keeps the
+  // persistence writer away from live plugin state.
+  if (mStateSavePending.exchange(false))
+    SubmitStandaloneState();
+
   // Cache GetUI() once - it becomes nullptr when editor is closed/being recreated
   IGraphics* pUI = GetUI();
   if (!pUI)
   {
+    mUi = UiBinding();
     mLastApplyButtonState = -1; // Reset tracking when editor closes
     return;
   }
 
-  // Handle deferred codec update (from OnParamChange on host thread)
-  if (mPendingCodecUpdate.exchange(false))
+  // Apply only what changed since the last tick; events stay queued while the editor is closed
+  const uint32_t events = mUiEvents.exchange(0, std::memory_order_acquire);
+
+  // Deferred codec update (from OnParamChange on host thread)
+  if (events & kUiEventCodecChanged)
   {
     UpdateBitrateForCodec(mCurrentCodecIndex);
     UpdateOptionsForCodec(mCurrentCodecIndex);
@@ -894,176 +1080,270 @@ void CodecSim::OnIdle()
     mLastBitrateDisplayStr.clear(); // Force display text refresh
   }
 
-  // Update Apply button appearance based on pending changes (only when state changes)
+  if (events & (kUiEventPendingApply | kUiEventInitializing))
+    UpdateApplyButton();
+
+  // Show/hide loading spinner during initialization
+  if ((events & kUiEventInitializing) && mUi.spinner)
   {
-    bool pending = mPendingApply.load();
     bool initializing = mInitializing.load();
-    int desiredState = (pending && !initializing) ? 1 : (pending ? -1 : 0);
+    if (initializing && mUi.spinner->IsHidden())
+      mUi.spinner->StartSpinning();
+    else if (!initializing && !mUi.spinner->IsHidden())
+      mUi.spinner->StopSpinning();
+  }
+
+  if (events & (kUiEventCodecChanged | kUiEventBitrate))
+    UpdateBitrateControls();
+
+  if (events & kUiEventTabChanged)
+    SetDetailTab(mDetailTabIndex);
 
-    if (desiredState != -1 && desiredState != mLastApplyButtonState)
+  // Log: only while the tab is visible, rebuilt when a line arrives or the status line changes
+  if (mDetailTabIndex == 1 && mUi.logDisplay)
+  {
+    // Passthrough size check (the real encoder, running at idle priority)
+    std::string statusLine;
+    if (mLosslessVerifier.IsRunning())
     {
-      if (IControl* pApplyBtn = pUI->GetControlWithTag(kCtrlTagApplyButton))
-      {
-        auto* pBtn = dynamic_cast<IVButtonControl*>(pApplyBtn);
-        if (pBtn)
-        {
-          if (desiredState == 1)
-          {
-            // Orange: unapplied changes exist
-            const IVStyle pendingStyle = IVStyle({
-              IColor(0, 0, 0, 0),
-              IColor(255, 210, 150, 50),
-              IColor(255, 160, 100, 20),
-              IColor(255, 220, 160, 60),
-              IColor(255, 200, 140, 40),
-              IColor(0, 0, 0, 0),
-              Colors::TextWhite, Colors::TextWhite, Colors::TextWhite
-            }).WithLabelText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
-              .WithValueText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
-              .WithShowLabel(true).WithDrawFrame(true).WithDrawShadows(false).WithRoundness(4.f);
-            pBtn->SetStyle(pendingStyle);
-            pBtn->SetLabelStr("Apply *");
-          }
-          else
-          {
-            // Green: all changes applied
-            const IVStyle appliedStyle = IVStyle({
-              IColor(0, 0, 0, 0),
-              IColor(255, 50, 140, 80),
-              IColor(255, 40, 120, 70),
-              IColor(255, 60, 160, 90),
-              IColor(255, 50, 140, 80),
-              IColor(0, 0, 0, 0),
-              Colors::TextWhite, Colors::TextWhite, Colors::TextWhite
-            }).WithLabelText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
-              .WithValueText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
-              .WithShowLabel(true).WithDrawFrame(true).WithDrawShadows(false).WithRoundness(4.f);
-            pBtn->SetStyle(appliedStyle);
-            pBtn->SetLabelStr("Apply");
-          }
-          pApplyBtn->SetDirty(false);
-          mLastApplyButtonState = desiredState;
-        }
-      }
+      const LosslessVerifierReport lossless = mLosslessVerifier.GetReport();
+      char line[160];
+      snprintf(line, sizeof(line), "Lossless: %.2f MB -> %.2f MB (%.1f%%)%s",
+               lossless.pcmBytes / 1048576.0, lossless.compressedBytes / 1048576.0, lossless.GetRatio() * 100.0,
+               lossless.failed ? ", encoder failed" : lossless.droppedFrames > 0 ? ", frames dropped" : "");
+      statusLine = line;
     }
-  }
 
-  // Show/hide loading spinner during initialization
-  if (IControl* pSpinner = pUI->GetControlWithTag(kCtrlTagSpinner))
-  {
-    auto* pSpinnerCtrl = dynamic_cast<SpinnerOverlayControl*>(pSpinner);
-    if (pSpinnerCtrl)
+    if (mLog.Generation() != mLogShownGeneration || statusLine != mLogShownStatus)
     {
-      bool initializing = mInitializing.load();
-      if (initializing && pSpinner->IsHidden())
-        pSpinnerCtrl->StartSpinning();
-      else if (!initializing && !pSpinner->IsHidden())
-        pSpinnerCtrl->StopSpinning();
+      std::string logText;
+      mLogShownGeneration = mLog.AppendRecent(logText, kMaxLogLines);
+      logText += statusLine;
+      mLogShownStatus = std::move(statusLine);
+      mUi.logDisplay->SetStr(logText.c_str());
+      mUi.logDisplay->SetDirty(false);
     }
   }
 
-  // Handle detail panel tab switching
-  if (IControl* pTabSwitch = pUI->GetControlWithTag(kCtrlTagDetailTabSwitch))
+  // Live pipeline metrics: only while the tab is visible, redrawn when a new snapshot changes the text
+  if (mDetailTabIndex == 2 && mUi.metricsDisplay)
   {
-    int tabIdx = static_cast<int>(pTabSwitch->GetValue() * 1.0 + 0.5); // 0=Options, 1=Log
-    if (tabIdx != mDetailTabIndex)
-      SetDetailTab(tabIdx);
+    const std::string metricsText = BuildMetricsText();
+    if (metricsText != mUi.metricsDisplay->GetStr())
+    {
+      mUi.metricsDisplay->SetStr(metricsText.c_str());
+      mUi.metricsDisplay->SetDirty(false);
+    }
   }
+}
 
+//==============================================================================
+// Apply button styles (built once, shared by all instances)
+//==============================================================================
+static const IVStyle& ApplyButtonStyle(bool pending)
+{
+  // Orange: unapplied changes exist
+  static const IVStyle pendingStyle = IVStyle({
+    IColor(0, 0, 0, 0),
+    IColor(255, 210, 150, 50),
+    IColor(255, 160, 100, 20),
+    IColor(255, 220, 160, 60),
+    IColor(255, 200, 140, 40),
+    IColor(0, 0, 0, 0),
+    Colors::TextWhite, Colors::TextWhite, Colors::TextWhite
+  }).WithLabelText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
+    .WithValueText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
+    .WithShowLabel(true).WithDrawFrame(true).WithDrawShadows(false).WithRoundness(4.f);
+
+  // Green: all changes applied
+  static const IVStyle appliedStyle = IVStyle({
+    IColor(0, 0, 0, 0),
+    IColor(255, 50, 140, 80),
+    IColor(255, 40, 120, 70),
+    IColor(255, 60, 160, 90),
+    IColor(255, 50, 140, 80),
+    IColor(0, 0, 0, 0),
+    Colors::TextWhite, Colors::TextWhite, Colors::TextWhite
+  }).WithLabelText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
+    .WithValueText(IText(13.f, Colors::TextWhite, "Roboto-Regular"))
+    .WithShowLabel(true).WithDrawFrame(true).WithDrawShadows(false).WithRoundness(4.f);
+
+  return pending ? pendingStyle : appliedStyle;
+}
+
+void CodecSim::BindUi(IGraphics* pGraphics)
+{
+  mUi = UiBinding();
+  mUi.applyButton = dynamic_cast<IVButtonControl*>(pGraphics->GetControlWithTag(kCtrlTagApplyButton));
+  mUi.spinner = dynamic_cast<SpinnerOverlayControl*>(pGraphics->GetControlWithTag(kCtrlTagSpinner));
+  mUi.tabSwitch = dynamic_cast<IVTabSwitchControl*>(pGraphics->GetControlWithTag(kCtrlTagDetailTabSwitch));
+  mUi.bitrateLabel = pGraphics->GetControlWithTag(kCtrlTagBitrateLabel);
+  mUi.bitrateSelector = pGraphics->GetControlWithTag(kCtrlTagBitrateSelector);
+  mUi.bitrateCustom = pGraphics->GetControlWithTag(kCtrlTagBitrateCustom);
+  mUi.channelSelector = pGraphics->GetControlWithTag(kCtrlTagChannelSelector);
+  mUi.logDisplay = dynamic_cast<IMultiLineTextControl*>(pGraphics->GetControlWithTag(kCtrlTagLogDisplay));
+  mUi.metricsDisplay = dynamic_cast<IMultiLineTextControl*>(pGraphics->GetControlWithTag(kCtrlTagMetricsDisplay));
+
+  // The menu button draws its value with a child button
+  if (auto* pContainer = dynamic_cast<IContainerBase*>(mUi.bitrateSelector))
+  {
+    if (pContainer->NChildren() > 0)
+      mUi.bitrateValueButton = dynamic_cast<IVectorBase*>(pContainer->GetChild(0));
+  }
+
+  // Fresh controls: bring everything in line with the current state
+  mLastApplyButtonState = -1;
+  mLastBitrateDisplayStr.clear();
+  mLogShownGeneration = UINT64_MAX;
+  PostUiEvents(kUiEventPendingApply | kUiEventInitializing | kUiEventBitrate | kUiEventTabChanged);
+}
+
+void CodecSim::UpdateApplyButton()
+{
+  // Update Apply button appearance based on pending changes (only when state changes)
+  bool pending = mPendingApply.load();
+  bool initializing = mInitializing.load();
+  int desiredState = (pending && !initializing) ? 1 : (pending ? -1 : 0);
+
+  if (!mUi.applyButton || desiredState == -1 || desiredState == mLastApplyButtonState)
+    return;
+
+  mUi.applyButton->SetStyle(ApplyButtonStyle(desiredState == 1));
+  mUi.applyButton->SetLabelStr(desiredState == 1 ? "Apply *" : "Apply");
+  mUi.applyButton->SetDirty(false);
+  mLastApplyButtonState = desiredState;
+}
+
+void CodecSim::UpdateBitrateControls()
+{
   // Hide/show bitrate controls based on codec type
   bool hideBitrate = mCurrentCodecIsLossless;
-  if (IControl* pBitrateLabel = pUI->GetControlWithTag(kCtrlTagBitrateLabel))
-    pBitrateLabel->Hide(hideBitrate);
-  if (IControl* pBitrateCtrl = pUI->GetControlWithTag(kCtrlTagBitrateSelector))
-  {
-    pBitrateCtrl->Hide(hideBitrate);
-
-    // Force-sync the IVMenuButtonControl's displayed text with the parameter value.
-    // Only update when the display text actually changes (avoid redundant SetValueStr
-    // which can cause visual oscillation or host feedback loops).
-    if (!hideBitrate)
+  if (mUi.bitrateLabel)
+    mUi.bitrateLabel->Hide(hideBitrate);
+  if (mUi.bitrateSelector)
+    mUi.bitrateSelector->Hide(hideBitrate);
+
+  IParam* pBitrateParam = GetParam(kParamBitrate);
+
+  // Sync the IVMenuButtonControl's displayed text with the parameter value.
+  // Only update when the display text actually changes (avoid redundant SetValueStr
+  // which can cause visual oscillation or host feedback loops).
+  int bitrateIdx = pBitrateParam->Int();
+  if (!hideBitrate && mUi.bitrateValueButton && bitrateIdx >= 0 && bitrateIdx < pBitrateParam->NDisplayTexts())
+  {
+    WDL_String str;
+    pBitrateParam->GetDisplay(str);
+    if (mLastBitrateDisplayStr != str.Get())
     {
-      IParam* pBitrateParam = GetParam(kParamBitrate);
-      int bitrateIdx = pBitrateParam->Int();
-      int maxIdx = pBitrateParam->NDisplayTexts();
-      double paramNorm = pBitrateParam->GetNormalized();
-      double ctrlValue = pBitrateCtrl->GetValue();
-
-      // Bounds check: ensure the parameter index is within the enum range
-      if (bitrateIdx >= 0 && bitrateIdx < maxIdx)
-      {
-        WDL_String str;
-        pBitrateParam->GetDisplay(str);
-        const char* newText = str.Get();
-
-        // Only update the button text if it actually changed
-        if (mLastBitrateDisplayStr != newText)
-        {
-          mLastBitrateDisplayStr = newText;
-          if (auto* pContainer = dynamic_cast<IContainerBase*>(pBitrateCtrl))
-          {
-            if (pContainer->NChildren() > 0)
-            {
-              if (auto* pChildBtn = dynamic_cast<IVectorBase*>(pContainer->GetChild(0)))
-              {
-                pChildBtn->SetValueStr(newText);
-              }
-            }
-          }
-        }
-      }
-      else
-      {
-        // Out of bounds - skip display update
-      }
+      mLastBitrateDisplayStr = str.Get();
+      mUi.bitrateValueButton->SetValueStr(str.Get());
     }
   }
 
   // Show/hide custom bitrate input
-  if (IControl* pCustomBitrate = pUI->GetControlWithTag(kCtrlTagBitrateCustom))
+  if (mUi.bitrateCustom)
   {
     int numPresets = static_cast<int>(mCurrentBitratePresets.size());
-    bool isOther = mCurrentCodecHasOther && (GetParam(kParamBitrate)->Int() >= numPresets);
-    pCustomBitrate->Hide(hideBitrate || !isOther);
+    bool isOther = mCurrentCodecHasOther && (bitrateIdx >= numPresets);
+    mUi.bitrateCustom->Hide(hideBitrate || !isOther);
   }
+}
 
-  if (IControl* pLogCtrl = pUI->GetControlWithTag(kCtrlTagLogDisplay))
+std::string CodecSim::BuildMetricsText() const
+{
+  PipelineMetricsSnapshot m;
+  if (!mMetricsPublisher || !mMetricsPublisher->GetSnapshot(m) || m.starts == 0)
+    return "No pipeline running";
+
+  const double rate = m.sampleRate > 0 ? m.sampleRate : 48000.0;
+  auto ms = [rate](uint64_t frames) { return frames * 1000.0 / rate; };
+
+  char buf[1024];
+  snprintf(buf, sizeof(buf),
+           "Stream: %s, %d Hz, %d ch\n"
+           "\n"
+           "Input queue:    %6.1f ms\n"
+           "Output queue:   %6.1f ms\n"
+           "Decoded buffer: %6.1f ms\n"
+           "First audio:    %6.1f ms after start\n"
+           "\n"
+           "Underruns: %llu (%.1f ms)\n"
+           "Overruns:  %llu\n"
+           "Restarts:  %llu (watchdog %llu)\n"
+           "\n"
+           "Pipe in:  %7.1f KB/s\n"
+           "Pipe out: %7.1f KB/s\n"
+           "\n"
+           "Encoder: %5.1f %% CPU, %6.1f MB\n"
+           "Decoder: %5.1f %% CPU, %6.1f MB\n",
+           m.codecId, m.sampleRate, m.channels,
+           ms(m.inputQueueFrames), ms(m.outputQueueFrames), ms(m.decodedBufferFrames),
+           m.timeToFirstAudioUs / 1000.0,
+           static_cast<unsigned long long>(m.underruns), ms(m.underrunFrames),
+           static_cast<unsigned long long>(m.overruns),
+           static_cast<unsigned long long>(m.starts - 1),
+           static_cast<unsigned long long>(m.watchdogRestarts),
+           m.inputBytesPerSecond / 1024.0, m.outputBytesPerSecond / 1024.0,
+           m.encoderCpuPercent, m.encoderRssBytes / (1024.0 * 1024.0),
+           m.decoderCpuPercent, m.decoderRssBytes / (1024.0 * 1024.0));
+
+  std::string text = buf;
+
+  // Live quality of the running pipeline (scored on the analysis thread while this tab is open)
+  QualityReport quality;
+  if (mQualityAnalyzer.GetReport(quality))
+  {
+    snprintf(buf, sizeof(buf), "\nQuality: SNR %.1f dB, segSNR %.1f dB\n         LSD %.2f dB, loudness %+.2f LU\n",
+             quality.snrDb, quality.segmentalSnrDb, quality.lsdDb, quality.lufsDelta);
+    text += buf;
+  }
+  else
   {
-    std::string logText;
-    {
-      std::lock_guard<std::mutex> lock(mLogMutex);
-      for (const auto& line : mLogMessages)
-        logText += line + "\n";
-    }
-    if (!logText.empty())
-    {
-      auto* pMultiLine = dynamic_cast<IMultiLineTextControl*>(pLogCtrl);
-      if (pMultiLine)
-      {
-        pMultiLine->SetStr(logText.c_str());
-        pLogCtrl->SetDirty(false);
-      }
-    }
+    text += "\nQuality: measuring...\n";
   }
+
+  const std::string& segment = mMetricsPublisher->GetSegmentName();
+  text += "\nShared memory: " + (segment.empty() ? std::string("unavailable") : segment);
+  return text;
+}
+
+void CodecSim::SaveTrace()
+{
+#if CODECSIM_TRACE
+  char stamp[32];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+  const std::string path = GetAppDataPath() + "trace-" + stamp + ".json";
+
+#ifdef _WIN32
+  CreateDirectoryA(GetAppDataPath().c_str(), NULL);
+#endif
+
+  std::string error;
+  if (TraceRecorder::WriteChromeTrace(path, error))
+    AddLogMessage("Trace saved: " + path);
+  else
+    AddLogMessage("ERROR: " + error);
+#endif
 }
 
 void CodecSim::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 {
+  CODECSIM_TRACE_THREAD_NAME("audio");
+  CODECSIM_TRACE_SCOPE_VALUE("ProcessBlock", nFrames);
   const int nOutChans = NOutChansConnected();
   const int nInChans = NInChansConnected();
 
-  // Early diagnostic logging (first 50 calls)
+  // Early diagnostic logging (first 50 calls; Trace level, compiled out by default).
+  // Audio thread: only integer records, formatted by the logger's writer thread.
   static int sPBCount = 0;
   const bool earlyLog = (sPBCount < 50);
   if (earlyLog)
   {
     sPBCount++;
-    DebugLogCodecSim("PB#" + std::to_string(sPBCount) +
-                     " nF=" + std::to_string(nFrames) +
-                     " nIn=" + std::to_string(nInChans) +
-                     " nOut=" + std::to_string(nOutChans) +
-                     " proc=" + std::to_string(mCodecProcessor ? (mCodecProcessor->IsInitialized() ? 1 : 0) : -1) +
-                     " deque=" + std::to_string(mDecodedBuffer.size()));
+    CODECSIM_LOG_RT(LogLevel::Trace, "CodecSim", "PB#%lld nF=%lld nIn=%lld nOut=%lld proc=%lld deque=%lld",
+                    sPBCount, nFrames, nInChans, nOutChans,
+                    mCodecProcessor ? (mCodecProcessor->IsInitialized() ? 1 : 0) : -1, mDecodedBuffer.size());
   }
 
   // Safety: clear all output channels first
@@ -1071,22 +1351,84 @@ void CodecSim::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
     for (int s = 0; s < nFrames; s++)
       outputs[c][s] = 0.0;
 
-  std::unique_lock<std::recursive_mutex> lock(mCodecMutex, std::try_to_lock);
+  // Render mode switch not announced through OnReset (host-dependent): the
+  // render-mode thread performs it, since it joins threads and starts ffmpeg.
+  // Offline there is no deadline, so the block waits for the new pipeline.
+  const bool offline = GetRenderingOffline();
+  if (offline != mOfflineMode.load(std::memory_order_relaxed))
+  {
+    mPreRollCapturing = false;
+    mRenderModeRequest.store(offline ? 1 : 0);
+    mRenderModeCv.notify_all();
+    if (offline)
+    {
+      std::unique_lock<std::mutex> modeLock(mRenderModeMutex);
+      mRenderModeCv.wait_for(modeLock, std::chrono::milliseconds(kRenderModeSwitchTimeoutMs),
+                             [this]() { return mRenderModeRequest.load() < 0; });
+    }
+  }
 
-  if (!lock.owns_lock())
+  // Lazy start: first non-silent block requests the pipeline and starts pre-roll capture
+  if (!offline && mLazyStartArmed.load(std::memory_order_relaxed) && !mPreRollCapturing &&
+      !IsBlockSilent(inputs, nInChans, nFrames))
   {
-    if (earlyLog) DebugLogCodecSim("  SKIP: lock failed");
-    return;
+    mPreRollCapturing = true;
+    mPreRollFrames = 0;
+    mPreRollWrite = 0;
+    RequestLazyStart();
   }
-  if (!mCodecProcessor)
+
+  // Offline there is no deadline: wait for the lock instead of dropping the block
+  std::unique_lock<std::recursive_mutex> lock(mCodecMutex, std::defer_lock);
+  if (offline)
+    lock.lock();
+  else
+    lock.try_lock();
+
+  const bool ready = lock.owns_lock() && mCodecProcessor && mCodecProcessor->IsInitialized();
+  if (!ready)
   {
-    if (earlyLog) DebugLogCodecSim("  SKIP: no processor");
+    // Pipeline still starting: keep the input so it can be fed once it is up
+    if (mPreRollCapturing)
+      CapturePreRoll(inputs, nInChans, nFrames);
+    if (earlyLog)
+      CODECSIM_LOG_RT(LogLevel::Trace, "CodecSim", !lock.owns_lock() ? "  SKIP: lock failed" :
+                      !mCodecProcessor ? "  SKIP: no processor" : "  SKIP: not initialized");
     return;
   }
-  if (!mCodecProcessor->IsInitialized())
+
+  if (mPreRollCapturing)
   {
-    if (earlyLog) DebugLogCodecSim("  SKIP: not initialized");
-    return;
+    mPreRollCapturing = false;
+    FeedPreRoll();
+  }
+
+  // Silence-aware parking: idle the ffmpeg pipeline during long silences
+  // (never offline: a frozen pipeline would shift the rest of the bounce)
+  if (mParkAfterSeconds > 0.0 && !offline)
+  {
+    const float peak = BlockPeak(inputs, nInChans, nFrames);
+    if (mParked)
+    {
+      if (peak <= kWakeThreshold)
+        return; // Stay parked: output stays zeroed, pipeline state is frozen
+
+      // Signal returned: input queued while ffmpeg wakes up is fed first
+      mParked = false;
+      mSilentFrames = 0;
+      mOutputPrimed = false;  // Refill after waking is not an underrun
+      mCodecProcessor->SetParked(false);
+    }
+    else
+    {
+      mSilentFrames = (peak <= kSilenceThreshold) ? mSilentFrames + nFrames : 0;
+      if (mSilentFrames >= static_cast<int64_t>(mParkAfterSeconds * GetSampleRate()))
+      {
+        mParked = true;
+        mCodecProcessor->SetParked(true);
+        return;
+      }
+    }
   }
 
   // Clamp nFrames to buffer capacity
@@ -1097,67 +1439,54 @@ void CodecSim::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
   float* outBuf = mInterleavedOutput.data();
   const int numCh = mNumChannels; // Capture locally (1=mono, 2=stereo)
 
-  // Interleave input based on channel mode
-  if (numCh == 1)
+  // Interleave input based on channel mode (mono: downmix L+R)
+  InterleaveHostBlock(inputs, nInChans, framesToProcess, numCh, inBuf);
+
+  // Write input to codec and drain all available decoded samples.
+  // Offline, block until the accumulation buffer can fill this whole block.
+  int decodedFrames;
+  if (offline)
   {
-    // Mono: downmix L+R to single channel
-    for (int s = 0; s < framesToProcess; s++)
-    {
-      float L = (nInChans > 0) ? static_cast<float>(inputs[0][s]) : 0.f;
-      float R = (nInChans > 1) ? static_cast<float>(inputs[1][s]) : L;
-      inBuf[s] = (L + R) * 0.5f;
-    }
+    const int bufferedFrames = static_cast<int>(mDecodedBuffer.size()) / numCh;
+    const int neededFrames = std::max(0, framesToProcess - bufferedFrames);
+    decodedFrames = mCodecProcessor->ProcessBlocking(inBuf, framesToProcess, outBuf, neededFrames,
+                                                     maxFrames, kOfflineReadTimeoutMs);
+    if (decodedFrames < neededFrames && mOfflineStarvedBlocks++ == 0)
+      AddLogMessage("WARNING: offline render starved (pipeline stalled beyond hold-back)");
   }
   else
   {
-    // Stereo: interleave L/R
-    for (int s = 0; s < framesToProcess; s++)
-    {
-      inBuf[s * 2]     = (nInChans > 0) ? static_cast<float>(inputs[0][s]) : 0.f;
-      inBuf[s * 2 + 1] = (nInChans > 1) ? static_cast<float>(inputs[1][s]) : inBuf[s * 2];
-    }
+    decodedFrames = mCodecProcessor->Process(inBuf, framesToProcess, outBuf, maxFrames);
   }
-
-  // Write input to codec and drain all available decoded samples
-  int decodedFrames = mCodecProcessor->Process(inBuf, framesToProcess, outBuf, maxFrames);
+  PushQualityStreams(inBuf, framesToProcess, outBuf, decodedFrames);
+  mLosslessVerifier.Push(inBuf, framesToProcess);
 
   // Accumulate decoded samples into buffer (absorbs bursty pipeline)
-  for (int i = 0; i < decodedFrames * numCh; i++)
-    mDecodedBuffer.push_back(outBuf[i]);
+  AccumulateDecoded(mDecodedBuffer, outBuf, decodedFrames, numCh);
+  if (mPreRollDropFrames > 0)
+    mPreRollDropFrames -= static_cast<int64_t>(DropDecoded(mDecodedBuffer, static_cast<size_t>(mPreRollDropFrames), numCh));
 
-  // Output from accumulation buffer
-  const size_t availableFrames = mDecodedBuffer.size() / numCh;
-  const size_t framesToOutput = std::min(availableFrames, static_cast<size_t>(framesToProcess));
+  // Output from accumulation buffer (mono is duplicated to L and R)
+  const size_t framesToOutput = DrainToHostBlock(mDecodedBuffer, outputs, nOutChans, framesToProcess, numCh);
+  // Remaining samples (framesToOutput..framesToProcess) stay zeroed from the initial clear
 
-  if (numCh == 1)
+  // Underrun: a short block once the pipeline has delivered a full one (start-up fill is not counted)
+  if (framesToOutput == static_cast<size_t>(framesToProcess))
+    mOutputPrimed = true;
+  else if (mOutputPrimed)
   {
-    // Mono output: duplicate to both L and R channels
-    for (size_t s = 0; s < framesToOutput; s++)
-    {
-      float M = mDecodedBuffer.front(); mDecodedBuffer.pop_front();
-      if (nOutChans > 0) outputs[0][s] = static_cast<sample>(M);
-      if (nOutChans > 1) outputs[1][s] = static_cast<sample>(M);
-    }
+    PipelineMetrics::Add(mMetrics->underruns, 1);
+    PipelineMetrics::Add(mMetrics->underrunFrames, framesToProcess - framesToOutput);
   }
-  else
-  {
-    // Stereo output: de-interleave L/R
-    for (size_t s = 0; s < framesToOutput; s++)
-    {
-      float L = mDecodedBuffer.front(); mDecodedBuffer.pop_front();
-      float R = mDecodedBuffer.front(); mDecodedBuffer.pop_front();
-      if (nOutChans > 0) outputs[0][s] = static_cast<sample>(L);
-      if (nOutChans > 1) outputs[1][s] = static_cast<sample>(R);
-    }
-  }
-  // Remaining samples (framesToOutput..framesToProcess) stay zeroed from the initial clear
+  PipelineMetrics::Set(mMetrics->decodedBufferFrames, mDecodedBuffer.size() / numCh);
+  CODECSIM_TRACE_COUNTER("DecodedBufferFrames", mDecodedBuffer.size() / numCh);
 
   // Early diagnostic: log actual output values
   if (earlyLog && framesToOutput > 0 && nOutChans > 0)
   {
-    DebugLogCodecSim("  OUT: frames=" + std::to_string(framesToOutput) +
-                     " L[0]=" + std::to_string(outputs[0][0]) +
-                     (nOutChans > 1 ? " R[0]=" + std::to_string(outputs[1][0]) : ""));
+    CODECSIM_LOG_RT(LogLevel::Trace, "CodecSim", "  OUT: frames=%lld L[0]=%lld R[0]=%lld (x1e-6)",
+                    framesToOutput, std::lround(outputs[0][0] * 1e6),
+                    std::lround(outputs[nOutChans > 1 ? 1 : 0][0] * 1e6));
   }
 
   // Debug: periodic logging of buffer state (every ~1 second at 48kHz/64 block size)
@@ -1165,15 +1494,14 @@ void CodecSim::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
   if (++dbgCounter >= 750)
   {
     dbgCounter = 0;
-    DebugLogCodecSim("ProcessBlock: nFrames=" + std::to_string(nFrames) +
-                     " decoded=" + std::to_string(decodedFrames) +
-                     " bufSize=" + std::to_string(mDecodedBuffer.size() / mNumChannels) +
-                     " output=" + std::to_string(framesToOutput));
+    CODECSIM_LOG_RT(LogLevel::Debug, "CodecSim", "ProcessBlock: nFrames=%lld decoded=%lld bufSize=%lld output=%lld",
+                    nFrames, decodedFrames, mDecodedBuffer.size() / mNumChannels, framesToOutput);
   }
 }
 
-void CodecSim::InitializeCodec(int codecIndex)
+void CodecSim::InitializeCodec(int codecIndex, int numChannels)
 {
+  CODECSIM_TRACE_SCOPE_VALUE("InitializeCodec", codecIndex);
   std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
 
   if (mIsInitializing) {
@@ -1189,7 +1517,17 @@ void CodecSim::InitializeCodec(int codecIndex)
     mCodecProcessor.reset();
   }
 
+  // Nothing is running any more: the new pipeline's parameters can take over
+  mNumChannels = numChannels;
   mDecodedBuffer.clear();
+  mPreRollDropFrames = 0;
+  mQualityAnalyzer.Stop();
+  mCodecInputFrames = 0;
+  mCodecDecodedFrames = 0;
+  mParked = false;
+  mSilentFrames = 0;
+  mOutputPrimed = false;
+  PipelineMetrics::Set(mMetrics->decodedBufferFrames, 0);
 
   const CodecInfo* codecInfo = CodecRegistry::Instance().GetAvailableByIndex(codecIndex);
   if (!codecInfo)
@@ -1199,51 +1537,140 @@ void CodecSim::InitializeCodec(int codecIndex)
     return;
   }
 
-  auto processor = std::make_unique<GenericCodecProcessor>(*codecInfo);
+  int bitrateKbps = GetEffectiveBitrate();
+  mMetricsPublisher->SetStream(std::string(codecInfo->id), mSampleRate, mNumChannels);
 
-  // Connect log callback
-  processor->SetLogCallback([this](const std::string& msg) {
-    AddLogMessage("[ffmpeg] " + msg);
-  });
+  // In-process codec first (no processes, no latency); the ffmpeg pipeline is the fallback
+  bool started = false;
+  mLosslessVerifier.Stop();
+  std::unique_ptr<ICodecProcessor> processor =
+    CreateNativeCodecProcessor(*codecInfo, mCodecOptionValues, bitrateKbps, mSampleRate);
+  if (processor)
+  {
+    processor->SetLogCallback([this](const std::string& msg) { AddLogMessage(msg); });
+    started = processor->Initialize(mSampleRate, mNumChannels);
+    if (!started)
+      AddLogMessage("WARNING: native " + std::string(codecInfo->displayName) + " failed to start, using ffmpeg");
+  }
 
-  // Set bitrate from UI
-  int bitrateKbps = GetEffectiveBitrate();
-  if (!codecInfo->isLossless)
-    processor->SetBitrate(bitrateKbps);
+  if (!started)
+  {
+    auto pipeline = std::make_unique<GenericCodecProcessor>(*codecInfo);
+
+    // Connect log callback
+    pipeline->SetLogCallback([this](const std::string& msg) {
+      AddLogMessage("[ffmpeg] " + msg);
+    });
+
+    // Set bitrate from UI
+    if (!codecInfo->isLossless)
+      pipeline->SetBitrate(bitrateKbps);
 
-  // Apply codec-specific options
-  processor->SetAdditionalArgs(BuildCurrentAdditionalArgs());
+    // Apply codec-specific options
+    pipeline->SetAdditionalArgs(BuildCurrentAdditionalArgs());
+    pipeline->SetSharedWorker(UseSharedWorkers());
+    pipeline->SetOfflineMode(mOfflineMode.load());
+    pipeline->SetMetrics(mMetrics);
+    WatchdogConfig watchdog;
+    watchdog.enabled = true;  // Ignored for offline renders
+    pipeline->SetWatchdog(watchdog);
 
-  // Initialize (launches ffmpeg processes)
-  if (processor->Initialize(mSampleRate, mNumChannels))
+    // Initialize (launches ffmpeg processes)
+    started = pipeline->Initialize(mSampleRate, mNumChannels);
+    processor = std::move(pipeline);
+  }
+
+  if (started)
   {
-    int latency = processor->GetLatencySamples();
+    // A synchronous processor has nothing in flight to hold back for
+    mOfflineHoldback = (mOfflineMode.load() && !processor->IsSynchronous())
+                         ? OfflineHoldbackFrames(*codecInfo, mSampleRate) : 0;
+    int latency = processor->GetLatencySamples() + mOfflineHoldback;
     if (latency != mLatencySamples.load())
     {
       SetLatency(latency);
+      SetTailSize(latency);  // Host keeps rendering until the delayed signal is out
       mLatencySamples.store(latency);
     }
 
+    // Offline: output frame n is decoded frame n - holdback
+    mDecodedBuffer.assign(static_cast<size_t>(mOfflineHoldback) * mNumChannels, 0.f);
+
+    // Passthrough skips the real encoder; optionally run it in the background for its size
+    const bool passthrough = dynamic_cast<LosslessPassthroughProcessor*>(processor.get()) != nullptr;
+    if (passthrough && GetCodecOptionValue(*codecInfo, mCodecOptionValues, "lossless_verify") != 0 &&
+        !mLosslessVerifier.Start(FFmpegPipeManager::ResolveFFmpegPath(), *codecInfo, BuildCurrentAdditionalArgs(),
+                                 mSampleRate, mNumChannels))
+      AddLogMessage("WARNING: size verification unavailable: " + mLosslessVerifier.GetLastError());
+
     const int maxFrames = 8192;
     mInterleavedInput.resize(maxFrames * mNumChannels);
     mInterleavedOutput.resize(maxFrames * mNumChannels);
+    mAppliedOptionValues = mCodecOptionValues;
 
-    AddLogMessage("Started: " + codecInfo->displayName +
+    const char* kind = passthrough ? " (passthrough)" : processor->IsSynchronous() ? " (native)" : "";
+    AddLogMessage("Started: " + std::string(codecInfo->displayName) + kind +
                  " @ " + (codecInfo->isLossless ? "lossless" : std::to_string(bitrateKbps) + "kbps") +
                  ", " + std::to_string(mSampleRate) + "Hz");
   }
   else
   {
-    AddLogMessage("ERROR: Failed to start " + codecInfo->displayName);
+    AddLogMessage("ERROR: Failed to start " + std::string(codecInfo->displayName));
   }
 
   mCodecProcessor = std::move(processor);
+  UpdateQualityAnalyzer();
   mIsInitializing = false;
   DebugLogCodecSim("InitializeCodec END");
 }
 
+void CodecSim::PushQualityStreams(const float* input, int inputFrames, const float* decoded, int decodedFrames)
+{
+  mCodecInputFrames += inputFrames;
+  mCodecDecodedFrames += decodedFrames;
+  if (!mQualityAnalyzer.IsRunning())
+    return;
+  mQualityAnalyzer.PushReference(input, inputFrames);
+  mQualityAnalyzer.PushDecoded(decoded, decodedFrames);
+}
+
+void CodecSim::UpdateQualityAnalyzer()
+{
+  // Caller holds mCodecMutex (serializes Start/Stop with the audio thread's pushes)
+  const bool wanted = mQualityWanted.load() && mCodecProcessor && mCodecProcessor->IsInitialized();
+  if (wanted == mQualityAnalyzer.IsRunning())
+    return;
+  if (!wanted)
+  {
+    mQualityAnalyzer.Stop();
+    return;
+  }
+
+  // Scores the codec's own streams, so the hold-back does not enter the alignment.
+  // Started mid-stream, the frames still in flight shift decoded against input.
+  const int64_t inFlight = mCodecInputFrames - mCodecDecodedFrames;
+  mQualityAnalyzer.Start(mSampleRate, mNumChannels,
+                         mCodecProcessor->GetLatencySamples() + static_cast<int>(inFlight));
+}
+
+void CodecSim::SetParkAfterSeconds(double seconds)
+{
+  std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
+  mParkAfterSeconds = std::max(0.0, seconds);
+  mSilentFrames = 0;
+  if (mParked && mParkAfterSeconds == 0.0)
+  {
+    // ProcessBlock no longer looks at the park state: wake the pipeline here
+    mParked = false;
+    mOutputPrimed = false;
+    if (mCodecProcessor)
+      mCodecProcessor->SetParked(false);
+  }
+}
+
 void CodecSim::StopCodec()
 {
+  CODECSIM_TRACE_SCOPE("StopCodec");
   std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
 
   if (mCodecProcessor) {
@@ -1252,64 +1679,131 @@ void CodecSim::StopCodec()
   }
 
   mDecodedBuffer.clear();
+  mQualityAnalyzer.Stop();
+  mLosslessVerifier.Stop();
 
   AddLogMessage("Codec stopped.");
 }
 
 void CodecSim::ApplyCodecSettings()
 {
-  mPendingApply.store(false);
-  DebugLogCodecSim("ApplyCodecSettings called");
-
-  // Cancel previous init wait and join thread quickly
-  mCancelInit.store(true);
-  if (mInitThread.joinable())
-    mInitThread.join();
-  mCancelInit.store(false);
+  CODECSIM_TRACE_SCOPE("Apply");
+  std::lock_guard<std::recursive_mutex> threadLock(mThreadMutex);
+  // An explicit Apply supersedes a pending lazy start
+  CancelLazyStart();
 
-  mInitializing.store(true);
-
-  // Start spinner immediately
-  if (GetUI())
+  if (ApplyToRunningPipeline())
   {
-    if (IControl* pSpinner = GetUI()->GetControlWithTag(kCtrlTagSpinner))
-      dynamic_cast<SpinnerOverlayControl*>(pSpinner)->StartSpinning();
+    mPendingApply.store(false);
+    PostUiEvents(kUiEventPendingApply);
+    return;
   }
 
-  mCurrentCodecIndex = GetParam(kParamCodec)->Int();
+  // Start spinner immediately
+  if (GetUI() && mUi.spinner)
+    mUi.spinner->StartSpinning();
 
-  // Update channel count from parameter
-  {
-    int channelMode = GetParam(kParamChannels)->Int();
-    mNumChannels = (channelMode == 0) ? 2 : 1;
-    const CodecInfo* applyInfo = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
-    if (applyInfo && applyInfo->monoOnly)
-      mNumChannels = 1;
-  }
+  StartPipeline();
+}
 
-#ifdef CODECSIM_TRIAL
+bool CodecSim::ApplyToRunningPipeline()
+{
+  // A start in flight and offline renders always get a fresh pipeline
+  if (mInitializing.load() || mOfflineMode.load())
+    return false;
+
+  // The candidate settings are only compared against the running pipeline;
+  // nothing it or ProcessBlock uses changes unless they apply in place
+  int codecIndex, numChannels;
+  ResolveCodecFromParams(codecIndex, numChannels);
+  const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(codecIndex);
+  const int bitrateKbps = GetEffectiveBitrate();
+
+  std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
+#if CODECSIM_HAS_LIBOPUS
+  // libopus takes bitrate, VBR mode and complexity between two frames
+  if (auto* opus = dynamic_cast<LibOpusProcessor*>(mCodecProcessor.get()))
   {
-    const CodecInfo* checkInfo = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
-    if (checkInfo && checkInfo->id != "mp3")
+    if (!info || !opus->IsInitialized() || opus->GetCodecInfo().id != info->id)
+      return false;
+    if (!opus->ApplySettings(mSampleRate, numChannels, bitrateKbps, mCodecOptionValues))
     {
-      int mp3Index = CodecRegistry::Instance().GetAvailableIndexById("mp3");
-      if (mp3Index >= 0)
-      {
-        mCurrentCodecIndex = mp3Index;
-        GetParam(kParamCodec)->Set(mp3Index);
-        SendParameterValueFromDelegate(kParamCodec,
-          GetParam(kParamCodec)->ToNormalized(static_cast<double>(mp3Index)), false);
-        UpdateBitrateForCodec(mp3Index);
-      }
+      AddLogMessage("Apply: respawn (libopus frame duration, application or format)");
+      return false;
     }
+    AddLogMessage("Apply: in-place (libopus, " + std::to_string(bitrateKbps) + " kbps)");
+    mAppliedOptionValues = mCodecOptionValues;
+    return true;
   }
 #endif
+  auto* processor = dynamic_cast<GenericCodecProcessor*>(mCodecProcessor.get());
+  if (!info || !processor || !processor->IsInitialized())
+    return false;
+  if (processor->GetCodecInfo().id != info->id)
+  {
+    AddLogMessage("Apply: respawn (codec " + std::string(processor->GetCodecInfo().id) + " -> " +
+                  std::string(info->id) + ")");
+    return false;
+  }
+  if (HasNativeProcessor(*info, mCodecOptionValues, mSampleRate))
+  {
+    AddLogMessage("Apply: respawn (in-process " + std::string(info->id) + ")");
+    return false;
+  }
+
+  const std::string args = BuildCodecArgs(*info, mCodecOptionValues);
+  const PipelineConfigDiff diff =
+    processor->PreviewUpdate(mSampleRate, numChannels, info->isLossless ? 0 : bitrateKbps, args);
+
+  std::string message = "Apply: " + diff.Describe();
+  const auto options = DiffCodecOptions(*info, mAppliedOptionValues, mCodecOptionValues);
+  for (size_t i = 0; i < options.size(); ++i)
+    message += (i == 0 ? " [options: " : ", ") + options[i] + (i + 1 == options.size() ? "]" : "");
+  AddLogMessage(message);
+
+  if (diff.change == ConfigChange::Respawn)
+    return false;  // StartPipeline builds a new processor with these settings
+
+  // All changes in one transaction, known not to respawn
+  processor->BeginUpdate();
+  processor->SetSampleRate(mSampleRate);
+  processor->SetChannels(numChannels);
+  if (!info->isLossless)
+    processor->SetBitrate(bitrateKbps);
+  processor->SetAdditionalArgs(args);
+  processor->CommitUpdate(false);
+  mNumChannels = numChannels;
+  mAppliedOptionValues = mCodecOptionValues;
+  return true;
+}
+
+void CodecSim::StartPipeline()
+{
+  mPendingApply.store(false);
+  PostUiEvents(kUiEventPendingApply);
+  DebugLogCodecSim("StartPipeline called");
+  std::lock_guard<std::recursive_mutex> threadLock(mThreadMutex);
+
+  // Cancel previous init wait and join thread quickly
+  mCancelInit.store(true);
+  if (mInitThread.joinable())
+    mInitThread.join();
+  mCancelInit.store(false);
+
+  mInitializing.store(true);
+  PostUiEvents(kUiEventInitializing);
+
+  EnforceTrialCodec();
+  int codecIndex, numChannels;
+  ResolveCodecFromParams(codecIndex, numChannels);
 
   AddLogMessage("Applying codec settings...");
 
-  mInitThread = std::thread([this, codecIdx = mCurrentCodecIndex]() {
-    InitializeCodec(codecIdx);
+  mInitThread = std::thread([this, codecIndex, numChannels]() {
+    CODECSIM_TRACE_THREAD_NAME("codec-init");
+    InitializeCodec(codecIndex, numChannels);
     // Wait for first decoded audio output (cancellable)
+    CODECSIM_TRACE_SCOPE("WaitFirstAudio");
     auto start = std::chrono::steady_clock::now();
     while (!mCancelInit.load())
     {
@@ -1323,9 +1817,245 @@ void CodecSim::ApplyCodecSettings()
       std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
     mInitializing.store(false);
+    PostUiEvents(kUiEventInitializing);
+  });
+}
+
+void CodecSim::ResolveCodecFromParams(int& codecIndex, int& numChannels)
+{
+  codecIndex = GetParam(kParamCodec)->Int();
+
+#ifdef CODECSIM_TRIAL
+  {
+    const CodecInfo* checkInfo = CodecRegistry::Instance().GetAvailableByIndex(codecIndex);
+    int mp3Index = CodecRegistry::Instance().GetAvailableIndexById("mp3");
+    if (checkInfo && checkInfo->id != "mp3" && mp3Index >= 0)
+      codecIndex = mp3Index;
+  }
+#endif
+
+  const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(codecIndex);
+  numChannels = (GetParam(kParamChannels)->Int() == 0) ? 2 : 1;
+  if (info && info->monoOnly)
+    numChannels = 1;
+}
+
+void CodecSim::EnforceTrialCodec()
+{
+#ifdef CODECSIM_TRIAL
+  const CodecInfo* checkInfo = CodecRegistry::Instance().GetAvailableByIndex(GetParam(kParamCodec)->Int());
+  if (checkInfo && checkInfo->id != "mp3")
+  {
+    int mp3Index = CodecRegistry::Instance().GetAvailableIndexById("mp3");
+    if (mp3Index >= 0)
+    {
+      mCurrentCodecIndex = mp3Index;
+      GetParam(kParamCodec)->Set(mp3Index);
+      SendParameterValueFromDelegate(kParamCodec,
+        GetParam(kParamCodec)->ToNormalized(static_cast<double>(mp3Index)), false);
+      UpdateBitrateForCodec(mp3Index);
+    }
+  }
+#endif
+}
+
+void CodecSim::SetOfflineMode(bool offline)
+{
+  // Nested call from SetLatency -> OnReset while this thread rebuilds the
+  // pipeline. A rebuild on another thread is waited for (it holds the lock).
+  {
+    std::lock_guard<std::recursive_mutex> lock(mCodecMutex);
+    if (mIsInitializing)
+      return;
+  }
+
+  std::lock_guard<std::recursive_mutex> threadLock(mThreadMutex);
+  const bool wasOffline = mOfflineMode.exchange(offline);
+  if (!offline && !wasOffline)
+    return;
+
+  DebugLogCodecSim(std::string("SetOfflineMode: ") + (offline ? "offline" : "realtime"));
+
+  // Pending lazy starts and init waits would race the restart below
+  CancelLazyStart();
+  mCancelInit.store(true);
+  if (mInitThread.joinable())
+    mInitThread.join();
+  mCancelInit.store(false);
+
+  if (offline)
+  {
+    // Every bounce starts from a fresh pipeline so the timeline begins at zero.
+    // Synchronous on purpose: nothing may be rendered before the pipeline is up.
+    AddLogMessage("Offline render: blocking, sample-exact pipeline");
+    mOfflineStarvedBlocks = 0;
+    EnforceTrialCodec();
+    int codecIndex, numChannels;
+    ResolveCodecFromParams(codecIndex, numChannels);
+    InitializeCodec(codecIndex, numChannels);
+  }
+  else
+  {
+    AddLogMessage("Realtime playback: streaming pipeline");
+    StartPipeline();
+  }
+}
+
+void CodecSim::RenderModeThread()
+{
+  CODECSIM_TRACE_THREAD_NAME("render-mode");
+  while (!mRenderModeStop.load())
+  {
+    int request;
+    {
+      std::unique_lock<std::mutex> lock(mRenderModeMutex);
+      // Timeout covers a notify lost to the lock-free store in ProcessBlock
+      mRenderModeCv.wait_for(lock, std::chrono::milliseconds(50),
+                             [this]() { return mRenderModeStop.load() || mRenderModeRequest.load() >= 0; });
+      request = mRenderModeRequest.load();
+    }
+    if (mRenderModeStop.load() || request < 0)
+      continue;
+
+    SetOfflineMode(request == 1);
+    {
+      // A newer request (the host flipped back meanwhile) stays pending
+      std::lock_guard<std::mutex> lock(mRenderModeMutex);
+      mRenderModeRequest.compare_exchange_strong(request, -1);
+    }
+    mRenderModeCv.notify_all();
+  }
+}
+
+//==============================================================================
+// Lazy Pipeline Start
+//==============================================================================
+
+void CodecSim::ArmLazyStart()
+{
+  std::lock_guard<std::recursive_mutex> threadLock(mThreadMutex);
+  mLazyStartRequested.store(false);
+  mLazyStartCancel.store(false);
+  mLazyStartArmed.store(true);
+  if (kLazyPipelineStart)
+    AddLogMessage("Waiting for audio (pipeline starts on first signal)");
+
+  // Parked thread: no processes exist until a start is requested and the state is settled
+  mLazyStartThread = std::thread([this]() {
+    CODECSIM_TRACE_THREAD_NAME("lazy-start");
+    const auto graceEnd = mConstructedTime + std::chrono::milliseconds(kRestoreGraceMs);
+    {
+      std::unique_lock<std::mutex> lock(mLazyStartMutex);
+      while (!mLazyStartCancel.load() &&
+             !(mLazyStartRequested.load() &&
+               (mStateRestored.load() || std::chrono::steady_clock::now() >= graceEnd)))
+        mLazyStartCv.wait_for(lock, std::chrono::milliseconds(50)); // timeout covers a lost notify and the grace end
+    }
+    mLazyStartArmed.store(false);
+
+    // Whoever holds the thread lock may be cancelling (and joining) this thread
+    std::unique_lock<std::recursive_mutex> threadLock(mThreadMutex, std::defer_lock);
+    while (!mLazyStartCancel.load() && !threadLock.try_lock())
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    if (mLazyStartCancel.load())
+      return;
+
+    DebugLogCodecSim("Lazy start: starting pipeline");
+    StartPipeline();
   });
 }
 
+void CodecSim::RequestLazyStart()
+{
+  // Called from the audio thread: no locks, no allocation
+  if (!mLazyStartArmed.load(std::memory_order_relaxed))
+    return;
+  mLazyStartRequested.store(true);
+  mLazyStartCv.notify_one();
+}
+
+void CodecSim::CancelLazyStart()
+{
+  // Caller holds mThreadMutex
+  mLazyStartCancel.store(true);
+  mLazyStartCv.notify_one();
+  if (mLazyStartThread.joinable())
+    mLazyStartThread.join();
+  mLazyStartArmed.store(false);
+}
+
+void CodecSim::CapturePreRoll(sample** inputs, int nInChans, int nFrames)
+{
+  // Stored as stereo interleaved in a ring: on overflow the oldest frames go,
+  // so what is fed is always the most recent, contiguous stretch of input
+  for (int s = 0; s < nFrames; s++)
+  {
+    float* dst = mPreRollBuffer.data() + mPreRollWrite * 2;
+    dst[0] = (nInChans > 0) ? static_cast<float>(inputs[0][s]) : 0.f;
+    dst[1] = (nInChans > 1) ? static_cast<float>(inputs[1][s]) : dst[0];
+    mPreRollWrite = (mPreRollWrite + 1) % kPreRollMaxFrames;
+  }
+  mPreRollFrames = std::min(mPreRollFrames + nFrames, kPreRollMaxFrames);
+}
+
+void CodecSim::FeedPreRoll()
+{
+  // Caller holds mCodecMutex and the processor is initialized.
+  //
+  // The captured input only warms the codec up: the host has already played
+  // those blocks (as silence), so their decoded frames are discarded, now or as
+  // they arrive (mPreRollDropFrames). Keeping them would delay everything after
+  // by the pre-roll length on top of the reported latency, and PDC would be off.
+  const int maxFrames = 8192;
+  const int numCh = mNumChannels;
+  float* inBuf = mInterleavedInput.data();
+  float* outBuf = mInterleavedOutput.data();
+  const int start = (mPreRollWrite - mPreRollFrames + kPreRollMaxFrames) % kPreRollMaxFrames;
+
+  for (int offset = 0, chunk = 0; offset < mPreRollFrames; offset += chunk)
+  {
+    // Chunks stop at the ring's end so each one is contiguous
+    const int position = (start + offset) % kPreRollMaxFrames;
+    chunk = std::min({maxFrames, mPreRollFrames - offset, kPreRollMaxFrames - position});
+    const float* src = mPreRollBuffer.data() + position * 2;
+    if (numCh == 1)
+    {
+      for (int s = 0; s < chunk; s++)
+        inBuf[s] = (src[s * 2] + src[s * 2 + 1]) * 0.5f;
+    }
+    else
+    {
+      std::copy(src, src + chunk * 2, inBuf);
+    }
+
+    int decodedFrames = mCodecProcessor->Process(inBuf, chunk, outBuf, maxFrames);
+    PushQualityStreams(inBuf, chunk, outBuf, decodedFrames);
+    mLosslessVerifier.Push(inBuf, chunk);
+    AccumulateDecoded(mDecodedBuffer, outBuf, decodedFrames, numCh);
+  }
+  mPreRollDropFrames = mPreRollFrames - static_cast<int64_t>(DropDecoded(mDecodedBuffer, mPreRollFrames, numCh));
+  mPreRollFrames = 0;
+  mPreRollWrite = 0;
+}
+
+#if IPLUG_EDITOR
+void CodecSim::OnUIOpen()
+{
+  Plugin::OnUIOpen();
+  mLogShownGeneration = UINT64_MAX;  // Fresh controls: rebuild the log text
+  // Opening the editor counts as intent to listen: start the pipeline now
+  RequestLazyStart();
+}
+
+void CodecSim::OnUIClose()
+{
+  // The controls are destroyed with the editor
+  mUi = UiBinding();
+  mLastApplyButtonState = -1;
+  Plugin::OnUIClose();
+}
+#endif
+
 void CodecSim::UpdateBitrateForCodec(int codecIndex)
 {
   const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(codecIndex);
@@ -1339,35 +2069,20 @@ void CodecSim::UpdateBitrateForCodec(int codecIndex)
   {
     // Lossless codec: no bitrate control needed
     // UI hiding handled in OnIdle
-    DebugLogCodecSim("UpdateBitrateForCodec: " + info->displayName + " is lossless, hiding bitrate");
+    DebugLogCodecSim("UpdateBitrateForCodec: " + std::string(info->displayName) + " is lossless, hiding bitrate");
   }
   else if (info->minBitrate == info->maxBitrate)
   {
     // Fixed bitrate: single option only
-    mCurrentBitratePresets.push_back(info->minBitrate);
-    DebugLogCodecSim("UpdateBitrateForCodec: " + info->displayName + " fixed at " + std::to_string(info->minBitrate) + " kbps");
+    mCurrentBitratePresets = GetBitrateLadder(*info);
+    DebugLogCodecSim("UpdateBitrateForCodec: " + std::string(info->displayName) + " fixed at " + std::to_string(info->minBitrate) + " kbps");
   }
   else
   {
-    // Variable bitrate: filter global presets to valid range
-    for (int i = 0; i < kNumBitratePresets; i++)
-    {
-      if (kBitratePresets[i] >= info->minBitrate && kBitratePresets[i] <= info->maxBitrate)
-        mCurrentBitratePresets.push_back(kBitratePresets[i]);
-    }
-    // Ensure default bitrate is in the list
-    bool hasDefault = false;
-    for (int bp : mCurrentBitratePresets)
-    {
-      if (bp == info->defaultBitrate) { hasDefault = true; break; }
-    }
-    if (!hasDefault && info->defaultBitrate > 0)
-    {
-      mCurrentBitratePresets.push_back(info->defaultBitrate);
-      std::sort(mCurrentBitratePresets.begin(), mCurrentBitratePresets.end());
-    }
+    // Variable bitrate: global presets within the valid range, plus the default
+    mCurrentBitratePresets = GetBitrateLadder(*info);
     mCurrentCodecHasOther = true;
-    DebugLogCodecSim("UpdateBitrateForCodec: " + info->displayName + " range " +
+    DebugLogCodecSim("UpdateBitrateForCodec: " + std::string(info->displayName) + " range " +
                      std::to_string(info->minBitrate) + "-" + std::to_string(info->maxBitrate) +
                      " kbps, " + std::to_string(mCurrentBitratePresets.size()) + " presets");
   }
@@ -1434,7 +2149,6 @@ void CodecSim::UpdateChannelSelectorForCodec(int codecIndex)
   if (info->monoOnly)
   {
     // Force mono for mono-only codec
-    mNumChannels = 1;
     GetParam(kParamChannels)->Set(1);
     SendParameterValueFromDelegate(kParamChannels,
       GetParam(kParamChannels)->ToNormalized(1.0), false);
@@ -1442,13 +2156,10 @@ void CodecSim::UpdateChannelSelectorForCodec(int codecIndex)
 
   // Enable/disable the UI control
   IGraphics* pUI = GetUI();
-  if (pUI)
+  if (pUI && mUi.channelSelector)
   {
-    if (IControl* pChannelCtrl = pUI->GetControlWithTag(kCtrlTagChannelSelector))
-    {
-      pChannelCtrl->SetDisabled(info->monoOnly);
-      pChannelCtrl->SetDirty(false);
-    }
+    mUi.channelSelector->SetDisabled(info->monoOnly);
+    mUi.channelSelector->SetDirty(false);
   }
 }
 
@@ -1460,6 +2171,14 @@ void CodecSim::SetDetailTab(int tabIndex)
 
   bool showOptions = (tabIndex == 0);
   bool showLog = (tabIndex == 1);
+  bool showMetrics = (tabIndex == 2);
+
+  // Keep the switch in step when the tab comes from restored state
+  if (mUi.tabSwitch && static_cast<int>(mUi.tabSwitch->GetValue() * 2.0 + 0.5) != tabIndex)
+  {
+    mUi.tabSwitch->SetValue(tabIndex / 2.0);
+    mUi.tabSwitch->SetDirty(false);
+  }
 
   // Get current codec options count
   const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
@@ -1480,8 +2199,28 @@ void CodecSim::SetDetailTab(int tabIndex)
     p->Hide(!showOptions || numOptions > 0);
 
   // Show/hide log
-  if (IControl* p = pUI->GetControlWithTag(kCtrlTagLogDisplay))
-    p->Hide(!showLog);
+  if (mUi.logDisplay)
+    mUi.logDisplay->Hide(!showLog);
+  if (showLog)
+    mLogShownGeneration = UINT64_MAX;  // Rebuild on the next idle tick
+
+  // Show/hide metrics
+  if (mUi.metricsDisplay)
+    mUi.metricsDisplay->Hide(!showMetrics);
+  if (IControl* p = pUI->GetControlWithTag(kCtrlTagTraceSaveButton))
+    p->Hide(!showMetrics);
+  if (IControl* p = pUI->GetControlWithTag(kCtrlTagParkSelector))
+  {
+    // Also brings the selector in step with a restored state
+    int parkIdx = 0;
+    for (int i = 0; i < kNumParkAfterChoices; i++)
+    {
+      if (std::abs(kParkAfterChoices[i] - mParkAfterSeconds) < std::abs(kParkAfterChoices[parkIdx] - mParkAfterSeconds))
+        parkIdx = i;
+    }
+    p->SetValue(static_cast<double>(parkIdx) / (kNumParkAfterChoices - 1));
+    p->Hide(!showMetrics);
+  }
 }
 
 void CodecSim::UpdateOptionsForCodec(int codecIndex)
@@ -1490,11 +2229,11 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
   if (!info) return;
 
   // Set defaults only for keys not already present (preserves loaded/saved values)
-  std::map<std::string, int> newValues;
+  std::map<std::string, int, std::less<>> newValues;
   for (const auto& opt : info->options)
   {
     auto it = mCodecOptionValues.find(opt.key);
-    newValues[opt.key] = (it != mCodecOptionValues.end()) ? it->second : opt.defaultValue;
+    newValues[std::string(opt.key)] = (it != mCodecOptionValues.end()) ? it->second : opt.defaultValue;
   }
   mCodecOptionValues = newValues;
 
@@ -1530,7 +2269,7 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
       if (IControl* pLabel = pGraphics->GetControlWithTag(labelTag))
       {
         if (auto* pText = dynamic_cast<ITextControl*>(pLabel))
-          pText->SetStr(opt.label.c_str());
+          pText->SetStr(opt.label.data());
       }
 
       // Remove old control and create new one
@@ -1574,7 +2313,7 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
         {
           auto* pToggle = new IVToggleControl(ctrlBounds, kNoParameter, "", optStyle, "Off", "On");
           pToggle->SetValue(opt.defaultValue != 0 ? 1.0 : 0.0);
-          pToggle->SetActionFunction([this, key = opt.key](IControl* pCaller) {
+          pToggle->SetActionFunction([this, key = std::string(opt.key)](IControl* pCaller) {
             mCodecOptionValues[key] = pCaller->GetValue() > 0.5 ? 1 : 0;
           });
           pNewCtrl = pToggle;
@@ -1587,12 +2326,12 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
             // Tab switch for few choices
             std::vector<const char*> labels;
             for (const auto& c : opt.choices)
-              labels.push_back(c.label.c_str());
+              labels.push_back(c.label.data());
 
             auto* pTabs = new IVTabSwitchControl(ctrlBounds, kNoParameter, labels, "", optStyle);
             if (!opt.choices.empty())
               pTabs->SetValue(static_cast<double>(opt.defaultValue) / static_cast<double>(std::max(1, (int)opt.choices.size() - 1)));
-            pTabs->SetActionFunction([this, key = opt.key](IControl* pCaller) {
+            pTabs->SetActionFunction([this, key = std::string(opt.key)](IControl* pCaller) {
               if (auto* pSwitch = dynamic_cast<ISwitchControlBase*>(pCaller))
                 mCodecOptionValues[key] = pSwitch->GetSelectedIdx();
             });
@@ -1602,14 +2341,14 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
           {
             // Dropdown menu for many choices (IVButtonControl + IPopupMenu)
             auto choices = opt.choices;
-            std::string defaultLabel = (opt.defaultValue >= 0 && opt.defaultValue < static_cast<int>(choices.size()))
-              ? choices[opt.defaultValue].label : choices[0].label;
+            std::string defaultLabel((opt.defaultValue >= 0 && opt.defaultValue < static_cast<int>(choices.size()))
+              ? choices[opt.defaultValue].label : choices[0].label);
 
             auto* pButton = new IVButtonControl(ctrlBounds,
               [this, key = opt.key, choices](IControl* pCaller) {
                 IPopupMenu menu;
                 for (const auto& c : choices)
-                  menu.AddItem(new IPopupMenu::Item(c.label.c_str()));
+                  menu.AddItem(new IPopupMenu::Item(c.label.data()));
 
                 menu.SetFunction([this, key, pCaller](IPopupMenu* pMenu) {
                   int idx = pMenu->GetChosenItemIdx();
@@ -1648,7 +2387,7 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
 
           auto* pNum = new IVNumberBoxControl(ctrlBounds, kNoParameter, nullptr, "", numStyle,
             true, opt.defaultValue, opt.minValue, opt.maxValue);
-          pNum->SetActionFunction([this, key = opt.key](IControl* pCaller) {
+          pNum->SetActionFunction([this, key = std::string(opt.key)](IControl* pCaller) {
             if (auto* pNB = dynamic_cast<IVNumberBoxControl*>(pCaller))
             {
               // Map normalized value back to integer range
@@ -1681,10 +2420,9 @@ void CodecSim::UpdateOptionsForCodec(int codecIndex)
   // Ensure spinner overlay stays on top (AttachControl appends to end of draw list)
   if (IControl* pOldSpinner = pGraphics->GetControlWithTag(kCtrlTagSpinner))
     pGraphics->RemoveControl(pOldSpinner);
-  pGraphics->AttachControl(
-    new SpinnerOverlayControl(pGraphics->GetBounds(), IColor(120, 0, 0, 0), Colors::AccentBlue, 28.f, 4.f),
-    kCtrlTagSpinner
-  );
+  mUi.spinner = new SpinnerOverlayControl(pGraphics->GetBounds(), IColor(120, 0, 0, 0), Colors::AccentBlue, 28.f, 4.f);
+  pGraphics->AttachControl(mUi.spinner, kCtrlTagSpinner);
+  PostUiEvents(kUiEventInitializing);  // The new overlay starts hidden
 
   // Update tab visibility
   SetDetailTab(mDetailTabIndex);
@@ -1695,37 +2433,12 @@ std::string CodecSim::BuildCurrentAdditionalArgs()
   const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
   if (!info) return "";
 
-  std::string result = info->additionalArgs;
-
-  for (const auto& opt : info->options)
-  {
-    auto it = mCodecOptionValues.find(opt.key);
-    int val = (it != mCodecOptionValues.end()) ? it->second : opt.defaultValue;
-
-    switch (opt.type)
-    {
-      case CodecOptionType::Toggle:
-        result += " " + opt.argName + " " + std::to_string(val);
-        break;
-      case CodecOptionType::Choice:
-        if (val >= 0 && val < static_cast<int>(opt.choices.size()) && !opt.choices[val].argValue.empty())
-          result += " " + opt.argName + " " + opt.choices[val].argValue;
-        break;
-      case CodecOptionType::IntRange:
-        result += " " + opt.argName + " " + std::to_string(val);
-        break;
-    }
-  }
-
-  return result;
+  return BuildCodecArgs(*info, mCodecOptionValues);
 }
 
 void CodecSim::AddLogMessage(const std::string& msg)
 {
-  std::lock_guard<std::mutex> lock(mLogMutex);
-  mLogMessages.push_back(msg);
-  while (static_cast<int>(mLogMessages.size()) > kMaxLogLines)
-    mLogMessages.erase(mLogMessages.begin());
+  mLog.Push(msg);
 }
 
 //==============================================================================
@@ -1733,7 +2446,7 @@ void CodecSim::AddLogMessage(const std::string& msg)
 //==============================================================================
 
 static constexpr int kStateMagic = 0x43534D31; // 'CSM1'
-static constexpr int kStateVersion = 2;
+static constexpr int kStateVersion = 3;
 
 bool CodecSim::SerializeState(IByteChunk& chunk) const
 {
@@ -1751,7 +2464,7 @@ bool CodecSim::SerializeState(IByteChunk& chunk) const
 
   // Codec ID (for robust codec identification across different machines)
   const CodecInfo* info = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
-  std::string codecId = info ? info->id : "mp3";
+  std::string codecId = info ? std::string(info->id) : "mp3";
   chunk.PutStr(codecId.c_str());
 
   // Semantic values (not param indices, for robustness against dynamic param changes)
@@ -1780,6 +2493,10 @@ bool CodecSim::SerializeState(IByteChunk& chunk) const
   // UI state
   chunk.Put(&mDetailTabIndex);
 
+  // Pipeline settings (v3+)
+  int parkAfterMs = static_cast<int>(std::lround(mParkAfterSeconds * 1000.0));
+  chunk.Put(&parkAfterMs);
+
   return true;
 }
 
@@ -1825,12 +2542,7 @@ int CodecSim::UnserializeState(const IByteChunk& chunk, int startPos)
   DebugLogCodecSim("UnserializeState: codecId=" + codecId);
 
   // Find codec by ID in available list
-  auto available = CodecRegistry::Instance().GetAvailable();
-  int codecIndex = 0;
-  for (int i = 0; i < static_cast<int>(available.size()); i++)
-  {
-    if (available[i]->id == codecId) { codecIndex = i; break; }
-  }
+  int codecIndex = std::max(0, CodecRegistry::Instance().GetAvailableIndexById(codecId));
   mCurrentCodecIndex = codecIndex;
 
 #ifdef CODECSIM_TRIAL
@@ -1889,7 +2601,6 @@ int CodecSim::UnserializeState(const IByteChunk& chunk, int startPos)
     const CodecInfo* chInfo = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
     if (chInfo && chInfo->monoOnly) channelMode = 1;
     GetParam(kParamChannels)->Set(channelMode);
-    mNumChannels = (channelMode == 0) ? 2 : 1;
   }
   else
   {
@@ -1897,7 +2608,6 @@ int CodecSim::UnserializeState(const IByteChunk& chunk, int startPos)
     const CodecInfo* chInfo = CodecRegistry::Instance().GetAvailableByIndex(mCurrentCodecIndex);
     int channelMode = (chInfo && chInfo->monoOnly) ? 1 : 0;
     GetParam(kParamChannels)->Set(channelMode);
-    mNumChannels = (channelMode == 0) ? 2 : 1;
   }
 
   // Read codec option values
@@ -1923,6 +2633,15 @@ int CodecSim::UnserializeState(const IByteChunk& chunk, int startPos)
     pos = chunk.Get(&mDetailTabIndex, pos);
   }
 
+  // Read pipeline settings (v3+; older states keep the defaults)
+  int parkAfterMs = static_cast<int>(kDefaultParkAfterSeconds * 1000.0);
+  if (version >= 3)
+  {
+    pos = chunk.Get(&parkAfterMs, pos);
+    if (pos < 0) return pos;
+  }
+  SetParkAfterSeconds(std::max(0, parkAfterMs) / 1000.0);
+
   // Keep enabled (codec is always active)
   GetParam(kParamEnabled)->Set(1);
 
@@ -1936,6 +2655,20 @@ void CodecSim::OnRestoreState()
 {
   DebugLogCodecSim("OnRestoreState");
 
+  if (mLazyStartArmed.load())
+  {
+    // Project load: the pending first start picks up the restored settings
+    mStateRestored.store(true);
+    mLazyStartCv.notify_one();
+  }
+  else
+  {
+    // Restored after the pipeline came up (late restore, host preset): the
+    // config diff restarts it only if the restored settings differ
+    mStateRestored.store(true);
+    ApplyCodecSettings();
+  }
+
   // Update UI controls to reflect restored state
   SendCurrentParamValuesFromDelegate();
 
@@ -1946,15 +2679,15 @@ void CodecSim::OnRestoreState()
     UpdateChannelSelectorForCodec(mCurrentCodecIndex);
 
     // Refresh bitrate selector display
-    if (IControl* pCtrl = GetUI()->GetControlWithTag(kCtrlTagBitrateSelector))
+    if (mUi.bitrateSelector)
     {
       double normVal = GetParam(kParamBitrate)->ToNormalized(static_cast<double>(GetParam(kParamBitrate)->Int()));
-      pCtrl->SetValue(1.0 - normVal, 0);
-      pCtrl->SetValueFromUserInput(normVal, 0);
+      mUi.bitrateSelector->SetValue(1.0 - normVal, 0);
+      mUi.bitrateSelector->SetValueFromUserInput(normVal, 0);
     }
 
-    // Refresh tab state
-    SetDetailTab(mDetailTabIndex);
+    // Refresh bitrate text and tab state on the next idle tick
+    PostUiEvents(kUiEventBitrate | kUiEventTabChanged);
   }
 }
 
@@ -1991,36 +2724,22 @@ std::string CodecSim::GetAppDataPath()
 
 void CodecSim::SaveStandaloneState()
 {
-  std::string dir = GetAppDataPath();
-  std::string path = dir + "state.dat";
-  DebugLogCodecSim("SaveStandaloneState to " + path);
-
-  // Ensure directory exists
-#ifdef _WIN32
-  CreateDirectoryA(dir.c_str(), NULL);
-#else
-  // mkdir -p equivalent
-  system(("mkdir -p \"" + dir + "\"").c_str());
-#endif
+  // Never serializes or touches the filesystem here: this runs from host
+  // callbacks (possibly on the audio thread). The next OnIdle takes the snapshot.
+  mStateSavePending.store(true);
+}
 
+void CodecSim::SubmitStandaloneState()
+{
+  if (!mStatePersistence)
+    return;
   IByteChunk chunk;
   if (!SerializeState(chunk))
   {
-    DebugLogCodecSim("SaveStandaloneState: SerializeState failed");
+    DebugLogCodecSim("SubmitStandaloneState: SerializeState failed");
     return;
   }
-
-  FILE* f = fopen(path.c_str(), "wb");
-  if (f)
-  {
-    fwrite(chunk.GetData(), 1, chunk.Size(), f);
-    fclose(f);
-    DebugLogCodecSim("SaveStandaloneState: wrote " + std::to_string(chunk.Size()) + " bytes");
-  }
-  else
-  {
-    DebugLogCodecSim("SaveStandaloneState: failed to open file");
-  }
+  mStatePersistence->Submit(std::vector<uint8_t>(chunk.GetData(), chunk.GetData() + chunk.Size()));
 }
 
 void CodecSim::LoadStandaloneState()
@@ -2160,13 +2879,13 @@ void CodecSim::LoadUserPreset(const std::string& name)
       SendCurrentParamValuesFromDelegate();
       UpdateBitrateForCodec(mCurrentCodecIndex);
       UpdateOptionsForCodec(mCurrentCodecIndex);
-      if (IControl* pBR = GetUI()->GetControlWithTag(kCtrlTagBitrateSelector))
+      if (mUi.bitrateSelector)
       {
         double nv = GetParam(kParamBitrate)->ToNormalized(static_cast<double>(GetParam(kParamBitrate)->Int()));
-        pBR->SetValue(1.0 - nv, 0);
-        pBR->SetValueFromUserInput(nv, 0);
+        mUi.bitrateSelector->SetValue(1.0 - nv, 0);
+        mUi.bitrateSelector->SetValueFromUserInput(nv, 0);
       }
-      SetDetailTab(mDetailTabIndex);
+      PostUiEvents(kUiEventBitrate | kUiEventTabChanged);
     }
     SaveStandaloneState();
     AddLogMessage("Loaded preset: " + name);
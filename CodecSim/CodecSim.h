@@ -6,9 +6,27 @@
 #include <map>
 #include <memory>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
+#include <condition_variable>
 #include <functional>
+#include "ICodecProcessor.h"
+#include "QualityMetrics.h"
+#include "LosslessVerifier.h"
+#include "PipelineMetrics.h"
+#include "MessageRing.h"
+
+class StatePersistence;
+
+// Control types bound in CodecSim::UiBinding (defined in IControls.h / CodecSim.cpp)
+namespace iplug { namespace igraphics {
+class IVButtonControl;
+class IVTabSwitchControl;
+class IVectorBase;
+class IMultiLineTextControl;
+} }
+class SpinnerOverlayControl;
 
 const int kNumPresets = 1;
 
@@ -67,33 +85,11 @@ enum ECtrlTags
   kCtrlTagPresetSaveButton,
   kCtrlTagPresetNameEntry,
 
-  kNumCtrlTags
-};
-
-//==============================================================================
-// Codec Processor Interface
-//==============================================================================
-class ICodecProcessor
-{
-public:
-  virtual ~ICodecProcessor() = default;
-
-  virtual bool Initialize(int sampleRate, int channels) = 0;
-  virtual void Shutdown() = 0;
-  virtual void Reset() = 0;
-
-  virtual int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) = 0;
-  virtual int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) = 0;
-
-  virtual int Process(const float* input, int numSamples, float* output, int maxOutputSamples) = 0;
+  kCtrlTagMetricsDisplay,
+  kCtrlTagParkSelector,
+  kCtrlTagTraceSaveButton,             // Only with CODECSIM_TRACE
 
-  virtual int GetLatencySamples() const = 0;
-  virtual int GetFrameSize() const = 0;
-  virtual bool IsInitialized() const = 0;
-
-  virtual void SetLogCallback(std::function<void(const std::string&)> callback) = 0;
-
-  virtual bool HasFirstAudioArrived() const = 0;
+  kNumCtrlTags
 };
 
 using namespace iplug;
@@ -115,6 +111,8 @@ public:
 
 #if IPLUG_EDITOR
   bool OnHostRequestingSupportedViewConfiguration(int width, int height) override { return true; }
+  void OnUIOpen() override;
+  void OnUIClose() override;
 #endif
 
 #if IPLUG_DSP
@@ -135,22 +133,43 @@ private:
   // Codec processor
   std::unique_ptr<ICodecProcessor> mCodecProcessor;
 
+  // Live objective quality (input vs decoded), scored off the audio thread while
+  // the Metrics tab is visible
+  void PushQualityStreams(const float* input, int inputFrames, const float* decoded, int decodedFrames);
+  void UpdateQualityAnalyzer();                // Start/stop to match mQualityWanted (under mCodecMutex)
+  QualityAnalyzer mQualityAnalyzer;
+  std::atomic<bool> mQualityWanted{false};     // Set by OnIdle
+  int64_t mCodecInputFrames = 0;               // Fed to / decoded by the processor since it started
+  int64_t mCodecDecodedFrames = 0;             // (under mCodecMutex)
+
+  // Compressed size of a lossless codec in passthrough mode ("lossless_verify")
+  LosslessVerifier mLosslessVerifier;
+
+  // Live pipeline counters (survive restarts) and their periodic snapshot / shared-memory export
+  std::shared_ptr<PipelineMetrics> mMetrics;
+  std::unique_ptr<PipelineMetricsPublisher> mMetricsPublisher;
+  bool mOutputPrimed = false;          // A full block was delivered since start (audio thread, under mCodecMutex)
+
   // State
   int mCurrentCodecIndex;     // Index into available codec list
   int mSampleRate;
-  int mNumChannels;
+  int mNumChannels;           // Channels of the running pipeline (written under mCodecMutex)
 
   // Latency tracking
   std::atomic<int> mLatencySamples;
 
-  // Log display
-  std::vector<std::string> mLogMessages;
-  std::mutex mLogMutex;
+  // Log display: lines from any thread; the Log tab is rebuilt only when the ring's
+  // generation or the status line changes (UI thread state below)
+  MessageRing mLog;
+  uint64_t mLogShownGeneration = UINT64_MAX;
+  std::string mLogShownStatus;
   static constexpr int kMaxLogLines = 12;
 
   // Helper methods
-  void InitializeCodec(int codecIndex);
+  void InitializeCodec(int codecIndex, int numChannels);
   void ApplyCodecSettings();
+  bool ApplyToRunningPipeline();  // Apply without a respawn when the changes allow it
+  void StartPipeline();
   void StopCodec();
   void AddLogMessage(const std::string& msg);
   void UpdateBitrateForCodec(int codecIndex);
@@ -159,8 +178,13 @@ private:
   void UpdateChannelSelectorForCodec(int codecIndex);
   void SetDetailTab(int tabIndex);
   std::string BuildCurrentAdditionalArgs();
-  void SaveStandaloneState();
+  std::string BuildMetricsText() const;      // Metrics tab contents from the latest snapshot
+  void SaveTrace();                          // Chrome trace JSON into the app data folder (CODECSIM_TRACE)
+  void SaveStandaloneState();   // Schedules a debounced background write (real-time safe)
+  void SubmitStandaloneState(); // Serializes on the calling thread and hands the bytes to the writer
   void LoadStandaloneState();
+  std::unique_ptr<StatePersistence> mStatePersistence;
+  std::atomic<bool> mStateSavePending{false}; // Set by SaveStandaloneState, taken by OnIdle
   static std::string GetAppDataPath();
 
   // User preset management (file-based)
@@ -176,29 +200,104 @@ private:
   bool mCurrentCodecHasOther = false; // true if "Other" (custom) option is available
 
   // Codec option values and tab state
-  std::map<std::string, int> mCodecOptionValues;
-  int mDetailTabIndex = 0; // 0=Options, 1=Log (default to Options)
+  std::map<std::string, int, std::less<>> mCodecOptionValues; // transparent: lookups by string_view key
+  std::map<std::string, int, std::less<>> mAppliedOptionValues; // What the running pipeline uses (for the Apply log)
+  int mDetailTabIndex = 0; // 0=Options, 1=Log, 2=Metrics (default to Options)
 
   // Thread safety
   std::recursive_mutex mCodecMutex;
+  // Guards the mInitThread/mLazyStartThread handles and the starts that replace
+  // them. Taken before mCodecMutex, never on the audio thread.
+  std::recursive_mutex mThreadMutex;
 
   bool mIsInitializing = false;
   std::atomic<bool> mInitializing{false};
   std::thread mInitThread;
   bool mConstructed = false;
 
+  // Lazy pipeline start (no ffmpeg until the first non-silent block or editor open)
+  void ArmLazyStart();
+  void RequestLazyStart();   // Real-time safe
+  void CancelLazyStart();
+  void CapturePreRoll(sample** inputs, int nInChans, int nFrames);
+  void FeedPreRoll();
+  std::thread mLazyStartThread;
+  std::mutex mLazyStartMutex;
+  std::condition_variable mLazyStartCv;
+  std::atomic<bool> mLazyStartArmed{false};
+  std::atomic<bool> mLazyStartRequested{false};
+  std::atomic<bool> mLazyStartCancel{false};
+  std::atomic<bool> mStateRestored{false};   // Host restored the project (gates the first start)
+  std::chrono::steady_clock::time_point mConstructedTime;  // Start of the restore grace period
+  std::vector<float> mPreRollBuffer;   // Stereo interleaved ring, pre-allocated
+  int mPreRollFrames = 0;              // Frames held (audio thread only)
+  int mPreRollWrite = 0;               // Next ring position (audio thread only)
+  bool mPreRollCapturing = false;      // Audio thread only
+  int64_t mPreRollDropFrames = 0;      // Decoded pre-roll frames still to discard (under mCodecMutex)
+
+  // Silence-aware parking (audio thread only, under mCodecMutex)
+  void SetParkAfterSeconds(double seconds);  // Persisted with the state; wakes a parked pipeline for 0
+  double mParkAfterSeconds;            // Silence needed before parking (0 = never park)
+  int64_t mSilentFrames = 0;
+  bool mParked = false;
+
+  // Offline (non-realtime) render: blocking, sample-exact pipeline
+  void SetOfflineMode(bool offline);   // Not on the audio thread (joins threads)
+  void ResolveCodecFromParams(int& codecIndex, int& numChannels);  // Reads only
+  void EnforceTrialCodec();            // Trial builds: switch the codec parameter to MP3
+  std::atomic<bool> mOfflineMode{false};
+  int mOfflineHoldback = 0;            // Zero frames primed ahead of the decoded stream (offline only)
+  int64_t mOfflineStarvedBlocks = 0;   // Audio thread only
+
+  // Render mode switches seen by ProcessBlock, performed on their own thread
+  void RenderModeThread();
+  std::thread mRenderModeThread;
+  std::mutex mRenderModeMutex;
+  std::condition_variable mRenderModeCv;
+  std::atomic<int> mRenderModeRequest{-1};   // -1 none, 0 realtime, 1 offline
+  std::atomic<bool> mRenderModeStop{false};
+
   // Pending changes indicator
   std::atomic<bool> mPendingApply{false};
   std::atomic<bool> mCancelInit{false};
 
+  // UI state-change events: posted from any thread, applied by OnIdle on the UI thread.
+  // OnIdle touches the controls only for the events it receives.
+  enum EUiEvents : uint32_t
+  {
+    kUiEventPendingApply = 1 << 0,   // Apply button colour/label
+    kUiEventInitializing = 1 << 1,   // Spinner overlay (and Apply button)
+    kUiEventCodecChanged = 1 << 2,   // Bitrate presets, options and channel selector for the new codec
+                                     // (OnParamChange runs on the host thread, these need the UI thread)
+    kUiEventBitrate      = 1 << 3,   // Bitrate selector text, custom bitrate box
+    kUiEventTabChanged   = 1 << 4,   // Detail tab visibility
+  };
+  void PostUiEvents(uint32_t events) { mUiEvents.fetch_or(events, std::memory_order_release); }
+  std::atomic<uint32_t> mUiEvents{0};
+
+  // Typed control pointers, bound once by mLayoutFunc (UI thread; all null while the editor is closed)
+  struct UiBinding
+  {
+    IVButtonControl* applyButton = nullptr;
+    SpinnerOverlayControl* spinner = nullptr;      // Replaced by UpdateOptionsForCodec
+    IVTabSwitchControl* tabSwitch = nullptr;
+    IControl* bitrateLabel = nullptr;
+    IControl* bitrateSelector = nullptr;
+    IVectorBase* bitrateValueButton = nullptr;     // Child of bitrateSelector that shows the value
+    IControl* bitrateCustom = nullptr;
+    IControl* channelSelector = nullptr;
+    IMultiLineTextControl* logDisplay = nullptr;
+    IMultiLineTextControl* metricsDisplay = nullptr;
+  };
+  UiBinding mUi;
+  void BindUi(IGraphics* pGraphics);
+  void UpdateApplyButton();
+  void UpdateBitrateControls();
+
   // UI state tracking (to avoid redundant updates in OnIdle)
   int mLastApplyButtonState = -1; // -1=unknown, 0=applied(green), 1=pending(orange)
 
-  // Deferred codec update: OnParamChange(kParamCodec) runs on host thread,
-  // but UpdateBitrateForCodec/UpdateOptionsForCodec must run on the UI thread.
-  std::atomic<bool> mPendingCodecUpdate{false};
-
-  // Cache the last bitrate display string to avoid redundant SetValueStr calls in OnIdle
+  // Cache the last bitrate display string to avoid redundant SetValueStr calls
   std::string mLastBitrateDisplayStr;
 
 #ifdef CODECSIM_TRIAL
@@ -0,0 +1,379 @@
+//==============================================================================
+// DebugLog.cpp
+// Asynchronous diagnostic logger: per-thread lock-free queues, one writer thread
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "DebugLog.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <debugapi.h>
+#endif
+
+std::atomic<bool> DebugLogger::sRunning{false};
+
+namespace
+{
+
+constexpr size_t kMaxRings = 32;          // Threads logging at the same time
+constexpr size_t kRecordsPerRing = 128;   // Power of two
+constexpr size_t kTextCapacity = 168;     // Message bytes per record (longer ones continue)
+constexpr int kWriterIntervalMs = 20;
+
+constexpr uint8_t kFlagContinued = 1;     // Next record in the ring continues this message
+
+struct LogRecord
+{
+  uint64_t timeNs;
+  const char* category;
+  const char* format;                     // Realtime records: formatted by the writer
+  int64_t args[DebugLogger::kMaxArgs];
+  uint32_t suppressed;
+  uint16_t textLength;
+  LogLevel level;
+  uint8_t flags;
+  uint8_t numArgs;
+  char text[kTextCapacity];
+};
+static_assert(sizeof(LogRecord) <= 256, "keep records within 256 bytes");
+
+// Single producer (the owning thread), single consumer (the writer)
+struct LogRing
+{
+  std::atomic<uint64_t> head{0};          // Written by the producer
+  std::atomic<uint64_t> tail{0};          // Written by the writer
+  std::atomic<uint64_t> dropped{0};       // Records lost to a full ring
+  std::atomic<bool> inUse{false};         // Claimed by a thread (or still holding its records)
+  std::atomic<bool> released{false};      // Owner exited; free once drained
+  int index = 0;
+  LogRecord records[kRecordsPerRing];
+};
+
+// Pool is allocated once and never freed: a thread may still hold a ring
+// pointer when the last user stops the logger
+std::unique_ptr<LogRing[]> sRings;
+std::atomic<uint64_t> sUnclaimedDrops{0};  // No free ring for a thread
+
+std::mutex sStateMutex;                    // Start/Stop
+int sUsers = 0;
+std::thread sWriter;
+std::mutex sWakeMutex;
+std::condition_variable sWakeCv;
+bool sStopRequested = false;
+FILE* sFile = nullptr;
+int64_t sWallOffsetNs = 0;                 // system_clock - steady_clock at Start
+
+thread_local LogRing* tRing = nullptr;     // Trivial: no TLS registration on the audio thread
+
+// Frees the ring once the writer has drained it (registered by the first
+// non-realtime record of a thread; realtime-only threads keep their ring)
+struct LogRingRelease
+{
+  LogRing* ring = nullptr;
+  ~LogRingRelease()
+  {
+    if (ring)
+      ring->released.store(true, std::memory_order_release);
+    if (tRing == ring)
+      tRing = nullptr;
+  }
+};
+
+LogRing* ClaimRing()
+{
+  if (tRing)
+    return tRing;
+  if (!sRings)
+    return nullptr;
+  for (size_t i = 0; i < kMaxRings; ++i)
+  {
+    bool expected = false;
+    if (sRings[i].inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+    {
+      sRings[i].released.store(false, std::memory_order_relaxed);
+      tRing = &sRings[i];
+      return tRing;
+    }
+  }
+  return nullptr;
+}
+
+// Reserve 'count' consecutive records; false (and one drop) if they do not fit
+bool Reserve(LogRing* ring, size_t count, uint64_t& head)
+{
+  head = ring->head.load(std::memory_order_relaxed);
+  const uint64_t tail = ring->tail.load(std::memory_order_acquire);
+  if (head - tail + count > kRecordsPerRing)
+  {
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+const char* LevelTag(LogLevel level)
+{
+  switch (level)
+  {
+    case LogLevel::Trace: return "TRACE ";
+    case LogLevel::Debug: return "";
+    case LogLevel::Info: return "INFO ";
+    case LogLevel::Warning: return "WARNING ";
+    case LogLevel::Error: return "ERROR ";
+  }
+  return "";
+}
+
+struct PendingLine
+{
+  uint64_t timeNs;
+  int ring;
+  std::string text;
+};
+
+std::string FormatLine(const LogRecord& first, int ring, const std::string& message)
+{
+  char stamp[32];
+  const int64_t wallNs = static_cast<int64_t>(first.timeNs) + sWallOffsetNs;
+  const std::time_t seconds = static_cast<std::time_t>(wallNs / 1000000000);
+  std::tm local{};
+#ifdef _WIN32
+  localtime_s(&local, &seconds);
+#else
+  localtime_r(&seconds, &local);
+#endif
+  std::strftime(stamp, sizeof(stamp), "%H:%M:%S", &local);
+
+  char prefix[96];
+  std::snprintf(prefix, sizeof(prefix), "%s.%03d t%02d [%s] %s", stamp,
+                static_cast<int>((wallNs / 1000000) % 1000), ring, first.category ? first.category : "?",
+                LevelTag(first.level));
+
+  std::string line = prefix + message;
+  if (first.suppressed > 0)
+    line += " (" + std::to_string(first.suppressed) + " more suppressed)";
+  line += '\n';
+  return line;
+}
+
+// Move every complete message out of the rings (writer thread)
+void Drain(std::vector<PendingLine>& lines)
+{
+  for (size_t r = 0; r < kMaxRings; ++r)
+  {
+    LogRing& ring = sRings[r];
+    if (!ring.inUse.load(std::memory_order_acquire))
+      continue;
+
+    const uint64_t head = ring.head.load(std::memory_order_acquire);
+    uint64_t tail = ring.tail.load(std::memory_order_relaxed);
+    while (tail < head)
+    {
+      const LogRecord& first = ring.records[tail & (kRecordsPerRing - 1)];
+      std::string message;
+      if (first.format)
+      {
+        char buf[512];
+        const int64_t* a = first.args;
+        std::snprintf(buf, sizeof(buf), first.format, static_cast<long long>(a[0]), static_cast<long long>(a[1]),
+                      static_cast<long long>(a[2]), static_cast<long long>(a[3]), static_cast<long long>(a[4]),
+                      static_cast<long long>(a[5]));
+        message = buf;
+        ++tail;
+      }
+      else
+      {
+        // Producer publishes all parts of a message at once
+        const LogRecord* part = &first;
+        while (true)
+        {
+          message.append(part->text, part->textLength);
+          ++tail;
+          if (!(part->flags & kFlagContinued) || tail >= head)
+            break;
+          part = &ring.records[tail & (kRecordsPerRing - 1)];
+        }
+      }
+      lines.push_back({first.timeNs, ring.index, FormatLine(first, ring.index, message)});
+    }
+    ring.tail.store(tail, std::memory_order_release);
+
+    if (const uint64_t dropped = ring.dropped.exchange(0, std::memory_order_relaxed))
+      lines.push_back({DebugLogger::NowNs(), ring.index,
+                       "[DebugLog] " + std::to_string(dropped) + " records dropped (queue full)\n"});
+
+    // Exited owner and nothing left: the ring can be claimed again
+    if (ring.released.load(std::memory_order_acquire) && ring.head.load(std::memory_order_acquire) == tail)
+    {
+      ring.released.store(false, std::memory_order_relaxed);
+      ring.inUse.store(false, std::memory_order_release);
+    }
+  }
+
+  if (const uint64_t unclaimed = sUnclaimedDrops.exchange(0, std::memory_order_relaxed))
+    lines.push_back({DebugLogger::NowNs(), -1,
+                     "[DebugLog] " + std::to_string(unclaimed) + " records dropped (too many logging threads)\n"});
+}
+
+void WriteLines(std::vector<PendingLine>& lines)
+{
+  if (lines.empty())
+    return;
+  std::stable_sort(lines.begin(), lines.end(),
+                   [](const PendingLine& a, const PendingLine& b) { return a.timeNs < b.timeNs; });
+  for (const auto& line : lines)
+  {
+    if (sFile)
+      std::fputs(line.text.c_str(), sFile);
+#ifdef _WIN32
+    OutputDebugStringA(line.text.c_str());
+#endif
+  }
+  if (sFile)
+    std::fflush(sFile);
+  lines.clear();
+}
+
+void WriterThread()
+{
+  std::vector<PendingLine> lines;
+  std::unique_lock<std::mutex> lock(sWakeMutex);
+  while (!sStopRequested)
+  {
+    sWakeCv.wait_for(lock, std::chrono::milliseconds(kWriterIntervalMs));
+    lock.unlock();
+    Drain(lines);
+    WriteLines(lines);
+    lock.lock();
+  }
+  lock.unlock();
+  Drain(lines);
+  WriteLines(lines);
+}
+
+} // namespace
+
+//==============================================================================
+// DebugLogger
+//==============================================================================
+
+void DebugLogger::Start(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(sStateMutex);
+  if (sUsers++ > 0)
+    return;
+
+  if (!sRings)
+  {
+    sRings = std::make_unique<LogRing[]>(kMaxRings);
+    for (size_t i = 0; i < kMaxRings; ++i)
+      sRings[i].index = static_cast<int>(i);
+  }
+
+  const char* overridePath = std::getenv("CODECSIM_DEBUG_LOG");
+  const std::string filePath = overridePath ? overridePath : path;
+  sFile = filePath.empty() ? nullptr : std::fopen(filePath.c_str(), "a");
+
+  sWallOffsetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count() -
+                  static_cast<int64_t>(NowNs());
+  sStopRequested = false;
+  sWriter = std::thread(WriterThread);
+  sRunning.store(true, std::memory_order_release);
+}
+
+void DebugLogger::Stop()
+{
+  std::lock_guard<std::mutex> lock(sStateMutex);
+  if (sUsers == 0 || --sUsers > 0)
+    return;
+
+  sRunning.store(false, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> wakeLock(sWakeMutex);
+    sStopRequested = true;
+  }
+  sWakeCv.notify_all();
+  if (sWriter.joinable())
+    sWriter.join();
+
+  if (sFile)
+  {
+    std::fclose(sFile);
+    sFile = nullptr;
+  }
+}
+
+void DebugLogger::Write(LogLevel level, const char* category, const std::string& message, uint32_t suppressed)
+{
+  LogRing* ring = ClaimRing();
+  if (!ring)
+  {
+    sUnclaimedDrops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  thread_local LogRingRelease release;
+  release.ring = ring;
+
+  const size_t parts = std::max<size_t>(1, (message.size() + kTextCapacity - 1) / kTextCapacity);
+  uint64_t head = 0;
+  if (!Reserve(ring, parts, head))
+    return;
+
+  const uint64_t now = NowNs();
+  for (size_t i = 0; i < parts; ++i)
+  {
+    LogRecord& record = ring->records[(head + i) & (kRecordsPerRing - 1)];
+    const size_t offset = i * kTextCapacity;
+    const size_t length = std::min(kTextCapacity, message.size() - std::min(offset, message.size()));
+    record.timeNs = now;
+    record.category = category;
+    record.format = nullptr;
+    record.suppressed = suppressed;
+    record.level = level;
+    record.flags = (i + 1 < parts) ? kFlagContinued : 0;
+    record.numArgs = 0;
+    record.textLength = static_cast<uint16_t>(length);
+    std::memcpy(record.text, message.data() + offset, length);
+  }
+  ring->head.store(head + parts, std::memory_order_release);
+}
+
+void DebugLogger::WriteRealtime(LogLevel level, const char* category, const char* format, uint32_t suppressed,
+                                const int64_t* args, int numArgs)
+{
+  LogRing* ring = ClaimRing();
+  if (!ring)
+  {
+    sUnclaimedDrops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  uint64_t head = 0;
+  if (!Reserve(ring, 1, head))
+    return;
+
+  LogRecord& record = ring->records[head & (kRecordsPerRing - 1)];
+  record.timeNs = NowNs();
+  record.category = category;
+  record.format = format;
+  for (int i = 0; i < kMaxArgs; ++i)
+    record.args[i] = (i < numArgs) ? args[i] : 0;
+  record.suppressed = suppressed;
+  record.level = level;
+  record.flags = 0;
+  record.numArgs = static_cast<uint8_t>(numArgs);
+  record.textLength = 0;
+  ring->head.store(head + 1, std::memory_order_release);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+//==============================================================================
+// DebugLog.h
+// Asynchronous diagnostic logger: per-thread lock-free queues, one writer thread
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+enum class LogLevel : uint8_t
+{
+  Trace,    // Hot paths (per block); compiled out by default
+  Debug,
+  Info,
+  Warning,
+  Error
+};
+
+// Lowest level compiled in (0 = Trace ... 4 = Error). Records below it are
+// removed by the compiler, including the formatting of their arguments.
+#ifndef CODECSIM_LOG_LEVEL
+#define CODECSIM_LOG_LEVEL 1
+#endif
+
+//==============================================================================
+// LogRateLimiter - one per call site (static, constant-initialised), lock-free.
+// Allows kMaxPerSecond records per one-second window; the rest are counted and
+// reported with the next record that gets through.
+//==============================================================================
+class LogRateLimiter
+{
+public:
+  static constexpr uint32_t kMaxPerSecond = 20;
+
+  constexpr LogRateLimiter() = default;
+
+  bool Allow(uint64_t nowNs)
+  {
+    const uint64_t window = nowNs / 1000000000ull;
+    uint64_t current = mWindow.load(std::memory_order_relaxed);
+    if (window != current && mWindow.compare_exchange_strong(current, window, std::memory_order_relaxed))
+      mCount.store(0, std::memory_order_relaxed);
+    if (mCount.fetch_add(1, std::memory_order_relaxed) < kMaxPerSecond)
+      return true;
+    mSuppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Records dropped since the last call
+  uint32_t TakeSuppressed() { return mSuppressed.exchange(0, std::memory_order_relaxed); }
+
+private:
+  std::atomic<uint64_t> mWindow{0};
+  std::atomic<uint32_t> mCount{0};
+  std::atomic<uint32_t> mSuppressed{0};
+};
+
+//==============================================================================
+// DebugLogger - records go into the calling thread's single-producer ring and
+// a background thread formats them and writes them through one persistent
+// file handle (and OutputDebugString on Windows). Nothing is recorded until
+// Start(); a full ring drops the record and counts it.
+//==============================================================================
+class DebugLogger
+{
+public:
+  static constexpr int kMaxArgs = 6;
+
+  /**
+   * Start the writer (reference counted: every Start needs a Stop).
+   * @param path Log file, opened for append; empty = debugger output only.
+   *             The CODECSIM_DEBUG_LOG environment variable overrides it.
+   */
+  static void Start(const std::string& path);
+
+  // Flush and stop the writer when the last user stops
+  static void Stop();
+
+  // Queue a preformatted message (any thread except the audio thread: the
+  // caller has already allocated the string). Long messages span several records.
+  static void Write(LogLevel level, const char* category, const std::string& message, uint32_t suppressed);
+
+  /**
+   * Queue a message formatted later by the writer (real-time safe: no
+   * formatting, allocation, locks or I/O on the calling thread).
+   * @param format String literal; every conversion must be %lld
+   */
+  static void WriteRealtime(LogLevel level, const char* category, const char* format, uint32_t suppressed,
+                            const int64_t* args, int numArgs);
+
+  static uint64_t NowNs()
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  static bool IsRunning() { return sRunning.load(std::memory_order_acquire); }
+
+private:
+  static std::atomic<bool> sRunning;
+};
+
+// Argument packing for CODECSIM_LOG_RT (integers only)
+template <typename... Args>
+inline void DebugLogRealtime(LogLevel level, const char* category, uint32_t suppressed, const char* format,
+                             Args... args)
+{
+  static_assert(sizeof...(Args) <= DebugLogger::kMaxArgs, "too many log arguments");
+  const int64_t packed[DebugLogger::kMaxArgs + 1] = {static_cast<int64_t>(args)..., 0};
+  DebugLogger::WriteRealtime(level, category, format, suppressed, packed, static_cast<int>(sizeof...(Args)));
+}
+
+#define CODECSIM_LOG_ENABLED(level) (static_cast<int>(level) >= CODECSIM_LOG_LEVEL)
+
+// Message expression is only evaluated if the level is compiled in, the
+// logger runs and the call site is within its rate limit
+#define CODECSIM_LOG(level, category, message)                                                   \
+  do                                                                                              \
+  {                                                                                               \
+    if constexpr (CODECSIM_LOG_ENABLED(level))                                                    \
+    {                                                                                             \
+      static LogRateLimiter codecsimLogLimiter;                                                   \
+      if (DebugLogger::IsRunning() && codecsimLogLimiter.Allow(DebugLogger::NowNs()))             \
+        DebugLogger::Write(level, category, message, codecsimLogLimiter.TakeSuppressed());        \
+    }                                                                                             \
+  } while (0)
+
+// Audio-thread variant: literal format with %lld conversions and integer arguments
+#define CODECSIM_LOG_RT(level, category, ...)                                                    \
+  do                                                                                              \
+  {                                                                                               \
+    if constexpr (CODECSIM_LOG_ENABLED(level))                                                    \
+    {                                                                                             \
+      static LogRateLimiter codecsimLogLimiter;                                                   \
+      if (DebugLogger::IsRunning() && codecsimLogLimiter.Allow(DebugLogger::NowNs()))             \
+        DebugLogRealtime(level, category, codecsimLogLimiter.TakeSuppressed(), __VA_ARGS__);      \
+    }                                                                                             \
+  } while (0)
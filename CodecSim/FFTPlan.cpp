@@ -0,0 +1,101 @@
+//==============================================================================
+// FFTPlan.cpp
+// Radix-2 FFT plans (twiddles, bit-reversal, analysis window) shared by size
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "FFTPlan.h"
+#include <cmath>
+#include <utility>
+
+namespace
+{
+constexpr double kPi = 3.14159265358979323846;
+
+bool IsPowerOfTwo(int n) { return n >= 4 && (n & (n - 1)) == 0; }
+}
+
+FFTPlan::FFTPlan(int size)
+  : mSize(size)
+{
+  int bits = 0;
+  while ((1 << bits) < size)
+    ++bits;
+
+  mBitReverse.resize(size);
+  for (int i = 0; i < size; ++i)
+  {
+    uint32_t r = 0;
+    for (int b = 0; b < bits; ++b)
+      r |= ((i >> b) & 1u) << (bits - 1 - b);
+    mBitReverse[i] = r;
+  }
+
+  mTwiddles.resize(size / 2);
+  for (int k = 0; k < size / 2; ++k)
+  {
+    const double phase = -2.0 * kPi * k / size;
+    mTwiddles[k] = std::complex<float>(static_cast<float>(std::cos(phase)), static_cast<float>(std::sin(phase)));
+  }
+
+  mWindow.resize(size);
+  for (int i = 0; i < size; ++i)
+  {
+    const double w = 0.5 - 0.5 * std::cos(2.0 * kPi * i / size);
+    mWindow[i] = static_cast<float>(w);
+    mWindowEnergy += w * w;
+  }
+}
+
+void FFTPlan::Forward(std::complex<float>* data) const
+{
+  for (int i = 0; i < mSize; ++i)
+  {
+    const int j = static_cast<int>(mBitReverse[i]);
+    if (j > i)
+      std::swap(data[i], data[j]);
+  }
+
+  // Iterative decimation in time; complex products spelled out so the
+  // compiler does not emit the C99 NaN/Inf recovery path
+  float* d = reinterpret_cast<float*>(data);
+  const float* tw = reinterpret_cast<const float*>(mTwiddles.data());
+  for (int half = 1; half < mSize; half *= 2)
+  {
+    const int step = mSize / (2 * half);
+    for (int start = 0; start < mSize; start += 2 * half)
+    {
+      for (int k = 0; k < half; ++k)
+      {
+        const float wr = tw[2 * k * step];
+        const float wi = tw[2 * k * step + 1];
+        float* a = d + 2 * (start + k);
+        float* b = d + 2 * (start + k + half);
+        const float tr = b[0] * wr - b[1] * wi;
+        const float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+FFTPlanCache& FFTPlanCache::Instance()
+{
+  static FFTPlanCache sInstance;
+  return sInstance;
+}
+
+std::shared_ptr<const FFTPlan> FFTPlanCache::Get(int size)
+{
+  if (!IsPowerOfTwo(size))
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& plan = mPlans[size];
+  if (!plan)
+    plan = std::make_shared<const FFTPlan>(size);
+  return plan;
+}
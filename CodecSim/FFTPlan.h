@@ -0,0 +1,58 @@
+#pragma once
+
+//==============================================================================
+// FFTPlan.h
+// Radix-2 FFT plans (twiddles, bit-reversal, analysis window) shared by size
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//==============================================================================
+// FFTPlan - immutable once built, so one plan serves any number of threads
+//==============================================================================
+class FFTPlan
+{
+public:
+  explicit FFTPlan(int size);  // size: power of two >= 4
+
+  int GetSize() const { return mSize; }
+
+  // Periodic Hann window of GetSize() points and its energy (sum of w^2)
+  const float* GetWindow() const { return mWindow.data(); }
+  double GetWindowEnergy() const { return mWindowEnergy; }
+
+  // In-place forward transform (no scaling)
+  void Forward(std::complex<float>* data) const;
+
+private:
+  int mSize;
+  std::vector<std::complex<float>> mTwiddles;  // exp(-2*pi*i*k/N), k < N/2
+  std::vector<uint32_t> mBitReverse;
+  std::vector<float> mWindow;
+  double mWindowEnergy = 0.0;
+};
+
+//==============================================================================
+// FFTPlanCache - process-wide plans keyed by size. Get() locks, so fetch the
+// plan once when configuring, never per frame.
+//==============================================================================
+class FFTPlanCache
+{
+public:
+  static FFTPlanCache& Instance();
+
+  // nullptr if size is not a power of two >= 4
+  std::shared_ptr<const FFTPlan> Get(int size);
+
+private:
+  FFTPlanCache() = default;
+
+  std::mutex mMutex;
+  std::map<int, std::shared_ptr<const FFTPlan>> mPlans;
+};
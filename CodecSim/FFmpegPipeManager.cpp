@@ -7,14 +7,194 @@
 #include "FFmpegPipeManager.h"
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 
+#ifdef _WIN32
+#include "SharedFFmpegWorker.h"
+#include <psapi.h>
+
+//==============================================================================
+// Process suspension (ntdll exports, resolved at runtime)
+//==============================================================================
+
+using NtProcessControlFn = LONG (NTAPI*)(HANDLE);
+
+static NtProcessControlFn GetNtProcessControl(const char* name)
+{
+  HMODULE ntdll = GetModuleHandleA("ntdll.dll");
+  return ntdll ? reinterpret_cast<NtProcessControlFn>(GetProcAddress(ntdll, name)) : nullptr;
+}
+
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// Shared workers multiplex over Windows named pipes; POSIX builds always run
+// private pipelines, so the slot is never instantiated
+class SharedFFmpegSlot
+{
+public:
+  bool WriteSamples(const float*, size_t) { return false; }
+  size_t ReadSamples(float*, size_t, uint32_t) { return 0; }
+  size_t AvailableOutputSamples() const { return 0; }
+  bool HasFirstAudioArrived() const { return false; }
+  void SetParked(bool) {}
+  bool IsAlive() const { return false; }
+};
+
+//==============================================================================
+// POSIX process helpers
+//==============================================================================
+
+// Reap 'pid' if it exits within timeoutMs; returns false if it is still running
+static bool WaitForExit(pid_t pid, int timeoutMs)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true)
+  {
+    pid_t result = waitpid(pid, nullptr, WNOHANG);
+    if (result == pid || (result < 0 && errno == ECHILD))
+      return true;
+    if (std::chrono::steady_clock::now() >= deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+static void KillAndReap(pid_t pid)
+{
+  kill(pid, SIGKILL);
+  while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {}
+}
+#endif
+
+//==============================================================================
+// Pipe I/O primitives
+//==============================================================================
+
+enum class PipeStatus
+{
+  Ok,
+  Closed,   // Other end went away (process exited or pipe closed)
+  Failed    // Anything else; 'error' holds the OS error code
+};
+
+#ifdef _WIN32
+static PipeStatus ReadPipe(HANDLE pipe, void* buffer, size_t size, size_t& bytesRead, long& error)
+{
+  DWORD read = 0;
+  if (ReadFile(pipe, buffer, static_cast<DWORD>(size), &read, nullptr) && read > 0)
+  {
+    bytesRead = read;
+    return PipeStatus::Ok;
+  }
+  error = static_cast<long>(GetLastError());
+  return (error == ERROR_BROKEN_PIPE || error == ERROR_NO_DATA) ? PipeStatus::Closed : PipeStatus::Failed;
+}
+
+static PipeStatus WritePipe(HANDLE pipe, const void* data, size_t size, size_t& bytesWritten, long& error)
+{
+  DWORD written = 0;
+  if (WriteFile(pipe, data, static_cast<DWORD>(size), &written, nullptr) && written > 0)
+  {
+    bytesWritten = written;
+    return PipeStatus::Ok;
+  }
+  error = static_cast<long>(GetLastError());
+  return (error == ERROR_BROKEN_PIPE || error == ERROR_NO_DATA) ? PipeStatus::Closed : PipeStatus::Failed;
+}
+
+static void ClosePipe(HANDLE& pipe)
+{
+  if (pipe != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(pipe);
+    pipe = INVALID_HANDLE_VALUE;
+  }
+}
+#else
+static PipeStatus ReadPipe(int fd, void* buffer, size_t size, size_t& bytesRead, long& error)
+{
+  while (true)
+  {
+    ssize_t result = read(fd, buffer, size);
+    if (result > 0)
+    {
+      bytesRead = static_cast<size_t>(result);
+      return PipeStatus::Ok;
+    }
+    if (result == 0)
+      return PipeStatus::Closed;
+    if (errno != EINTR)
+    {
+      error = errno;
+      return PipeStatus::Failed;
+    }
+  }
+}
+
+// The write end is non-blocking so the input thread notices Stop() while the
+// encoder is not reading: a full pipe waits up to 100 ms and reports 0 bytes
+static PipeStatus WritePipe(int fd, const void* data, size_t size, size_t& bytesWritten, long& error)
+{
+  while (true)
+  {
+    ssize_t result = write(fd, data, size);
+    if (result > 0)
+    {
+      bytesWritten = static_cast<size_t>(result);
+      return PipeStatus::Ok;
+    }
+    if (result < 0 && errno == EAGAIN)
+    {
+      pollfd pfd = {fd, POLLOUT, 0};
+      poll(&pfd, 1, 100);
+      bytesWritten = 0;
+      return PipeStatus::Ok;
+    }
+    if (result < 0 && errno == EINTR)
+      continue;
+    error = errno;
+    return (errno == EPIPE) ? PipeStatus::Closed : PipeStatus::Failed;
+  }
+}
+
+static void ClosePipe(int& fd)
+{
+  if (fd >= 0)
+  {
+    close(fd);
+    fd = -1;
+  }
+}
+#endif
+
+//==============================================================================
+// Running per-instance pipelines (for resource accounting)
+//==============================================================================
+
+static std::mutex sRunningMutex;
+static std::vector<const FFmpegPipeManager*> sRunningManagers;
+
 //==============================================================================
 // Static Utility
 //==============================================================================
 
 std::string FFmpegPipeManager::ResolveFFmpegPath()
 {
+#ifdef _WIN32
   char exePath[MAX_PATH] = {};
   DWORD len = GetModuleFileNameA(NULL, exePath, MAX_PATH);
   if (len > 0 && len < MAX_PATH)
@@ -31,6 +211,22 @@ std::string FFmpegPipeManager::ResolveFFmpegPath()
     }
   }
   return "ffmpeg.exe";
+#else
+  char exePath[PATH_MAX] = {};
+  ssize_t len = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+  if (len > 0)
+  {
+    std::string dir(exePath, static_cast<size_t>(len));
+    size_t pos = dir.find_last_of('/');
+    if (pos != std::string::npos)
+    {
+      std::string candidate = dir.substr(0, pos + 1) + "ffmpeg";
+      if (access(candidate.c_str(), X_OK) == 0)
+        return candidate;
+    }
+  }
+  return "ffmpeg";
+#endif
 }
 
 //==============================================================================
@@ -38,14 +234,21 @@ std::string FFmpegPipeManager::ResolveFFmpegPath()
 //==============================================================================
 
 FFmpegPipeManager::FFmpegPipeManager()
-  : mIsRunning(false)
+#ifdef _WIN32
+  : mJobObject(nullptr)
+#else
+  : mEncoderPid(-1)
+  , mDecoderPid(-1)
+#endif
+  , mIntermediatePipeRead(InvalidPipe())
+  , mIntermediatePipeWrite(InvalidPipe())
+  , mIsRunning(false)
   , mLatencySamples(0)
-  , mIntermediatePipeRead(INVALID_HANDLE_VALUE)
-  , mIntermediatePipeWrite(INVALID_HANDLE_VALUE)
-  , mJobObject(nullptr)
 {
+#ifdef _WIN32
   std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
   std::memset(&mDecoderProcessInfo, 0, sizeof(mDecoderProcessInfo));
+#endif
 }
 
 FFmpegPipeManager::~FFmpegPipeManager()
@@ -59,6 +262,7 @@ FFmpegPipeManager::~FFmpegPipeManager()
 
 bool FFmpegPipeManager::Start(const Config& config)
 {
+  CODECSIM_TRACE_SCOPE("PipelineStart");
   std::lock_guard<std::mutex> lock(mMutex);
 
   if (mIsRunning)
@@ -66,10 +270,34 @@ bool FFmpegPipeManager::Start(const Config& config)
     LogError("FFmpeg process already running");
     return false;
   }
+  if (mStarted)
+    Stop();  // Reap a pipeline whose children died (broken pipe)
 
   // Store configuration
   mConfig = config;
 
+  // Shared mode: lease a stream on a worker with the same configuration,
+  // falling back to a private pipeline if no worker can be started
+#ifdef _WIN32
+  if (config.sharedWorker)
+  {
+    mSharedSlot = SharedFFmpegWorker::Acquire(config, mLogCallback);
+    if (mSharedSlot)
+    {
+      mIsRunning = true;
+      mStarted = true;
+      mStartedFlag.store(true);
+      Log("Joined shared FFmpeg worker");
+      LogResourceUsage();
+      return true;
+    }
+    Log("Shared FFmpeg worker unavailable, starting a private pipeline");
+  }
+#else
+  if (config.sharedWorker)
+    Log("Shared FFmpeg workers are Windows-only, starting a private pipeline");
+#endif
+
   // Create pipes
   if (!CreatePipes())
   {
@@ -86,97 +314,73 @@ bool FFmpegPipeManager::Start(const Config& config)
 
   // Start background threads
   mFirstOutputReceived.store(false, std::memory_order_relaxed);
+  mInputEndRequested.store(false);
+  mOutputEnded = false;
+  mInputOverrun = false;
+  mFailed.store(false);
+  mSuspendWhenParked.store(config.suspendWhenParked);
+  mInputBytesWritten.store(0, std::memory_order_relaxed);
+  mInputWriteSince.store(0, std::memory_order_relaxed);
+  mOutputFramesDecoded.store(0, std::memory_order_relaxed);
+  mStartTime = std::chrono::steady_clock::now();
+  if (mMetrics)
+  {
+    PipelineMetrics::Add(mMetrics->starts, 1);
+    PipelineMetrics::Set(mMetrics->timeToFirstAudioUs, 0);
+  }
   mIsRunning = true;
+  mStarted = true;
+  mStartedFlag.store(true);
   mErrorThread = std::thread(&FFmpegPipeManager::ErrorReadThread, this);
   mOutputThread = std::thread(&FFmpegPipeManager::OutputReadThread, this);
   mInputThread = std::thread(&FFmpegPipeManager::InputWriteThread, this);
 
+  {
+    std::lock_guard<std::mutex> runningLock(sRunningMutex);
+    sRunningManagers.push_back(this);
+  }
+
   Log("FFmpeg process started successfully");
+  LogResourceUsage();
   return true;
 }
 
 void FFmpegPipeManager::Stop()
 {
-  if (!mIsRunning)
+  // mIsRunning alone is not enough: the input thread clears it on a broken
+  // pipe, and the threads and children still have to be reaped
+  if (!mStarted)
     return;
 
-  Log("Stopping FFmpeg processes...");
+  CODECSIM_TRACE_SCOPE("PipelineStop");
+  mStarted = false;
+  mStartedFlag.store(false);
   mIsRunning = false;
-
-  // Close write end of input pipe to signal EOF to encoder
-  if (mPipes.hInputWrite != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hInputWrite);
-    mPipes.hInputWrite = INVALID_HANDLE_VALUE;
-  }
-
-  // Wait briefly for graceful process exit
-  bool encoderAlive = false;
-  bool decoderAlive = false;
-
-  if (mEncoderProcessInfo.hProcess != nullptr)
-  {
-    DWORD waitResult = WaitForSingleObject(mEncoderProcessInfo.hProcess, 2000);
-    encoderAlive = (waitResult == WAIT_TIMEOUT);
-  }
-  if (mDecoderProcessInfo.hProcess != nullptr)
   {
-    DWORD waitResult = WaitForSingleObject(mDecoderProcessInfo.hProcess, 2000);
-    decoderAlive = (waitResult == WAIT_TIMEOUT);
+    std::lock_guard<std::mutex> lock(mOutputMutex);
+    mOutputCv.notify_all();  // Release blocking readers
   }
 
-  if (encoderAlive || decoderAlive)
+  if (mSharedSlot)
   {
-    Log("FFmpeg processes did not exit gracefully, forcing termination");
-    if (mJobObject)
-    {
-      CloseHandle(mJobObject);
-      mJobObject = nullptr;
-    }
-    if (encoderAlive && mEncoderProcessInfo.hProcess)
-      ::TerminateProcess(mEncoderProcessInfo.hProcess, 1);
-    if (decoderAlive && mDecoderProcessInfo.hProcess)
-      ::TerminateProcess(mDecoderProcessInfo.hProcess, 1);
+    mSharedSlot.reset();  // Worker shuts down with its last stream
+    Log("Left shared FFmpeg worker");
+    return;
   }
 
-  // Join threads
-  if (mInputThread.joinable()) mInputThread.join();
-  if (mOutputThread.joinable()) mOutputThread.join();
-  if (mErrorThread.joinable()) mErrorThread.join();
-
-  // Clean up encoder process handles
-  if (mEncoderProcessInfo.hProcess != nullptr)
-  {
-    CloseHandle(mEncoderProcessInfo.hProcess);
-    CloseHandle(mEncoderProcessInfo.hThread);
-    std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
-  }
-  // Clean up decoder process handles
-  if (mDecoderProcessInfo.hProcess != nullptr)
+  Log("Stopping FFmpeg processes...");
   {
-    CloseHandle(mDecoderProcessInfo.hProcess);
-    CloseHandle(mDecoderProcessInfo.hThread);
-    std::memset(&mDecoderProcessInfo, 0, sizeof(mDecoderProcessInfo));
+    std::lock_guard<std::mutex> runningLock(sRunningMutex);
+    sRunningManagers.erase(std::remove(sRunningManagers.begin(), sRunningManagers.end(), this),
+                           sRunningManagers.end());
   }
 
-  // Close job object
-  if (mJobObject)
-  {
-    CloseHandle(mJobObject);
-    mJobObject = nullptr;
-  }
+  // Suspended children would never see EOF: wake them before closing input
+  mParkRequested.store(false);
+  mParkCv.notify_all();
+  SetChildrenSuspended(false);
 
-  // Close intermediate pipe handles
-  if (mIntermediatePipeRead != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mIntermediatePipeRead);
-    mIntermediatePipeRead = INVALID_HANDLE_VALUE;
-  }
-  if (mIntermediatePipeWrite != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mIntermediatePipeWrite);
-    mIntermediatePipeWrite = INVALID_HANDLE_VALUE;
-  }
+  StopProcesses();
 
   // Close remaining pipes
   ClosePipes();
@@ -196,34 +400,138 @@ void FFmpegPipeManager::Stop()
   Log("FFmpeg processes stopped");
 }
 
+bool FFmpegPipeManager::Restart()
+{
+  const Config config = mConfig;
+  const bool parked = mParkRequested.load();
+  Stop();
+  if (!Start(config))
+    return false;
+  if (parked)
+    SetParked(true);
+  return true;
+}
+
+bool FFmpegPipeManager::Reconfigure(const Config& config)
+{
+  if (!mStarted)
+    return false;
+
+  mConfig.suspendWhenParked = config.suspendWhenParked;
+  mSuspendWhenParked.store(config.suspendWhenParked);
+  if (!config.suspendWhenParked)
+    SetChildrenSuspended(false);  // Still parked: the input thread just stops feeding
+
+  SchedulingPolicy& scheduling = mConfig.scheduling;
+  if (!mSharedSlot && (scheduling.processes != config.scheduling.processes ||
+                       scheduling.processAffinity != config.scheduling.processAffinity))
+  {
+    scheduling.processes = config.scheduling.processes;
+    scheduling.processAffinity = config.scheduling.processAffinity;
+#ifdef _WIN32
+    SchedulingClass encoderClass = ApplyProcessScheduling(scheduling, mEncoderProcessInfo.hProcess);
+    ApplyProcessScheduling(scheduling, mDecoderProcessInfo.hProcess);
+#else
+    SchedulingClass encoderClass = ApplyProcessScheduling(scheduling, mEncoderPid);
+    ApplyProcessScheduling(scheduling, mDecoderPid);
+#endif
+    Log(std::string("Child process scheduling: ") + SchedulingClassName(encoderClass));
+  }
+  return true;
+}
+
+//==============================================================================
+// Health
+//==============================================================================
+
+FFmpegPipeManager::Progress FFmpegPipeManager::GetProgress() const
+{
+  Progress progress;
+  progress.started = mStartedFlag.load();
+  progress.sampleRate = mConfig.sampleRate;
+  progress.parked = mParkRequested.load(std::memory_order_relaxed);
+  progress.finishing = mInputEndRequested.load();
+  if (mSharedSlot)
+  {
+    progress.failed = progress.started && !mSharedSlot->IsAlive();
+    return progress;
+  }
+  progress.failed = mFailed.load();
+  progress.countersValid = true;
+  const uint64_t bytesPerFrame = sizeof(int16_t) * static_cast<uint64_t>(std::max(1, mConfig.channels));
+  progress.inputFrames = mInputBytesWritten.load(std::memory_order_relaxed) / bytesPerFrame;
+  progress.outputFrames = mOutputFramesDecoded.load(std::memory_order_relaxed);
+  const int64_t writeSince = mInputWriteSince.load(std::memory_order_relaxed);
+  if (writeSince != 0)
+  {
+    const auto blocked = std::chrono::steady_clock::now().time_since_epoch() -
+                         std::chrono::steady_clock::duration(writeSince);
+    progress.inputBlockedMs = static_cast<uint64_t>(
+      std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(blocked).count()));
+  }
+  return progress;
+}
+
 //==============================================================================
 // Data Transfer
 //==============================================================================
 
+bool FFmpegPipeManager::IsRunning() const
+{
+  return mIsRunning && (!mSharedSlot || mSharedSlot->IsAlive());
+}
+
+bool FFmpegPipeManager::HasFirstAudioArrived() const
+{
+  if (mSharedSlot)
+    return mSharedSlot->HasFirstAudioArrived();
+  return mFirstOutputReceived.load(std::memory_order_relaxed);
+}
+
 bool FFmpegPipeManager::WriteSamples(const float* data, size_t numSamples)
 {
-  if (!mIsRunning)
+  CODECSIM_TRACE_SCOPE_VALUE("WriteSamples", numSamples);
+  if (!mIsRunning || mInputEndRequested.load())
     return false;
+  if (mSharedSlot)
+    return mSharedSlot->WriteSamples(data, numSamples);
 
   // Non-blocking: just append to input queue
   size_t totalSamples = numSamples * mConfig.channels;
 
   std::lock_guard<std::mutex> lock(mInputMutex);
   mInputFloatBuffer.insert(mInputFloatBuffer.end(), data, data + totalSamples);
+  if (mMetrics)
+  {
+    const size_t queuedFrames = mInputFloatBuffer.size() / mConfig.channels;
+    PipelineMetrics::Set(mMetrics->inputQueueFrames, queuedFrames);
+    const bool overrun = queuedFrames > static_cast<size_t>(PipelineMetrics::kOverrunSeconds * mConfig.sampleRate);
+    if (overrun && !mInputOverrun)
+      PipelineMetrics::Add(mMetrics->overruns, 1);
+    mInputOverrun = overrun;
+  }
   return true;
 }
 
-size_t FFmpegPipeManager::ReadSamples(float* data, size_t numSamples, DWORD timeout)
+size_t FFmpegPipeManager::ReadSamples(float* data, size_t numSamples, uint32_t timeout)
 {
+  CODECSIM_TRACE_SCOPE_VALUE("ReadSamples", numSamples);
   if (!mIsRunning)
   {
     return 0;
   }
+  if (mSharedSlot)
+    return mSharedSlot->ReadSamples(data, numSamples, timeout);
 
   size_t totalSamples = numSamples * mConfig.channels;
   size_t samplesRead = 0;
 
-  std::lock_guard<std::mutex> lock(mOutputMutex);
+  std::unique_lock<std::mutex> lock(mOutputMutex);
+  if (timeout > 0)
+  {
+    mOutputCv.wait_for(lock, std::chrono::milliseconds(timeout),
+                       [&]() { return mOutputFloatBuffer.size() >= totalSamples || mOutputEnded || !mIsRunning; });
+  }
 
   // Read available samples from buffer
   while (samplesRead < totalSamples && !mOutputFloatBuffer.empty())
@@ -231,23 +539,202 @@ size_t FFmpegPipeManager::ReadSamples(float* data, size_t numSamples, DWORD time
     data[samplesRead++] = mOutputFloatBuffer.front();
     mOutputFloatBuffer.pop();
   }
+  if (mMetrics)
+    PipelineMetrics::Set(mMetrics->outputQueueFrames, mOutputFloatBuffer.size() / mConfig.channels);
 
   return samplesRead / mConfig.channels;
 }
 
 size_t FFmpegPipeManager::AvailableOutputSamples() const
 {
+  if (mSharedSlot)
+    return mSharedSlot->AvailableOutputSamples();
   std::lock_guard<std::mutex> lock(mOutputMutex);
   return mOutputFloatBuffer.size() / mConfig.channels;
 }
 
+void FFmpegPipeManager::SetParked(bool parked)
+{
+  if (mSharedSlot)
+  {
+    mSharedSlot->SetParked(parked);
+    return;
+  }
+  mParkRequested.store(parked);
+  mParkCv.notify_one();
+}
+
+void FFmpegPipeManager::SetChildrenSuspended(bool suspended)
+{
+  std::lock_guard<std::mutex> lock(mSuspendMutex);
+  if (suspended == mChildrenSuspended.load())
+    return;
+
+#ifdef _WIN32
+  static NtProcessControlFn sSuspend = GetNtProcessControl("NtSuspendProcess");
+  static NtProcessControlFn sResume = GetNtProcessControl("NtResumeProcess");
+  NtProcessControlFn fn = suspended ? sSuspend : sResume;
+  if (!fn)
+    return;
+
+  if (mEncoderProcessInfo.hProcess)
+    fn(mEncoderProcessInfo.hProcess);
+  if (mDecoderProcessInfo.hProcess)
+    fn(mDecoderProcessInfo.hProcess);
+#else
+  for (pid_t pid : {mEncoderPid, mDecoderPid})
+  {
+    if (pid > 0)
+      kill(pid, suspended ? SIGSTOP : SIGCONT);
+  }
+#endif
+  mChildrenSuspended.store(suspended);
+  Log(suspended ? "Pipeline parked (processes suspended)" : "Pipeline resumed");
+}
+
 void FFmpegPipeManager::Flush()
 {
+#ifdef _WIN32
   // Close input to signal EOF
   if (mPipes.hInputWrite != INVALID_HANDLE_VALUE)
   {
     FlushFileBuffers(mPipes.hInputWrite);
   }
+#endif
+}
+
+bool FFmpegPipeManager::Finish(uint32_t timeout)
+{
+  if (!mIsRunning || mSharedSlot)
+    return false;
+
+  // The input thread closes stdin once everything queued so far is written
+  mInputEndRequested.store(true);
+  mParkRequested.store(false);
+  mParkCv.notify_all();
+
+  std::unique_lock<std::mutex> lock(mOutputMutex);
+  mOutputCv.wait_for(lock, std::chrono::milliseconds(timeout),
+                     [this]() { return mOutputEnded || !mIsRunning; });
+  return mOutputEnded;
+}
+
+//==============================================================================
+// Resource Accounting
+//==============================================================================
+
+FFmpegPipeManager::ProcessStats FFmpegPipeManager::GetProcessStats()
+{
+  ProcessStats stats;
+  std::lock_guard<std::mutex> lock(sRunningMutex);
+  for (const FFmpegPipeManager* manager : sRunningManagers)
+  {
+    ++stats.pipelines;
+#ifdef _WIN32
+    for (const PROCESS_INFORMATION* pi : {&manager->mEncoderProcessInfo, &manager->mDecoderProcessInfo})
+    {
+      if (!pi->hProcess || WaitForSingleObject(pi->hProcess, 0) != WAIT_TIMEOUT)
+        continue;
+      ++stats.processes;
+      PROCESS_MEMORY_COUNTERS pmc = {};
+      if (K32GetProcessMemoryInfo(pi->hProcess, &pmc, sizeof(pmc)))
+        stats.workingSetBytes += pmc.WorkingSetSize;
+    }
+#else
+    for (pid_t pid : {manager->mEncoderPid, manager->mDecoderPid})
+    {
+      if (pid <= 0 || kill(pid, 0) != 0)
+        continue;
+      ++stats.processes;
+      // Resident set from /proc/<pid>/statm (second field, in pages)
+      std::string path = "/proc/" + std::to_string(pid) + "/statm";
+      if (FILE* f = std::fopen(path.c_str(), "r"))
+      {
+        unsigned long sizePages = 0, residentPages = 0;
+        if (std::fscanf(f, "%lu %lu", &sizePages, &residentPages) == 2)
+          stats.workingSetBytes += residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        std::fclose(f);
+      }
+    }
+#endif
+  }
+  return stats;
+}
+
+void FFmpegPipeManager::SampleChildUsage()
+{
+#ifdef _WIN32
+  const PROCESS_INFORMATION* children[] = {&mEncoderProcessInfo, &mDecoderProcessInfo};
+#else
+  const pid_t children[] = {mEncoderPid, mDecoderPid};
+#endif
+  std::atomic<uint64_t>* cpu[] = {&mMetrics->encoderCpuUs, &mMetrics->decoderCpuUs};
+  std::atomic<uint64_t>* rss[] = {&mMetrics->encoderRssBytes, &mMetrics->decoderRssBytes};
+
+  for (int i = 0; i < 2; ++i)
+  {
+    uint64_t cpuUs = 0, rssBytes = 0;
+#ifdef _WIN32
+    if (HANDLE process = children[i]->hProcess)
+    {
+      FILETIME created, exited, kernel, user;
+      if (GetProcessTimes(process, &created, &exited, &kernel, &user))
+      {
+        auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+        cpuUs = (ticks(kernel) + ticks(user)) / 10;  // 100 ns units
+      }
+      PROCESS_MEMORY_COUNTERS pmc = {};
+      if (K32GetProcessMemoryInfo(process, &pmc, sizeof(pmc)))
+        rssBytes = pmc.WorkingSetSize;
+    }
+#else
+    if (children[i] > 0)
+    {
+      // utime and stime are fields 14 and 15 of /proc/<pid>/stat, after the "(comm)" field
+      std::string path = "/proc/" + std::to_string(children[i]) + "/stat";
+      if (FILE* f = std::fopen(path.c_str(), "r"))
+      {
+        char line[1024] = {};
+        const size_t n = std::fread(line, 1, sizeof(line) - 1, f);
+        std::fclose(f);
+        line[n] = '\0';
+        unsigned long long utime = 0, stime = 0;
+        if (const char* rest = std::strrchr(line, ')'))
+        {
+          if (std::sscanf(rest + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) == 2)
+            cpuUs = (utime + stime) * 1000000ull / static_cast<unsigned long long>(sysconf(_SC_CLK_TCK));
+        }
+      }
+      path = "/proc/" + std::to_string(children[i]) + "/statm";
+      if (FILE* f = std::fopen(path.c_str(), "r"))
+      {
+        unsigned long sizePages = 0, residentPages = 0;
+        if (std::fscanf(f, "%lu %lu", &sizePages, &residentPages) == 2)
+          rssBytes = residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        std::fclose(f);
+      }
+    }
+#endif
+    PipelineMetrics::Set(*cpu[i], cpuUs);
+    PipelineMetrics::Set(*rss[i], rssBytes);
+  }
+}
+
+void FFmpegPipeManager::LogResourceUsage()
+{
+  ProcessStats perInstance = GetProcessStats();
+  auto mb = [](size_t bytes) { return std::to_string(bytes / (1024 * 1024)) + " MB"; };
+#ifdef _WIN32
+  SharedFFmpegWorker::Stats shared = SharedFFmpegWorker::GetStats();
+  Log("ffmpeg usage: per-instance " + std::to_string(perInstance.pipelines) + " pipelines / " +
+      std::to_string(perInstance.processes) + " processes / " + mb(perInstance.workingSetBytes) +
+      ", shared " + std::to_string(shared.slotsInUse) + " streams on " +
+      std::to_string(shared.workers) + " workers / " + std::to_string(shared.processes) +
+      " processes / " + mb(shared.workingSetBytes));
+#else
+  Log("ffmpeg usage: " + std::to_string(perInstance.pipelines) + " pipelines / " +
+      std::to_string(perInstance.processes) + " processes / " + mb(perInstance.workingSetBytes));
+#endif
 }
 
 //==============================================================================
@@ -260,104 +747,174 @@ void FFmpegPipeManager::SetLogCallback(std::function<void(const std::string&)> c
 }
 
 //==============================================================================
-// Internal Methods - Pipe Management
+// Child processes
 //==============================================================================
 
-bool FFmpegPipeManager::CreatePipes()
+#ifdef _WIN32
+bool FFmpegPipeManager::CreateChildPipe(HANDLE& readEnd, HANDLE& writeEnd, bool childReads)
 {
   SECURITY_ATTRIBUTES sa;
   sa.nLength = sizeof(SECURITY_ATTRIBUTES);
   sa.bInheritHandle = TRUE;
   sa.lpSecurityDescriptor = nullptr;
 
-  // Create stdin pipe
-  if (!CreatePipe(&mPipes.hInputRead, &mPipes.hInputWrite, &sa, 0))
+  if (!CreatePipe(&readEnd, &writeEnd, &sa, 0))
+    return false;
+
+  // Ensure our end is not inherited
+  if (!SetHandleInformation(childReads ? writeEnd : readEnd, HANDLE_FLAG_INHERIT, 0))
   {
-    LogError("Failed to create input pipe");
+    ClosePipe(readEnd);
+    ClosePipe(writeEnd);
     return false;
   }
+  return true;
+}
 
-  // Ensure write handle is not inherited
-  if (!SetHandleInformation(mPipes.hInputWrite, HANDLE_FLAG_INHERIT, 0))
+bool FFmpegPipeManager::SpawnChild(const std::string& command, HANDLE stdIn, HANDLE stdOut, HANDLE stdErr,
+                                   bool lowPriority, PROCESS_INFORMATION& child, long& error)
+{
+  // Handles the caller has no use for go to NUL
+  HANDLE nul = INVALID_HANDLE_VALUE;
+  if (stdIn == INVALID_HANDLE_VALUE || stdOut == INVALID_HANDLE_VALUE || stdErr == INVALID_HANDLE_VALUE)
   {
-    LogError("Failed to set input pipe handle information");
-    ClosePipes();
+    SECURITY_ATTRIBUTES sa;
+    sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+    sa.bInheritHandle = TRUE;
+    sa.lpSecurityDescriptor = nullptr;
+    nul = CreateFileA("NUL", GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &sa,
+                      OPEN_EXISTING, 0, nullptr);
+  }
+  auto orNul = [nul](HANDLE handle) { return handle != INVALID_HANDLE_VALUE ? handle : nul; };
+
+  STARTUPINFOA si;
+  std::memset(&si, 0, sizeof(si));
+  si.cb = sizeof(STARTUPINFOA);
+  si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
+  si.hStdInput = orNul(stdIn);
+  si.hStdOutput = orNul(stdOut);
+  si.hStdError = orNul(stdErr);
+  si.wShowWindow = SW_HIDE;
+
+  std::vector<char> cmdBuf(command.begin(), command.end());
+  cmdBuf.push_back('\0');
+
+  std::memset(&child, 0, sizeof(child));
+  const DWORD flags = CREATE_NO_WINDOW | (lowPriority ? IDLE_PRIORITY_CLASS : 0);
+  const BOOL success = CreateProcessA(nullptr, cmdBuf.data(), nullptr, nullptr, TRUE, flags, nullptr, nullptr,
+                                      &si, &child);
+  error = success ? 0 : static_cast<long>(GetLastError());
+  ClosePipe(nul);
+  return success != FALSE;
+}
+#else
+bool FFmpegPipeManager::CreateChildPipe(int& readEnd, int& writeEnd, bool /*childReads*/)
+{
+  // Close-on-exec on both ends: posix_spawn's dup2 clears the flag on the
+  // descriptors a child is meant to have
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) != 0)
     return false;
+  readEnd = fds[0];
+  writeEnd = fds[1];
+  return true;
+}
+
+bool FFmpegPipeManager::SpawnChild(const std::string& command, int stdIn, int stdOut, int stdErr,
+                                   bool lowPriority, pid_t& child, long& error)
+{
+  posix_spawn_file_actions_t actions;
+  int result = posix_spawn_file_actions_init(&actions);
+  if (result != 0)
+  {
+    error = result;
+    return false;
+  }
+  const int handles[] = {stdIn, stdOut, stdErr};
+  const int targets[] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+  for (int i = 0; i < 3; ++i)
+  {
+    if (handles[i] >= 0)
+      posix_spawn_file_actions_adddup2(&actions, handles[i], targets[i]);
+    else
+      posix_spawn_file_actions_addopen(&actions, targets[i], "/dev/null", i == 0 ? O_RDONLY : O_WRONLY, 0);
   }
 
-  // Create stdout pipe
-  if (!CreatePipe(&mPipes.hOutputRead, &mPipes.hOutputWrite, &sa, 0))
+  // Same quoting rules as the Windows command line; 'exec' makes the pid the program itself
+  std::string script = "exec " + command;
+  char shell[] = "/bin/sh";
+  char flag[] = "-c";
+  char* argv[] = {shell, flag, &script[0], nullptr};
+
+  result = posix_spawn(&child, shell, &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (result != 0)
   {
-    LogError("Failed to create output pipe");
-    ClosePipes();
+    child = -1;
+    error = result;
     return false;
   }
+  if (lowPriority)
+    setpriority(PRIO_PROCESS, child, 19);
+  error = 0;
+  return true;
+}
+#endif
 
-  // Ensure read handle is not inherited
-  if (!SetHandleInformation(mPipes.hOutputRead, HANDLE_FLAG_INHERIT, 0))
+//==============================================================================
+// Internal Methods - Pipe Management
+//==============================================================================
+
+bool FFmpegPipeManager::CreatePipes()
+{
+  if (!CreateChildPipe(mPipes.hInputRead, mPipes.hInputWrite, true))
   {
-    LogError("Failed to set output pipe handle information");
-    ClosePipes();
+    LogError("Failed to create input pipe");
     return false;
   }
 
-  // Create stderr pipe
-  if (!CreatePipe(&mPipes.hErrorRead, &mPipes.hErrorWrite, &sa, 0))
+  if (!CreateChildPipe(mPipes.hOutputRead, mPipes.hOutputWrite, false))
   {
-    LogError("Failed to create error pipe");
+    LogError("Failed to create output pipe");
     ClosePipes();
     return false;
   }
 
-  // Ensure read handle is not inherited
-  if (!SetHandleInformation(mPipes.hErrorRead, HANDLE_FLAG_INHERIT, 0))
+  if (!CreateChildPipe(mPipes.hErrorRead, mPipes.hErrorWrite, false))
   {
-    LogError("Failed to set error pipe handle information");
+    LogError("Failed to create error pipe");
     ClosePipes();
     return false;
   }
 
+#ifndef _WIN32
+  // Our write end must never block the input thread indefinitely (see WritePipe)
+  fcntl(mPipes.hInputWrite, F_SETFL, fcntl(mPipes.hInputWrite, F_GETFL) | O_NONBLOCK);
+#endif
   return true;
 }
 
 void FFmpegPipeManager::ClosePipes()
 {
-  if (mPipes.hInputRead != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hInputRead);
-    mPipes.hInputRead = INVALID_HANDLE_VALUE;
-  }
-  if (mPipes.hInputWrite != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hInputWrite);
-    mPipes.hInputWrite = INVALID_HANDLE_VALUE;
-  }
-  if (mPipes.hOutputRead != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hOutputRead);
-    mPipes.hOutputRead = INVALID_HANDLE_VALUE;
-  }
-  if (mPipes.hOutputWrite != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hOutputWrite);
-    mPipes.hOutputWrite = INVALID_HANDLE_VALUE;
-  }
-  if (mPipes.hErrorRead != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hErrorRead);
-    mPipes.hErrorRead = INVALID_HANDLE_VALUE;
-  }
-  if (mPipes.hErrorWrite != INVALID_HANDLE_VALUE)
-  {
-    CloseHandle(mPipes.hErrorWrite);
-    mPipes.hErrorWrite = INVALID_HANDLE_VALUE;
-  }
+  ClosePipe(mPipes.hInputRead);
+  ClosePipe(mPipes.hInputWrite);
+  ClosePipe(mPipes.hOutputRead);
+  ClosePipe(mPipes.hOutputWrite);
+  ClosePipe(mPipes.hErrorRead);
+  ClosePipe(mPipes.hErrorWrite);
+}
+
+void FFmpegPipeManager::CloseInputPipe()
+{
+  std::lock_guard<std::mutex> lock(mInputMutex);
+  ClosePipe(mPipes.hInputWrite);
 }
 
 //==============================================================================
 // Internal Methods - Process Management
 //==============================================================================
 
+#ifdef _WIN32
 bool FFmpegPipeManager::LaunchProcesses(const Config& config)
 {
   // Create intermediate pipe (encoder stdout -> decoder stdin)
@@ -389,72 +946,36 @@ bool FFmpegPipeManager::LaunchProcesses(const Config& config)
 
   // === Launch Encoder Process ===
   // stdin=our input pipe, stdout=intermediate pipe write, stderr=our error pipe
+  long error = 0;
+  if (!SpawnChild(encoderCmd, mPipes.hInputRead, mIntermediatePipeWrite, mPipes.hErrorWrite, false,
+                  mEncoderProcessInfo, error))
   {
-    STARTUPINFOA si;
-    std::memset(&si, 0, sizeof(si));
-    si.cb = sizeof(STARTUPINFOA);
-    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
-    si.hStdInput = mPipes.hInputRead;
-    si.hStdOutput = mIntermediatePipeWrite;
-    si.hStdError = mPipes.hErrorWrite;
-    si.wShowWindow = SW_HIDE;
-
-    std::vector<char> cmdBuf(encoderCmd.begin(), encoderCmd.end());
-    cmdBuf.push_back('\0');
-
-    BOOL success = CreateProcessA(
-      nullptr, cmdBuf.data(), nullptr, nullptr,
-      TRUE, CREATE_NO_WINDOW, nullptr, nullptr,
-      &si, &mEncoderProcessInfo
-    );
-
-    if (!success)
-    {
-      DWORD error = GetLastError();
-      LogError("Failed to create encoder process (error: " + std::to_string(error) + ")");
-      return false;
-    }
-
-    if (mJobObject)
-      AssignProcessToJobObject(mJobObject, mEncoderProcessInfo.hProcess);
+    LogError("Failed to create encoder process (error: " + std::to_string(error) + ")");
+    return false;
   }
+  if (mJobObject)
+    AssignProcessToJobObject(mJobObject, mEncoderProcessInfo.hProcess);
 
   // === Launch Decoder Process ===
   // stdin=intermediate pipe read, stdout=our output pipe, stderr=our error pipe
+  if (!SpawnChild(decoderCmd, mIntermediatePipeRead, mPipes.hOutputWrite, mPipes.hErrorWrite, false,
+                  mDecoderProcessInfo, error))
   {
-    STARTUPINFOA si;
-    std::memset(&si, 0, sizeof(si));
-    si.cb = sizeof(STARTUPINFOA);
-    si.dwFlags = STARTF_USESTDHANDLES | STARTF_USESHOWWINDOW;
-    si.hStdInput = mIntermediatePipeRead;
-    si.hStdOutput = mPipes.hOutputWrite;
-    si.hStdError = mPipes.hErrorWrite;
-    si.wShowWindow = SW_HIDE;
-
-    std::vector<char> cmdBuf(decoderCmd.begin(), decoderCmd.end());
-    cmdBuf.push_back('\0');
-
-    BOOL success = CreateProcessA(
-      nullptr, cmdBuf.data(), nullptr, nullptr,
-      TRUE, CREATE_NO_WINDOW, nullptr, nullptr,
-      &si, &mDecoderProcessInfo
-    );
-
-    if (!success)
-    {
-      DWORD error = GetLastError();
-      LogError("Failed to create decoder process (error: " + std::to_string(error) + ")");
-      // Kill encoder since decoder failed
-      ::TerminateProcess(mEncoderProcessInfo.hProcess, 1);
-      CloseHandle(mEncoderProcessInfo.hProcess);
-      CloseHandle(mEncoderProcessInfo.hThread);
-      std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
-      return false;
-    }
-
-    if (mJobObject)
-      AssignProcessToJobObject(mJobObject, mDecoderProcessInfo.hProcess);
+    LogError("Failed to create decoder process (error: " + std::to_string(error) + ")");
+    // Kill encoder since decoder failed
+    ::TerminateProcess(mEncoderProcessInfo.hProcess, 1);
+    CloseHandle(mEncoderProcessInfo.hProcess);
+    CloseHandle(mEncoderProcessInfo.hThread);
+    std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
+    return false;
   }
+  if (mJobObject)
+    AssignProcessToJobObject(mJobObject, mDecoderProcessInfo.hProcess);
+
+  // Keep the children from being preempted by the host's own load
+  SchedulingClass encoderClass = ApplyProcessScheduling(config.scheduling, mEncoderProcessInfo.hProcess);
+  ApplyProcessScheduling(config.scheduling, mDecoderProcessInfo.hProcess);
+  Log(std::string("Child process scheduling: ") + SchedulingClassName(encoderClass));
 
   // Close pipe ends that belong to child processes
   CloseHandle(mPipes.hInputRead);
@@ -509,6 +1030,169 @@ void FFmpegPipeManager::TerminateProcesses()
   }
 }
 
+void FFmpegPipeManager::StopProcesses()
+{
+  // Close write end of input pipe to signal EOF to encoder
+  CloseInputPipe();
+
+  // Wait briefly for graceful process exit
+  bool encoderAlive = false;
+  bool decoderAlive = false;
+
+  if (mEncoderProcessInfo.hProcess != nullptr)
+  {
+    DWORD waitResult = WaitForSingleObject(mEncoderProcessInfo.hProcess, 2000);
+    encoderAlive = (waitResult == WAIT_TIMEOUT);
+  }
+  if (mDecoderProcessInfo.hProcess != nullptr)
+  {
+    DWORD waitResult = WaitForSingleObject(mDecoderProcessInfo.hProcess, 2000);
+    decoderAlive = (waitResult == WAIT_TIMEOUT);
+  }
+
+  if (encoderAlive || decoderAlive)
+  {
+    Log("FFmpeg processes did not exit gracefully, forcing termination");
+    if (mJobObject)
+    {
+      CloseHandle(mJobObject);
+      mJobObject = nullptr;
+    }
+    if (encoderAlive && mEncoderProcessInfo.hProcess)
+      ::TerminateProcess(mEncoderProcessInfo.hProcess, 1);
+    if (decoderAlive && mDecoderProcessInfo.hProcess)
+      ::TerminateProcess(mDecoderProcessInfo.hProcess, 1);
+  }
+
+  // Join threads
+  if (mInputThread.joinable()) mInputThread.join();
+  if (mOutputThread.joinable()) mOutputThread.join();
+  if (mErrorThread.joinable()) mErrorThread.join();
+
+  // Clean up encoder process handles
+  if (mEncoderProcessInfo.hProcess != nullptr)
+  {
+    CloseHandle(mEncoderProcessInfo.hProcess);
+    CloseHandle(mEncoderProcessInfo.hThread);
+    std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
+  }
+  // Clean up decoder process handles
+  if (mDecoderProcessInfo.hProcess != nullptr)
+  {
+    CloseHandle(mDecoderProcessInfo.hProcess);
+    CloseHandle(mDecoderProcessInfo.hThread);
+    std::memset(&mDecoderProcessInfo, 0, sizeof(mDecoderProcessInfo));
+  }
+
+  // Close job object
+  if (mJobObject)
+  {
+    CloseHandle(mJobObject);
+    mJobObject = nullptr;
+  }
+
+  // Close intermediate pipe handles
+  ClosePipe(mIntermediatePipeRead);
+  ClosePipe(mIntermediatePipeWrite);
+}
+#else
+bool FFmpegPipeManager::LaunchProcesses(const Config& config)
+{
+  // Create intermediate pipe (encoder stdout -> decoder stdin)
+  int intermediate[2];
+  if (pipe2(intermediate, O_CLOEXEC) != 0)
+  {
+    LogError("Failed to create intermediate pipe");
+    return false;
+  }
+  mIntermediatePipeRead = intermediate[0];
+  mIntermediatePipeWrite = intermediate[1];
+
+  // Build command lines
+  std::string encoderCmd = BuildEncoderCommand(config);
+  std::string decoderCmd = BuildDecoderCommand(config);
+  Log("Encoder command: " + encoderCmd);
+  Log("Decoder command: " + decoderCmd);
+
+  // === Launch Encoder Process ===
+  long error = 0;
+  if (!SpawnChild(encoderCmd, mPipes.hInputRead, mIntermediatePipeWrite, mPipes.hErrorWrite, false, mEncoderPid,
+                  error))
+  {
+    LogError("Failed to create encoder process (" + std::string(std::strerror(static_cast<int>(error))) + ")");
+    return false;
+  }
+
+  // === Launch Decoder Process ===
+  if (!SpawnChild(decoderCmd, mIntermediatePipeRead, mPipes.hOutputWrite, mPipes.hErrorWrite, false, mDecoderPid,
+                  error))
+  {
+    LogError("Failed to create decoder process (" + std::string(std::strerror(static_cast<int>(error))) + ")");
+    // Kill encoder since decoder failed
+    KillAndReap(mEncoderPid);
+    mEncoderPid = -1;
+    return false;
+  }
+
+  // Keep the children from being preempted by other load
+  SchedulingClass encoderClass = ApplyProcessScheduling(config.scheduling, mEncoderPid);
+  ApplyProcessScheduling(config.scheduling, mDecoderPid);
+  Log(std::string("Child process scheduling: ") + SchedulingClassName(encoderClass));
+
+  // Close pipe ends that belong to child processes
+  ClosePipe(mPipes.hInputRead);
+  ClosePipe(mPipes.hOutputWrite);
+  ClosePipe(mPipes.hErrorWrite);
+  ClosePipe(mIntermediatePipeWrite);
+  ClosePipe(mIntermediatePipeRead);
+
+  return true;
+}
+
+void FFmpegPipeManager::TerminateProcesses()
+{
+  for (pid_t* pid : {&mEncoderPid, &mDecoderPid})
+  {
+    if (*pid > 0)
+    {
+      KillAndReap(*pid);
+      *pid = -1;
+    }
+  }
+}
+
+void FFmpegPipeManager::StopProcesses()
+{
+  // The input thread only blocks for 100 ms at a time, so it can be joined
+  // before its descriptor is closed (a descriptor closed under a running
+  // write() could be reused by a concurrent pipeline)
+  if (mInputThread.joinable()) mInputThread.join();
+
+  // Close write end of input pipe to signal EOF to encoder
+  CloseInputPipe();
+
+  // Wait briefly for graceful process exit
+  bool encoderAlive = mEncoderPid > 0 && !WaitForExit(mEncoderPid, 2000);
+  bool decoderAlive = mDecoderPid > 0 && !WaitForExit(mDecoderPid, 2000);
+  if (encoderAlive || decoderAlive)
+    Log("FFmpeg processes did not exit gracefully, forcing termination");
+  if (encoderAlive)
+    KillAndReap(mEncoderPid);
+  if (decoderAlive)
+    KillAndReap(mDecoderPid);
+  mEncoderPid = -1;
+  mDecoderPid = -1;
+
+  // Both children are gone, so the output and stderr pipes report EOF
+  if (mOutputThread.joinable()) mOutputThread.join();
+  if (mErrorThread.joinable()) mErrorThread.join();
+
+  // Close intermediate pipe handles
+  ClosePipe(mIntermediatePipeRead);
+  ClosePipe(mIntermediatePipeWrite);
+}
+#endif
+
 std::string FFmpegPipeManager::BuildEncoderCommand(const Config& config) const
 {
   std::string muxFormat = config.muxerFormat;
@@ -527,6 +1211,7 @@ std::string FFmpegPipeManager::BuildEncoderCommand(const Config& config) const
   if (!config.additionalArgs.empty())
     oss << " " << config.additionalArgs;
   oss << " -f " << muxFormat;
+  oss << GetLowDelayMuxArgs(config, muxFormat);
   oss << " pipe:1";
 
   return oss.str();
@@ -556,6 +1241,21 @@ std::string FFmpegPipeManager::BuildDecoderCommand(const Config& config) const
   return oss.str();
 }
 
+std::string FFmpegPipeManager::GetLowDelayMuxArgs(const Config& config, const std::string& muxFormat)
+{
+  if (!config.lowDelayMux)
+    return std::string();
+
+  // Hand every packet to the decoder as soon as it is encoded; containers
+  // that batch packets into pages/clusters are told to keep them short
+  std::string args = " -flush_packets 1";
+  if (muxFormat == "ogg")
+    args += " -page_duration 20000";   // microseconds
+  else if (muxFormat == "matroska")
+    args += " -cluster_time_limit 20"; // milliseconds
+  return args;
+}
+
 std::string FFmpegPipeManager::GetIntermediateFormat(const std::string& codecName) const
 {
   // Map codec names to appropriate container formats
@@ -579,23 +1279,17 @@ std::string FFmpegPipeManager::GetIntermediateFormat(const std::string& codecNam
 
 void FFmpegPipeManager::ErrorReadThread()
 {
+  CODECSIM_TRACE_THREAD_NAME("pipe-stderr");
   char buffer[4096];
-  DWORD bytesRead;
+  size_t bytesRead = 0;
+  long error = 0;
 
   while (mIsRunning)
   {
-    BOOL success = ReadFile(
-      mPipes.hErrorRead,
-      buffer,
-      sizeof(buffer) - 1,
-      &bytesRead,
-      nullptr
-    );
-
-    if (!success || bytesRead == 0)
+    PipeStatus status = ReadPipe(mPipes.hErrorRead, buffer, sizeof(buffer) - 1, bytesRead, error);
+    if (status != PipeStatus::Ok)
     {
-      DWORD error = GetLastError();
-      if (error != ERROR_BROKEN_PIPE)
+      if (status == PipeStatus::Failed)
       {
         Log("Error pipe read failed: " + std::to_string(error));
       }
@@ -609,29 +1303,38 @@ void FFmpegPipeManager::ErrorReadThread()
 
 void FFmpegPipeManager::OutputReadThread()
 {
+  CODECSIM_TRACE_THREAD_NAME("pipe-output");
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
   std::vector<uint8_t> tempBuffer(mConfig.bufferSize);
-  DWORD bytesRead;
+  size_t bytesRead = 0;
+  long error = 0;
 
   while (mIsRunning)
   {
-    BOOL success = ReadFile(
-      mPipes.hOutputRead,
-      tempBuffer.data(),
-      static_cast<DWORD>(tempBuffer.size()),
-      &bytesRead,
-      nullptr
-    );
-
-    if (!success || bytesRead == 0)
+    PipeStatus status = ReadPipe(mPipes.hOutputRead, tempBuffer.data(), tempBuffer.size(), bytesRead, error);
+    if (status != PipeStatus::Ok)
     {
-      DWORD error = GetLastError();
-      if (error != ERROR_BROKEN_PIPE && error != ERROR_NO_DATA)
+      if (status == PipeStatus::Failed)
       {
         Log("Output pipe read failed: " + std::to_string(error));
       }
+      if (mIsRunning && !mInputEndRequested.load())
+      {
+        Log("Decoder output ended unexpectedly - FFmpeg process may have terminated");
+        mFailed.store(true);
+      }
+
+      // Decoder is done: release Finish() and blocking readers
+      std::lock_guard<std::mutex> lock(mOutputMutex);
+      mOutputEnded = true;
+      mOutputCv.notify_all();
       break;
     }
 
+    CODECSIM_TRACE_INSTANT("PipeRead", bytesRead);
+    if (mMetrics)
+      PipelineMetrics::Add(mMetrics->outputBytes, bytesRead);
+
     // Store raw bytes
     std::lock_guard<std::mutex> lock(mOutputMutex);
     mOutputRawBuffer.insert(mOutputRawBuffer.end(),
@@ -658,10 +1361,20 @@ void FFmpegPipeManager::OutputReadThread()
       {
         mOutputFloatBuffer.push(sample);
       }
+      mOutputFramesDecoded.fetch_add(numCompleteSamples, std::memory_order_relaxed);
 
       // Signal first audio arrival
       if (!mFirstOutputReceived.load(std::memory_order_relaxed))
+      {
         mFirstOutputReceived.store(true, std::memory_order_relaxed);
+        CODECSIM_TRACE_INSTANT("FirstAudio", numCompleteSamples);
+        if (mMetrics)
+          PipelineMetrics::Set(mMetrics->timeToFirstAudioUs, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStartTime).count()));
+      }
+      if (mMetrics)
+        PipelineMetrics::Set(mMetrics->outputQueueFrames, mOutputFloatBuffer.size() / mConfig.channels);
+      mOutputCv.notify_all();
 
       // Remove processed bytes
       mOutputRawBuffer.erase(mOutputRawBuffer.begin(),
@@ -672,24 +1385,66 @@ void FFmpegPipeManager::OutputReadThread()
 
 void FFmpegPipeManager::InputWriteThread()
 {
+  CODECSIM_TRACE_THREAD_NAME("pipe-input");
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+  Log(std::string("I/O thread scheduling: ") + SchedulingClassName(scheduling.GetEffectiveClass()));
+
+#ifndef _WIN32
+  // An encoder that dies must surface as EPIPE here, not kill the host process
+  sigset_t sigpipe;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+#endif
+
   std::vector<float> localBuffer;
   std::vector<int16_t> s16Buffer;
+  auto nextUsageSample = std::chrono::steady_clock::now();
 
   while (mIsRunning)
   {
-    // Grab data from the input queue
+    if (mMetrics && std::chrono::steady_clock::now() >= nextUsageSample)
+    {
+      SampleChildUsage();
+      nextUsageSample += std::chrono::milliseconds(500);
+    }
+
+    // Parked: stop feeding, optionally suspend the children, and sleep until woken
+    if (mParkRequested.load())
+    {
+      if (mSuspendWhenParked.load(std::memory_order_relaxed))
+        SetChildrenSuspended(true);
+      std::unique_lock<std::mutex> lock(mParkMutex);
+      mParkCv.wait_for(lock, std::chrono::milliseconds(100),
+                       [this]() { return !mParkRequested.load() || !mIsRunning; });
+      continue;
+    }
+    if (mChildrenSuspended.load())
+      SetChildrenSuspended(false);
+
+    // Grab data from the input queue (read the end flag first so nothing
+    // queued before Finish() is left behind)
+    const bool endRequested = mInputEndRequested.load();
     {
       std::lock_guard<std::mutex> lock(mInputMutex);
       if (!mInputFloatBuffer.empty())
       {
         localBuffer.swap(mInputFloatBuffer);
         mInputFloatBuffer.clear();
+        mInputOverrun = false;
+        if (mMetrics)
+          PipelineMetrics::Set(mMetrics->inputQueueFrames, 0);
       }
     }
 
     if (localBuffer.empty())
     {
-      Sleep(1);  // Reduce CPU load when no data
+      if (endRequested)
+      {
+        CloseInputPipe();  // EOF: encoder flushes, decoder follows
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Reduce CPU load when no data
       continue;
     }
 
@@ -699,32 +1454,46 @@ void FFmpegPipeManager::InputWriteThread()
     localBuffer.clear();
 
     // Write to pipe (blocking OK - this is a worker thread)
-    DWORD bytesToWrite = static_cast<DWORD>(s16Buffer.size() * sizeof(int16_t));
-    DWORD bytesWritten = 0;
-    DWORD offset = 0;
+    const size_t bytesToWrite = s16Buffer.size() * sizeof(int16_t);
+    CODECSIM_TRACE_SCOPE_VALUE("PipeWrite", bytesToWrite);
+    size_t bytesWritten = 0;
+    size_t offset = 0;
+    long error = 0;
 
     while (offset < bytesToWrite && mIsRunning)
     {
-      BOOL success = WriteFile(
+      // A wedged encoder stops reading and the write makes no progress (blocks,
+      // or keeps returning 0 bytes); the watchdog sees that as Progress::inputBlockedMs
+      if (mInputWriteSince.load(std::memory_order_relaxed) == 0)
+        mInputWriteSince.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+      PipeStatus status = WritePipe(
         mPipes.hInputWrite,
         reinterpret_cast<const uint8_t*>(s16Buffer.data()) + offset,
         bytesToWrite - offset,
-        &bytesWritten,
-        nullptr
+        bytesWritten,
+        error
       );
+      if (status != PipeStatus::Ok || bytesWritten > 0)
+        mInputWriteSince.store(0, std::memory_order_relaxed);
 
-      if (!success || bytesWritten == 0)
+      if (status != PipeStatus::Ok)
       {
-        DWORD error = GetLastError();
-        if (error == ERROR_BROKEN_PIPE || error == ERROR_NO_DATA)
+        if (status == PipeStatus::Closed)
         {
           Log("Input pipe broken - FFmpeg process may have terminated");
+          mFailed.store(true);
           mIsRunning = false;
+          mOutputCv.notify_all();
         }
         break;
       }
       offset += bytesWritten;
+      // Counted per partial write: input the encoder took before wedging is still "fed"
+      mInputBytesWritten.fetch_add(bytesWritten, std::memory_order_relaxed);
     }
+    mInputWriteSince.store(0, std::memory_order_relaxed);
+    if (mMetrics)
+      PipelineMetrics::Add(mMetrics->inputBytes, offset);
   }
 }
 
@@ -736,14 +1505,10 @@ void FFmpegPipeManager::FloatToS16LE(const float* input, int16_t* output, size_t
 {
   for (size_t i = 0; i < numSamples; ++i)
   {
-    float sample = input[i];
-
-    // Clamp to [-1.0, 1.0]
-    sample = std::max(-1.0f, std::min(1.0f, sample));
-
-    // Convert to S16
-    int32_t intSample = static_cast<int32_t>(sample * 32767.0f);
-    output[i] = static_cast<int16_t>(intSample);
+    // Same scale both ways (x32768 here, /32768 in S16LEToFloat), rounded to
+    // nearest and clamped, so every s16 value survives s16 -> float -> s16
+    const float scaled = std::max(-32768.0f, std::min(32767.0f, input[i] * 32768.0f));
+    output[i] = static_cast<int16_t>(std::lrint(scaled));
   }
 }
 
@@ -771,6 +1536,7 @@ void FFmpegPipeManager::LogError(const std::string& message)
 {
   mLastError = message;
 
+#ifdef _WIN32
   DWORD error = ::GetLastError();
   std::string fullMessage = message;
   if (error != 0)
@@ -787,6 +1553,12 @@ void FFmpegPipeManager::LogError(const std::string& message)
     );
     fullMessage += " (Windows error: " + std::string(buf) + ")";
   }
+#else
+  int error = errno;
+  std::string fullMessage = message;
+  if (error != 0)
+    fullMessage += " (" + std::string(std::strerror(error)) + ")";
+#endif
 
   Log("ERROR: " + fullMessage);
 }
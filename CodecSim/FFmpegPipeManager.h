@@ -6,11 +6,12 @@
 // Copyright 2025 MouseSoft
 //==============================================================================
 
-#ifndef _WIN32
-  #error "FFmpegPipeManager.h is Windows-only."
-#endif
-
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <mutex>
@@ -18,10 +19,19 @@
 #include <atomic>
 #include <functional>
 #include <queue>
+#include <condition_variable>
+#include <memory>
+#include "PipelineMetrics.h"
+#include "ThreadScheduling.h"
+#include "TraceRecorder.h"
+
+class SharedFFmpegSlot;
 
 //==============================================================================
 // FFmpegPipeManager Class
 // Manages ffmpeg.exe process with pipe communication for real-time audio processing
+// (Windows: CreateProcess + anonymous pipes; POSIX: posix_spawn + pipes, used
+// by the headless CLI. Shared workers are Windows-only.)
 //==============================================================================
 
 class FFmpegPipeManager
@@ -38,6 +48,7 @@ public:
   FFmpegPipeManager& operator=(const FFmpegPipeManager&) = delete;
 
   // Resolve ffmpeg.exe path: first checks next to the running executable, then falls back to PATH
+  // (POSIX: "ffmpeg" next to the executable, then PATH)
   static std::string ResolveFFmpegPath();
 
   //--------------------------------------------------------------------------
@@ -54,6 +65,11 @@ public:
     std::string muxerFormat;          // Container format for encoder output (e.g., "mp3", "adts", "ogg")
     std::string demuxerFormat;        // Container format for decoder input (e.g., "mp3", "aac", "ogg")
     size_t bufferSize;                // Internal buffer size in bytes
+    bool suspendWhenParked;           // Suspend child processes while parked (not just stop feeding)
+    bool sharedWorker;                // Join a SharedFFmpegWorker instead of spawning a private pair
+    int sharedSlots;                  // Streams per shared worker (only with sharedWorker)
+    SchedulingPolicy scheduling;      // Priority/affinity for the pipe threads and ffmpeg children
+    bool lowDelayMux;                 // Flush every packet and keep container pages/clusters short
 
     Config()
       : ffmpegPath(ResolveFFmpegPath())
@@ -62,9 +78,77 @@ public:
       , channels(2)
       , bitrate(128000)
       , bufferSize(65536)
+      , suspendWhenParked(true)
+      , sharedWorker(false)
+      , sharedSlots(8)
+      , lowDelayMux(false)
     {}
   };
 
+  //--------------------------------------------------------------------------
+  // Resource accounting
+  //--------------------------------------------------------------------------
+  struct ProcessStats
+  {
+    int pipelines = 0;           // Running per-instance pipelines
+    int processes = 0;           // Live per-instance ffmpeg processes
+    size_t workingSetBytes = 0;  // Sum of their working sets
+  };
+
+  /**
+   * Count per-instance ffmpeg processes and their memory use
+   * (shared workers are reported by SharedFFmpegWorker::GetStats)
+   * @return Snapshot of all running per-instance pipelines
+   */
+  static ProcessStats GetProcessStats();
+
+  //--------------------------------------------------------------------------
+  // Child processes (also used by SharedFFmpegWorker and LosslessVerifier)
+  //--------------------------------------------------------------------------
+
+#ifdef _WIN32
+  using PipeHandle = HANDLE;
+  using ChildProcess = PROCESS_INFORMATION;  // Caller closes hProcess and hThread
+  static PipeHandle InvalidPipe() { return INVALID_HANDLE_VALUE; }
+#else
+  using PipeHandle = int;                    // File descriptor
+  using ChildProcess = pid_t;                // Caller reaps it
+  static PipeHandle InvalidPipe() { return -1; }
+#endif
+
+  /**
+   * Create a pipe for a child's stdin (childReads) or stdout/stderr. Only the
+   * child's end can be inherited; ours stays private to this process, so other
+   * pipelines' children never hold it open.
+   */
+  static bool CreateChildPipe(PipeHandle& readEnd, PipeHandle& writeEnd, bool childReads);
+
+  /**
+   * Start a command line (quoted as for BuildEncoderCommand) as a hidden child
+   * process. POSIX runs it through /bin/sh with 'exec', so the child is the
+   * program itself.
+   * @param stdIn, stdOut, stdErr The child's standard handles; InvalidPipe() = null device
+   * @param lowPriority Idle priority class / nice 19
+   * @param error OS error code on failure
+   */
+  static bool SpawnChild(const std::string& command, PipeHandle stdIn, PipeHandle stdOut, PipeHandle stdErr,
+                         bool lowPriority, ChildProcess& child, long& error);
+
+  //--------------------------------------------------------------------------
+  // Format Conversion
+  //--------------------------------------------------------------------------
+
+  /**
+   * Convert float samples to S16LE format (x32768, round to nearest, clamp to
+   * [-32768, 32767]); exact inverse of S16LEToFloat for every s16 value
+   */
+  static void FloatToS16LE(const float* input, int16_t* output, size_t numSamples);
+
+  /**
+   * Convert S16LE format to float samples
+   */
+  static void S16LEToFloat(const int16_t* input, float* output, size_t numSamples);
+
   //--------------------------------------------------------------------------
   // Lifecycle
   //--------------------------------------------------------------------------
@@ -85,7 +169,48 @@ public:
    * Check if ffmpeg process is running
    * @return true if running, false otherwise
    */
-  bool IsRunning() const { return mIsRunning; }
+  bool IsRunning() const;
+
+  /**
+   * Stop and start again with the Config of the last Start() (watchdog
+   * recovery). A parked pipeline comes back parked.
+   * @return true if the new pipeline started
+   */
+  bool Restart();
+
+  /**
+   * Apply the settings a running pipeline can take without new processes:
+   * suspendWhenParked and the children's scheduling class/affinity (a class of
+   * Default leaves their current priority). Everything else in config is
+   * ignored; callers classify changes with DiffPipelineConfig() first.
+   * Not concurrently with Start/Stop/Restart.
+   * @return false if no pipeline is started
+   */
+  bool Reconfigure(const Config& config);
+
+  //--------------------------------------------------------------------------
+  // Health
+  //--------------------------------------------------------------------------
+
+  // Progress since the last Start(), for stall detection (see PipelineWatchdog)
+  struct Progress
+  {
+    uint64_t inputFrames = 0;    // Written to the encoder's stdin (partial writes included)
+    uint64_t outputFrames = 0;   // Decoded and queued for ReadSamples
+    uint64_t inputBlockedMs = 0; // How long the write in progress has been waiting on the encoder (0 = none)
+    int sampleRate = 0;
+    bool started = false;        // Start() succeeded and Stop() has not run
+    bool failed = false;         // A child exited or a pipe broke while running
+    bool parked = false;
+    bool finishing = false;      // Finish() requested: end of output is expected
+    bool countersValid = false;  // false for shared-worker streams (only 'failed' is tracked)
+  };
+
+  /**
+   * Lock-free snapshot of the progress counters (any thread, but not
+   * concurrently with Start/Stop/Restart)
+   */
+  Progress GetProgress() const;
 
   //--------------------------------------------------------------------------
   // Data Transfer
@@ -101,13 +226,14 @@ public:
   bool WriteSamples(const float* data, size_t numSamples);
 
   /**
-   * Read processed audio samples from ffmpeg output pipe (blocking)
+   * Read processed audio samples from the output queue
    * @param data Pointer to buffer for audio data (float samples, interleaved)
    * @param numSamples Number of samples per channel to read
-   * @param timeout Timeout in milliseconds (0 = no timeout)
-   * @return Number of samples actually read, or 0 on error/timeout
+   * @param timeout Milliseconds to wait for numSamples to become available
+   *                (0 = return whatever is queued immediately)
+   * @return Number of samples actually read (less than numSamples on timeout)
    */
-  size_t ReadSamples(float* data, size_t numSamples, DWORD timeout = 0);
+  size_t ReadSamples(float* data, size_t numSamples, uint32_t timeout = 0);
 
   /**
    * Check if output data is available
@@ -119,13 +245,44 @@ public:
    * Check if the first decoded audio output has been received
    * @return true if at least one decoded sample has arrived
    */
-  bool HasFirstAudioArrived() const { return mFirstOutputReceived.load(std::memory_order_relaxed); }
+  bool HasFirstAudioArrived() const;
 
   /**
    * Flush input buffer and wait for output
    */
   void Flush();
 
+  /**
+   * End of input: feed what is still queued, close the encoder's stdin and
+   * wait until the decoder has delivered everything (batch use; the decoded
+   * tail stays readable through ReadSamples until Stop)
+   * Not supported on shared workers, whose processes never see EOF.
+   * @param timeout Milliseconds to wait for the decoder to finish
+   * @return true if the decoded stream ended within the timeout
+   */
+  bool Finish(uint32_t timeout);
+
+  /**
+   * Park or unpark the pipeline (real-time safe: only sets a flag)
+   * While parked the input thread stops feeding ffmpeg and, if
+   * Config::suspendWhenParked is set, suspends both child processes.
+   * Samples written while parked or waking are queued and fed on resume.
+   * @param parked true to park, false to resume
+   */
+  void SetParked(bool parked);
+
+  /**
+   * Check whether the pipeline has been asked to park
+   * @return true if parked
+   */
+  bool IsParked() const { return mParkRequested.load(std::memory_order_relaxed); }
+
+  /**
+   * Check whether this pipeline is a stream on a shared worker
+   * @return true if Config::sharedWorker was honoured by Start()
+   */
+  bool IsShared() const { return mSharedSlot != nullptr; }
+
   //--------------------------------------------------------------------------
   // Error Handling
   //--------------------------------------------------------------------------
@@ -142,6 +299,13 @@ public:
    */
   void SetLogCallback(std::function<void(const std::string&)> callback);
 
+  /**
+   * Counters this pipeline updates (queue fill, pipe bytes, child CPU/RSS,
+   * time to first audio). Set before Start(); may be shared across restarts.
+   * Shared-worker streams only report the host-side queues.
+   */
+  void SetMetrics(std::shared_ptr<PipelineMetrics> metrics) { mMetrics = std::move(metrics); }
+
   //--------------------------------------------------------------------------
   // Status
   //--------------------------------------------------------------------------
@@ -159,20 +323,20 @@ private:
 
   struct PipeHandles
   {
-    HANDLE hInputRead;
-    HANDLE hInputWrite;
-    HANDLE hOutputRead;
-    HANDLE hOutputWrite;
-    HANDLE hErrorRead;
-    HANDLE hErrorWrite;
+    PipeHandle hInputRead;
+    PipeHandle hInputWrite;
+    PipeHandle hOutputRead;
+    PipeHandle hOutputWrite;
+    PipeHandle hErrorRead;
+    PipeHandle hErrorWrite;
 
     PipeHandles()
-      : hInputRead(INVALID_HANDLE_VALUE)
-      , hInputWrite(INVALID_HANDLE_VALUE)
-      , hOutputRead(INVALID_HANDLE_VALUE)
-      , hOutputWrite(INVALID_HANDLE_VALUE)
-      , hErrorRead(INVALID_HANDLE_VALUE)
-      , hErrorWrite(INVALID_HANDLE_VALUE)
+      : hInputRead(InvalidPipe())
+      , hInputWrite(InvalidPipe())
+      , hOutputRead(InvalidPipe())
+      , hOutputWrite(InvalidPipe())
+      , hErrorRead(InvalidPipe())
+      , hErrorWrite(InvalidPipe())
     {}
   };
 
@@ -200,6 +364,17 @@ private:
    */
   void TerminateProcesses();
 
+  /**
+   * Stop sequence: EOF to the encoder, wait briefly for a graceful exit,
+   * force-terminate stragglers, join the I/O threads, release the processes
+   */
+  void StopProcesses();
+
+  /**
+   * Close the encoder's stdin (idempotent; guarded by mInputMutex)
+   */
+  void CloseInputPipe();
+
   /**
    * Build ffmpeg encoder command line
    */
@@ -210,6 +385,11 @@ private:
    */
   std::string BuildDecoderCommand(const Config& config) const;
 
+  /**
+   * Extra muxer arguments for Config::lowDelayMux (empty when not set)
+   */
+  static std::string GetLowDelayMuxArgs(const Config& config, const std::string& muxFormat);
+
   /**
    * Get intermediate format for codec
    */
@@ -231,14 +411,20 @@ private:
   void InputWriteThread();
 
   /**
-   * Convert float samples to S16LE format
+   * Suspend or resume both child processes (no-op if already in that state)
    */
-  void FloatToS16LE(const float* input, int16_t* output, size_t numSamples);
+  void SetChildrenSuspended(bool suspended);
 
   /**
-   * Convert S16LE format to float samples
+   * Log per-instance vs shared process count and working set
+   */
+  void LogResourceUsage();
+
+  /**
+   * Store the encoder/decoder CPU time and resident memory in mMetrics
+   * (input thread; the children are only reaped after it has been joined)
    */
-  void S16LEToFloat(const int16_t* input, float* output, size_t numSamples);
+  void SampleChildUsage();
 
   /**
    * Log message
@@ -258,16 +444,33 @@ private:
   Config mConfig;
 
   // Process handles (two ffmpeg processes: encoder + decoder)
+#ifdef _WIN32
   PROCESS_INFORMATION mEncoderProcessInfo;
   PROCESS_INFORMATION mDecoderProcessInfo;
-  PipeHandles mPipes;
-  HANDLE mIntermediatePipeRead;   // Encoder stdout -> Decoder stdin
-  HANDLE mIntermediatePipeWrite;
   HANDLE mJobObject;
+#else
+  pid_t mEncoderPid;
+  pid_t mDecoderPid;
+#endif
+  PipeHandles mPipes;
+  PipeHandle mIntermediatePipeRead;   // Encoder stdout -> Decoder stdin
+  PipeHandle mIntermediatePipeWrite;
 
   // State
   std::atomic<bool> mIsRunning;
+  bool mStarted = false;                        // Start() succeeded and Stop() has not run; unlike
+                                                // mIsRunning, stays set after the children die
   std::atomic<bool> mFirstOutputReceived{false};
+  std::atomic<bool> mParkRequested{false};
+  std::atomic<bool> mChildrenSuspended{false};  // Written under mSuspendMutex
+  std::atomic<bool> mInputEndRequested{false};  // Finish(): close stdin once the queue is fed
+  std::atomic<bool> mStartedFlag{false};        // mStarted, readable from other threads
+  std::atomic<bool> mSuspendWhenParked{true};   // Config::suspendWhenParked (Reconfigure may change it)
+  std::atomic<bool> mFailed{false};             // Broken pipe or unexpected decoder EOF
+  std::atomic<uint64_t> mInputBytesWritten{0};  // Since Start() (input thread)
+  std::atomic<int64_t> mInputWriteSince{0};     // steady_clock ticks when the pending write began (0 = none)
+  std::atomic<uint64_t> mOutputFramesDecoded{0};  // Since Start() (output thread)
+  bool mOutputEnded = false;                    // Decoder stdout reached EOF (under mOutputMutex)
   std::string mLastError;
   size_t mLatencySamples;
 
@@ -277,7 +480,14 @@ private:
   std::thread mInputThread;
   std::mutex mMutex;
   mutable std::mutex mOutputMutex;
+  std::condition_variable mOutputCv;  // Signalled when decoded samples are queued
   std::mutex mInputMutex;
+  std::mutex mParkMutex;
+  std::condition_variable mParkCv;
+  std::mutex mSuspendMutex;
+
+  // Shared-worker stream (null in per-instance mode)
+  std::unique_ptr<SharedFFmpegSlot> mSharedSlot;
 
   // Buffers
   std::vector<float> mInputFloatBuffer;   // Non-blocking input queue
@@ -286,4 +496,9 @@ private:
 
   // Logging
   std::function<void(const std::string&)> mLogCallback;
+
+  // Metrics (optional)
+  std::shared_ptr<PipelineMetrics> mMetrics;
+  std::chrono::steady_clock::time_point mStartTime;
+  bool mInputOverrun = false;             // Backlog above PipelineMetrics::kOverrunSeconds (under mInputMutex)
 };
@@ -0,0 +1,62 @@
+#pragma once
+
+//==============================================================================
+// ICodecProcessor.h
+// Codec processor interface (shared by the plugin and the headless CLI)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+//==============================================================================
+// Codec Processor Interface
+//==============================================================================
+class ICodecProcessor
+{
+public:
+  virtual ~ICodecProcessor() = default;
+
+  virtual bool Initialize(int sampleRate, int channels) = 0;
+  virtual void Shutdown() = 0;
+  virtual void Reset() = 0;
+
+  virtual int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) = 0;
+  virtual int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) = 0;
+
+  virtual int Process(const float* input, int numSamples, float* output, int maxOutputSamples) = 0;
+
+  // Offline variant of Process: waits up to timeoutMs until at least
+  // minOutputSamples are decoded, then returns up to maxOutputSamples
+  virtual int ProcessBlocking(const float* input, int numSamples, float* output,
+                              int minOutputSamples, int maxOutputSamples, int timeoutMs)
+  {
+    (void)minOutputSamples;
+    (void)timeoutMs;
+    return Process(input, numSamples, output, maxOutputSamples);
+  }
+
+  virtual int GetLatencySamples() const = 0;
+  virtual int GetFrameSize() const = 0;
+  virtual bool IsInitialized() const = 0;
+
+  virtual void SetLogCallback(std::function<void(const std::string&)> callback) = 0;
+
+  virtual bool HasFirstAudioArrived() const = 0;
+
+  // Batch end of input: flush buffered frames so Process (numSamples = 0)
+  // can return the tail (default: nothing is buffered)
+  virtual bool Finish(int timeoutMs)
+  {
+    (void)timeoutMs;
+    return true;
+  }
+
+  // Every Process call returns the decoded audio of its own input, so
+  // offline renders need no hold-back (in-process codecs)
+  virtual bool IsSynchronous() const { return false; }
+
+  // Idle external resources during long silences (real-time safe; default no-op)
+  virtual void SetParked(bool parked) { (void)parked; }
+};
@@ -0,0 +1,328 @@
+//==============================================================================
+// LibOpusProcessor.cpp
+// In-process Opus encoder/decoder on libopus (no container, no processes)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "LibOpusProcessor.h"
+
+#if CODECSIM_HAS_LIBOPUS
+
+#include <opus.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+
+constexpr int kPendingReserveFrames = 8192;   // Plugin block limit; larger overflows allocate
+constexpr int kMaxPacketBytes = 4000;         // libopus's recommended max_data_bytes
+constexpr int kMaxPacketMs = 120;             // Longest packet Decode accepts
+constexpr int kLengthBytes = 2;               // Packet length prefix in the Encode/Decode bitstream
+
+// "opus_frame" choices in units of 2.5 ms: 2.5, 5, 10, 20, 40, 60 ms
+constexpr int kFrameUnits[] = {1, 2, 4, 8, 16, 24};
+constexpr int kNumFrameChoices = sizeof(kFrameUnits) / sizeof(kFrameUnits[0]);
+
+// "opus_app" choices: VoIP, Audio, Low Delay (ffmpeg's voip/audio/lowdelay)
+int ApplicationOf(int choice)
+{
+  switch (choice)
+  {
+    case 0: return OPUS_APPLICATION_VOIP;
+    case 2: return OPUS_APPLICATION_RESTRICTED_LOWDELAY;
+    default: return OPUS_APPLICATION_AUDIO;
+  }
+}
+
+} // namespace
+
+bool LibOpusProcessor::SupportsSampleRate(int sampleRate)
+{
+  return sampleRate == 8000 || sampleRate == 12000 || sampleRate == 16000 || sampleRate == 24000 ||
+         sampleRate == 48000;
+}
+
+LibOpusProcessor::LibOpusProcessor(const CodecInfo& codecInfo, const CodecOptionValues& options, int bitrateKbps)
+  : mCodecInfo(codecInfo)
+  , mAppChoice(GetCodecOptionValue(codecInfo, options, "opus_app", 1))
+  , mFrameChoice(std::clamp(GetCodecOptionValue(codecInfo, options, "opus_frame", 3), 0, kNumFrameChoices - 1))
+  , mVbrChoice(GetCodecOptionValue(codecInfo, options, "opus_vbr", 1))
+  , mComplexity(std::clamp(GetCodecOptionValue(codecInfo, options, "opus_complexity", 10), 0, 10))
+  , mBitrateKbps(bitrateKbps > 0 ? bitrateKbps : codecInfo.defaultBitrate)
+{
+}
+
+LibOpusProcessor::~LibOpusProcessor()
+{
+  Shutdown();
+}
+
+bool LibOpusProcessor::Initialize(int sampleRate, int channels)
+{
+  Shutdown();
+  if (channels < 1 || channels > 2)
+    return false;
+  if (!SupportsSampleRate(sampleRate))
+  {
+    Log("Native " + std::string(mCodecInfo.displayName) + ": libopus does not run at " +
+        std::to_string(sampleRate) + " Hz");
+    return false;
+  }
+
+  int error = OPUS_OK;
+  mEncoder = opus_encoder_create(sampleRate, channels, ApplicationOf(mAppChoice), &error);
+  if (error == OPUS_OK)
+    mDecoder = opus_decoder_create(sampleRate, channels, &error);
+  if (error != OPUS_OK)
+  {
+    Log("Native " + std::string(mCodecInfo.displayName) + ": " + opus_strerror(error));
+    Shutdown();
+    return false;
+  }
+
+  mSampleRate = sampleRate;
+  mChannels = channels;
+  mFrameSize = sampleRate / 400 * kFrameUnits[mFrameChoice];
+  opus_int32 lookahead = 0;
+  if (!ConfigureEncoder() || opus_encoder_ctl(mEncoder, OPUS_GET_LOOKAHEAD(&lookahead)) != OPUS_OK)
+  {
+    Shutdown();
+    return false;
+  }
+  mPreSkip = static_cast<int>(lookahead);
+
+  const size_t maxDecodedFrames = static_cast<size_t>(sampleRate) * kMaxPacketMs / 1000;
+  mFrameInput.assign(static_cast<size_t>(mFrameSize) * channels, 0.0f);
+  mPacket.assign(kMaxPacketBytes, 0);
+  mFrameDecoded.assign(maxDecodedFrames * channels, 0.0f);
+  mPending.reserve(static_cast<size_t>(kPendingReserveFrames + GetLatencySamples() + mFrameSize) * channels);
+  mInitialized = true;
+  Reset();
+
+  char frameMs[16];
+  snprintf(frameMs, sizeof(frameMs), "%g", 2.5 * kFrameUnits[mFrameChoice]);
+  Log("Native " + std::string(mCodecInfo.displayName) + " (libopus): " + std::to_string(sampleRate) + " Hz, " +
+      std::to_string(channels) + " ch, " + frameMs + " ms frames, latency " + std::to_string(GetLatencySamples()) +
+      " (pre-skip " + std::to_string(mPreSkip) + ")");
+  return true;
+}
+
+void LibOpusProcessor::Shutdown()
+{
+  mInitialized = false;
+  if (mEncoder)
+  {
+    opus_encoder_destroy(mEncoder);
+    mEncoder = nullptr;
+  }
+  if (mDecoder)
+  {
+    opus_decoder_destroy(mDecoder);
+    mDecoder = nullptr;
+  }
+  mPending.clear();
+  mPendingRead = 0;
+}
+
+void LibOpusProcessor::Reset()
+{
+  if (!mInitialized)
+    return;
+
+  // Keeps bitrate, VBR mode and complexity
+  opus_encoder_ctl(mEncoder, OPUS_RESET_STATE);
+  opus_decoder_ctl(mDecoder, OPUS_RESET_STATE);
+  mFrameFill = 0;
+  mSkipRemaining = mPreSkip;
+
+  // One frame plus the pre-skip of silence ahead of the first decoded frame
+  mPending.assign(static_cast<size_t>(GetLatencySamples()) * mChannels, 0.0f);
+  mPendingRead = 0;
+}
+
+void LibOpusProcessor::SetLogCallback(std::function<void(const std::string&)> callback)
+{
+  mLogCallback = std::move(callback);
+}
+
+void LibOpusProcessor::Log(const std::string& message) const
+{
+  if (mLogCallback)
+    mLogCallback(message);
+}
+
+bool LibOpusProcessor::ConfigureEncoder()
+{
+  const int bitrate = std::clamp(mBitrateKbps, mCodecInfo.minBitrate, mCodecInfo.maxBitrate) * 1000;
+  return opus_encoder_ctl(mEncoder, OPUS_SET_BITRATE(bitrate)) == OPUS_OK &&
+         opus_encoder_ctl(mEncoder, OPUS_SET_VBR(mVbrChoice != 0 ? 1 : 0)) == OPUS_OK &&
+         opus_encoder_ctl(mEncoder, OPUS_SET_VBR_CONSTRAINT(mVbrChoice == 2 ? 1 : 0)) == OPUS_OK &&
+         opus_encoder_ctl(mEncoder, OPUS_SET_COMPLEXITY(mComplexity)) == OPUS_OK;
+}
+
+bool LibOpusProcessor::ApplySettings(int sampleRate, int channels, int bitrateKbps, const CodecOptionValues& options)
+{
+  if (!mInitialized || sampleRate != mSampleRate || channels != mChannels ||
+      GetCodecOptionValue(mCodecInfo, options, "opus_app", 1) != mAppChoice ||
+      GetCodecOptionValue(mCodecInfo, options, "opus_frame", 3) != mFrameChoice)
+    return false;
+
+  mVbrChoice = GetCodecOptionValue(mCodecInfo, options, "opus_vbr", 1);
+  mComplexity = std::clamp(GetCodecOptionValue(mCodecInfo, options, "opus_complexity", 10), 0, 10);
+  mBitrateKbps = bitrateKbps > 0 ? bitrateKbps : mCodecInfo.defaultBitrate;
+  return ConfigureEncoder();
+}
+
+size_t LibOpusProcessor::FillFrame(const float* input, size_t frames)
+{
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t taken = std::min(frames, static_cast<size_t>(mFrameSize) - mFrameFill);
+  std::copy_n(input, taken * channels, mFrameInput.data() + mFrameFill * channels);
+  mFrameFill += taken;
+  return taken;
+}
+
+int LibOpusProcessor::EncodeFrame(uint8_t* packet, int maxBytes)
+{
+  mFrameFill = 0;
+  return opus_encode_float(mEncoder, mFrameInput.data(), mFrameSize, packet, maxBytes);
+}
+
+int LibOpusProcessor::DecodePacket(const uint8_t* packet, int bytes)
+{
+  const int maxFrames = static_cast<int>(mFrameDecoded.size()) / mChannels;
+  int frames = packet ? opus_decode_float(mDecoder, packet, bytes, mFrameDecoded.data(), maxFrames, 0) : -1;
+  if (frames < 0)
+  {
+    frames = mFrameSize;
+    std::fill_n(mFrameDecoded.begin(), static_cast<size_t>(frames) * mChannels, 0.0f);
+  }
+
+  // The first decoded frames are the encoder's lookahead, not input
+  const int skip = std::min(mSkipRemaining, frames);
+  if (skip > 0)
+  {
+    std::copy(mFrameDecoded.begin() + static_cast<std::ptrdiff_t>(skip) * mChannels,
+              mFrameDecoded.begin() + static_cast<std::ptrdiff_t>(frames) * mChannels, mFrameDecoded.begin());
+    mSkipRemaining -= skip;
+  }
+  return frames - skip;
+}
+
+void LibOpusProcessor::EncodeFrameToPending()
+{
+  const int bytes = EncodeFrame(mPacket.data(), kMaxPacketBytes);
+  const int frames = DecodePacket(bytes > 0 ? mPacket.data() : nullptr, bytes);
+  const size_t count = static_cast<size_t>(frames) * mChannels;
+  mPending.insert(mPending.end(), mFrameDecoded.begin(), mFrameDecoded.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+size_t LibOpusProcessor::DrainPending(float* output, size_t maxFrames)
+{
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t frames = std::min((mPending.size() - mPendingRead) / channels, maxFrames);
+  std::copy_n(mPending.data() + mPendingRead, frames * channels, output);
+  mPendingRead += frames * channels;
+
+  // At most a frame plus the pre-skip (or one call's overflow) stays behind
+  mPending.erase(mPending.begin(), mPending.begin() + static_cast<std::ptrdiff_t>(mPendingRead));
+  mPendingRead = 0;
+  return frames;
+}
+
+int LibOpusProcessor::Process(const float* input, int numSamples, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || maxOutputSamples < 0)
+    return 0;
+
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t frames = (input && numSamples > 0) ? static_cast<size_t>(numSamples) : 0;
+  for (size_t done = 0; done < frames;)
+  {
+    done += FillFrame(input + done * channels, frames - done);
+    if (mFrameFill == static_cast<size_t>(mFrameSize))
+      EncodeFrameToPending();
+  }
+
+  // The primed silence covers the partial frame and the lookahead, so there
+  // are always 'frames' to return; with no input (after Finish) all of it goes
+  const size_t limit = frames > 0 ? std::min(frames, static_cast<size_t>(maxOutputSamples))
+                                  : static_cast<size_t>(maxOutputSamples);
+  return static_cast<int>(DrainPending(output, limit));
+}
+
+bool LibOpusProcessor::Finish(int timeoutMs)
+{
+  (void)timeoutMs;
+  if (!mInitialized)
+    return false;
+
+  // Pad the partial frame, then push silence through until the lookahead is out
+  int flushFrames = (mPreSkip + mFrameSize - 1) / mFrameSize;
+  if (mFrameFill > 0)
+  {
+    std::fill(mFrameInput.begin() + static_cast<std::ptrdiff_t>(mFrameFill * mChannels), mFrameInput.end(), 0.0f);
+    EncodeFrameToPending();
+  }
+  std::fill(mFrameInput.begin(), mFrameInput.end(), 0.0f);
+  for (; flushFrames > 0; --flushFrames)
+    EncodeFrameToPending();
+  return true;
+}
+
+int LibOpusProcessor::Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes)
+{
+  if (!mInitialized || !input || numSamples <= 0 || maxOutputBytes <= 0)
+    return 0;
+
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t frames = static_cast<size_t>(numSamples);
+  int written = 0;
+  for (size_t done = 0; done < frames;)
+  {
+    // A frame is only completed if its packet is sure to fit
+    const bool completes = mFrameFill + (frames - done) >= static_cast<size_t>(mFrameSize);
+    if (completes && maxOutputBytes - written < kLengthBytes + kMaxPacketBytes)
+      break;
+
+    done += FillFrame(input + done * channels, frames - done);
+    if (mFrameFill == static_cast<size_t>(mFrameSize))
+    {
+      const int bytes = EncodeFrame(output + written + kLengthBytes, kMaxPacketBytes);
+      if (bytes < 0)
+        continue;  // Frame lost; the decoder's packet loss concealment would cover it
+      output[written] = static_cast<uint8_t>(bytes & 0xFF);
+      output[written + 1] = static_cast<uint8_t>(bytes >> 8);
+      written += kLengthBytes + bytes;
+    }
+  }
+  return written;
+}
+
+int LibOpusProcessor::Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || !input || inputBytes <= 0 || maxOutputSamples <= 0)
+    return 0;
+
+  int written = 0;
+  for (int offset = 0; offset + kLengthBytes <= inputBytes;)
+  {
+    const int bytes = input[offset] | (input[offset + 1] << 8);
+    const uint8_t* packet = input + offset + kLengthBytes;
+    if (offset + kLengthBytes + bytes > inputBytes)
+      break;  // Truncated packet
+    const int packetFrames = opus_packet_get_nb_samples(packet, bytes, mSampleRate);
+    if (packetFrames > 0 && written + packetFrames > maxOutputSamples)
+      break;
+    offset += kLengthBytes + bytes;
+
+    const int frames = std::min(DecodePacket(packet, bytes), maxOutputSamples - written);
+    std::copy_n(mFrameDecoded.begin(), static_cast<size_t>(frames) * mChannels,
+                output + static_cast<size_t>(written) * mChannels);
+    written += frames;
+  }
+  return written;
+}
+
+#endif // CODECSIM_HAS_LIBOPUS
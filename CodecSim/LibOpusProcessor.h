@@ -0,0 +1,122 @@
+#pragma once
+
+//==============================================================================
+// LibOpusProcessor.h
+// In-process Opus encoder/decoder on libopus (no container, no processes)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "ICodecProcessor.h"
+#include "CodecRegistry.h"
+
+#if CODECSIM_HAS_LIBOPUS
+
+#include <vector>
+
+struct OpusEncoder;
+struct OpusDecoder;
+
+//==============================================================================
+// LibOpusProcessor
+// Encodes each frame as it fills and decodes the packet straight away, so the
+// only delay is Opus's own: one frame of buffering plus the encoder lookahead
+// (the stream's pre-skip, 2.5 ms with "Low Delay", 6.5 ms otherwise). The
+// pre-skip is dropped from the decoded stream, which then lines up with the
+// input; the output starts with GetLatencySamples() of silence so every
+// Process call returns as many frames as it was given.
+//
+// Options: "opus_app", "opus_vbr", "opus_frame" (2.5 to 60 ms) and
+// "opus_complexity", as passed to ffmpeg's libopus encoder. libopus only runs
+// at 8, 12, 16, 24 and 48 kHz; CreateNativeCodecProcessor goes straight to
+// ffmpeg (which resamples) at other rates, and Initialize fails at them.
+//==============================================================================
+class LibOpusProcessor : public ICodecProcessor
+{
+public:
+  LibOpusProcessor(const CodecInfo& codecInfo, const CodecOptionValues& options, int bitrateKbps);
+  ~LibOpusProcessor() override;
+
+  // Non-copyable
+  LibOpusProcessor(const LibOpusProcessor&) = delete;
+  LibOpusProcessor& operator=(const LibOpusProcessor&) = delete;
+
+  // ICodecProcessor interface
+  bool Initialize(int sampleRate, int channels) override;
+  void Shutdown() override;
+  void Reset() override;
+
+  // The bitstream is a sequence of packets, each a 16-bit little-endian length
+  // followed by the packet. Encode writes whole packets only; input beyond the
+  // packets that fit in maxOutputBytes is dropped. Decode drops the pre-skip
+  // at the start of the stream. Encode/Decode share the codec state with
+  // Process: use one or the other.
+  int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) override;
+  int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) override;
+  int Process(const float* input, int numSamples, float* output, int maxOutputSamples) override;
+
+  // One frame plus the pre-skip
+  int GetLatencySamples() const override { return mFrameSize + mPreSkip; }
+  int GetFrameSize() const override { return mFrameSize; }
+  bool IsInitialized() const override { return mInitialized; }
+  void SetLogCallback(std::function<void(const std::string&)> callback) override;
+  bool HasFirstAudioArrived() const override { return mInitialized; }
+  bool IsSynchronous() const override { return true; }
+
+  // Pad the partial frame with silence and flush the lookahead, so Process
+  // (numSamples = 0) returns the tail
+  bool Finish(int timeoutMs) override;
+
+  /**
+   * Apply new settings to the running encoder (from the next frame, no restart).
+   * @return false if they need a new encoder: a different frame duration or
+   *         application, or a stream format other than the running one
+   */
+  bool ApplySettings(int sampleRate, int channels, int bitrateKbps, const CodecOptionValues& options);
+
+  const CodecInfo& GetCodecInfo() const { return mCodecInfo; }
+
+  // Whether libopus runs at this rate (8, 12, 16, 24 or 48 kHz)
+  static bool SupportsSampleRate(int sampleRate);
+
+private:
+  // Bitrate, VBR mode and complexity (encoder ctls that need no restart)
+  bool ConfigureEncoder();
+  size_t FillFrame(const float* input, size_t frames);  // Frames taken into mFrameInput
+  int EncodeFrame(uint8_t* packet, int maxBytes);       // mFrameInput -> packet bytes (< 0: libopus error)
+  // Frames kept in mFrameDecoded after the pre-skip. A packet that cannot be
+  // decoded ('packet' null: one that could not be encoded) becomes a frame of
+  // silence, so the output timeline never slips.
+  int DecodePacket(const uint8_t* packet, int bytes);
+  void EncodeFrameToPending();
+  size_t DrainPending(float* output, size_t maxFrames);
+  void Log(const std::string& message) const;
+
+  CodecInfo mCodecInfo;
+  int mAppChoice = 0;          // "opus_app" choice index
+  int mFrameChoice = 0;        // "opus_frame" choice index
+  int mVbrChoice = 0;          // "opus_vbr" choice index
+  int mComplexity = 10;
+  int mBitrateKbps = 0;
+
+  int mSampleRate = 0;
+  int mChannels = 0;
+  int mFrameSize = 0;          // Frames per packet
+  int mPreSkip = 0;            // Encoder lookahead, dropped from the decoded stream
+  bool mInitialized = false;
+  std::function<void(const std::string&)> mLogCallback;
+
+  OpusEncoder* mEncoder = nullptr;
+  OpusDecoder* mDecoder = nullptr;
+
+  std::vector<float> mFrameInput;     // The frame being collected (interleaved)
+  size_t mFrameFill = 0;              // Frames in mFrameInput
+  std::vector<uint8_t> mPacket;
+  std::vector<float> mFrameDecoded;
+  int mSkipRemaining = 0;             // Pre-skip frames still to drop
+
+  // Decoded frames not yet returned (interleaved)
+  std::vector<float> mPending;
+  size_t mPendingRead = 0;
+};
+
+#endif // CODECSIM_HAS_LIBOPUS
@@ -0,0 +1,164 @@
+//==============================================================================
+// LosslessPassthrough.cpp
+// Passthrough processor for lossless codecs (output = input, optionally delayed)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "LosslessPassthrough.h"
+#include "NativeCodecs.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+constexpr size_t kChunkSamples = 1024;   // s16 staging
+
+// What the ffmpeg pipeline returns for a lossless codec: the input reduced to
+// s16 word length. s16 input (k/32768) comes back unchanged, bit for bit.
+void QuantizeS16(const float* input, float* output, size_t count)
+{
+  int16_t samples[kChunkSamples];
+  for (size_t offset = 0; offset < count; offset += kChunkSamples)
+  {
+    const size_t n = std::min(kChunkSamples, count - offset);
+    NativeCodecs::FloatToS16(input + offset, samples, n);
+    NativeCodecs::S16ToFloat(samples, output + offset, n);
+  }
+}
+
+} // namespace
+
+LosslessPassthroughProcessor::LosslessPassthroughProcessor(const CodecInfo& codecInfo, int delayFrames)
+  : mCodecInfo(codecInfo)
+  , mDelayFrames(std::max(0, delayFrames))
+{
+}
+
+bool LosslessPassthroughProcessor::Initialize(int sampleRate, int channels)
+{
+  if (sampleRate <= 0 || channels < 1 || channels > 2)
+    return false;
+
+  mChannels = channels;
+  mDelayLine.assign(static_cast<size_t>(mDelayFrames) * channels, 0.0f);
+  Reset();
+  mInitialized = true;
+
+  if (mLogCallback)
+    mLogCallback("Passthrough " + std::string(mCodecInfo.displayName) + ": " + std::to_string(sampleRate) + " Hz, " +
+                 std::to_string(channels) + " ch, delay " + std::to_string(mDelayFrames));
+  return true;
+}
+
+void LosslessPassthroughProcessor::Shutdown()
+{
+  mInitialized = false;
+}
+
+void LosslessPassthroughProcessor::Reset()
+{
+  std::fill(mDelayLine.begin(), mDelayLine.end(), 0.0f);
+  mDelayPos = 0;
+  mTailFrames = 0;
+}
+
+void LosslessPassthroughProcessor::SetLogCallback(std::function<void(const std::string&)> callback)
+{
+  mLogCallback = std::move(callback);
+}
+
+void LosslessPassthroughProcessor::Delay(const float* input, float* output, size_t count)
+{
+  if (mDelayLine.empty())
+  {
+    if (input)
+      QuantizeS16(input, output, count);
+    else
+      std::fill(output, output + count, 0.0f);
+    return;
+  }
+
+  // Each stretch reads the delayed samples before overwriting them, so
+  // blocks longer than the delay still come out in order
+  while (count > 0)
+  {
+    const size_t n = std::min(count, mDelayLine.size() - mDelayPos);
+    float* line = mDelayLine.data() + mDelayPos;
+    std::memcpy(output, line, n * sizeof(float));
+    if (input)
+    {
+      QuantizeS16(input, line, n);
+      input += n;
+    }
+    else
+    {
+      std::fill(line, line + n, 0.0f);
+    }
+    output += n;
+    count -= n;
+    mDelayPos = (mDelayPos + n) % mDelayLine.size();
+  }
+}
+
+int LosslessPassthroughProcessor::Process(const float* input, int numSamples, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || maxOutputSamples <= 0)
+    return 0;
+
+  const size_t channels = static_cast<size_t>(mChannels);
+  if (input && numSamples > 0)
+  {
+    const size_t frames = std::min(numSamples, maxOutputSamples);
+    Delay(input, output, frames * channels);
+    return static_cast<int>(frames);
+  }
+
+  const size_t frames = std::min(mTailFrames, static_cast<size_t>(maxOutputSamples));
+  Delay(nullptr, output, frames * channels);
+  mTailFrames -= frames;
+  return static_cast<int>(frames);
+}
+
+bool LosslessPassthroughProcessor::Finish(int timeoutMs)
+{
+  (void)timeoutMs;
+  mTailFrames = static_cast<size_t>(mDelayFrames);
+  return mInitialized;
+}
+
+int LosslessPassthroughProcessor::Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes)
+{
+  if (!mInitialized || !input || numSamples <= 0 || maxOutputBytes <= 0)
+    return 0;
+
+  const size_t frameBytes = sizeof(int16_t) * mChannels;
+  const size_t frames = std::min(static_cast<size_t>(numSamples), static_cast<size_t>(maxOutputBytes) / frameBytes);
+  const size_t count = frames * mChannels;
+  int16_t samples[kChunkSamples];
+  for (size_t offset = 0; offset < count; offset += kChunkSamples)
+  {
+    const size_t n = std::min(kChunkSamples, count - offset);
+    NativeCodecs::FloatToS16(input + offset, samples, n);
+    std::memcpy(output + offset * sizeof(int16_t), samples, n * sizeof(int16_t));
+  }
+  return static_cast<int>(frames * frameBytes);
+}
+
+int LosslessPassthroughProcessor::Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || !input || inputBytes <= 0 || maxOutputSamples <= 0)
+    return 0;
+
+  const size_t frameBytes = sizeof(int16_t) * mChannels;
+  const size_t frames = std::min(static_cast<size_t>(inputBytes) / frameBytes, static_cast<size_t>(maxOutputSamples));
+  const size_t count = frames * mChannels;
+  int16_t samples[kChunkSamples];
+  for (size_t offset = 0; offset < count; offset += kChunkSamples)
+  {
+    const size_t n = std::min(kChunkSamples, count - offset);
+    std::memcpy(samples, input + offset * sizeof(int16_t), n * sizeof(int16_t));
+    NativeCodecs::S16ToFloat(samples, output + offset, n);
+  }
+  return static_cast<int>(frames);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+//==============================================================================
+// LosslessPassthrough.h
+// Passthrough processor for lossless codecs (output = input, optionally delayed)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "ICodecProcessor.h"
+#include "CodecRegistry.h"
+#include <vector>
+
+//==============================================================================
+// LosslessPassthroughProcessor
+// A lossless encode -> decode returns its (s16) input, so the two ffmpeg
+// processes are replaced by an s16 quantizer and a delay line. The delay (0 by
+// default) lets the output line up with a chosen latency, e.g. the one the
+// ffmpeg pipeline would report.
+//==============================================================================
+class LosslessPassthroughProcessor : public ICodecProcessor
+{
+public:
+  LosslessPassthroughProcessor(const CodecInfo& codecInfo, int delayFrames);
+
+  // ICodecProcessor interface
+  bool Initialize(int sampleRate, int channels) override;
+  void Shutdown() override;
+  void Reset() override;
+
+  // The "bitstream" is s16le PCM, as the ffmpeg pipeline would decode it
+  int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) override;
+  int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) override;
+
+  // Returns min(numSamples, maxOutputSamples) frames; input beyond that is dropped
+  int Process(const float* input, int numSamples, float* output, int maxOutputSamples) override;
+
+  int GetLatencySamples() const override { return mDelayFrames; }
+  int GetFrameSize() const override { return mCodecInfo.frameSize; }
+  bool IsInitialized() const override { return mInitialized; }
+  void SetLogCallback(std::function<void(const std::string&)> callback) override;
+  bool HasFirstAudioArrived() const override { return mInitialized; }
+  bool IsSynchronous() const override { return true; }
+
+  // The delayed tail comes out of Process (numSamples = 0) afterwards
+  bool Finish(int timeoutMs) override;
+
+  const CodecInfo& GetCodecInfo() const { return mCodecInfo; }
+
+private:
+  // 'input' null feeds silence (the tail after Finish)
+  void Delay(const float* input, float* output, size_t count);
+
+  CodecInfo mCodecInfo;
+  int mDelayFrames = 0;
+  int mChannels = 0;
+  bool mInitialized = false;
+  std::function<void(const std::string&)> mLogCallback;
+
+  std::vector<float> mDelayLine;  // mDelayFrames * channels, circular
+  size_t mDelayPos = 0;
+  size_t mTailFrames = 0;         // Frames still to come out after Finish
+};
@@ -0,0 +1,354 @@
+//==============================================================================
+// LosslessVerifier.cpp
+// Background encoder that reports a lossless codec's compressed size
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "LosslessVerifier.h"
+#include "DebugLog.h"
+#include "FFmpegPipeManager.h"
+#include "NativeCodecs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define DebugLogVerifier(msg) CODECSIM_LOG(LogLevel::Debug, "LosslessVerifier", msg)
+
+namespace
+{
+
+constexpr int kRingSeconds = 4;             // Input the encoder may fall behind by before drops
+constexpr size_t kWriteChunkSamples = 4096;
+constexpr size_t kReadChunkBytes = 65536;
+constexpr int kWakeMs = 50;
+constexpr int kStopTimeoutMs = 3000;        // Encoder flush after stdin closes (idle priority)
+
+void ClosePipe(FFmpegPipeManager::PipeHandle& pipe)
+{
+  if (pipe == FFmpegPipeManager::InvalidPipe())
+    return;
+#ifdef _WIN32
+  CloseHandle(pipe);
+#else
+  close(pipe);
+#endif
+  pipe = FFmpegPipeManager::InvalidPipe();
+}
+
+} // namespace
+
+LosslessVerifier::LosslessVerifier() = default;
+
+LosslessVerifier::~LosslessVerifier()
+{
+  Stop();
+}
+
+bool LosslessVerifier::Start(const std::string& ffmpegPath, const CodecInfo& codec, const std::string& encoderArgs,
+                             int sampleRate, int channels)
+{
+  Stop();
+
+  mChannels = std::clamp(channels, 1, 2);
+  mRing.assign(static_cast<size_t>(sampleRate) * kRingSeconds * mChannels, 0.0f);
+  mRingHead.store(0);
+  mRingTail.store(0);
+  mPcmBytes.store(0);
+  mCompressedBytes.store(0);
+  mDroppedFrames.store(0);
+  mFailed.store(false);
+  mLastError.clear();
+
+  std::ostringstream oss;
+  oss << "\"" << ffmpegPath << "\"";
+  oss << " -hide_banner -loglevel error";
+  oss << " -f s16le";
+  oss << " -ar " << sampleRate;
+  oss << " -ac " << mChannels;
+  oss << " -i pipe:0";
+  oss << " -c:a " << codec.encoderName;
+  if (!encoderArgs.empty())
+    oss << " " << encoderArgs;
+  oss << " -f " << codec.muxerFormat;
+  oss << " pipe:1";
+  DebugLogVerifier("Encoder command: " + oss.str());
+
+  if (!LaunchEncoder(oss.str()))
+  {
+    CloseHandles();
+    return false;
+  }
+
+  mStopRequested = false;
+  mRunning.store(true, std::memory_order_release);
+  mWriter = std::thread(&LosslessVerifier::WriterThread, this);
+  mReader = std::thread(&LosslessVerifier::ReaderThread, this);
+  return true;
+}
+
+void LosslessVerifier::Stop()
+{
+  mRunning.store(false, std::memory_order_release);
+  if (mWriter.joinable() || mReader.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mWakeMutex);
+      mStopRequested = true;
+    }
+    mWakeCv.notify_all();
+
+    // The writer hands over what is queued and closes stdin; the encoder then
+    // flushes and exits, which ends the reader
+    if (!WaitForEncoderExit(kStopTimeoutMs))
+    {
+      mFailed.store(true);
+      KillEncoder();
+    }
+    if (mWriter.joinable())
+      mWriter.join();
+    if (mReader.joinable())
+      mReader.join();
+  }
+  CloseHandles();
+}
+
+void LosslessVerifier::Push(const float* data, int numFrames)
+{
+  if (numFrames <= 0 || !mRunning.load(std::memory_order_acquire) || mFailed.load(std::memory_order_relaxed))
+    return;
+
+  const size_t count = static_cast<size_t>(numFrames) * mChannels;
+  const size_t head = mRingHead.load(std::memory_order_relaxed);
+  const size_t tail = mRingTail.load(std::memory_order_acquire);
+  if (mRing.size() - (head - tail) < count)
+  {
+    mDroppedFrames.fetch_add(numFrames, std::memory_order_relaxed);
+    return;
+  }
+
+  const size_t start = head % mRing.size();
+  const size_t first = std::min(count, mRing.size() - start);
+  std::memcpy(mRing.data() + start, data, first * sizeof(float));
+  std::memcpy(mRing.data(), data + first, (count - first) * sizeof(float));
+  mRingHead.store(head + count, std::memory_order_release);
+}
+
+LosslessVerifierReport LosslessVerifier::GetReport() const
+{
+  LosslessVerifierReport report;
+  report.pcmBytes = mPcmBytes.load(std::memory_order_relaxed);
+  report.compressedBytes = mCompressedBytes.load(std::memory_order_relaxed);
+  report.droppedFrames = mDroppedFrames.load(std::memory_order_relaxed);
+  report.failed = mFailed.load(std::memory_order_relaxed);
+  return report;
+}
+
+//==============================================================================
+// Encoder process
+//==============================================================================
+
+bool LosslessVerifier::LaunchEncoder(const std::string& command)
+{
+  // The child inherits only its own ends; stderr is discarded
+  FFmpegPipeManager::PipeHandle inputRead = FFmpegPipeManager::InvalidPipe();
+  FFmpegPipeManager::PipeHandle outputWrite = FFmpegPipeManager::InvalidPipe();
+  if (!FFmpegPipeManager::CreateChildPipe(inputRead, mInputWrite, true))
+  {
+    mLastError = "cannot create the encoder pipes";
+    return false;
+  }
+  if (!FFmpegPipeManager::CreateChildPipe(mOutputRead, outputWrite, false))
+  {
+    mLastError = "cannot create the encoder pipes";
+    ClosePipe(inputRead);
+    return false;
+  }
+
+  // Lowest priority: the verifier only ever gets CPU time the host does not want
+  FFmpegPipeManager::ChildProcess child;
+  long error = 0;
+  const bool started = FFmpegPipeManager::SpawnChild(command, inputRead, outputWrite,
+                                                     FFmpegPipeManager::InvalidPipe(), true, child, error);
+  ClosePipe(inputRead);
+  ClosePipe(outputWrite);
+  if (!started)
+  {
+#ifdef _WIN32
+    mLastError = "cannot start the encoder (error " + std::to_string(error) + ")";
+#else
+    mLastError = std::string("cannot start the encoder: ") + std::strerror(static_cast<int>(error));
+#endif
+    return false;
+  }
+#ifdef _WIN32
+  CloseHandle(child.hThread);
+  mProcess = child.hProcess;
+#else
+  mPid = child;
+#endif
+  return true;
+}
+
+#ifdef _WIN32
+bool LosslessVerifier::WaitForEncoderExit(int timeoutMs)
+{
+  return !mProcess || WaitForSingleObject(mProcess, static_cast<DWORD>(timeoutMs)) == WAIT_OBJECT_0;
+}
+
+void LosslessVerifier::KillEncoder()
+{
+  if (mProcess)
+  {
+    TerminateProcess(mProcess, 1);
+    WaitForSingleObject(mProcess, INFINITE);
+  }
+}
+
+void LosslessVerifier::CloseHandles()
+{
+  if (mProcess)
+  {
+    CloseHandle(mProcess);
+    mProcess = nullptr;
+  }
+  ClosePipe(mInputWrite);
+  ClosePipe(mOutputRead);
+}
+#else
+bool LosslessVerifier::WaitForEncoderExit(int timeoutMs)
+{
+  if (mPid < 0)
+    return true;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true)
+  {
+    const pid_t result = waitpid(mPid, nullptr, WNOHANG);
+    if (result == mPid || (result < 0 && errno == ECHILD))
+    {
+      mPid = -1;
+      return true;
+    }
+    if (std::chrono::steady_clock::now() >= deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+void LosslessVerifier::KillEncoder()
+{
+  if (mPid < 0)
+    return;
+  kill(mPid, SIGKILL);
+  while (waitpid(mPid, nullptr, 0) < 0 && errno == EINTR) {}
+  mPid = -1;
+}
+
+void LosslessVerifier::CloseHandles()
+{
+  KillEncoder();  // Only if Stop could not reap it
+  ClosePipe(mInputWrite);
+  ClosePipe(mOutputRead);
+}
+#endif
+
+//==============================================================================
+// I/O threads
+//==============================================================================
+
+void LosslessVerifier::WriterThread()
+{
+#ifndef _WIN32
+  // An encoder that dies must surface as EPIPE here, not kill the host process
+  sigset_t sigpipe;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, nullptr);
+#endif
+
+  std::vector<int16_t> s16(kWriteChunkSamples);
+  bool stopping = false;
+  while (!stopping && !mFailed.load(std::memory_order_relaxed))
+  {
+    {
+      std::unique_lock<std::mutex> lock(mWakeMutex);
+      mWakeCv.wait_for(lock, std::chrono::milliseconds(kWakeMs), [this] { return mStopRequested; });
+      stopping = mStopRequested;
+    }
+
+    // Everything queued so far, including after a stop request
+    size_t tail = mRingTail.load(std::memory_order_relaxed);
+    const size_t head = mRingHead.load(std::memory_order_acquire);
+    while (tail != head)
+    {
+      const size_t start = tail % mRing.size();
+      const size_t n = std::min({head - tail, kWriteChunkSamples, mRing.size() - start});
+      NativeCodecs::FloatToS16(mRing.data() + start, s16.data(), n);
+      tail += n;
+      mRingTail.store(tail, std::memory_order_release);
+
+      const char* bytes = reinterpret_cast<const char*>(s16.data());
+      size_t remaining = n * sizeof(int16_t);
+      while (remaining > 0)
+      {
+#ifdef _WIN32
+        DWORD written = 0;
+        if (!WriteFile(mInputWrite, bytes, static_cast<DWORD>(remaining), &written, nullptr) || written == 0)
+#else
+        const ssize_t written = write(mInputWrite, bytes, remaining);
+        if (written < 0 && errno == EINTR)
+          continue;
+        if (written <= 0)
+#endif
+        {
+          mFailed.store(true);
+          break;
+        }
+        bytes += written;
+        remaining -= static_cast<size_t>(written);
+        mPcmBytes.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+      }
+      if (mFailed.load(std::memory_order_relaxed))
+        break;
+    }
+  }
+
+  if (mFailed.load())
+    DebugLogVerifier("Encoder stopped accepting input");
+
+  // End of input: the encoder flushes and exits
+#ifdef _WIN32
+  CloseHandle(mInputWrite);
+  mInputWrite = INVALID_HANDLE_VALUE;
+#else
+  close(mInputWrite);
+  mInputWrite = -1;
+#endif
+}
+
+void LosslessVerifier::ReaderThread()
+{
+  std::vector<char> buffer(kReadChunkBytes);
+  while (true)
+  {
+#ifdef _WIN32
+    DWORD read = 0;
+    if (!ReadFile(mOutputRead, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) || read == 0)
+      break;
+#else
+    const ssize_t read = ::read(mOutputRead, buffer.data(), buffer.size());
+    if (read < 0 && errno == EINTR)
+      continue;
+    if (read <= 0)
+      break;
+#endif
+    mCompressedBytes.fetch_add(static_cast<uint64_t>(read), std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+//==============================================================================
+// LosslessVerifier.h
+// Background encoder that reports a lossless codec's compressed size
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/types.h>
+#endif
+#include "CodecRegistry.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// LosslessVerifierReport
+//==============================================================================
+struct LosslessVerifierReport
+{
+  uint64_t pcmBytes = 0;          // s16 input handed to the encoder
+  uint64_t compressedBytes = 0;   // Encoder output so far (trails pcmBytes by the encoder's buffering)
+  int64_t droppedFrames = 0;      // Input lost because the encoder fell behind (not in pcmBytes)
+  bool failed = false;            // The encoder exited early or could not be written to
+
+  // Compressed / PCM size (0 until the first output)
+  double GetRatio() const { return pcmBytes > 0 ? static_cast<double>(compressedBytes) / pcmBytes : 0.0; }
+};
+
+//==============================================================================
+// LosslessVerifier
+// Runs the codec's real ffmpeg encoder beside a LosslessPassthroughProcessor,
+// at idle priority, and counts what it writes. The audio thread only copies
+// its input into a ring; if the encoder cannot keep up, input is dropped and
+// counted rather than ever blocking the audio thread.
+//==============================================================================
+class LosslessVerifier
+{
+public:
+  LosslessVerifier();
+  ~LosslessVerifier();
+
+  // Non-copyable
+  LosslessVerifier(const LosslessVerifier&) = delete;
+  LosslessVerifier& operator=(const LosslessVerifier&) = delete;
+
+  /**
+   * Spawn the encoder (stops a running one first). Must not run concurrently
+   * with Push; the caller serializes them.
+   * @param encoderArgs Codec arguments (BuildCodecArgs)
+   * @return false with GetLastError() set if the encoder could not be started
+   */
+  bool Start(const std::string& ffmpegPath, const CodecInfo& codec, const std::string& encoderArgs,
+             int sampleRate, int channels);
+
+  // Let the encoder finish what it was given, then close it (kills it after a timeout)
+  void Stop();
+
+  bool IsRunning() const { return mRunning.load(std::memory_order_acquire); }
+
+  // Audio thread (real-time safe): interleaved frames; ignored while stopped
+  void Push(const float* data, int numFrames);
+
+  // Counters of the running (or last) encoder
+  LosslessVerifierReport GetReport() const;
+
+  const std::string& GetLastError() const { return mLastError; }
+
+private:
+  bool LaunchEncoder(const std::string& command);
+  bool WaitForEncoderExit(int timeoutMs);
+  void KillEncoder();
+  void CloseHandles();
+  void WriterThread();
+  void ReaderThread();
+
+  // Single-producer/single-consumer sample ring (sized in Start)
+  std::vector<float> mRing;
+  std::atomic<size_t> mRingHead{0};   // Samples written (producer)
+  std::atomic<size_t> mRingTail{0};   // Samples read (consumer)
+  int mChannels = 0;
+
+  std::atomic<bool> mRunning{false};
+  std::atomic<uint64_t> mPcmBytes{0};
+  std::atomic<uint64_t> mCompressedBytes{0};
+  std::atomic<int64_t> mDroppedFrames{0};
+  std::atomic<bool> mFailed{false};
+
+  std::thread mWriter;
+  std::thread mReader;
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCv;
+  bool mStopRequested = false;
+
+#ifdef _WIN32
+  HANDLE mProcess = nullptr;
+  HANDLE mInputWrite = INVALID_HANDLE_VALUE;   // Our end of the encoder's stdin
+  HANDLE mOutputRead = INVALID_HANDLE_VALUE;   // Our end of the encoder's stdout
+#else
+  pid_t mPid = -1;
+  int mInputWrite = -1;
+  int mOutputRead = -1;
+#endif
+
+  std::string mLastError;
+};
@@ -0,0 +1,52 @@
+//==============================================================================
+// MessageRing.cpp
+// Fixed-capacity multi-producer ring of status lines for the Log tab
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "MessageRing.h"
+#include <algorithm>
+#include <cstring>
+
+static_assert((MessageRing::kCapacity & (MessageRing::kCapacity - 1)) == 0, "capacity must be a power of two");
+
+void MessageRing::Push(const std::string& line)
+{
+  const uint64_t index = mNext.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = mSlots[index & (kCapacity - 1)];
+
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);  // Odd: write in progress
+  std::atomic_thread_fence(std::memory_order_release);
+  const size_t length = std::min(line.size(), kMaxLineBytes);
+  std::memcpy(slot.text, line.data(), length);
+  slot.length = static_cast<uint32_t>(length);
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+  mGeneration.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t MessageRing::AppendRecent(std::string& out, size_t maxLines) const
+{
+  const uint64_t generation = mGeneration.load(std::memory_order_acquire);
+  const uint64_t end = mNext.load(std::memory_order_acquire);
+  const uint64_t count = std::min<uint64_t>({end, maxLines, kCapacity});
+
+  char text[kMaxLineBytes];
+  for (uint64_t index = end - count; index < end; ++index)
+  {
+    const Slot& slot = mSlots[index & (kCapacity - 1)];
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before != 2 * index + 2)
+      continue;  // Still being written, or already overwritten by a newer line
+
+    const size_t length = std::min<size_t>(slot.length, kMaxLineBytes);
+    std::memcpy(text, slot.text, length);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before)
+      continue;
+
+    out.append(text, length);
+    out += '\n';
+  }
+  return generation;
+}
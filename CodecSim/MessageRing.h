@@ -0,0 +1,52 @@
+#pragma once
+
+//==============================================================================
+// MessageRing.h
+// Fixed-capacity multi-producer ring of status lines for the Log tab
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//==============================================================================
+// MessageRing - producers (ffmpeg stderr, parameter and init threads) reserve a
+// slot with one fetch_add and copy their line into it; they never wait for each
+// other or for the UI. The generation counter changes whenever a line has been
+// completed, so the UI rebuilds its text only when there is something new.
+// The oldest lines are overwritten.
+//==============================================================================
+class MessageRing
+{
+public:
+  static constexpr size_t kCapacity = 64;        // Power of two, more than the UI shows
+  static constexpr size_t kMaxLineBytes = 244;   // Longer lines are truncated
+
+  // Append a line (any thread)
+  void Push(const std::string& line);
+
+  // Changes after every completed Push
+  uint64_t Generation() const { return mGeneration.load(std::memory_order_acquire); }
+
+  /**
+   * Append the newest lines, oldest first, each followed by '\n'. Lines still
+   * being written are skipped; their Push bumps the generation afterwards.
+   * @param maxLines Number of most recent lines to consider (at most kCapacity)
+   * @return The generation the text reflects
+   */
+  uint64_t AppendRecent(std::string& out, size_t maxLines) const;
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence{0};   // 2 * index + 1 while written, 2 * index + 2 when complete
+    uint32_t length = 0;
+    char text[kMaxLineBytes];
+  };
+
+  std::atomic<uint64_t> mNext{0};        // Index of the next line to reserve
+  std::atomic<uint64_t> mGeneration{0};
+  Slot mSlots[kCapacity];
+};
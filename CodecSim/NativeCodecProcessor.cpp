@@ -0,0 +1,315 @@
+//==============================================================================
+// NativeCodecProcessor.cpp
+// In-process codec processor for codecs with a native implementation
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "NativeCodecProcessor.h"
+#include "LibOpusProcessor.h"
+#include "LosslessPassthrough.h"
+#include <algorithm>
+
+namespace
+{
+
+constexpr int kPendingReserveFrames = 8192;   // Plugin block limit; larger overflows allocate
+constexpr size_t kChunkSamples = 1024;        // s16 staging for Encode/Decode
+
+NativeCodecs::G711Law LawOf(NativeCodec codec)
+{
+  return codec == NativeCodec::G711MuLaw ? NativeCodecs::G711Law::MuLaw : NativeCodecs::G711Law::ALaw;
+}
+
+bool AdpcmFormatOf(NativeCodec codec, NativeCodecs::AdpcmFormat& format)
+{
+  switch (codec)
+  {
+    case NativeCodec::AdpcmIma: format = NativeCodecs::AdpcmFormat::ImaWav; return true;
+    case NativeCodec::AdpcmMs: format = NativeCodecs::AdpcmFormat::Ms; return true;
+    case NativeCodec::AdpcmYamaha: format = NativeCodecs::AdpcmFormat::Yamaha; return true;
+    default: return false;
+  }
+}
+
+} // namespace
+
+NativeCodecProcessor::NativeCodecProcessor(const CodecInfo& codecInfo)
+  : mCodecInfo(codecInfo)
+{
+}
+
+bool NativeCodecProcessor::Initialize(int sampleRate, int channels)
+{
+  if (mCodecInfo.native == NativeCodec::None || mCodecInfo.native == NativeCodec::Passthrough ||
+      mCodecInfo.native == NativeCodec::Opus || sampleRate <= 0 ||
+      channels < 1 || channels > 2 || (mCodecInfo.monoOnly && channels != 1))
+    return false;
+
+  NativeCodecs::AdpcmFormat format;
+  mBlockCodec = AdpcmFormatOf(mCodecInfo.native, format);
+  if (mBlockCodec)
+  {
+    if (!mAdpcm.Configure(format, channels))
+      return false;
+    const size_t blockSamples = static_cast<size_t>(mAdpcm.GetFrameSize()) * channels;
+    mBlockInput.assign(blockSamples, 0);
+    mBlockBytes.assign(static_cast<size_t>(mAdpcm.GetBlockAlign()), 0);
+    mBlockDecoded.assign(blockSamples, 0);
+  }
+
+  mSampleRate = sampleRate;
+  mChannels = channels;
+  mPending.reserve(static_cast<size_t>(kPendingReserveFrames + GetLatencySamples()) * channels);
+  Reset();
+  mInitialized = true;
+
+  if (mLogCallback)
+    mLogCallback("Native " + std::string(mCodecInfo.displayName) + ": " + std::to_string(sampleRate) + " Hz, " +
+                 std::to_string(channels) + " ch, latency " + std::to_string(GetLatencySamples()));
+  return true;
+}
+
+void NativeCodecProcessor::Shutdown()
+{
+  mInitialized = false;
+  mPending.clear();
+  mPendingRead = 0;
+}
+
+void NativeCodecProcessor::Reset()
+{
+  mDfpwmEncoder.Reset();
+  mDfpwmDecoder.Reset();
+  mAdpcm.Reset();
+  mBlockFill = 0;
+
+  // Block codecs: one block of silence ahead of the first decoded block
+  mPending.assign(static_cast<size_t>(GetLatencySamples()) * mChannels, 0.0f);
+  mPendingRead = 0;
+}
+
+void NativeCodecProcessor::SetLogCallback(std::function<void(const std::string&)> callback)
+{
+  mLogCallback = std::move(callback);
+}
+
+void NativeCodecProcessor::RoundTrip(const float* input, float* output, size_t count)
+{
+  if (mCodecInfo.native == NativeCodec::Dfpwm)
+    NativeCodecs::DfpwmRoundTrip(mDfpwmEncoder, mDfpwmDecoder, input, output, count);
+  else
+    NativeCodecs::G711RoundTrip(LawOf(mCodecInfo.native), input, output, count);
+}
+
+size_t NativeCodecProcessor::DrainPending(float* output, size_t maxFrames)
+{
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t frames = std::min((mPending.size() - mPendingRead) / channels, maxFrames);
+  std::copy_n(mPending.data() + mPendingRead, frames * channels, output);
+  mPendingRead += frames * channels;
+
+  // Only a block or two (or one call's overflow) stays behind, so compacting is cheap
+  mPending.erase(mPending.begin(), mPending.begin() + static_cast<std::ptrdiff_t>(mPendingRead));
+  mPendingRead = 0;
+  return frames;
+}
+
+size_t NativeCodecProcessor::FillBlock(const float* input, size_t frames)
+{
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t taken = std::min(frames, static_cast<size_t>(mAdpcm.GetFrameSize()) - mBlockFill);
+  NativeCodecs::FloatToS16(input, mBlockInput.data() + mBlockFill * channels, taken * channels);
+  mBlockFill += taken;
+  return taken;
+}
+
+bool NativeCodecProcessor::IsBlockFull() const
+{
+  return mBlockFill == static_cast<size_t>(mAdpcm.GetFrameSize());
+}
+
+void NativeCodecProcessor::DecodeBlockToPending()
+{
+  mAdpcm.DecodeBlock(mBlockBytes.data(), mBlockDecoded.data());
+  const size_t base = mPending.size();
+  mPending.resize(base + mBlockDecoded.size());
+  NativeCodecs::S16ToFloat(mBlockDecoded.data(), mPending.data() + base, mBlockDecoded.size());
+}
+
+int NativeCodecProcessor::Process(const float* input, int numSamples, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || maxOutputSamples < 0)
+    return 0;
+
+  const size_t channels = static_cast<size_t>(mChannels);
+  const size_t frames = (input && numSamples > 0) ? static_cast<size_t>(numSamples) : 0;
+
+  if (mBlockCodec)
+  {
+    for (size_t done = 0; done < frames;)
+    {
+      done += FillBlock(input + done * channels, frames - done);
+      if (IsBlockFull())
+      {
+        mAdpcm.EncodeBlock(mBlockInput.data(), mBlockBytes.data());
+        mBlockFill = 0;
+        DecodeBlockToPending();
+      }
+    }
+    // The primed block covers the partial one, so there are always 'frames'
+    // to return; the rest waits. With no input (after Finish) all of it goes.
+    const size_t limit = frames > 0 ? std::min(frames, static_cast<size_t>(maxOutputSamples))
+                                    : static_cast<size_t>(maxOutputSamples);
+    return static_cast<int>(DrainPending(output, limit));
+  }
+
+  // Overflow from earlier calls goes out first, so the stream stays in order
+  size_t written = 0;
+  if (mPendingRead < mPending.size())
+    written = DrainPending(output, static_cast<size_t>(maxOutputSamples));
+  if (frames == 0)
+    return static_cast<int>(written);
+
+  const size_t direct = mPending.empty() ? std::min(frames, static_cast<size_t>(maxOutputSamples) - written) : 0;
+  RoundTrip(input, output + written * channels, direct * channels);
+  written += direct;
+
+  if (direct < frames)
+  {
+    const size_t base = mPending.size();
+    mPending.resize(base + (frames - direct) * channels);
+    RoundTrip(input + direct * channels, mPending.data() + base, (frames - direct) * channels);
+  }
+  return static_cast<int>(written);
+}
+
+bool NativeCodecProcessor::Finish(int timeoutMs)
+{
+  (void)timeoutMs;
+  if (!mInitialized || !mBlockCodec || mBlockFill == 0)
+    return mInitialized;
+
+  // Like ffmpeg's encoder, the last partial block is padded with silence
+  std::fill(mBlockInput.begin() + static_cast<std::ptrdiff_t>(mBlockFill * mChannels), mBlockInput.end(), 0);
+  mAdpcm.EncodeBlock(mBlockInput.data(), mBlockBytes.data());
+  mBlockFill = 0;
+  DecodeBlockToPending();
+  return true;
+}
+
+int NativeCodecProcessor::Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes)
+{
+  if (!mInitialized || !input || numSamples <= 0 || maxOutputBytes <= 0)
+    return 0;
+
+  const size_t channels = static_cast<size_t>(mChannels);
+  if (mBlockCodec)
+  {
+    const size_t blockAlign = static_cast<size_t>(mAdpcm.GetBlockAlign());
+    const size_t blocks = static_cast<size_t>(maxOutputBytes) / blockAlign;
+    const size_t room = blocks > 0 ? blocks * mAdpcm.GetFrameSize() - mBlockFill : 0;
+    const size_t frames = std::min(static_cast<size_t>(numSamples), room);
+    size_t written = 0;
+    for (size_t done = 0; done < frames;)
+    {
+      done += FillBlock(input + done * channels, frames - done);
+      if (IsBlockFull())
+      {
+        mAdpcm.EncodeBlock(mBlockInput.data(), output + written);
+        mBlockFill = 0;
+        written += blockAlign;
+      }
+    }
+    return static_cast<int>(written);
+  }
+
+  const bool dfpwm = mCodecInfo.native == NativeCodec::Dfpwm;
+  const size_t fit = dfpwm ? static_cast<size_t>(maxOutputBytes) * 8 : static_cast<size_t>(maxOutputBytes);
+  const size_t count = std::min(static_cast<size_t>(numSamples) * channels, fit / channels * channels);
+
+  int16_t samples[kChunkSamples];
+  size_t written = 0;
+  for (size_t offset = 0; offset < count; offset += kChunkSamples)
+  {
+    const size_t n = std::min(kChunkSamples, count - offset);
+    NativeCodecs::FloatToS16(input + offset, samples, n);
+    if (dfpwm)
+    {
+      written += mDfpwmEncoder.Encode(samples, n, output + written);
+    }
+    else
+    {
+      NativeCodecs::G711EncodeBlock(LawOf(mCodecInfo.native), samples, output + written, n);
+      written += n;
+    }
+  }
+  return static_cast<int>(written);
+}
+
+int NativeCodecProcessor::Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples)
+{
+  if (!mInitialized || !input || inputBytes <= 0 || maxOutputSamples <= 0)
+    return 0;
+
+  if (mBlockCodec)
+  {
+    const size_t blockAlign = static_cast<size_t>(mAdpcm.GetBlockAlign());
+    const size_t frameSize = static_cast<size_t>(mAdpcm.GetFrameSize());
+    const size_t blocks = std::min(static_cast<size_t>(inputBytes) / blockAlign,
+                                   static_cast<size_t>(maxOutputSamples) / frameSize);
+    for (size_t b = 0; b < blocks; ++b)
+    {
+      mAdpcm.DecodeBlock(input + b * blockAlign, mBlockDecoded.data());
+      NativeCodecs::S16ToFloat(mBlockDecoded.data(), output + b * mBlockDecoded.size(), mBlockDecoded.size());
+    }
+    return static_cast<int>(blocks * frameSize);
+  }
+
+  const bool dfpwm = mCodecInfo.native == NativeCodec::Dfpwm;
+  const size_t maxSamples = static_cast<size_t>(maxOutputSamples) * mChannels;
+  const size_t bytes = std::min(static_cast<size_t>(inputBytes), dfpwm ? maxSamples / 8 : maxSamples);
+  const size_t samplesPerByte = dfpwm ? 8 : 1;
+
+  int16_t samples[kChunkSamples];
+  const size_t chunkBytes = kChunkSamples / samplesPerByte;
+  for (size_t offset = 0; offset < bytes; offset += chunkBytes)
+  {
+    const size_t n = std::min(chunkBytes, bytes - offset);
+    if (dfpwm)
+      mDfpwmDecoder.Decode(input + offset, n, samples);
+    else
+      NativeCodecs::G711DecodeBlock(LawOf(mCodecInfo.native), input + offset, samples, n);
+    NativeCodecs::S16ToFloat(samples, output + offset * samplesPerByte, n * samplesPerByte);
+  }
+  return static_cast<int>(bytes * samplesPerByte / mChannels);
+}
+
+bool HasNativeProcessor(const CodecInfo& codecInfo, const CodecOptionValues& options, int sampleRate)
+{
+  if (codecInfo.native == NativeCodec::Passthrough)
+    return GetCodecOptionValue(codecInfo, options, "lossless_mode") == 0;
+#if CODECSIM_HAS_LIBOPUS
+  if (codecInfo.native == NativeCodec::Opus && sampleRate > 0)
+    return LibOpusProcessor::SupportsSampleRate(sampleRate);
+#else
+  (void)sampleRate;
+#endif
+  return codecInfo.native != NativeCodec::None;
+}
+
+std::unique_ptr<ICodecProcessor> CreateNativeCodecProcessor(const CodecInfo& codecInfo, const CodecOptionValues& options,
+                                                            int bitrateKbps, int sampleRate)
+{
+  if (!HasNativeProcessor(codecInfo, options, sampleRate))
+    return nullptr;
+  if (codecInfo.native == NativeCodec::Passthrough)
+    return std::make_unique<LosslessPassthroughProcessor>(codecInfo,
+                                                          GetCodecOptionValue(codecInfo, options, "lossless_delay"));
+#if CODECSIM_HAS_LIBOPUS
+  if (codecInfo.native == NativeCodec::Opus)
+    return std::make_unique<LibOpusProcessor>(codecInfo, options, bitrateKbps);
+#else
+  (void)bitrateKbps;  // Only libopus takes a bitrate
+#endif
+  return std::make_unique<NativeCodecProcessor>(codecInfo);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+//==============================================================================
+// NativeCodecProcessor.h
+// In-process codec processor for codecs with a native implementation
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "ICodecProcessor.h"
+#include "CodecRegistry.h"
+#include "NativeCodecs.h"
+#include <memory>
+#include <vector>
+
+//==============================================================================
+// NativeCodecProcessor
+// Runs the codec's encoder and decoder on the calling thread: no processes,
+// no pipes. Output is bit-exact with the ffmpeg pipeline's.
+//
+// Sample codecs (G.711, DFPWM) have no latency. Block codecs (ADPCM) encode
+// and decode each block as its last frame arrives; the output starts with
+// one block of silence, so every Process call still returns as many frames
+// as it was given, exactly GetLatencySamples() late.
+//==============================================================================
+class NativeCodecProcessor : public ICodecProcessor
+{
+public:
+  explicit NativeCodecProcessor(const CodecInfo& codecInfo);
+
+  // ICodecProcessor interface
+  bool Initialize(int sampleRate, int channels) override;
+  void Shutdown() override;
+  void Reset() override;
+
+  // numSamples in frames, as for Process. Encode/Decode share the codec state
+  // with Process: use one or the other. Block codecs write and read whole
+  // blocks; input beyond the blocks that fit in maxOutputBytes is dropped.
+  int Encode(const float* input, int numSamples, uint8_t* output, int maxOutputBytes) override;
+  int Decode(const uint8_t* input, int inputBytes, float* output, int maxOutputSamples) override;
+  int Process(const float* input, int numSamples, float* output, int maxOutputSamples) override;
+
+  int GetLatencySamples() const override { return mBlockCodec ? mAdpcm.GetFrameSize() : 0; }
+  int GetFrameSize() const override { return mBlockCodec ? mAdpcm.GetFrameSize() : mCodecInfo.frameSize; }
+  bool IsInitialized() const override { return mInitialized; }
+  void SetLogCallback(std::function<void(const std::string&)> callback) override;
+  bool HasFirstAudioArrived() const override { return mInitialized; }
+  bool IsSynchronous() const override { return true; }
+
+  // Block codecs: pad the partial block with silence so Process can return the tail
+  bool Finish(int timeoutMs) override;
+
+  const CodecInfo& GetCodecInfo() const { return mCodecInfo; }
+
+private:
+  void RoundTrip(const float* input, float* output, size_t count);  // Sample codecs
+  size_t DrainPending(float* output, size_t maxFrames);             // Frames copied
+  size_t FillBlock(const float* input, size_t frames);              // Frames taken into mBlockInput
+  bool IsBlockFull() const;
+  void DecodeBlockToPending();                                      // mBlockBytes -> mPending
+
+  CodecInfo mCodecInfo;
+  int mSampleRate = 0;
+  int mChannels = 0;
+  bool mInitialized = false;
+  std::function<void(const std::string&)> mLogCallback;
+
+  NativeCodecs::DfpwmEncoder mDfpwmEncoder;
+  NativeCodecs::DfpwmDecoder mDfpwmDecoder;
+
+  // Block codecs: the block being collected, its encoding and decoding
+  bool mBlockCodec = false;
+  NativeCodecs::AdpcmCodec mAdpcm;
+  std::vector<int16_t> mBlockInput;
+  size_t mBlockFill = 0;   // Frames in mBlockInput
+  std::vector<uint8_t> mBlockBytes;
+  std::vector<int16_t> mBlockDecoded;
+
+  // Decoded frames not yet returned (interleaved)
+  std::vector<float> mPending;
+  size_t mPendingRead = 0;
+};
+
+// Whether CreateNativeCodecProcessor returns a processor for these settings
+// (sampleRate 0 = not known yet: any rate the codec may run at)
+bool HasNativeProcessor(const CodecInfo& codecInfo, const CodecOptionValues& options, int sampleRate = 0);
+
+/**
+ * Native processor for a codec, if it has one (CodecInfo::native): the codec
+ * kernels above, LosslessPassthroughProcessor for lossless codecs, or
+ * LibOpusProcessor for Opus
+ * @param options Codec option values (lossless: "lossless_mode", "lossless_delay"; Opus: all of its options)
+ * @param bitrateKbps Bitrate for codecs that take one (0 = codec default)
+ * @param sampleRate Rate it will be initialized at (0 = not known yet)
+ * @return nullptr for codecs that only run through ffmpeg, or whose options or
+ *         sample rate select it (libopus only runs at the Opus rates)
+ */
+std::unique_ptr<ICodecProcessor> CreateNativeCodecProcessor(const CodecInfo& codecInfo,
+                                                            const CodecOptionValues& options = {},
+                                                            int bitrateKbps = 0, int sampleRate = 0);
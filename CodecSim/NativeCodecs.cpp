@@ -0,0 +1,633 @@
+//==============================================================================
+// NativeCodecs.cpp
+// In-process codec kernels, bit-exact with ffmpeg's encoders/decoders
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "NativeCodecs.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CODECSIM_NATIVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace NativeCodecs
+{
+
+namespace
+{
+
+//==============================================================================
+// G.711 tables (libavcodec/pcm_tablegen.h)
+//==============================================================================
+constexpr int kXlawTableSize = 16384;   // 14-bit linear index
+
+int ALawToLinear(uint8_t code)
+{
+  code ^= 0x55;
+  int t = code & 0x0f;
+  const int segment = (code & 0x70) >> 4;
+  if (segment)
+    t = (t + t + 1 + 32) << (segment + 2);
+  else
+    t = (t + t + 1) << 3;
+  return (code & 0x80) ? t : -t;
+}
+
+int MuLawToLinear(uint8_t code)
+{
+  constexpr int kBias = 0x84;
+  code = static_cast<uint8_t>(~code);
+  int t = ((code & 0x0f) << 3) + kBias;
+  t <<= (code & 0x70) >> 4;
+  return (code & 0x80) ? (kBias - t) : (t - kBias);
+}
+
+// Each code covers the 14-bit values up to the midpoint between it and the next code
+void BuildEncodeTable(uint8_t* table, int (*toLinear)(uint8_t), int mask)
+{
+  int j = 1;
+  table[8192] = static_cast<uint8_t>(mask);
+  for (int i = 0; i < 127; ++i)
+  {
+    const int v1 = toLinear(static_cast<uint8_t>(i ^ mask));
+    const int v2 = toLinear(static_cast<uint8_t>((i + 1) ^ mask));
+    const int v = (v1 + v2 + 4) >> 3;
+    for (; j < v; ++j)
+    {
+      table[8192 - j] = static_cast<uint8_t>(i ^ (mask ^ 0x80));
+      table[8192 + j] = static_cast<uint8_t>(i ^ mask);
+    }
+  }
+  for (; j < 8192; ++j)
+  {
+    table[8192 - j] = static_cast<uint8_t>(127 ^ (mask ^ 0x80));
+    table[8192 + j] = static_cast<uint8_t>(127 ^ mask);
+  }
+  table[0] = table[1];
+}
+
+struct G711Tables
+{
+  uint8_t encode[kXlawTableSize];
+  int16_t decode[256];
+  float roundTrip[kXlawTableSize];   // 14-bit index -> decoded float
+
+  G711Tables(int (*toLinear)(uint8_t), int mask)
+  {
+    BuildEncodeTable(encode, toLinear, mask);
+    for (int code = 0; code < 256; ++code)
+      decode[code] = static_cast<int16_t>(toLinear(static_cast<uint8_t>(code)));
+    for (int i = 0; i < kXlawTableSize; ++i)
+      roundTrip[i] = static_cast<float>(decode[encode[i]]) / 32768.0f;
+  }
+};
+
+const G711Tables& TablesFor(G711Law law)
+{
+  static const G711Tables alaw(ALawToLinear, 0xd5);
+  static const G711Tables mulaw(MuLawToLinear, 0xff);
+  return law == G711Law::ALaw ? alaw : mulaw;
+}
+
+inline int EncodeIndex(int16_t sample)
+{
+  return (sample + 32768) >> 2;
+}
+
+// x32768, clamp, round to nearest even (the SSE2 conversion's default mode)
+inline int16_t ToS16(float sample)
+{
+  const float scaled = std::max(-32768.0f, std::min(32767.0f, sample * 32768.0f));
+  return static_cast<int16_t>(std::lrint(scaled));
+}
+
+#if CODECSIM_NATIVE_SSE2
+// Four lanes of ToS16 as int32; min/max with the sample as first operand match
+// std::min/max, NaN included
+inline __m128i ToS16x4(__m128 sample)
+{
+  const __m128 scaled = _mm_mul_ps(sample, _mm_set1_ps(32768.0f));
+  return _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(scaled, _mm_set1_ps(32767.0f)), _mm_set1_ps(-32768.0f)));
+}
+#endif
+
+//==============================================================================
+// DFPWM1a (libavcodec/dfpwmenc.c, dfpwmdec.c)
+//==============================================================================
+constexpr int kDfpwmPrecision = 10;
+constexpr int kDfpwmLowPassStrength = 140;   // ffmpeg's decoder filter constant
+
+// Move the charge toward the target and adapt the strength; returns the new charge
+inline int StepPredictor(DfpwmPredictor& p, int target)
+{
+  int charge = p.charge + ((p.strength * (target - p.charge) + (1 << (kDfpwmPrecision - 1))) >> kDfpwmPrecision);
+  if (charge == p.charge && charge != target)
+    charge += (target == 127) ? 1 : -1;
+  p.charge = charge;
+
+  const int strengthTarget = (target != p.lastTarget) ? 0 : (1 << kDfpwmPrecision) - 1;
+  int strength = p.strength;
+  if (strength != strengthTarget)
+    strength += (strengthTarget != 0) ? 1 : -1;
+  p.strength = std::max(strength, 1 << (kDfpwmPrecision - 8));
+  return charge;
+}
+
+// s16 -> u8 (swresample: (s >> 8) + 0x80) -> signed level
+inline int DfpwmLevel(int16_t sample)
+{
+  return sample >> 8;
+}
+
+} // namespace
+
+//==============================================================================
+// Sample conversion
+//==============================================================================
+void FloatToS16(const float* input, int16_t* output, size_t count)
+{
+  size_t i = 0;
+#if CODECSIM_NATIVE_SSE2
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m128i packed = _mm_packs_epi32(ToS16x4(_mm_loadu_ps(input + i)), ToS16x4(_mm_loadu_ps(input + i + 4)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+  }
+#endif
+  for (; i < count; ++i)
+    output[i] = ToS16(input[i]);
+}
+
+void S16ToFloat(const int16_t* input, float* output, size_t count)
+{
+  size_t i = 0;
+#if CODECSIM_NATIVE_SSE2
+  const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);   // Power of two: same result as dividing
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+    _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+  }
+#endif
+  for (; i < count; ++i)
+    output[i] = static_cast<float>(input[i]) / 32768.0f;
+}
+
+//==============================================================================
+// G.711
+//==============================================================================
+uint8_t G711Encode(G711Law law, int16_t sample)
+{
+  return TablesFor(law).encode[EncodeIndex(sample)];
+}
+
+int16_t G711Decode(G711Law law, uint8_t code)
+{
+  return TablesFor(law).decode[code];
+}
+
+void G711EncodeBlock(G711Law law, const int16_t* input, uint8_t* output, size_t count)
+{
+  const uint8_t* table = TablesFor(law).encode;
+  for (size_t i = 0; i < count; ++i)
+    output[i] = table[EncodeIndex(input[i])];
+}
+
+void G711DecodeBlock(G711Law law, const uint8_t* input, int16_t* output, size_t count)
+{
+  const int16_t* table = TablesFor(law).decode;
+  for (size_t i = 0; i < count; ++i)
+    output[i] = table[input[i]];
+}
+
+void G711RoundTrip(G711Law law, const float* input, float* output, size_t count)
+{
+  const float* table = TablesFor(law).roundTrip;
+  size_t i = 0;
+#if CODECSIM_NATIVE_SSE2
+  // Index math in SIMD ((ToS16(x) + 32768) >> 2), lookups scalar
+  const __m128i offset = _mm_set1_epi32(32768);
+  alignas(16) int32_t index[8];
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m128i ia = _mm_srai_epi32(_mm_add_epi32(ToS16x4(_mm_loadu_ps(input + i)), offset), 2);
+    const __m128i ib = _mm_srai_epi32(_mm_add_epi32(ToS16x4(_mm_loadu_ps(input + i + 4)), offset), 2);
+    _mm_store_si128(reinterpret_cast<__m128i*>(index), ia);
+    _mm_store_si128(reinterpret_cast<__m128i*>(index + 4), ib);
+    for (int k = 0; k < 8; ++k)
+      output[i + k] = table[index[k]];
+  }
+#endif
+  for (; i < count; ++i)
+    output[i] = table[EncodeIndex(ToS16(input[i]))];
+}
+
+//==============================================================================
+// DFPWM
+//==============================================================================
+void DfpwmEncoder::Reset()
+{
+  mPredictor = DfpwmPredictor();
+  mBits = 0;
+  mBitCount = 0;
+}
+
+int DfpwmEncoder::EncodeSample(int sample)
+{
+  const int charge = mPredictor.charge;
+  const int target = (sample > charge || (sample == charge && sample == 127)) ? 127 : -128;
+  StepPredictor(mPredictor, target);
+  mPredictor.lastTarget = target;
+  return target;
+}
+
+size_t DfpwmEncoder::Encode(const int16_t* input, size_t count, uint8_t* output)
+{
+  size_t written = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    mBits >>= 1;
+    if (EncodeSample(DfpwmLevel(input[i])) > 0)
+      mBits |= 0x80;
+    if (++mBitCount == 8)
+    {
+      output[written++] = static_cast<uint8_t>(mBits);
+      mBits = 0;
+      mBitCount = 0;
+    }
+  }
+  return written;
+}
+
+void DfpwmDecoder::Reset()
+{
+  mPredictor = DfpwmPredictor();
+  mFiltered = 0;
+}
+
+int DfpwmDecoder::DecodeSample(int target)
+{
+  const int lastCharge = mPredictor.charge;
+  const int charge = StepPredictor(mPredictor, target);
+
+  // Antijerk: average across a target flip, then the low-pass filter
+  const int level = (target != mPredictor.lastTarget) ? (charge + lastCharge + 1) >> 1 : charge;
+  mFiltered += (kDfpwmLowPassStrength * (level - mFiltered) + 0x80) >> 8;
+  mPredictor.lastTarget = target;
+  return mFiltered;
+}
+
+void DfpwmDecoder::Decode(const uint8_t* input, size_t bytes, int16_t* output)
+{
+  for (size_t i = 0; i < bytes; ++i)
+  {
+    unsigned bits = input[i];
+    for (int b = 0; b < 8; ++b, bits >>= 1)
+      *output++ = static_cast<int16_t>(DecodeSample((bits & 1) ? 127 : -128) * 256);   // u8 -> s16: (u - 0x80) << 8
+  }
+}
+
+void DfpwmRoundTrip(DfpwmEncoder& encoder, DfpwmDecoder& decoder, const float* input, float* output, size_t count)
+{
+  // The predictor is serial, so only the conversions are vectorized
+  constexpr size_t kChunk = 256;
+  int16_t samples[kChunk];
+  for (size_t offset = 0; offset < count; offset += kChunk)
+  {
+    const size_t n = std::min(kChunk, count - offset);
+    FloatToS16(input + offset, samples, n);
+    for (size_t i = 0; i < n; ++i)
+      samples[i] = static_cast<int16_t>(decoder.DecodeSample(encoder.EncodeSample(DfpwmLevel(samples[i]))) * 256);
+    S16ToFloat(samples, output + offset, n);
+  }
+}
+
+//==============================================================================
+// ADPCM (libavcodec/adpcmenc.c, adpcm.c, adpcm_data.c)
+//==============================================================================
+namespace
+{
+
+constexpr int16_t kImaStepTable[89] = {
+  7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+  19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+  50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+  130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+  337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+  876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+  2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+  5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+  15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+constexpr int8_t kImaIndexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+constexpr int kMsAdaptationTable[16] = {230, 230, 230, 230, 307, 409, 512, 614,
+                                        768, 614, 512, 409, 307, 230, 230, 230};
+// Microsoft's coefficients / 4 (ffmpeg predicts with a / 64)
+constexpr int kMsAdaptCoeff1[7] = {64, 128, 0, 48, 60, 115, 98};
+constexpr int kMsAdaptCoeff2[7] = {0, -64, 0, 16, 0, -52, -58};
+
+constexpr int kYamahaIndexScale[16] = {230, 230, 230, 230, 307, 409, 512, 614,
+                                       230, 230, 230, 230, 307, 409, 512, 614};
+constexpr int kYamahaDiffLookup[16] = {1, 3, 5, 7, 9, 11, 13, 15, -1, -3, -5, -7, -9, -11, -13, -15};
+
+using Channel = AdpcmCodec::Channel;
+
+inline int ClipInt16(int value)
+{
+  return std::clamp(value, -32768, 32767);
+}
+
+inline int ReadLe16(const uint8_t* p)
+{
+  return static_cast<int16_t>(p[0] | (p[1] << 8));
+}
+
+inline void WriteLe16(uint8_t* p, int value)
+{
+  p[0] = static_cast<uint8_t>(value & 0xff);
+  p[1] = static_cast<uint8_t>((value >> 8) & 0xff);
+}
+
+// adpcm_ima_compress_sample
+inline int ImaCompress(Channel& c, int sample)
+{
+  const int step = kImaStepTable[c.stepIndex];
+  const int delta = sample - c.predictor;
+  const int nibble = std::min(7, std::abs(delta) * 4 / step) + (delta < 0) * 8;
+  c.predictor = ClipInt16(c.predictor + step * kYamahaDiffLookup[nibble] / 8);
+  c.stepIndex = std::clamp(c.stepIndex + kImaIndexTable[nibble], 0, 88);
+  return nibble;
+}
+
+// adpcm_ima_qt_expand_nibble (ffmpeg's 4-bit IMA WAV decoder)
+inline int ImaExpand(Channel& c, int nibble)
+{
+  const int step = kImaStepTable[c.stepIndex];
+  int diff = step >> 3;
+  if (nibble & 4)
+    diff += step;
+  if (nibble & 2)
+    diff += step >> 1;
+  if (nibble & 1)
+    diff += step >> 2;
+  c.predictor = ClipInt16((nibble & 8) ? c.predictor - diff : c.predictor + diff);
+  c.stepIndex = std::clamp(c.stepIndex + kImaIndexTable[nibble], 0, 88);
+  return c.predictor;
+}
+
+// adpcm_ms_compress_sample
+inline int MsCompress(Channel& c, int sample)
+{
+  int predictor = (c.sample1 * c.coeff1 + c.sample2 * c.coeff2) / 64;
+  const int error = sample - predictor;
+  const int bias = (error >= 0) ? c.idelta / 2 : -c.idelta / 2;
+  const int nibble = std::clamp((error + bias) / c.idelta, -8, 7) & 0x0f;
+
+  predictor += ((nibble & 0x08) ? nibble - 0x10 : nibble) * c.idelta;
+  c.sample2 = c.sample1;
+  c.sample1 = ClipInt16(predictor);
+  c.idelta = std::max((kMsAdaptationTable[nibble] * c.idelta) >> 8, 16);
+  return nibble;
+}
+
+// adpcm_ms_expand_nibble
+inline int MsExpand(Channel& c, int nibble)
+{
+  int predictor = (c.sample1 * c.coeff1 + c.sample2 * c.coeff2) / 64;
+  predictor += ((nibble & 0x08) ? nibble - 0x10 : nibble) * c.idelta;
+  c.sample2 = c.sample1;
+  c.sample1 = ClipInt16(predictor);
+  c.idelta = std::clamp((kMsAdaptationTable[nibble] * c.idelta) >> 8, 16, INT_MAX / 768);
+  return c.sample1;
+}
+
+inline void YamahaStart(Channel& c)
+{
+  if (!c.step)
+  {
+    c.predictor = 0;
+    c.step = 127;
+  }
+}
+
+inline void YamahaAdvance(Channel& c, int nibble)
+{
+  c.predictor = ClipInt16(c.predictor + c.step * kYamahaDiffLookup[nibble] / 8);
+  c.step = std::clamp((c.step * kYamahaIndexScale[nibble]) >> 8, 127, 24576);
+}
+
+// adpcm_yamaha_compress_sample
+inline int YamahaCompress(Channel& c, int sample)
+{
+  YamahaStart(c);
+  const int delta = sample - c.predictor;
+  const int nibble = std::min(7, std::abs(delta) * 4 / c.step) + (delta < 0) * 8;
+  YamahaAdvance(c, nibble);
+  return nibble;
+}
+
+// adpcm_yamaha_expand_nibble
+inline int YamahaExpand(Channel& c, int nibble)
+{
+  YamahaStart(c);
+  YamahaAdvance(c, nibble);
+  return c.predictor;
+}
+
+} // namespace
+
+bool AdpcmCodec::Configure(AdpcmFormat format, int channels)
+{
+  if (channels < 1 || channels > 2)
+    return false;
+  mFormat = format;
+  mChannels = channels;
+  switch (format)
+  {
+    case AdpcmFormat::ImaWav: mFrameSize = (kBlockAlign - 4 * channels) * 8 / (4 * channels) + 1; break;
+    case AdpcmFormat::Ms:     mFrameSize = (kBlockAlign - 7 * channels) * 2 / channels + 2; break;
+    case AdpcmFormat::Yamaha: mFrameSize = kBlockAlign * 2 / channels; break;
+  }
+  Reset();
+  return true;
+}
+
+void AdpcmCodec::Reset()
+{
+  for (int ch = 0; ch < 2; ++ch)
+  {
+    mEncoder[ch] = Channel();
+    mDecoder[ch] = Channel();
+  }
+}
+
+void AdpcmCodec::EncodeBlock(const int16_t* input, uint8_t* block)
+{
+  const int channels = mChannels;
+  uint8_t* dst = block;
+  switch (mFormat)
+  {
+    case AdpcmFormat::ImaWav:
+    {
+      // Header: first sample and step index per channel; then 8 samples
+      // (4 bytes, low nibble first) per channel in turn
+      for (int ch = 0; ch < channels; ++ch)
+      {
+        Channel& c = mEncoder[ch];
+        c.predictor = input[ch];
+        WriteLe16(dst, c.predictor);
+        dst[2] = static_cast<uint8_t>(c.stepIndex);
+        dst[3] = 0;
+        dst += 4;
+      }
+      for (int group = 0; group < (mFrameSize - 1) / 8; ++group)
+      {
+        for (int ch = 0; ch < channels; ++ch)
+        {
+          const int16_t* smp = input + (1 + group * 8) * channels + ch;
+          for (int j = 0; j < 8; j += 2)
+          {
+            const int lo = ImaCompress(mEncoder[ch], smp[j * channels]);
+            const int hi = ImaCompress(mEncoder[ch], smp[(j + 1) * channels]);
+            *dst++ = static_cast<uint8_t>(lo | (hi << 4));
+          }
+        }
+      }
+      break;
+    }
+    case AdpcmFormat::Ms:
+    {
+      // Header: predictor index, step, second and first sample per channel;
+      // then one byte per frame pair (mono) or frame (stereo), high nibble first
+      for (int ch = 0; ch < channels; ++ch)
+      {
+        *dst++ = 0;
+        mEncoder[ch].coeff1 = kMsAdaptCoeff1[0];
+        mEncoder[ch].coeff2 = kMsAdaptCoeff2[0];
+      }
+      for (int ch = 0; ch < channels; ++ch, dst += 2)
+      {
+        mEncoder[ch].idelta = std::max(mEncoder[ch].idelta, 16);
+        WriteLe16(dst, mEncoder[ch].idelta);
+      }
+      const int16_t* samples = input;
+      for (int ch = 0; ch < channels; ++ch)
+        mEncoder[ch].sample2 = *samples++;
+      for (int ch = 0; ch < channels; ++ch, dst += 2)
+      {
+        mEncoder[ch].sample1 = *samples++;
+        WriteLe16(dst, mEncoder[ch].sample1);
+      }
+      for (int ch = 0; ch < channels; ++ch, dst += 2)
+        WriteLe16(dst, mEncoder[ch].sample2);
+
+      const int second = channels - 1;
+      for (int i = 7 * channels; i < kBlockAlign; ++i)
+      {
+        const int hi = MsCompress(mEncoder[0], *samples++);
+        const int lo = MsCompress(mEncoder[second], *samples++);
+        *dst++ = static_cast<uint8_t>((hi << 4) | lo);
+      }
+      break;
+    }
+    case AdpcmFormat::Yamaha:
+    {
+      // No header; low nibble first
+      const int second = channels - 1;
+      const int16_t* samples = input;
+      for (int i = 0; i < kBlockAlign; ++i)
+      {
+        const int lo = YamahaCompress(mEncoder[0], *samples++);
+        const int hi = YamahaCompress(mEncoder[second], *samples++);
+        *dst++ = static_cast<uint8_t>(lo | (hi << 4));
+      }
+      break;
+    }
+  }
+}
+
+void AdpcmCodec::DecodeBlock(const uint8_t* block, int16_t* output)
+{
+  const int channels = mChannels;
+  const uint8_t* src = block;
+  switch (mFormat)
+  {
+    case AdpcmFormat::ImaWav:
+    {
+      for (int ch = 0; ch < channels; ++ch, src += 4)
+      {
+        Channel& c = mDecoder[ch];
+        c.predictor = ReadLe16(src);
+        c.stepIndex = std::clamp(ReadLe16(src + 2), 0, 88);   // ffmpeg rejects > 88; never written
+        output[ch] = static_cast<int16_t>(c.predictor);
+      }
+      for (int group = 0; group < (mFrameSize - 1) / 8; ++group)
+      {
+        for (int ch = 0; ch < channels; ++ch)
+        {
+          int16_t* smp = output + (1 + group * 8) * channels + ch;
+          for (int j = 0; j < 8; j += 2)
+          {
+            const int v = *src++;
+            smp[j * channels] = static_cast<int16_t>(ImaExpand(mDecoder[ch], v & 0x0f));
+            smp[(j + 1) * channels] = static_cast<int16_t>(ImaExpand(mDecoder[ch], v >> 4));
+          }
+        }
+      }
+      break;
+    }
+    case AdpcmFormat::Ms:
+    {
+      for (int ch = 0; ch < channels; ++ch)
+      {
+        const int predictor = std::min<int>(*src++, 6);   // ffmpeg rejects > 6; never written
+        mDecoder[ch].coeff1 = kMsAdaptCoeff1[predictor];
+        mDecoder[ch].coeff2 = kMsAdaptCoeff2[predictor];
+      }
+      for (int ch = 0; ch < channels; ++ch, src += 2)
+        mDecoder[ch].idelta = ReadLe16(src);
+      for (int ch = 0; ch < channels; ++ch, src += 2)
+        mDecoder[ch].sample1 = ReadLe16(src);
+      for (int ch = 0; ch < channels; ++ch, src += 2)
+        mDecoder[ch].sample2 = ReadLe16(src);
+
+      int16_t* samples = output;
+      for (int ch = 0; ch < channels; ++ch)
+        *samples++ = static_cast<int16_t>(mDecoder[ch].sample2);
+      for (int ch = 0; ch < channels; ++ch)
+        *samples++ = static_cast<int16_t>(mDecoder[ch].sample1);
+
+      const int second = channels - 1;
+      for (int i = 7 * channels; i < kBlockAlign; ++i)
+      {
+        const int v = *src++;
+        *samples++ = static_cast<int16_t>(MsExpand(mDecoder[0], v >> 4));
+        *samples++ = static_cast<int16_t>(MsExpand(mDecoder[second], v & 0x0f));
+      }
+      break;
+    }
+    case AdpcmFormat::Yamaha:
+    {
+      const int second = channels - 1;
+      int16_t* samples = output;
+      for (int i = 0; i < kBlockAlign; ++i)
+      {
+        const int v = *src++;
+        *samples++ = static_cast<int16_t>(YamahaExpand(mDecoder[0], v & 0x0f));
+        *samples++ = static_cast<int16_t>(YamahaExpand(mDecoder[second], v >> 4));
+      }
+      break;
+    }
+  }
+}
+
+} // namespace NativeCodecs
@@ -0,0 +1,151 @@
+#pragma once
+
+//==============================================================================
+// NativeCodecs.h
+// In-process codec kernels, bit-exact with ffmpeg's encoders/decoders
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <cstddef>
+#include <cstdint>
+
+namespace NativeCodecs
+{
+
+//==============================================================================
+// Sample conversion, identical to the ffmpeg pipe path
+// (FFmpegPipeManager::FloatToS16LE / S16LEToFloat)
+//==============================================================================
+void FloatToS16(const float* input, int16_t* output, size_t count);
+void S16ToFloat(const int16_t* input, float* output, size_t count);
+
+//==============================================================================
+// G.711 (ffmpeg pcm_alaw / pcm_mulaw)
+// Encoding is ffmpeg's 14-bit lookup (linear_to_xlaw[(s + 32768) >> 2]), so
+// ties between two codes round the same way ffmpeg's table does.
+//==============================================================================
+enum class G711Law
+{
+  ALaw,
+  MuLaw
+};
+
+uint8_t G711Encode(G711Law law, int16_t sample);
+int16_t G711Decode(G711Law law, uint8_t code);
+void G711EncodeBlock(G711Law law, const int16_t* input, uint8_t* output, size_t count);
+void G711DecodeBlock(G711Law law, const uint8_t* input, int16_t* output, size_t count);
+
+/**
+ * Float -> s16 -> G.711 -> s16 -> float in one pass, equal to what the ffmpeg
+ * encoder/decoder pipeline returns for the same input (no latency, no state)
+ * @param count Samples (frames * channels)
+ */
+void G711RoundTrip(G711Law law, const float* input, float* output, size_t count);
+
+//==============================================================================
+// DFPWM1a (ffmpeg dfpwm encoder/decoder)
+// One bit per sample, packed LSB first. Like ffmpeg, a single predictor runs
+// over the interleaved samples of all channels.
+//==============================================================================
+struct DfpwmPredictor
+{
+  int charge = 0;
+  int strength = 0;
+  int lastTarget = -128;
+};
+
+class DfpwmEncoder
+{
+public:
+  void Reset();
+
+  /**
+   * Encode s16 samples (converted to u8 the way ffmpeg's resampler does)
+   * @return Bytes written: one per 8 samples; a partial byte is kept for the next call
+   */
+  size_t Encode(const int16_t* input, size_t count, uint8_t* output);
+
+  // One sample (-128..127) -> target level: 127 for a 1 bit, -128 for a 0 bit
+  int EncodeSample(int sample);
+
+private:
+  DfpwmPredictor mPredictor;
+  unsigned mBits = 0;
+  int mBitCount = 0;
+};
+
+class DfpwmDecoder
+{
+public:
+  void Reset();
+
+  // 8 s16 samples per input byte
+  void Decode(const uint8_t* input, size_t bytes, int16_t* output);
+
+  // Target level of one bit (127 / -128) -> filtered sample (-128..127)
+  int DecodeSample(int target);
+
+private:
+  DfpwmPredictor mPredictor;
+  int mFiltered = 0;
+};
+
+/**
+ * Float -> s16 -> u8 -> DFPWM -> u8 -> s16 -> float per sample, without
+ * packing bits (the decoder sees each bit as soon as it is encoded)
+ * @param count Samples (frames * channels)
+ */
+void DfpwmRoundTrip(DfpwmEncoder& encoder, DfpwmDecoder& decoder, const float* input, float* output, size_t count);
+
+//==============================================================================
+// ADPCM block codecs (ffmpeg adpcm_ima_wav / adpcm_ms / adpcm_yamaha with the
+// encoder defaults: 1024-byte blocks, no trellis search). A block holds
+// GetFrameSize() interleaved s16 frames; encoder and decoder keep separate
+// state, as in two ffmpeg processes.
+//==============================================================================
+enum class AdpcmFormat
+{
+  ImaWav,
+  Ms,
+  Yamaha
+};
+
+class AdpcmCodec
+{
+public:
+  static constexpr int kBlockAlign = 1024;   // Bytes per block (ffmpeg -block_size default)
+
+  // false for channel counts the format does not support (1 or 2 only)
+  bool Configure(AdpcmFormat format, int channels);
+  void Reset();
+
+  int GetFrameSize() const { return mFrameSize; }        // Frames per block
+  int GetBlockAlign() const { return kBlockAlign; }
+
+  // GetFrameSize() frames -> GetBlockAlign() bytes
+  void EncodeBlock(const int16_t* input, uint8_t* block);
+  // GetBlockAlign() bytes -> GetFrameSize() frames
+  void DecodeBlock(const uint8_t* block, int16_t* output);
+
+  // ADPCMChannelStatus: the fields each format uses
+  struct Channel
+  {
+    int predictor = 0;   // IMA, Yamaha
+    int stepIndex = 0;   // IMA
+    int step = 0;        // Yamaha (0 = not started)
+    int sample1 = 0;     // MS: previous two samples, predictor coefficients, step
+    int sample2 = 0;
+    int coeff1 = 0;
+    int coeff2 = 0;
+    int idelta = 0;
+  };
+
+private:
+  AdpcmFormat mFormat = AdpcmFormat::ImaWav;
+  int mChannels = 1;
+  int mFrameSize = 0;
+  Channel mEncoder[2];
+  Channel mDecoder[2];
+};
+
+} // namespace NativeCodecs
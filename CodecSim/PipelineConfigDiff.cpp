@@ -0,0 +1,151 @@
+//==============================================================================
+// PipelineConfigDiff.cpp
+// Classifies configuration changes as no-op, in-place or respawn
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "PipelineConfigDiff.h"
+
+namespace
+{
+
+std::string Quote(const std::string& value)
+{
+  return "\"" + value + "\"";
+}
+
+template <typename T>
+void Compare(std::vector<std::string>& fields, const char* name, const T& running, const T& next)
+{
+  if (running != next)
+    fields.push_back(std::string(name) + " " + std::to_string(running) + " -> " + std::to_string(next));
+}
+
+void Compare(std::vector<std::string>& fields, const char* name, const std::string& running, const std::string& next)
+{
+  if (running != next)
+    fields.push_back(std::string(name) + " " + Quote(running) + " -> " + Quote(next));
+}
+
+// Name only: full ffmpeg argument strings are too long for a log line
+void CompareNameOnly(std::vector<std::string>& fields, const char* name, const std::string& running,
+                     const std::string& next)
+{
+  if (running != next)
+    fields.emplace_back(name);
+}
+
+void Compare(std::vector<std::string>& fields, const char* name, bool running, bool next)
+{
+  if (running != next)
+    fields.push_back(std::string(name) + (next ? " on" : " off"));
+}
+
+void Compare(std::vector<std::string>& fields, const char* name, SchedulingClass running, SchedulingClass next)
+{
+  if (running != next)
+    fields.push_back(std::string(name) + " " + SchedulingClassName(running) + " -> " + SchedulingClassName(next));
+}
+
+std::string JoinFields(const std::vector<std::string>& fields)
+{
+  std::string joined;
+  for (const auto& field : fields)
+  {
+    if (!joined.empty())
+      joined += ", ";
+    joined += field;
+  }
+  return joined;
+}
+
+} // namespace
+
+PipelineConfigDiff DiffPipelineConfig(const FFmpegPipeManager::Config& running,
+                                      const FFmpegPipeManager::Config& next)
+{
+  PipelineConfigDiff diff;
+
+  // Command lines and pipe setup
+  auto& respawn = diff.respawnFields;
+  Compare(respawn, "ffmpegPath", running.ffmpegPath, next.ffmpegPath);
+  Compare(respawn, "codec", running.codecName, next.codecName);
+  Compare(respawn, "sampleRate", running.sampleRate, next.sampleRate);
+  Compare(respawn, "channels", running.channels, next.channels);
+  Compare(respawn, "bitrate", running.bitrate, next.bitrate);
+  CompareNameOnly(respawn, "args", running.additionalArgs, next.additionalArgs);
+  Compare(respawn, "muxer", running.muxerFormat, next.muxerFormat);
+  Compare(respawn, "demuxer", running.demuxerFormat, next.demuxerFormat);
+  Compare(respawn, "bufferSize", running.bufferSize, next.bufferSize);
+  Compare(respawn, "sharedWorker", running.sharedWorker, next.sharedWorker);
+  if (next.sharedWorker)
+    Compare(respawn, "sharedSlots", running.sharedSlots, next.sharedSlots);
+  Compare(respawn, "lowDelayMux", running.lowDelayMux, next.lowDelayMux);
+
+  // Applied by each pipe thread to itself when it starts
+  const SchedulingPolicy& rs = running.scheduling;
+  const SchedulingPolicy& ns = next.scheduling;
+  Compare(respawn, "threadScheduling", rs.threads, ns.threads);
+  Compare(respawn, "threadAffinity", rs.threadAffinity, ns.threadAffinity);
+  Compare(respawn, "realTimePriority", rs.realTimePriority, ns.realTimePriority);
+  Compare(respawn, "niceValue", rs.niceValue, ns.niceValue);
+
+  // Read while running, or re-applied to the live children
+  auto& inPlace = diff.inPlaceFields;
+  Compare(inPlace, "suspendWhenParked", running.suspendWhenParked, next.suspendWhenParked);
+  Compare(inPlace, "processScheduling", rs.processes, ns.processes);
+  Compare(inPlace, "processAffinity", rs.processAffinity, ns.processAffinity);
+
+  if (!respawn.empty())
+    diff.change = ConfigChange::Respawn;
+  else if (!inPlace.empty())
+    diff.change = ConfigChange::InPlace;
+  return diff;
+}
+
+std::vector<std::string> DiffCodecOptions(const CodecInfo& info, const CodecOptionValues& running,
+                                          const CodecOptionValues& next)
+{
+  auto valueOf = [](const CodecOptionValues& values, const CodecOptionDef& option) {
+    auto it = values.find(option.key);
+    return it != values.end() ? it->second : option.defaultValue;
+  };
+
+  std::vector<std::string> changed;
+  for (const auto& option : info.options)
+  {
+    if (valueOf(running, option) != valueOf(next, option))
+      changed.emplace_back(option.key);
+  }
+  return changed;
+}
+
+std::string PipelineConfigDiff::Describe() const
+{
+  switch (change)
+  {
+    case ConfigChange::None:
+      return "no-op";
+    case ConfigChange::InPlace:
+      return "in-place (" + JoinFields(inPlaceFields) + ")";
+    case ConfigChange::Respawn:
+    {
+      std::string text = "respawn (" + JoinFields(respawnFields);
+      if (!inPlaceFields.empty())
+        text += ", " + JoinFields(inPlaceFields);
+      return text + ")";
+    }
+  }
+  return "";
+}
+
+const char* ConfigChangeName(ConfigChange change)
+{
+  switch (change)
+  {
+    case ConfigChange::None: return "none";
+    case ConfigChange::InPlace: return "in-place";
+    case ConfigChange::Respawn: return "respawn";
+  }
+  return "none";
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+//==============================================================================
+// PipelineConfigDiff.h
+// Classifies configuration changes as no-op, in-place or respawn
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "CodecRegistry.h"
+#include "FFmpegPipeManager.h"
+#include <string>
+#include <vector>
+
+//==============================================================================
+// ConfigChange - the cheapest way to get a running pipeline to a new Config
+//==============================================================================
+enum class ConfigChange
+{
+  None,      // Nothing the pipeline uses changed
+  InPlace,   // FFmpegPipeManager::Reconfigure() on the running pipeline
+  Respawn    // New ffmpeg processes (Stop + Start)
+};
+
+//==============================================================================
+// PipelineConfigDiff - result of comparing two FFmpegPipeManager::Configs.
+// Everything that ends up on an ffmpeg command line, in the pipe setup or in
+// a pipe thread's scheduling needs a respawn; settings read while running
+// (suspend-when-parked, child process priority/affinity) can change in place.
+//==============================================================================
+struct PipelineConfigDiff
+{
+  ConfigChange change = ConfigChange::None;
+  std::vector<std::string> respawnFields;   // "bitrate 128000 -> 192000", ...
+  std::vector<std::string> inPlaceFields;
+
+  // "no-op", "in-place (...)" or "respawn (...)"
+  std::string Describe() const;
+};
+
+/**
+ * Compare the Config a pipeline is running with against the one it should run with
+ * @return The changed fields and the cheapest change that applies all of them
+ */
+PipelineConfigDiff DiffPipelineConfig(const FFmpegPipeManager::Config& running,
+                                      const FFmpegPipeManager::Config& next);
+
+/**
+ * Option keys of a codec whose effective values differ (missing keys count
+ * as the option's default), for logging which options an Apply changed
+ */
+std::vector<std::string> DiffCodecOptions(const CodecInfo& info, const CodecOptionValues& running,
+                                          const CodecOptionValues& next);
+
+// "none" / "in-place" / "respawn"
+const char* ConfigChangeName(ConfigChange change);
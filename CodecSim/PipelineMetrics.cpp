@@ -0,0 +1,240 @@
+//==============================================================================
+// PipelineMetrics.cpp
+// Lock-free per-instance pipeline counters, snapshots and shared-memory export
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "PipelineMetrics.h"
+#include <chrono>
+#include <cstring>
+#include <new>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+std::atomic<int> sNextInstance{1};
+
+unsigned long CurrentProcessId()
+{
+#ifdef _WIN32
+  return static_cast<unsigned long>(GetCurrentProcessId());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+} // namespace
+
+//==============================================================================
+// Snapshots
+//==============================================================================
+
+PipelineMetricsSnapshot TakeSnapshot(const PipelineMetrics& metrics)
+{
+  auto load = [](const std::atomic<uint64_t>& value) { return value.load(std::memory_order_relaxed); };
+
+  PipelineMetricsSnapshot s;
+  s.inputQueueFrames = load(metrics.inputQueueFrames);
+  s.outputQueueFrames = load(metrics.outputQueueFrames);
+  s.decodedBufferFrames = load(metrics.decodedBufferFrames);
+  s.underruns = load(metrics.underruns);
+  s.underrunFrames = load(metrics.underrunFrames);
+  s.overruns = load(metrics.overruns);
+  s.inputBytes = load(metrics.inputBytes);
+  s.outputBytes = load(metrics.outputBytes);
+  s.starts = load(metrics.starts);
+  s.watchdogRestarts = load(metrics.watchdogRestarts);
+  s.encoderCpuUs = load(metrics.encoderCpuUs);
+  s.decoderCpuUs = load(metrics.decoderCpuUs);
+  s.encoderRssBytes = load(metrics.encoderRssBytes);
+  s.decoderRssBytes = load(metrics.decoderRssBytes);
+  s.timeToFirstAudioUs = load(metrics.timeToFirstAudioUs);
+  return s;
+}
+
+bool ReadMetricsSegment(const PipelineMetricsSegment* segment, PipelineMetricsSnapshot& snapshot)
+{
+  if (!segment || segment->magic != PipelineMetricsSegment::kMagic ||
+      segment->version != PipelineMetricsSegment::kVersion || segment->size != sizeof(PipelineMetricsSegment))
+    return false;
+
+  for (int attempt = 0; attempt < 1000; ++attempt)
+  {
+    const uint32_t before = segment->sequence.load(std::memory_order_acquire);
+    if (before & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    std::memcpy(&snapshot, &segment->snapshot, sizeof(snapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment->sequence.load(std::memory_order_relaxed) == before)
+      return true;
+  }
+  return false;
+}
+
+std::string GetMetricsSegmentName(unsigned long processId, int instance)
+{
+#ifdef _WIN32
+  return "Local\\CodecSimMetrics-" + std::to_string(processId) + "-" + std::to_string(instance);
+#else
+  return "/codecsim-metrics-" + std::to_string(processId) + "-" + std::to_string(instance);
+#endif
+}
+
+//==============================================================================
+// PipelineMetricsPublisher
+//==============================================================================
+
+PipelineMetricsPublisher::PipelineMetricsPublisher(std::shared_ptr<PipelineMetrics> metrics, int intervalMs)
+  : mMetrics(std::move(metrics)), mIntervalMs(intervalMs > 0 ? intervalMs : 250)
+{
+  mSegmentName = GetMetricsSegmentName(CurrentProcessId(), sNextInstance.fetch_add(1));
+  if (!OpenSegment())
+    mSegmentName.clear();  // UI still works without the export
+  mThread = std::thread(&PipelineMetricsPublisher::Run, this);
+}
+
+PipelineMetricsPublisher::~PipelineMetricsPublisher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStopMutex);
+    mStop = true;
+  }
+  mStopCv.notify_all();
+  if (mThread.joinable())
+    mThread.join();
+  CloseSegment();
+}
+
+void PipelineMetricsPublisher::SetStream(const std::string& codecId, int sampleRate, int channels)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mCodecId = codecId;
+  mSampleRate = sampleRate;
+  mChannels = channels;
+}
+
+bool PipelineMetricsPublisher::GetSnapshot(PipelineMetricsSnapshot& snapshot) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (!mHasSnapshot)
+    return false;
+  snapshot = mLatest;
+  return true;
+}
+
+void PipelineMetricsPublisher::Run()
+{
+  PipelineMetricsSnapshot previous = TakeSnapshot(*mMetrics);
+  auto previousTime = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> stopLock(mStopMutex);
+  while (!mStopCv.wait_for(stopLock, std::chrono::milliseconds(mIntervalMs), [this] { return mStop; }))
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(now - previousTime).count();
+    PipelineMetricsSnapshot current = TakeSnapshot(*mMetrics);
+
+    // Counters restart with each pipeline's CPU time: only positive deltas are rates
+    auto rate = [seconds](uint64_t now, uint64_t before) {
+      return (seconds > 0.0 && now >= before) ? static_cast<double>(now - before) / seconds : 0.0;
+    };
+    current.inputBytesPerSecond = rate(current.inputBytes, previous.inputBytes);
+    current.outputBytesPerSecond = rate(current.outputBytes, previous.outputBytes);
+    current.encoderCpuPercent = rate(current.encoderCpuUs, previous.encoderCpuUs) / 1e4;
+    current.decoderCpuPercent = rate(current.decoderCpuUs, previous.decoderCpuUs) / 1e4;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      current.sampleRate = mSampleRate;
+      current.channels = mChannels;
+      std::strncpy(current.codecId, mCodecId.c_str(), sizeof(current.codecId) - 1);
+      mLatest = current;
+      mHasSnapshot = true;
+    }
+    Publish(current);
+
+    previous = current;
+    previousTime = now;
+  }
+}
+
+void PipelineMetricsPublisher::Publish(const PipelineMetricsSnapshot& snapshot)
+{
+  if (!mSegment)
+    return;
+  const uint32_t sequence = mSegment->sequence.load(std::memory_order_relaxed);
+  mSegment->sequence.store(sequence + 1, std::memory_order_relaxed);  // Odd: write in progress
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&mSegment->snapshot, &snapshot, sizeof(snapshot));
+  ++mSegment->publishCount;
+  mSegment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+#ifdef _WIN32
+bool PipelineMetricsPublisher::OpenSegment()
+{
+  HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                      sizeof(PipelineMetricsSegment), mSegmentName.c_str());
+  if (!mapping)
+    return false;
+  void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(PipelineMetricsSegment));
+  if (!view)
+  {
+    CloseHandle(mapping);
+    return false;
+  }
+  mMapping = mapping;
+  mSegment = new (view) PipelineMetricsSegment{PipelineMetricsSegment::kMagic, PipelineMetricsSegment::kVersion,
+                                               sizeof(PipelineMetricsSegment), {0}, 0, {}};
+  return true;
+}
+
+void PipelineMetricsPublisher::CloseSegment()
+{
+  if (mSegment)
+    UnmapViewOfFile(mSegment);
+  if (mMapping)
+    CloseHandle(static_cast<HANDLE>(mMapping));
+  mSegment = nullptr;
+  mMapping = nullptr;
+}
+#else
+bool PipelineMetricsPublisher::OpenSegment()
+{
+  const int fd = shm_open(mSegmentName.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+  void* view = MAP_FAILED;
+  if (ftruncate(fd, sizeof(PipelineMetricsSegment)) == 0)
+    view = mmap(nullptr, sizeof(PipelineMetricsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED)
+  {
+    shm_unlink(mSegmentName.c_str());
+    return false;
+  }
+  mSegment = new (view) PipelineMetricsSegment{PipelineMetricsSegment::kMagic, PipelineMetricsSegment::kVersion,
+                                               sizeof(PipelineMetricsSegment), {0}, 0, {}};
+  return true;
+}
+
+void PipelineMetricsPublisher::CloseSegment()
+{
+  if (mSegment)
+  {
+    munmap(mSegment, sizeof(PipelineMetricsSegment));
+    shm_unlink(mSegmentName.c_str());
+  }
+  mSegment = nullptr;
+}
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+
+//==============================================================================
+// PipelineMetrics.h
+// Lock-free per-instance pipeline counters, snapshots and shared-memory export
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <condition_variable>
+
+//==============================================================================
+// PipelineMetrics - written with relaxed atomics from the audio thread, the
+// pipe threads and the init thread; never locks, never allocates. Owned by
+// the plugin instance, so counters survive pipeline restarts.
+//==============================================================================
+struct PipelineMetrics
+{
+  // Gauges (frames currently queued)
+  std::atomic<uint64_t> inputQueueFrames{0};     // Written by the host, not yet fed to the encoder
+  std::atomic<uint64_t> outputQueueFrames{0};    // Decoded, not yet read by the host
+  std::atomic<uint64_t> decodedBufferFrames{0};  // Plugin accumulation buffer
+
+  // Counters
+  std::atomic<uint64_t> underruns{0};            // Host blocks not filled completely after first audio
+  std::atomic<uint64_t> underrunFrames{0};
+  std::atomic<uint64_t> overruns{0};             // Input backlog crossed kOverrunSeconds
+  std::atomic<uint64_t> inputBytes{0};           // Into the encoder's stdin
+  std::atomic<uint64_t> outputBytes{0};          // Out of the decoder's stdout
+  std::atomic<uint64_t> starts{0};               // Pipelines started (restarts = starts - 1)
+  std::atomic<uint64_t> watchdogRestarts{0};     // Of those, restarts after a dead or stalled pipeline
+
+  // Child processes (sampled by the pipeline's input thread)
+  std::atomic<uint64_t> encoderCpuUs{0};
+  std::atomic<uint64_t> decoderCpuUs{0};
+  std::atomic<uint64_t> encoderRssBytes{0};
+  std::atomic<uint64_t> decoderRssBytes{0};
+
+  // Latest start: microseconds from Start() to the first decoded sample (0 = not yet)
+  std::atomic<uint64_t> timeToFirstAudioUs{0};
+
+  static constexpr double kOverrunSeconds = 1.0;
+
+  static void Add(std::atomic<uint64_t>& counter, uint64_t value) { counter.fetch_add(value, std::memory_order_relaxed); }
+  static void Set(std::atomic<uint64_t>& gauge, uint64_t value) { gauge.store(value, std::memory_order_relaxed); }
+};
+
+//==============================================================================
+// PipelineMetricsSnapshot - plain copy plus derived rates; also the payload
+// of the shared-memory segment, so only fixed-size fields
+//==============================================================================
+struct PipelineMetricsSnapshot
+{
+  uint64_t inputQueueFrames = 0;
+  uint64_t outputQueueFrames = 0;
+  uint64_t decodedBufferFrames = 0;
+  uint64_t underruns = 0;
+  uint64_t underrunFrames = 0;
+  uint64_t overruns = 0;
+  uint64_t inputBytes = 0;
+  uint64_t outputBytes = 0;
+  uint64_t starts = 0;
+  uint64_t watchdogRestarts = 0;
+  uint64_t encoderCpuUs = 0;
+  uint64_t decoderCpuUs = 0;
+  uint64_t encoderRssBytes = 0;
+  uint64_t decoderRssBytes = 0;
+  uint64_t timeToFirstAudioUs = 0;
+
+  double inputBytesPerSecond = 0.0;   // Over the last publish interval
+  double outputBytesPerSecond = 0.0;
+  double encoderCpuPercent = 0.0;     // Of one core
+  double decoderCpuPercent = 0.0;
+
+  int32_t sampleRate = 0;
+  int32_t channels = 0;
+  char codecId[32] = {};
+};
+
+//==============================================================================
+// Shared-memory layout: header + snapshot, guarded by a sequence lock (odd
+// while the publisher writes; readers retry until they see the same even
+// value before and after copying). Segment names:
+//   Windows: Local\CodecSimMetrics-<pid>-<instance>
+//   POSIX:   /codecsim-metrics-<pid>-<instance>  (/dev/shm on Linux)
+//==============================================================================
+struct PipelineMetricsSegment
+{
+  static constexpr uint32_t kMagic = 0x58534D43;  // "CMSX"
+  static constexpr uint32_t kVersion = 2;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;                      // sizeof(PipelineMetricsSegment)
+  std::atomic<uint32_t> sequence;
+  uint64_t publishCount;
+  PipelineMetricsSnapshot snapshot;
+};
+
+/**
+ * Copy the live counters into a snapshot (rates are left at zero)
+ */
+PipelineMetricsSnapshot TakeSnapshot(const PipelineMetrics& metrics);
+
+/**
+ * Read a snapshot from a mapped segment (external tools)
+ * @return false if the segment is not a compatible CodecSim metrics segment
+ *         or the writer kept it busy for too long
+ */
+bool ReadMetricsSegment(const PipelineMetricsSegment* segment, PipelineMetricsSnapshot& snapshot);
+
+/**
+ * Segment name for a plugin instance (see PipelineMetricsSegment)
+ * @param processId Host process id
+ * @param instance Per-process instance number, from 1 in creation order
+ */
+std::string GetMetricsSegmentName(unsigned long processId, int instance);
+
+//==============================================================================
+// PipelineMetricsPublisher - background thread that snapshots the counters
+// every interval, derives rates and publishes to the UI and shared memory.
+//==============================================================================
+class PipelineMetricsPublisher
+{
+public:
+  explicit PipelineMetricsPublisher(std::shared_ptr<PipelineMetrics> metrics, int intervalMs = 250);
+  ~PipelineMetricsPublisher();
+
+  PipelineMetricsPublisher(const PipelineMetricsPublisher&) = delete;
+  PipelineMetricsPublisher& operator=(const PipelineMetricsPublisher&) = delete;
+
+  // Labels the next snapshots (any thread)
+  void SetStream(const std::string& codecId, int sampleRate, int channels);
+
+  /**
+   * Latest published snapshot (UI thread)
+   * @return false before the first publish
+   */
+  bool GetSnapshot(PipelineMetricsSnapshot& snapshot) const;
+
+  // Shared-memory segment name, empty if it could not be created
+  const std::string& GetSegmentName() const { return mSegmentName; }
+
+private:
+  void Run();
+  void Publish(const PipelineMetricsSnapshot& snapshot);
+  bool OpenSegment();
+  void CloseSegment();
+
+  std::shared_ptr<PipelineMetrics> mMetrics;
+  const int mIntervalMs;
+
+  mutable std::mutex mMutex;          // mLatest, mHasSnapshot and the stream labels
+  PipelineMetricsSnapshot mLatest;
+  bool mHasSnapshot = false;
+  std::string mCodecId;
+  int mSampleRate = 0;
+  int mChannels = 0;
+
+  std::string mSegmentName;
+  PipelineMetricsSegment* mSegment = nullptr;
+  void* mMapping = nullptr;           // Windows file-mapping handle
+
+  std::mutex mStopMutex;
+  std::condition_variable mStopCv;
+  bool mStop = false;
+  std::thread mThread;
+};
@@ -0,0 +1,149 @@
+//==============================================================================
+// PipelineWatchdog.cpp
+// Dead/stalled pipeline detection with restart backoff
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "PipelineWatchdog.h"
+#include <algorithm>
+#include <cstdio>
+
+bool PipelineWatchdog::Update(const FFmpegPipeManager::Progress& progress, uint64_t nowMs)
+{
+  if (!mConfig.enabled)
+  {
+    mHealth = Health::Idle;
+    return false;
+  }
+
+  // A failed restart leaves nothing started; keep retrying on the backoff schedule
+  if (!mRestartFailed)
+  {
+    if (!progress.started || progress.finishing)
+    {
+      mHealth = Health::Idle;
+      ClearProgressTracking();
+      return false;
+    }
+
+    if (progress.failed)
+    {
+      if (mHealth != Health::Dead)
+        mReason = "pipeline process exited";
+      mHealth = Health::Dead;
+    }
+    else if (progress.parked || !progress.countersValid)
+    {
+      // Nothing is fed while parked; shared streams only report failures
+      mHealth = progress.parked ? Health::Idle : Health::Healthy;
+      mWaiting = false;
+    }
+    else
+    {
+      const uint64_t windowMs = static_cast<uint64_t>(mHasOutput ? mConfig.stallWindowMs : mConfig.startupGraceMs);
+
+      if (progress.outputFrames != mLastOutputFrames)
+      {
+        mLastOutputFrames = progress.outputFrames;
+        mInputAtLastOutput = progress.inputFrames;
+        mHasOutput = true;
+        mWaiting = false;
+      }
+      else if (progress.inputFrames != mLastInputFrames && !mWaiting)
+      {
+        mWaiting = true;
+        mWaitingSinceMs = nowMs;
+      }
+      mLastInputFrames = progress.inputFrames;
+
+      const uint64_t minInputFrames = static_cast<uint64_t>(progress.sampleRate) * windowMs / 2000;
+      const uint64_t fedFrames = progress.inputFrames - mInputAtLastOutput;
+
+      if (progress.inputBlockedMs >= windowMs)
+      {
+        // The encoder stopped reading: less than the half window may have got
+        // in (the pipe buffer), so the output test below would never fire
+        if (mHealth != Health::Stalled)
+        {
+          char reason[128];
+          std::snprintf(reason, sizeof(reason), "encoder has not accepted input for %.1f s",
+                        progress.inputBlockedMs / 1000.0);
+          mReason = reason;
+        }
+        mHealth = Health::Stalled;
+      }
+      else if (mWaiting && nowMs - mWaitingSinceMs >= windowMs && fedFrames >= minInputFrames)
+      {
+        if (mHealth != Health::Stalled)
+        {
+          char reason[128];
+          std::snprintf(reason, sizeof(reason), "no decoded audio for %.1f s after %.1f s of input",
+                        (nowMs - mWaitingSinceMs) / 1000.0,
+                        progress.sampleRate > 0 ? static_cast<double>(fedFrames) / progress.sampleRate : 0.0);
+          mReason = reason;
+        }
+        mHealth = Health::Stalled;
+      }
+      else
+      {
+        mHealth = Health::Healthy;
+      }
+    }
+
+    if (mHealth == Health::Healthy || mHealth == Health::Idle)
+    {
+      mRestartScheduled = false;
+      // Recovered for long enough: the next failure starts from the initial backoff again
+      if (mConsecutiveRestarts > 0 && mHasOutput && nowMs - mLastRestartMs >= static_cast<uint64_t>(mConfig.stableAfterMs))
+        mConsecutiveRestarts = 0;
+      return false;
+    }
+  }
+
+  if (!mRestartScheduled)
+  {
+    mRestartScheduled = true;
+    mRestartDueMs = nowMs + static_cast<uint64_t>(GetBackoffMs());
+  }
+  return nowMs >= mRestartDueMs;
+}
+
+void PipelineWatchdog::OnRestarted(bool success, uint64_t nowMs)
+{
+  ++mConsecutiveRestarts;
+  mLastRestartMs = nowMs;
+  mRestartScheduled = false;
+  mRestartFailed = !success;
+  if (!success)
+    mReason = "restart failed";
+  mHealth = success ? Health::Healthy : Health::Dead;
+  ClearProgressTracking();
+}
+
+void PipelineWatchdog::Reset()
+{
+  mHealth = Health::Idle;
+  mReason.clear();
+  mConsecutiveRestarts = 0;
+  mRestartScheduled = false;
+  mRestartFailed = false;
+  ClearProgressTracking();
+}
+
+int PipelineWatchdog::GetBackoffMs() const
+{
+  // initial * 2^restarts, capped (shift bounded so it cannot overflow)
+  const int shift = std::min(mConsecutiveRestarts, 16);
+  const int64_t backoff = static_cast<int64_t>(mConfig.initialBackoffMs) << shift;
+  return static_cast<int>(std::min<int64_t>(backoff, mConfig.maxBackoffMs));
+}
+
+void PipelineWatchdog::ClearProgressTracking()
+{
+  // Counters restart from zero with every Start()
+  mLastInputFrames = 0;
+  mLastOutputFrames = 0;
+  mInputAtLastOutput = 0;
+  mWaiting = false;
+  mHasOutput = false;
+}
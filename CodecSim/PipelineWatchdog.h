@@ -0,0 +1,86 @@
+#pragma once
+
+//==============================================================================
+// PipelineWatchdog.h
+// Dead/stalled pipeline detection with restart backoff
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "FFmpegPipeManager.h"
+#include <cstdint>
+#include <string>
+
+struct WatchdogConfig
+{
+  bool enabled = false;          // Off unless the owner opts in (batch renders must not restart mid-file)
+  int stallWindowMs = 3000;      // Input fed but no decoded output for this long = stalled
+  int startupGraceMs = 8000;     // Same, before the first decoded audio of a (re)start
+  int initialBackoffMs = 250;    // Wait before the first restart; doubles per consecutive restart
+  int maxBackoffMs = 30000;
+  int stableAfterMs = 10000;     // Decoding this long after a restart resets the backoff
+};
+
+//==============================================================================
+// PipelineWatchdog - pure state machine over FFmpegPipeManager::Progress; the
+// owner polls it (every ~100 ms) and performs the restart it asks for.
+//
+//   Dead:    a child exited or a pipe broke (Progress::failed)
+//   Stalled: at least half a window of audio went into the encoder while no
+//            decoded frame came out for a whole window, or a write to the
+//            encoder made no progress for a whole window
+//
+// Parked and finishing pipelines are never judged stalled.
+//==============================================================================
+class PipelineWatchdog
+{
+public:
+  enum class Health
+  {
+    Idle,      // Disabled, not started, parked or finishing
+    Healthy,
+    Dead,
+    Stalled
+  };
+
+  explicit PipelineWatchdog(const WatchdogConfig& config = WatchdogConfig()) : mConfig(config) {}
+
+  /**
+   * Feed the latest counters.
+   * @return true when the pipeline is dead or stalled and its backoff has elapsed:
+   *         the caller restarts it and reports the result with OnRestarted()
+   */
+  bool Update(const FFmpegPipeManager::Progress& progress, uint64_t nowMs);
+
+  // Result of the restart Update() asked for; a failed start is retried after the next backoff
+  void OnRestarted(bool success, uint64_t nowMs);
+
+  // A new pipeline was started by the owner (not the watchdog): clear history and backoff
+  void Reset();
+
+  Health GetHealth() const { return mHealth; }
+  const std::string& GetReason() const { return mReason; }     // Why the last restart was requested
+  int GetConsecutiveRestarts() const { return mConsecutiveRestarts; }
+  int GetBackoffMs() const;                                     // Delay before the next restart
+
+private:
+  void ClearProgressTracking();
+
+  WatchdogConfig mConfig;
+  Health mHealth = Health::Idle;
+  std::string mReason;
+
+  // Progress since the current pipeline started
+  uint64_t mLastInputFrames = 0;
+  uint64_t mLastOutputFrames = 0;
+  uint64_t mInputAtLastOutput = 0;
+  uint64_t mWaitingSinceMs = 0;     // Input advanced with no output since (if mWaiting)
+  bool mWaiting = false;
+  bool mHasOutput = false;
+
+  // Restart bookkeeping
+  int mConsecutiveRestarts = 0;
+  uint64_t mLastRestartMs = 0;
+  uint64_t mRestartDueMs = 0;       // If mRestartScheduled
+  bool mRestartScheduled = false;
+  bool mRestartFailed = false;      // Last restart could not start the pipeline
+};
@@ -0,0 +1,723 @@
+//==============================================================================
+// QualityMetrics.cpp
+// Streaming objective quality metrics: original vs decoded
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "QualityMetrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CODECSIM_METRICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSilenceMeanSquare = 1e-6;   // -60 dBFS: segments/frames below are not scored
+constexpr double kSpectralFloor = 1e-12;      // -120 dB per bin, keeps LSD finite on empty bins
+constexpr double kSegSnrMin = -10.0;
+constexpr double kSegSnrMax = 35.0;
+
+double LevelDb(double meanSquare)
+{
+  if (meanSquare <= 0.0)
+    return -kQualityMaxDb;
+  return std::max(10.0 * std::log10(meanSquare), -kQualityMaxDb);
+}
+
+double RatioDb(double signal, double noise)
+{
+  if (noise <= 0.0)
+    return signal > 0.0 ? kQualityMaxDb : 0.0;
+  if (signal <= 0.0)
+    return -kQualityMaxDb;
+  return std::clamp(10.0 * std::log10(signal / noise), -kQualityMaxDb, kQualityMaxDb);
+}
+
+//==============================================================================
+// Kernels (SSE2 where available; products in float, sums in double)
+//==============================================================================
+
+// signal += sum(ref^2), noise += sum((ref - dec)^2) over n samples
+void SumSquares(const float* ref, const float* dec, size_t n, double& signal, double& noise)
+{
+  size_t i = 0;
+  double s = 0.0, e = 0.0;
+#if CODECSIM_METRICS_SSE2
+  __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+  __m128d e0 = _mm_setzero_pd(), e1 = _mm_setzero_pd();
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 r = _mm_loadu_ps(ref + i);
+    const __m128 d = _mm_sub_ps(r, _mm_loadu_ps(dec + i));
+    const __m128 r2 = _mm_mul_ps(r, r);
+    const __m128 d2 = _mm_mul_ps(d, d);
+    s0 = _mm_add_pd(s0, _mm_cvtps_pd(r2));
+    s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(r2, r2)));
+    e0 = _mm_add_pd(e0, _mm_cvtps_pd(d2));
+    e1 = _mm_add_pd(e1, _mm_cvtps_pd(_mm_movehl_ps(d2, d2)));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(s0, s1));
+  s = lanes[0] + lanes[1];
+  _mm_storeu_pd(lanes, _mm_add_pd(e0, e1));
+  e = lanes[0] + lanes[1];
+#endif
+  for (; i < n; ++i)
+  {
+    const float d = ref[i] - dec[i];
+    s += static_cast<double>(ref[i]) * ref[i];
+    e += static_cast<double>(d) * d;
+  }
+  signal += s;
+  noise += e;
+}
+
+// Windowed pair packed as one complex signal: out = (ref*w) + i(dec*w)
+void PackWindowed(const float* ref, const float* dec, const float* window, float* out, int n)
+{
+  int i = 0;
+#if CODECSIM_METRICS_SSE2
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m128 w = _mm_loadu_ps(window + i);
+    const __m128 r = _mm_mul_ps(_mm_loadu_ps(ref + i), w);
+    const __m128 d = _mm_mul_ps(_mm_loadu_ps(dec + i), w);
+    _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(r, d));
+    _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(r, d));
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    out[2 * i] = ref[i] * window[i];
+    out[2 * i + 1] = dec[i] * window[i];
+  }
+}
+
+} // namespace
+
+//==============================================================================
+// LoudnessMeter - ITU-R BS.1770 integrated loudness. Gated 400 ms blocks
+// (100 ms hop) go into a 0.1 LU histogram, so the two-pass gating needs no
+// block list and memory stays constant.
+//==============================================================================
+class QualityMetrics::LoudnessMeter
+{
+public:
+  LoudnessMeter(int sampleRate, int channels)
+    : mChannels(channels)
+    , mSubBlockFrames(std::max(1, sampleRate / 10))
+    , mState(static_cast<size_t>(channels) * 4, 0.0)
+    , mCounts(kHistogramBins, 0)
+    , mEnergies(kHistogramBins, 0.0)
+  {
+    // K-weighting at any rate (pre-filter shelf + RLB high-pass), as in libebur128
+    const double fs = sampleRate;
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = std::tan(kPi * f0 / fs);
+    const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    mShelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+              2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(kPi * f0 / fs);
+    a0 = 1.0 + k / q + k * k;
+    mHighPass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+  }
+
+  void Reset()
+  {
+    std::fill(mState.begin(), mState.end(), 0.0);
+    std::fill(mCounts.begin(), mCounts.end(), 0);
+    std::fill(mEnergies.begin(), mEnergies.end(), 0.0);
+    mSubBlockEnergy = 0.0;
+    mSubBlockFill = 0;
+    mRecentCount = 0;
+  }
+
+  void Process(const float* data, size_t frames)
+  {
+    for (size_t f = 0; f < frames; ++f)
+    {
+      for (int c = 0; c < mChannels; ++c)
+      {
+        double* z = &mState[static_cast<size_t>(c) * 4];
+        const double x = data[f * mChannels + c];
+        const double y1 = mShelf.b0 * x + z[0];
+        z[0] = mShelf.b1 * x - mShelf.a1 * y1 + z[1];
+        z[1] = mShelf.b2 * x - mShelf.a2 * y1;
+        const double y2 = mHighPass.b0 * y1 + z[2];
+        z[2] = mHighPass.b1 * y1 - mHighPass.a1 * y2 + z[3];
+        z[3] = mHighPass.b2 * y1 - mHighPass.a2 * y2;
+        mSubBlockEnergy += y2 * y2;
+      }
+      if (++mSubBlockFill == mSubBlockFrames)
+        CompleteSubBlock();
+    }
+  }
+
+  double GetIntegratedLufs() const
+  {
+    int64_t count = 0;
+    double energy = 0.0;
+    for (int b = 0; b < kHistogramBins; ++b)
+    {
+      count += mCounts[b];
+      energy += mEnergies[b];
+    }
+    if (count == 0)
+      return kLoudnessFloorLufs;
+
+    const double relativeGate = -0.691 + 10.0 * std::log10(energy / count) - 10.0;
+    count = 0;
+    energy = 0.0;
+    for (int b = 0; b < kHistogramBins; ++b)
+    {
+      if (BinLoudness(b) >= relativeGate)
+      {
+        count += mCounts[b];
+        energy += mEnergies[b];
+      }
+    }
+    if (count == 0)
+      return kLoudnessFloorLufs;
+    return std::max(-0.691 + 10.0 * std::log10(energy / count), kLoudnessFloorLufs);
+  }
+
+private:
+  struct Biquad
+  {
+    double b0, b1, b2, a1, a2;
+  };
+
+  static constexpr int kHistogramBins = 800;   // kLoudnessFloorLufs .. +10 LUFS in 0.1 LU steps
+  static double BinLoudness(int bin) { return kLoudnessFloorLufs + (bin + 0.5) * 0.1; }
+
+  void CompleteSubBlock()
+  {
+    mRecent[mRecentCount % 4] = mSubBlockEnergy / mSubBlockFrames;
+    ++mRecentCount;
+    mSubBlockEnergy = 0.0;
+    mSubBlockFill = 0;
+    if (mRecentCount < 4)
+      return;
+
+    const double block = 0.25 * (mRecent[0] + mRecent[1] + mRecent[2] + mRecent[3]);
+    if (block <= 0.0)
+      return;
+    const double loudness = -0.691 + 10.0 * std::log10(block);
+    if (loudness <= kLoudnessFloorLufs)
+      return;  // Absolute gate
+    const int bin = std::min(kHistogramBins - 1, static_cast<int>((loudness - kLoudnessFloorLufs) * 10.0));
+    ++mCounts[bin];
+    mEnergies[bin] += block;
+  }
+
+  int mChannels;
+  int mSubBlockFrames;
+  Biquad mShelf{};
+  Biquad mHighPass{};
+  std::vector<double> mState;       // Per channel: shelf z1, z2, high-pass z1, z2
+  double mSubBlockEnergy = 0.0;
+  int mSubBlockFill = 0;
+  double mRecent[4] = {};
+  int64_t mRecentCount = 0;
+  std::vector<int64_t> mCounts;
+  std::vector<double> mEnergies;
+};
+
+//==============================================================================
+// QualityMetrics
+//==============================================================================
+
+QualityMetrics::QualityMetrics() = default;
+QualityMetrics::~QualityMetrics() = default;
+
+bool QualityMetrics::Configure(int sampleRate, int channels, int fftSize)
+{
+  std::shared_ptr<const FFTPlan> plan = FFTPlanCache::Instance().Get(fftSize);
+  if (sampleRate <= 0 || channels <= 0 || !plan)
+    return false;
+
+  mSampleRate = sampleRate;
+  mChannels = channels;
+  mFFTSize = fftSize;
+  mHop = fftSize / 2;
+  mPlan = std::move(plan);
+
+  mRefHistory.assign(static_cast<size_t>(channels) * fftSize, 0.f);
+  mDecHistory.assign(static_cast<size_t>(channels) * fftSize, 0.f);
+  mSpectrum.assign(fftSize, std::complex<float>());
+  mBinSignal.assign(fftSize / 2 + 1, 0.0);
+  mBinNoise.assign(fftSize / 2 + 1, 0.0);
+  mRefLoudness = std::make_unique<LoudnessMeter>(sampleRate, channels);
+  mDecLoudness = std::make_unique<LoudnessMeter>(sampleRate, channels);
+
+  Reset();
+  return true;
+}
+
+void QualityMetrics::Reset()
+{
+  mFill = 0;
+  mFrames = 0;
+  mSignalEnergy = mNoiseEnergy = 0.0;
+  mSegmentFill = 0;
+  mSegmentSignal = mSegmentNoise = 0.0;
+  mSegSnrSum = 0.0;
+  mSegments = 0;
+  mLsdSum = 0.0;
+  mLsdFrames = 0;
+  std::fill(mBinSignal.begin(), mBinSignal.end(), 0.0);
+  std::fill(mBinNoise.begin(), mBinNoise.end(), 0.0);
+  mSpectralFrames = 0;
+  if (mRefLoudness)
+  {
+    mRefLoudness->Reset();
+    mDecLoudness->Reset();
+  }
+}
+
+void QualityMetrics::Process(const float* reference, const float* decoded, size_t numFrames)
+{
+  if (!mPlan)
+    return;
+
+  size_t pos = 0;
+  while (pos < numFrames)
+  {
+    // Stop at whichever comes first: a full FFT frame or a segment boundary
+    const size_t n = std::min({numFrames - pos, static_cast<size_t>(mFFTSize - mFill),
+                               static_cast<size_t>(mHop - mSegmentFill)});
+    const float* ref = reference + pos * mChannels;
+    const float* dec = decoded + pos * mChannels;
+
+    for (int c = 0; c < mChannels; ++c)
+    {
+      float* refHistory = &mRefHistory[static_cast<size_t>(c) * mFFTSize + mFill];
+      float* decHistory = &mDecHistory[static_cast<size_t>(c) * mFFTSize + mFill];
+      for (size_t f = 0; f < n; ++f)
+      {
+        refHistory[f] = ref[f * mChannels + c];
+        decHistory[f] = dec[f * mChannels + c];
+      }
+    }
+
+    double signal = 0.0, noise = 0.0;
+    SumSquares(ref, dec, n * mChannels, signal, noise);
+    mSignalEnergy += signal;
+    mNoiseEnergy += noise;
+    mSegmentSignal += signal;
+    mSegmentNoise += noise;
+
+    mRefLoudness->Process(ref, n);
+    mDecLoudness->Process(dec, n);
+
+    pos += n;
+    mFrames += static_cast<int64_t>(n);
+    mFill += static_cast<int>(n);
+    mSegmentFill += static_cast<int>(n);
+
+    if (mSegmentFill == mHop)
+      EndSegment();
+    if (mFill == mFFTSize)
+    {
+      AnalyzeFrame();
+      for (int c = 0; c < mChannels; ++c)
+      {
+        float* refHistory = &mRefHistory[static_cast<size_t>(c) * mFFTSize];
+        float* decHistory = &mDecHistory[static_cast<size_t>(c) * mFFTSize];
+        std::memmove(refHistory, refHistory + mHop, sizeof(float) * (mFFTSize - mHop));
+        std::memmove(decHistory, decHistory + mHop, sizeof(float) * (mFFTSize - mHop));
+      }
+      mFill = mFFTSize - mHop;
+    }
+  }
+}
+
+void QualityMetrics::EndSegment()
+{
+  if (mSegmentSignal / (static_cast<double>(mHop) * mChannels) > kSilenceMeanSquare)
+  {
+    mSegSnrSum += std::clamp(RatioDb(mSegmentSignal, mSegmentNoise), kSegSnrMin, kSegSnrMax);
+    ++mSegments;
+  }
+  mSegmentFill = 0;
+  mSegmentSignal = mSegmentNoise = 0.0;
+}
+
+void QualityMetrics::AnalyzeFrame()
+{
+  // One complex FFT per channel yields both spectra: Z = R + iD, so
+  // R[k] = (Z[k] + conj(Z[N-k])) / 2 and D[k] = (Z[k] - conj(Z[N-k])) / 2i
+  const int bins = mFFTSize / 2 + 1;
+  const int mask = mFFTSize - 1;
+  const double scale = 2.0 / (static_cast<double>(mFFTSize) * mPlan->GetWindowEnergy());
+  float* spectrum = reinterpret_cast<float*>(mSpectrum.data());
+
+  for (int c = 0; c < mChannels; ++c)
+  {
+    const float* ref = &mRefHistory[static_cast<size_t>(c) * mFFTSize];
+    const float* dec = &mDecHistory[static_cast<size_t>(c) * mFFTSize];
+
+    double frameSignal = 0.0, frameNoise = 0.0;
+    SumSquares(ref, dec, mFFTSize, frameSignal, frameNoise);
+
+    PackWindowed(ref, dec, mPlan->GetWindow(), spectrum, mFFTSize);
+    mPlan->Forward(mSpectrum.data());
+
+    double lsd = 0.0;
+    for (int k = 0; k < bins; ++k)
+    {
+      const float* z = spectrum + 2 * k;
+      const float* zm = spectrum + 2 * ((mFFTSize - k) & mask);
+      const float rr = 0.5f * (z[0] + zm[0]);
+      const float ri = 0.5f * (z[1] - zm[1]);
+      const float dr = 0.5f * (z[1] + zm[1]);
+      const float di = -0.5f * (z[0] - zm[0]);
+      const double pr = (static_cast<double>(rr) * rr + static_cast<double>(ri) * ri) * scale;
+      const double pd = (static_cast<double>(dr) * dr + static_cast<double>(di) * di) * scale;
+      const double nr = rr - dr, ni = ri - di;
+      mBinSignal[k] += pr;
+      mBinNoise[k] += (nr * nr + ni * ni) * scale;
+      const double diff = 10.0 * std::log10((pr + kSpectralFloor) / (pd + kSpectralFloor));
+      lsd += diff * diff;
+    }
+    ++mSpectralFrames;
+
+    if (frameSignal / mFFTSize > kSilenceMeanSquare)
+    {
+      mLsdSum += std::sqrt(lsd / bins);
+      ++mLsdFrames;
+    }
+  }
+}
+
+QualityReport QualityMetrics::GetReport() const
+{
+  QualityReport report;
+  report.frames = mFrames;
+  report.snrDb = RatioDb(mSignalEnergy, mNoiseEnergy);
+  report.segmentalSnrDb = mSegments > 0 ? mSegSnrSum / mSegments : 0.0;
+  report.lsdDb = mLsdFrames > 0 ? mLsdSum / mLsdFrames : 0.0;
+  if (mRefLoudness)
+  {
+    report.referenceLufs = mRefLoudness->GetIntegratedLufs();
+    report.decodedLufs = mDecLoudness->GetIntegratedLufs();
+    report.lufsDelta = report.decodedLufs - report.referenceLufs;
+  }
+
+  if (mSpectralFrames > 0)
+  {
+    // Octave bands centred on 1 kHz * 2^n
+    const double nyquist = 0.5 * mSampleRate;
+    const double binHz = static_cast<double>(mSampleRate) / mFFTSize;
+    for (int octave = -5; octave <= 4; ++octave)
+    {
+      QualityBand band;
+      const double centre = 1000.0 * std::pow(2.0, octave);
+      band.lowHz = centre / std::sqrt(2.0);
+      band.highHz = std::min(centre * std::sqrt(2.0), nyquist);
+      if (band.lowHz >= nyquist)
+        break;
+
+      double signal = 0.0, noise = 0.0;
+      const int first = static_cast<int>(std::ceil(band.lowHz / binHz));
+      const int last = std::min(static_cast<int>(mBinSignal.size()) - 1, static_cast<int>(std::ceil(band.highHz / binHz)) - 1);
+      for (int k = first; k <= last; ++k)
+      {
+        signal += mBinSignal[k];
+        noise += mBinNoise[k];
+      }
+      band.signalDb = LevelDb(signal / mSpectralFrames);
+      band.noiseDb = LevelDb(noise / mSpectralFrames);
+      band.snrDb = RatioDb(signal, noise);
+      report.bands.push_back(band);
+    }
+  }
+  return report;
+}
+
+//==============================================================================
+// QualityAnalyzer::BlockRing
+//==============================================================================
+class QualityAnalyzer::BlockRing
+{
+public:
+  static constexpr uint32_t kSlots = 128;
+  static constexpr int kSlotFrames = 1024;
+  static constexpr int kMaxChannels = 2;
+
+  BlockRing()
+    : mData(static_cast<size_t>(kSlots) * kSlotFrames * kMaxChannels)
+    , mSlots(kSlots)
+  {}
+
+  // Not concurrent with Push/Peek
+  void Reset(int channels)
+  {
+    mChannels = std::clamp(channels, 1, kMaxChannels);
+    mHead.store(0);
+    mTail.store(0);
+    mPosition = 0;
+    mOpenFrames = 0;
+    mDropped.store(0);
+  }
+
+  // Producer: frames collect in the open slot, which is published once full
+  // (small host blocks would otherwise burn one slot each)
+  void Push(const float* data, int numFrames)
+  {
+    while (numFrames > 0)
+    {
+      const uint32_t head = mHead.load(std::memory_order_relaxed);
+      if (mOpenFrames == 0)
+      {
+        if (head - mTail.load(std::memory_order_acquire) >= kSlots)
+        {
+          mDropped.fetch_add(numFrames, std::memory_order_relaxed);
+          mPosition += numFrames;
+          return;
+        }
+        mSlots[head % kSlots].position = mPosition;
+      }
+
+      const int frames = std::min(numFrames, kSlotFrames - mOpenFrames);
+      std::memcpy(SlotData(head) + static_cast<size_t>(mOpenFrames) * mChannels, data,
+                  sizeof(float) * frames * mChannels);
+      mOpenFrames += frames;
+      mPosition += frames;
+      data += static_cast<size_t>(frames) * mChannels;
+      numFrames -= frames;
+
+      if (mOpenFrames == kSlotFrames)
+      {
+        mSlots[head % kSlots].frames = kSlotFrames;
+        mOpenFrames = 0;
+        mHead.store(head + 1, std::memory_order_release);
+      }
+    }
+  }
+
+  // Consumer
+  bool Peek(int64_t& position, int& frames, const float*& data)
+  {
+    const uint32_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail == mHead.load(std::memory_order_acquire))
+      return false;
+    const Slot& slot = mSlots[tail % kSlots];
+    position = slot.position;
+    frames = slot.frames;
+    data = SlotData(tail);
+    return true;
+  }
+
+  void Pop() { mTail.store(mTail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  int64_t GetDropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot
+  {
+    int64_t position = 0;           // Stream frame index of the slot's first frame
+    int frames = 0;
+  };
+
+  float* SlotData(uint32_t index) { return &mData[static_cast<size_t>(index % kSlots) * kSlotFrames * kMaxChannels]; }
+
+  std::vector<float> mData;
+  std::vector<Slot> mSlots;
+  int mChannels = 1;
+  std::atomic<uint32_t> mHead{0};
+  std::atomic<uint32_t> mTail{0};
+  int64_t mPosition = 0;            // Producer only
+  int mOpenFrames = 0;              // Producer only: frames in the unpublished slot at mHead
+  std::atomic<int64_t> mDropped{0};
+};
+
+//==============================================================================
+// QualityAnalyzer
+//==============================================================================
+
+namespace
+{
+constexpr int kAnalyzerWakeMs = 50;
+constexpr int kAnalyzerPublishMs = 250;
+constexpr size_t kMaxRefWindowFrames = 1 << 20;  // ~20 s at 48 kHz: longer than any codec delay
+}
+
+QualityAnalyzer::QualityAnalyzer()
+  : mReferenceRing(std::make_unique<BlockRing>())
+  , mDecodedRing(std::make_unique<BlockRing>())
+{
+}
+
+QualityAnalyzer::~QualityAnalyzer()
+{
+  Stop();
+}
+
+void QualityAnalyzer::Start(int sampleRate, int channels, int latencyFrames)
+{
+  Stop();
+
+  mChannels = std::clamp(channels, 1, BlockRing::kMaxChannels);
+  mLatency = std::max(0, latencyFrames);
+  mReferenceRing->Reset(mChannels);
+  mDecodedRing->Reset(mChannels);
+  mRefWindow.clear();
+  mRefWindowStart = 0;
+  if (!mMetrics.Configure(sampleRate, mChannels))
+    return;
+
+  mStopRequested = false;
+  mThread = std::thread(&QualityAnalyzer::ThreadLoop, this);
+  mRunning.store(true);
+}
+
+void QualityAnalyzer::Stop()
+{
+  mRunning.store(false);
+  if (mThread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mThreadMutex);
+      mStopRequested = true;
+    }
+    mThreadCv.notify_all();
+    mThread.join();
+  }
+
+  std::lock_guard<std::mutex> lock(mReportMutex);
+  mHasReport = false;
+}
+
+void QualityAnalyzer::PushReference(const float* data, int numFrames)
+{
+  mReferenceRing->Push(data, numFrames);
+}
+
+void QualityAnalyzer::PushDecoded(const float* data, int numFrames)
+{
+  mDecodedRing->Push(data, numFrames);
+}
+
+bool QualityAnalyzer::GetReport(QualityReport& report) const
+{
+  std::lock_guard<std::mutex> lock(mReportMutex);
+  if (!mHasReport)
+    return false;
+  report = mReport;
+  return true;
+}
+
+void QualityAnalyzer::ThreadLoop()
+{
+  auto lastPublish = std::chrono::steady_clock::now();
+  int64_t publishedFrames = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mThreadMutex);
+      mThreadCv.wait_for(lock, std::chrono::milliseconds(kAnalyzerWakeMs), [this] { return mStopRequested; });
+      if (mStopRequested)
+        return;
+    }
+
+    // Reference first: every decoded block in the ring was produced after
+    // the input that precedes it had been pushed
+    DrainReference();
+    DrainDecoded();
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - lastPublish < std::chrono::milliseconds(kAnalyzerPublishMs))
+      continue;
+    lastPublish = now;
+
+    QualityReport report = mMetrics.GetReport();
+    if (report.frames == publishedFrames)
+      continue;
+    publishedFrames = report.frames;
+    report.droppedFrames = mReferenceRing->GetDropped() + mDecodedRing->GetDropped();
+
+    std::lock_guard<std::mutex> lock(mReportMutex);
+    mReport = std::move(report);
+    mHasReport = true;
+  }
+}
+
+void QualityAnalyzer::DrainReference()
+{
+  int64_t position;
+  int frames;
+  const float* data;
+  while (mReferenceRing->Peek(position, frames, data))
+  {
+    const int64_t windowEnd = mRefWindowStart + static_cast<int64_t>(mRefWindow.size()) / mChannels;
+    if (position != windowEnd)
+    {
+      // Blocks were dropped: restart the window at this block
+      mRefWindow.clear();
+      mRefWindowStart = position;
+    }
+    mRefWindow.insert(mRefWindow.end(), data, data + static_cast<size_t>(frames) * mChannels);
+    mReferenceRing->Pop();
+
+    const size_t windowFrames = mRefWindow.size() / mChannels;
+    if (windowFrames > kMaxRefWindowFrames)
+    {
+      const size_t excess = windowFrames - kMaxRefWindowFrames;
+      mRefWindow.erase(mRefWindow.begin(), mRefWindow.begin() + excess * mChannels);
+      mRefWindowStart += static_cast<int64_t>(excess);
+    }
+  }
+}
+
+void QualityAnalyzer::DrainDecoded()
+{
+  int64_t position;
+  int frames;
+  const float* data;
+  while (mDecodedRing->Peek(position, frames, data))
+  {
+    // Decoded frame d shows input frame d - latency; earlier frames are
+    // codec start-up delay (or their input was dropped)
+    int64_t refIndex = position - mLatency;
+    int offset = 0;
+    if (refIndex < mRefWindowStart)
+    {
+      const int64_t skip = std::min<int64_t>(frames, mRefWindowStart - refIndex);
+      offset += static_cast<int>(skip);
+      refIndex += skip;
+    }
+
+    const int64_t windowEnd = mRefWindowStart + static_cast<int64_t>(mRefWindow.size()) / mChannels;
+    const int64_t count = std::min<int64_t>(frames - offset, windowEnd - refIndex);
+    if (count > 0)
+    {
+      const auto first = mRefWindow.begin() + (refIndex - mRefWindowStart) * mChannels;
+      mRefScratch.assign(first, first + count * mChannels);
+      mMetrics.Process(mRefScratch.data(), data + static_cast<size_t>(offset) * mChannels, static_cast<size_t>(count));
+    }
+
+    // Reference up to here can never be matched again
+    const int64_t consumed = std::min(windowEnd, refIndex + std::max<int64_t>(count, 0)) - mRefWindowStart;
+    if (consumed > 0)
+    {
+      mRefWindow.erase(mRefWindow.begin(), mRefWindow.begin() + consumed * mChannels);
+      mRefWindowStart += consumed;
+    }
+    mDecodedRing->Pop();
+  }
+}
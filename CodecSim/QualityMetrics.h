@@ -0,0 +1,193 @@
+#pragma once
+
+//==============================================================================
+// QualityMetrics.h
+// Streaming objective quality metrics: original vs decoded
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "FFTPlan.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// QualityReport
+// Levels are dB relative to a full-scale (1.0) mean square. Ratios are
+// clamped to +/-kQualityMaxDb so bit-exact output reports 150 dB, not inf.
+//==============================================================================
+constexpr double kQualityMaxDb = 150.0;
+constexpr double kLoudnessFloorLufs = -70.0;  // BS.1770 absolute gate; also "silence"
+
+struct QualityBand
+{
+  double lowHz = 0.0;
+  double highHz = 0.0;
+  double signalDb = 0.0;            // Original's power in the band
+  double noiseDb = 0.0;             // Power of (original - decoded) in the band
+  double snrDb = 0.0;
+};
+
+struct QualityReport
+{
+  int64_t frames = 0;               // Aligned frames analysed
+  double snrDb = 0.0;               // Whole-stream SNR
+  double segmentalSnrDb = 0.0;      // Mean per-segment SNR over non-silent segments, each clamped to [-10, 35]
+  double lsdDb = 0.0;               // Mean log-spectral distance over non-silent frames
+  double referenceLufs = kLoudnessFloorLufs;  // BS.1770 integrated loudness
+  double decodedLufs = kLoudnessFloorLufs;
+  double lufsDelta = 0.0;           // decoded - reference (LU)
+  std::vector<QualityBand> bands;   // Octave bands up to Nyquist
+  int64_t droppedFrames = 0;        // QualityAnalyzer only: frames the analysis thread could not keep up with
+};
+
+//==============================================================================
+// QualityMetrics
+// Consumes time-aligned original/decoded blocks and keeps only running sums,
+// one FFT frame of history and a loudness histogram, so memory is constant
+// however long the stream is. Not thread-safe; one instance per stream.
+//==============================================================================
+class QualityMetrics
+{
+public:
+  static constexpr int kDefaultFFTSize = 2048;
+
+  QualityMetrics();
+  ~QualityMetrics();
+
+  /**
+   * Prepare for a stream (also resets all accumulated state)
+   * @param fftSize Analysis frame for LSD / noise spectra (power of two); segments are half of it
+   * @return false on an invalid rate, channel count or FFT size
+   */
+  bool Configure(int sampleRate, int channels, int fftSize = kDefaultFFTSize);
+
+  // Forget everything measured so far, keep the configuration
+  void Reset();
+
+  /**
+   * Add aligned frames: reference[n] and decoded[n] are the same instant
+   * @param reference Interleaved original
+   * @param decoded Interleaved decoded (same channel count)
+   */
+  void Process(const float* reference, const float* decoded, size_t numFrames);
+
+  QualityReport GetReport() const;
+
+  int GetSampleRate() const { return mSampleRate; }
+  int GetChannels() const { return mChannels; }
+
+private:
+  class LoudnessMeter;
+
+  void AnalyzeFrame();
+  void EndSegment();
+
+  int mSampleRate = 0;
+  int mChannels = 0;
+  int mFFTSize = 0;
+  int mHop = 0;
+  std::shared_ptr<const FFTPlan> mPlan;
+
+  // Last mFFTSize frames per channel (channel-major), filled up to mFill
+  std::vector<float> mRefHistory;
+  std::vector<float> mDecHistory;
+  int mFill = 0;
+  std::vector<std::complex<float>> mSpectrum;
+
+  // Whole stream
+  int64_t mFrames = 0;
+  double mSignalEnergy = 0.0;
+  double mNoiseEnergy = 0.0;
+
+  // Segmental SNR (segments of mHop frames)
+  int mSegmentFill = 0;
+  double mSegmentSignal = 0.0;
+  double mSegmentNoise = 0.0;
+  double mSegSnrSum = 0.0;
+  int64_t mSegments = 0;
+
+  // Spectral (per FFT frame and channel)
+  double mLsdSum = 0.0;
+  int64_t mLsdFrames = 0;
+  std::vector<double> mBinSignal;   // Accumulated normalized power per bin
+  std::vector<double> mBinNoise;
+  int64_t mSpectralFrames = 0;
+
+  std::unique_ptr<LoudnessMeter> mRefLoudness;
+  std::unique_ptr<LoudnessMeter> mDecLoudness;
+};
+
+//==============================================================================
+// QualityAnalyzer
+// Runs QualityMetrics on its own thread for a live pipeline. The audio
+// thread hands over the codec's input and decoded streams separately through
+// lock-free rings (no locks, no allocation); the analysis thread lines them
+// up using the codec latency and stream positions, so blocks dropped on
+// overflow cost coverage but never misalign the comparison.
+//==============================================================================
+class QualityAnalyzer
+{
+public:
+  QualityAnalyzer();
+  ~QualityAnalyzer();
+
+  // Non-copyable
+  QualityAnalyzer(const QualityAnalyzer&) = delete;
+  QualityAnalyzer& operator=(const QualityAnalyzer&) = delete;
+
+  /**
+   * Begin analysing a new pipeline (restarts stream positions and the report).
+   * Must not run concurrently with Push*; the caller serializes them.
+   * @param latencyFrames Decoded frames that precede decoded frame 0's match in the input
+   */
+  void Start(int sampleRate, int channels, int latencyFrames);
+  void Stop();
+  bool IsRunning() const { return mRunning.load(); }  // Push* is wasted work otherwise
+
+  // Audio thread (real-time safe): interleaved frames in the pipeline's layout
+  void PushReference(const float* data, int numFrames);
+  void PushDecoded(const float* data, int numFrames);
+
+  /**
+   * Latest report (refreshed a few times per second)
+   * @return false if nothing has been analysed yet
+   */
+  bool GetReport(QualityReport& report) const;
+
+private:
+  // Single-producer/single-consumer ring of fixed-size blocks tagged with
+  // their stream position
+  class BlockRing;
+
+  void ThreadLoop();
+  void DrainReference();
+  void DrainDecoded();
+
+  std::unique_ptr<BlockRing> mReferenceRing;
+  std::unique_ptr<BlockRing> mDecodedRing;
+
+  int mChannels = 0;
+  int mLatency = 0;
+  QualityMetrics mMetrics;          // Analysis thread only
+
+  // Reference frames waiting for their decoded match (analysis thread only)
+  std::deque<float> mRefWindow;
+  int64_t mRefWindowStart = 0;
+  std::vector<float> mRefScratch;
+
+  std::thread mThread;
+  std::mutex mThreadMutex;
+  std::condition_variable mThreadCv;
+  bool mStopRequested = false;
+  std::atomic<bool> mRunning{false};
+
+  mutable std::mutex mReportMutex;
+  QualityReport mReport;
+  bool mHasReport = false;
+};
@@ -0,0 +1,816 @@
+//==============================================================================
+// SharedFFmpegWorker.cpp
+// Multiplexed encoder/decoder worker implementation
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "SharedFFmpegWorker.h"
+#include "DebugLog.h"
+#include <psapi.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#define DebugLogShared(msg) CODECSIM_LOG(LogLevel::Debug, "SharedFFmpegWorker", msg)
+
+//==============================================================================
+// Worker registry
+//==============================================================================
+
+static std::mutex sRegistryMutex;
+static std::vector<std::shared_ptr<SharedFFmpegWorker>> sWorkers;
+static std::atomic<uint32_t> sNextSerial{0};
+
+// A leased slot whose owner has not written for this long counts as idle and
+// is padded like a free one (host transport stopped, instance bypassed). A slot
+// that is being fed is never padded: filler spliced into live audio would
+// shift it, and priming makes the filler boundaries inexact.
+static constexpr ULONGLONG kFeedIdleMs = 250;
+
+// Upper bound on silence added to one slot per keep-alive tick
+static int MaxPadFrames(int sampleRate) { return std::max(1, sampleRate); }
+
+static constexpr DWORD kKeepAliveIntervalMs = 5;
+static constexpr DWORD kNamedPipeBufferSize = 65536;
+
+//==============================================================================
+// SlotState
+//==============================================================================
+
+struct SharedFFmpegWorker::SlotState
+{
+  // Server ends of this slot's named pipes
+  std::string encInName, encOutName, decInName, decOutName;
+  HANDLE encIn = INVALID_HANDLE_VALUE;   // we write PCM   -> encoder input k
+  HANDLE encOut = INVALID_HANDLE_VALUE;  // we read packets <- encoder output k
+  HANDLE decIn = INVALID_HANDLE_VALUE;   // we write packets -> decoder input k
+  HANDLE decOut = INVALID_HANDLE_VALUE;  // we read PCM    <- decoder output k
+
+  std::atomic<bool> inUse{false};
+  std::atomic<bool> parked{false};
+  std::atomic<bool> firstAudio{false};
+  LogFunc log;  // Guarded by logMutex
+  std::mutex logMutex;
+
+  // Input queue (owner + keep-alive -> InputThread)
+  std::mutex inputMutex;
+  std::vector<float> inputQueue;
+  uint64_t framesQueued = 0;  // All frames ever queued, filler included
+  ULONGLONG lastFedTick = 0;  // GetTickCount64() of the owner's last write
+
+  // Input frame ranges whose decoded output is dropped (lock order: input -> discard)
+  std::mutex discardMutex;
+  uint64_t discardBefore = 0;                               // Previous owner's audio
+  std::deque<std::pair<uint64_t, uint64_t>> fillerRanges;   // [begin, end) keep-alive silence
+
+  // Encoder output -> decoder input relay
+  std::mutex relayMutex;
+  std::condition_variable relayCv;
+  std::vector<uint8_t> relayQueue;
+
+  // Decoded output for the owner
+  mutable std::mutex outputMutex;
+  std::condition_variable outputCv;
+  std::deque<float> outputQueue;
+  uint64_t framesDecoded = 0;  // OutputThread only
+
+  std::thread inputThread, relayReadThread, relayWriteThread, outputThread;
+};
+
+//==============================================================================
+// SharedFFmpegSlot
+//==============================================================================
+
+SharedFFmpegSlot::~SharedFFmpegSlot()
+{
+  mWorker->ReleaseSlot(mIndex);
+}
+
+bool SharedFFmpegSlot::WriteSamples(const float* data, size_t numSamples)
+{
+  if (!mWorker->IsAlive())
+    return false;
+
+  SharedFFmpegWorker::SlotState& slot = *mWorker->mSlots[mIndex];
+  std::lock_guard<std::mutex> lock(slot.inputMutex);
+  slot.inputQueue.insert(slot.inputQueue.end(), data, data + numSamples * mWorker->mConfig.channels);
+  slot.framesQueued += numSamples;
+  slot.lastFedTick = GetTickCount64();
+  return true;
+}
+
+size_t SharedFFmpegSlot::ReadSamples(float* data, size_t numSamples, DWORD timeout)
+{
+  SharedFFmpegWorker::SlotState& slot = *mWorker->mSlots[mIndex];
+  const size_t channels = mWorker->mConfig.channels;
+
+  std::unique_lock<std::mutex> lock(slot.outputMutex);
+  if (timeout > 0)
+  {
+    slot.outputCv.wait_for(lock, std::chrono::milliseconds(timeout), [&]() {
+      return slot.outputQueue.size() >= numSamples * channels || !mWorker->IsAlive();
+    });
+  }
+  size_t available = slot.outputQueue.size() / channels;
+  size_t frames = std::min(numSamples, available);
+  auto end = slot.outputQueue.begin() + frames * channels;
+  std::copy(slot.outputQueue.begin(), end, data);
+  slot.outputQueue.erase(slot.outputQueue.begin(), end);
+  return frames;
+}
+
+size_t SharedFFmpegSlot::AvailableOutputSamples() const
+{
+  SharedFFmpegWorker::SlotState& slot = *mWorker->mSlots[mIndex];
+  std::lock_guard<std::mutex> lock(slot.outputMutex);
+  return slot.outputQueue.size() / mWorker->mConfig.channels;
+}
+
+bool SharedFFmpegSlot::HasFirstAudioArrived() const
+{
+  return mWorker->mSlots[mIndex]->firstAudio.load(std::memory_order_relaxed);
+}
+
+void SharedFFmpegSlot::SetParked(bool parked)
+{
+  // Shared processes cannot be suspended for one slot: the keep-alive thread
+  // feeds a parked slot silence instead, and its decoded output is dropped.
+  mWorker->mSlots[mIndex]->parked.store(parked);
+}
+
+bool SharedFFmpegSlot::IsAlive() const
+{
+  return mWorker->IsAlive();
+}
+
+//==============================================================================
+// Acquire / Release
+//==============================================================================
+
+std::unique_ptr<SharedFFmpegSlot> SharedFFmpegWorker::Acquire(
+  const FFmpegPipeManager::Config& config, LogFunc log)
+{
+  const std::string key = MakeKey(config);
+  std::lock_guard<std::mutex> lock(sRegistryMutex);
+
+  for (auto& worker : sWorkers)
+  {
+    if (worker->mKey != key || !worker->IsAlive())
+      continue;
+    int index = worker->ClaimFreeSlot(log);
+    if (index >= 0)
+      return std::unique_ptr<SharedFFmpegSlot>(new SharedFFmpegSlot(worker, index));
+  }
+
+  std::shared_ptr<SharedFFmpegWorker> worker(new SharedFFmpegWorker(config, key));
+  if (!worker->Launch())
+  {
+    worker->Shutdown();
+    return nullptr;
+  }
+  sWorkers.push_back(worker);
+  int index = worker->ClaimFreeSlot(log);
+  return std::unique_ptr<SharedFFmpegSlot>(new SharedFFmpegSlot(worker, index));
+}
+
+int SharedFFmpegWorker::ClaimFreeSlot(LogFunc log)
+{
+  for (size_t i = 0; i < mSlots.size(); ++i)
+  {
+    SlotState& slot = *mSlots[i];
+    if (slot.inUse.load())
+      continue;
+
+    // Everything queued so far belongs to the previous owner or the keep-alive
+    {
+      std::lock_guard<std::mutex> inputLock(slot.inputMutex);
+      std::lock_guard<std::mutex> discardLock(slot.discardMutex);
+      slot.discardBefore = slot.framesQueued;
+    }
+    {
+      std::lock_guard<std::mutex> outputLock(slot.outputMutex);
+      slot.outputQueue.clear();
+    }
+    {
+      std::lock_guard<std::mutex> logLock(slot.logMutex);
+      slot.log = std::move(log);
+    }
+    slot.firstAudio.store(false);
+    slot.parked.store(false);
+    slot.inUse.store(true);
+    ++mSlotsInUse;
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void SharedFFmpegWorker::ReleaseSlot(int index)
+{
+  SlotState& slot = *mSlots[index];
+  {
+    std::lock_guard<std::mutex> logLock(slot.logMutex);
+    slot.log = nullptr;
+  }
+
+  std::shared_ptr<SharedFFmpegWorker> retired;
+  {
+    std::lock_guard<std::mutex> lock(sRegistryMutex);
+    slot.inUse.store(false);
+    if (--mSlotsInUse == 0)
+    {
+      // Last user gone: unpublish, then stop the processes outside the lock
+      auto it = std::find_if(sWorkers.begin(), sWorkers.end(),
+                             [this](const std::shared_ptr<SharedFFmpegWorker>& w) { return w.get() == this; });
+      if (it != sWorkers.end())
+      {
+        retired = *it;
+        sWorkers.erase(it);
+      }
+    }
+  }
+
+  if (retired)
+    retired->Shutdown();
+}
+
+SharedFFmpegWorker::Stats SharedFFmpegWorker::GetStats()
+{
+  Stats stats;
+  std::lock_guard<std::mutex> lock(sRegistryMutex);
+  for (auto& worker : sWorkers)
+  {
+    ++stats.workers;
+    stats.slotsInUse += worker->mSlotsInUse.load();
+    for (const PROCESS_INFORMATION* pi : {&worker->mEncoderProcessInfo, &worker->mDecoderProcessInfo})
+    {
+      if (!pi->hProcess || WaitForSingleObject(pi->hProcess, 0) != WAIT_TIMEOUT)
+        continue;
+      ++stats.processes;
+      PROCESS_MEMORY_COUNTERS pmc = {};
+      if (K32GetProcessMemoryInfo(pi->hProcess, &pmc, sizeof(pmc)))
+        stats.workingSetBytes += pmc.WorkingSetSize;
+    }
+  }
+  return stats;
+}
+
+//==============================================================================
+// Constructor/Destructor
+//==============================================================================
+
+SharedFFmpegWorker::SharedFFmpegWorker(const FFmpegPipeManager::Config& config, std::string key)
+  : mConfig(config)
+  , mKey(std::move(key))
+  , mSerial(sNextSerial.fetch_add(1))
+  , mJobObject(nullptr)
+  , mErrorRead(INVALID_HANDLE_VALUE)
+  , mErrorWrite(INVALID_HANDLE_VALUE)
+{
+  std::memset(&mEncoderProcessInfo, 0, sizeof(mEncoderProcessInfo));
+  std::memset(&mDecoderProcessInfo, 0, sizeof(mDecoderProcessInfo));
+
+  const int numSlots = std::max(1, mConfig.sharedSlots);
+  for (int i = 0; i < numSlots; ++i)
+    mSlots.push_back(std::make_unique<SlotState>());
+}
+
+SharedFFmpegWorker::~SharedFFmpegWorker()
+{
+  Shutdown();
+}
+
+std::string SharedFFmpegWorker::MakeKey(const FFmpegPipeManager::Config& config)
+{
+  std::ostringstream oss;
+  oss << config.ffmpegPath << '|' << config.codecName << '|' << config.sampleRate << '|'
+      << config.channels << '|' << config.bitrate << '|' << config.additionalArgs << '|'
+      << config.muxerFormat << '|' << config.demuxerFormat << '|' << config.sharedSlots;
+  return oss.str();
+}
+
+//==============================================================================
+// Launch / Shutdown
+//==============================================================================
+
+bool SharedFFmpegWorker::Launch()
+{
+  for (size_t i = 0; i < mSlots.size(); ++i)
+  {
+    if (!CreateSlotPipes(*mSlots[i], static_cast<int>(i)))
+    {
+      DebugLogShared("Failed to create named pipes for slot " + std::to_string(i) +
+                     " (error " + std::to_string(GetLastError()) + ")");
+      return false;
+    }
+  }
+
+  if (!FFmpegPipeManager::CreateChildPipe(mErrorRead, mErrorWrite, false))
+  {
+    DebugLogShared("Failed to create error pipe");
+    return false;
+  }
+
+  mJobObject = CreateJobObject(nullptr, nullptr);
+  if (mJobObject)
+  {
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jeli = {};
+    jeli.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    SetInformationJobObject(mJobObject, JobObjectExtendedLimitInformation, &jeli, sizeof(jeli));
+  }
+
+  // Pipe threads must be listening before ffmpeg opens the pipes
+  mRunning = true;
+  for (size_t i = 0; i < mSlots.size(); ++i)
+  {
+    SlotState& slot = *mSlots[i];
+    int index = static_cast<int>(i);
+    slot.inputThread = std::thread(&SharedFFmpegWorker::InputThread, this, index);
+    slot.relayReadThread = std::thread(&SharedFFmpegWorker::RelayReadThread, this, index);
+    slot.relayWriteThread = std::thread(&SharedFFmpegWorker::RelayWriteThread, this, index);
+    slot.outputThread = std::thread(&SharedFFmpegWorker::OutputThread, this, index);
+  }
+  mErrorThread = std::thread(&SharedFFmpegWorker::ErrorReadThread, this);
+
+  std::string encoderCmd = BuildEncoderCommand();
+  std::string decoderCmd = BuildDecoderCommand();
+  DebugLogShared("Encoder command: " + encoderCmd);
+  DebugLogShared("Decoder command: " + decoderCmd);
+
+  if (!LaunchProcess(encoderCmd, mEncoderProcessInfo) || !LaunchProcess(decoderCmd, mDecoderProcessInfo))
+    return false;
+
+  // The children hold their own copy of the stderr write end
+  CloseHandle(mErrorWrite);
+  mErrorWrite = INVALID_HANDLE_VALUE;
+
+  mKeepAliveThread = std::thread(&SharedFFmpegWorker::KeepAliveThread, this);
+
+  DebugLogShared("Shared worker " + std::to_string(mSerial) + " started with " +
+                 std::to_string(mSlots.size()) + " slots");
+  return true;
+}
+
+void SharedFFmpegWorker::Shutdown()
+{
+  bool wasRunning = mRunning.exchange(false);
+
+  // Killing the job (and the processes, for good measure) breaks every
+  // connected pipe, so blocked ReadFile/WriteFile calls return
+  if (mJobObject)
+  {
+    CloseHandle(mJobObject);
+    mJobObject = nullptr;
+  }
+  for (PROCESS_INFORMATION* pi : {&mEncoderProcessInfo, &mDecoderProcessInfo})
+  {
+    if (pi->hProcess)
+    {
+      ::TerminateProcess(pi->hProcess, 1);
+      WaitForSingleObject(pi->hProcess, 3000);
+    }
+  }
+  if (mErrorWrite != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(mErrorWrite);
+    mErrorWrite = INVALID_HANDLE_VALUE;
+  }
+
+  // Pipes ffmpeg never opened still have a thread parked in ConnectNamedPipe:
+  // connect and drop a dummy client to release it
+  for (auto& slotPtr : mSlots)
+  {
+    SlotState& slot = *slotPtr;
+    slot.relayCv.notify_all();
+    {
+      std::lock_guard<std::mutex> lock(slot.outputMutex);
+      slot.outputCv.notify_all();
+    }
+    const std::pair<const std::string*, DWORD> clients[] = {
+      {&slot.encInName, GENERIC_READ}, {&slot.encOutName, GENERIC_WRITE},
+      {&slot.decInName, GENERIC_READ}, {&slot.decOutName, GENERIC_WRITE}};
+    for (const auto& client : clients)
+    {
+      if (client.first->empty())
+        continue;
+      HANDLE h = CreateFileA(client.first->c_str(), client.second, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+      if (h != INVALID_HANDLE_VALUE)
+        CloseHandle(h);
+    }
+  }
+
+  for (auto& slotPtr : mSlots)
+  {
+    SlotState& slot = *slotPtr;
+    for (std::thread* t : {&slot.inputThread, &slot.relayReadThread, &slot.relayWriteThread, &slot.outputThread})
+    {
+      if (t->joinable())
+        t->join();
+    }
+    for (HANDLE* h : {&slot.encIn, &slot.encOut, &slot.decIn, &slot.decOut})
+    {
+      if (*h != INVALID_HANDLE_VALUE)
+      {
+        CloseHandle(*h);
+        *h = INVALID_HANDLE_VALUE;
+      }
+    }
+  }
+  if (mKeepAliveThread.joinable()) mKeepAliveThread.join();
+  if (mErrorThread.joinable()) mErrorThread.join();
+
+  if (mErrorRead != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(mErrorRead);
+    mErrorRead = INVALID_HANDLE_VALUE;
+  }
+  for (PROCESS_INFORMATION* pi : {&mEncoderProcessInfo, &mDecoderProcessInfo})
+  {
+    if (pi->hProcess)
+    {
+      CloseHandle(pi->hProcess);
+      CloseHandle(pi->hThread);
+      std::memset(pi, 0, sizeof(*pi));
+    }
+  }
+
+  if (wasRunning)
+    DebugLogShared("Shared worker " + std::to_string(mSerial) + " stopped");
+}
+
+bool SharedFFmpegWorker::CreateSlotPipes(SlotState& slot, int index)
+{
+  std::string base = "\\\\.\\pipe\\codecsim-" + std::to_string(GetCurrentProcessId()) + "-" +
+                     std::to_string(mSerial) + "-" + std::to_string(index);
+  slot.encInName = base + "-ei";
+  slot.encOutName = base + "-eo";
+  slot.decInName = base + "-di";
+  slot.decOutName = base + "-do";
+
+  auto create = [](const std::string& name, DWORD access) {
+    return CreateNamedPipeA(name.c_str(), access | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                            PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT,
+                            1, kNamedPipeBufferSize, kNamedPipeBufferSize, 0, nullptr);
+  };
+  slot.encIn = create(slot.encInName, PIPE_ACCESS_OUTBOUND);
+  slot.encOut = create(slot.encOutName, PIPE_ACCESS_INBOUND);
+  slot.decIn = create(slot.decInName, PIPE_ACCESS_OUTBOUND);
+  slot.decOut = create(slot.decOutName, PIPE_ACCESS_INBOUND);
+
+  return slot.encIn != INVALID_HANDLE_VALUE && slot.encOut != INVALID_HANDLE_VALUE &&
+         slot.decIn != INVALID_HANDLE_VALUE && slot.decOut != INVALID_HANDLE_VALUE;
+}
+
+bool SharedFFmpegWorker::LaunchProcess(const std::string& cmd, PROCESS_INFORMATION& pi)
+{
+  // Audio travels over the named pipes: stdin/stdout are NUL, stderr is ours
+  long error = 0;
+  if (!FFmpegPipeManager::SpawnChild(cmd, FFmpegPipeManager::InvalidPipe(), FFmpegPipeManager::InvalidPipe(),
+                                     mErrorWrite, false, pi, error))
+  {
+    DebugLogShared("Failed to create process (error: " + std::to_string(error) + ")");
+    return false;
+  }
+
+  if (mJobObject)
+    AssignProcessToJobObject(mJobObject, pi.hProcess);
+  ApplyProcessScheduling(mConfig.scheduling, pi.hProcess);
+  return true;
+}
+
+std::string SharedFFmpegWorker::BuildEncoderCommand() const
+{
+  std::ostringstream oss;
+  oss << "\"" << mConfig.ffmpegPath << "\"";
+  oss << " -hide_banner -loglevel warning -nostdin -y";
+  for (const auto& slot : mSlots)
+  {
+    oss << " -f s16le";
+    oss << " -ar " << mConfig.sampleRate;
+    oss << " -ac " << mConfig.channels;
+    oss << " -i " << slot->encInName;
+  }
+  for (size_t i = 0; i < mSlots.size(); ++i)
+  {
+    oss << " -map " << i << ":a";
+    oss << " -c:a " << mConfig.codecName;
+    oss << " -b:a " << mConfig.bitrate;
+    if (!mConfig.additionalArgs.empty())
+      oss << " " << mConfig.additionalArgs;
+    oss << " -f " << mConfig.muxerFormat;
+    oss << " " << mSlots[i]->encOutName;
+  }
+  return oss.str();
+}
+
+std::string SharedFFmpegWorker::BuildDecoderCommand() const
+{
+  std::ostringstream oss;
+  oss << "\"" << mConfig.ffmpegPath << "\"";
+  oss << " -hide_banner -loglevel warning -nostdin -y";
+  for (const auto& slot : mSlots)
+  {
+    oss << " -f " << mConfig.demuxerFormat;
+    oss << " -i " << slot->decInName;
+  }
+  for (size_t i = 0; i < mSlots.size(); ++i)
+  {
+    oss << " -map " << i << ":a";
+    oss << " -f s16le";
+    oss << " -ar " << mConfig.sampleRate;
+    oss << " -ac " << mConfig.channels;
+    oss << " " << mSlots[i]->decOutName;
+  }
+  return oss.str();
+}
+
+//==============================================================================
+// Background Threads
+//==============================================================================
+
+// Wait for ffmpeg to open a server pipe; false if shutting down instead
+static bool WaitForClient(HANDLE pipe, const std::atomic<bool>& running)
+{
+  bool connected = ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+  return connected && running.load();
+}
+
+void SharedFFmpegWorker::InputThread(int index)
+{
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+  SlotState& slot = *mSlots[index];
+  if (!WaitForClient(slot.encIn, mRunning))
+    return;
+
+  std::vector<float> localBuffer;
+  std::vector<int16_t> s16Buffer;
+
+  while (mRunning)
+  {
+    {
+      std::lock_guard<std::mutex> lock(slot.inputMutex);
+      if (!slot.inputQueue.empty())
+      {
+        localBuffer.swap(slot.inputQueue);
+        slot.inputQueue.clear();
+      }
+    }
+
+    if (localBuffer.empty())
+    {
+      Sleep(1);  // Reduce CPU load when no data
+      continue;
+    }
+
+    s16Buffer.resize(localBuffer.size());
+    FFmpegPipeManager::FloatToS16LE(localBuffer.data(), s16Buffer.data(), localBuffer.size());
+    localBuffer.clear();
+
+    DWORD bytesToWrite = static_cast<DWORD>(s16Buffer.size() * sizeof(int16_t));
+    DWORD offset = 0;
+    while (offset < bytesToWrite && mRunning)
+    {
+      DWORD bytesWritten = 0;
+      if (!WriteFile(slot.encIn, reinterpret_cast<const uint8_t*>(s16Buffer.data()) + offset,
+                     bytesToWrite - offset, &bytesWritten, nullptr) || bytesWritten == 0)
+      {
+        Log("Encoder input pipe " + std::to_string(index) + " broken - shared worker stopped");
+        mRunning = false;
+        break;
+      }
+      offset += bytesWritten;
+    }
+  }
+}
+
+void SharedFFmpegWorker::RelayReadThread(int index)
+{
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+  SlotState& slot = *mSlots[index];
+  if (!WaitForClient(slot.encOut, mRunning))
+    return;
+
+  // Always drain the encoder, even before the decoder has opened this
+  // slot's input: a blocked encoder output would stall every other slot
+  std::vector<uint8_t> buffer(mConfig.bufferSize);
+  while (mRunning)
+  {
+    DWORD bytesRead = 0;
+    if (!ReadFile(slot.encOut, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, nullptr) ||
+        bytesRead == 0)
+      break;
+
+    {
+      std::lock_guard<std::mutex> lock(slot.relayMutex);
+      slot.relayQueue.insert(slot.relayQueue.end(), buffer.begin(), buffer.begin() + bytesRead);
+    }
+    slot.relayCv.notify_one();
+  }
+}
+
+void SharedFFmpegWorker::RelayWriteThread(int index)
+{
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+  SlotState& slot = *mSlots[index];
+  if (!WaitForClient(slot.decIn, mRunning))
+    return;
+
+  std::vector<uint8_t> localBuffer;
+  while (mRunning)
+  {
+    {
+      std::unique_lock<std::mutex> lock(slot.relayMutex);
+      slot.relayCv.wait_for(lock, std::chrono::milliseconds(100),
+                            [&]() { return !slot.relayQueue.empty() || !mRunning; });
+      localBuffer.swap(slot.relayQueue);
+      slot.relayQueue.clear();
+    }
+
+    DWORD offset = 0;
+    DWORD bytesToWrite = static_cast<DWORD>(localBuffer.size());
+    while (offset < bytesToWrite && mRunning)
+    {
+      DWORD bytesWritten = 0;
+      if (!WriteFile(slot.decIn, localBuffer.data() + offset, bytesToWrite - offset, &bytesWritten, nullptr) ||
+          bytesWritten == 0)
+      {
+        mRunning = false;
+        break;
+      }
+      offset += bytesWritten;
+    }
+    localBuffer.clear();
+  }
+}
+
+void SharedFFmpegWorker::OutputThread(int index)
+{
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+  SlotState& slot = *mSlots[index];
+  if (!WaitForClient(slot.decOut, mRunning))
+    return;
+
+  const size_t channels = mConfig.channels;
+  const size_t frameBytes = sizeof(int16_t) * channels;
+  std::vector<uint8_t> buffer(mConfig.bufferSize);
+  std::vector<uint8_t> raw;
+  std::vector<float> decoded;
+  std::vector<float> kept;
+
+  while (mRunning)
+  {
+    DWORD bytesRead = 0;
+    if (!ReadFile(slot.decOut, buffer.data(), static_cast<DWORD>(buffer.size()), &bytesRead, nullptr) ||
+        bytesRead == 0)
+      break;
+
+    raw.insert(raw.end(), buffer.begin(), buffer.begin() + bytesRead);
+    const size_t numFrames = raw.size() / frameBytes;
+    if (numFrames == 0)
+      continue;
+
+    decoded.resize(numFrames * channels);
+    FFmpegPipeManager::S16LEToFloat(reinterpret_cast<const int16_t*>(raw.data()), decoded.data(),
+                                    decoded.size());
+    raw.erase(raw.begin(), raw.begin() + numFrames * frameBytes);
+
+    // Output frame k is the decode of input frame k: drop frames that came
+    // from a previous owner or from keep-alive silence. (Codec priming shifts
+    // this by the codec delay, so a few ms where an idle slot is fed again
+    // may be misfiled; filler never lands inside a fed stretch.)
+    kept.clear();
+    {
+      std::lock_guard<std::mutex> lock(slot.discardMutex);
+      const uint64_t first = slot.framesDecoded;
+      const uint64_t last = first + numFrames;
+      uint64_t k = first;
+      while (k < last)
+      {
+        while (!slot.fillerRanges.empty() && slot.fillerRanges.front().second <= k)
+          slot.fillerRanges.pop_front();
+
+        uint64_t dropEnd = k;
+        if (k < slot.discardBefore)
+          dropEnd = slot.discardBefore;
+        else if (!slot.fillerRanges.empty() && slot.fillerRanges.front().first <= k)
+          dropEnd = slot.fillerRanges.front().second;
+
+        if (dropEnd > k)
+        {
+          k = std::min(dropEnd, last);
+          continue;
+        }
+
+        uint64_t keepEnd = last;
+        if (!slot.fillerRanges.empty())
+          keepEnd = std::min(keepEnd, slot.fillerRanges.front().first);
+        kept.insert(kept.end(), decoded.begin() + (k - first) * channels,
+                    decoded.begin() + (keepEnd - first) * channels);
+        k = keepEnd;
+      }
+      slot.framesDecoded = last;
+    }
+
+    if (kept.empty())
+      continue;
+
+    std::lock_guard<std::mutex> lock(slot.outputMutex);
+    slot.outputQueue.insert(slot.outputQueue.end(), kept.begin(), kept.end());
+    slot.firstAudio.store(true, std::memory_order_relaxed);
+    slot.outputCv.notify_all();
+  }
+}
+
+void SharedFFmpegWorker::KeepAliveThread()
+{
+  ScopedThreadScheduling scheduling(mConfig.scheduling);
+
+  while (mRunning)
+  {
+    Sleep(kKeepAliveIntervalMs);
+
+    // Process death is otherwise only noticed once a pipe breaks
+    for (PROCESS_INFORMATION* pi : {&mEncoderProcessInfo, &mDecoderProcessInfo})
+    {
+      if (pi->hProcess && WaitForSingleObject(pi->hProcess, 0) != WAIT_TIMEOUT)
+      {
+        Log("Shared ffmpeg process exited - shared worker stopped");
+        mRunning = false;
+      }
+    }
+
+    // Free, parked and unfed slots are padded up to the furthest-ahead slot
+    // that is actually being fed; fed slots keep pace on their own
+    const ULONGLONG now = GetTickCount64();
+    auto isIdle = [&](const SlotState& slot) {
+      return !slot.inUse.load() || slot.parked.load() || now - slot.lastFedTick > kFeedIdleMs;
+    };
+
+    uint64_t leader = 0;
+    for (auto& slotPtr : mSlots)
+    {
+      SlotState& slot = *slotPtr;
+      std::lock_guard<std::mutex> lock(slot.inputMutex);
+      if (!isIdle(slot))
+        leader = std::max(leader, slot.framesQueued);
+    }
+
+    for (auto& slotPtr : mSlots)
+    {
+      // Checked again under the lock: an owner write since the first pass
+      // makes the slot fed, and its audio must not be followed by filler
+      SlotState& slot = *slotPtr;
+      std::lock_guard<std::mutex> lock(slot.inputMutex);
+      if (isIdle(slot) && leader > slot.framesQueued)
+        PadWithSilence(slot, leader);
+    }
+  }
+}
+
+void SharedFFmpegWorker::PadWithSilence(SlotState& slot, uint64_t targetFrames)
+{
+  uint64_t pad = std::min<uint64_t>(targetFrames - slot.framesQueued,
+                                    static_cast<uint64_t>(MaxPadFrames(mConfig.sampleRate)));
+  uint64_t begin = slot.framesQueued;
+  slot.inputQueue.resize(slot.inputQueue.size() + pad * mConfig.channels, 0.0f);
+  slot.framesQueued += pad;
+
+  std::lock_guard<std::mutex> lock(slot.discardMutex);
+  if (!slot.fillerRanges.empty() && slot.fillerRanges.back().second == begin)
+    slot.fillerRanges.back().second = slot.framesQueued;
+  else
+    slot.fillerRanges.emplace_back(begin, slot.framesQueued);
+}
+
+void SharedFFmpegWorker::ErrorReadThread()
+{
+  char buffer[4096];
+  DWORD bytesRead;
+
+  while (true)
+  {
+    if (!ReadFile(mErrorRead, buffer, sizeof(buffer) - 1, &bytesRead, nullptr) || bytesRead == 0)
+      break;
+    buffer[bytesRead] = '\0';
+    Log("FFmpeg stderr (shared): " + std::string(buffer));
+  }
+}
+
+//==============================================================================
+// Logging
+//==============================================================================
+
+void SharedFFmpegWorker::Log(const std::string& message)
+{
+  DebugLogShared(message);
+
+  // Worker-wide events are reported to every current owner
+  for (auto& slotPtr : mSlots)
+  {
+    SlotState& slot = *slotPtr;
+    if (!slot.inUse.load())
+      continue;
+    std::lock_guard<std::mutex> lock(slot.logMutex);
+    if (slot.log)
+      slot.log(message);
+  }
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+//==============================================================================
+// SharedFFmpegWorker.h
+// One encoder/decoder ffmpeg pair multiplexed across many plugin instances
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#ifndef _WIN32
+  #error "SharedFFmpegWorker.h is Windows-only."
+#endif
+
+#include "FFmpegPipeManager.h"
+#include <windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//==============================================================================
+// SharedFFmpegWorker
+// A long-lived encoder + decoder process pair serving up to N instances that
+// share the same codec configuration. Every slot is its own -map'ed stream
+// over a set of named pipes, so instances never see each other's audio:
+//
+//   instance k -> \\.\pipe\...-ei<k> -> encoder -> ...-eo<k> -> (relay)
+//              -> ...-di<k> -> decoder -> ...-do<k> -> instance k
+//
+// ffmpeg keeps all of its outputs within a small timestamp window of each
+// other, so a slot that stops being fed would eventually stall every other
+// slot. A keep-alive thread therefore pads free, parked and unfed slots with
+// silence up to the leading slot, and the decoded filler is dropped before it
+// reaches the owner's output queue. Slots that are being fed are never padded.
+//==============================================================================
+class SharedFFmpegSlot;
+
+class SharedFFmpegWorker
+{
+public:
+  using LogFunc = std::function<void(const std::string&)>;
+
+  /**
+   * Lease a slot on a worker whose configuration matches, starting a new
+   * worker when none has a free slot
+   * @param config Codec configuration (sharedSlots sets the worker capacity)
+   * @param log Log callback for this slot's owner
+   * @return Slot lease, or nullptr if a new worker could not be started
+   */
+  static std::unique_ptr<SharedFFmpegSlot> Acquire(const FFmpegPipeManager::Config& config, LogFunc log);
+
+  //--------------------------------------------------------------------------
+  // Resource accounting (for comparing against per-instance pipelines)
+  //--------------------------------------------------------------------------
+  struct Stats
+  {
+    int workers = 0;
+    int slotsInUse = 0;
+    int processes = 0;
+    size_t workingSetBytes = 0;  // Sum over all shared ffmpeg processes
+  };
+  static Stats GetStats();
+
+  ~SharedFFmpegWorker();
+
+  // Non-copyable
+  SharedFFmpegWorker(const SharedFFmpegWorker&) = delete;
+  SharedFFmpegWorker& operator=(const SharedFFmpegWorker&) = delete;
+
+private:
+  friend class SharedFFmpegSlot;
+  struct SlotState;
+
+  SharedFFmpegWorker(const FFmpegPipeManager::Config& config, std::string key);
+
+  // Registry key: every Config field that reaches the ffmpeg command lines
+  static std::string MakeKey(const FFmpegPipeManager::Config& config);
+
+  bool Launch();
+  void Shutdown();
+  int ClaimFreeSlot(LogFunc log);
+  void ReleaseSlot(int index);
+  bool IsAlive() const { return mRunning.load(); }
+
+  std::string BuildEncoderCommand() const;
+  std::string BuildDecoderCommand() const;
+  bool CreateSlotPipes(SlotState& slot, int index);
+  bool LaunchProcess(const std::string& cmd, PROCESS_INFORMATION& pi);
+
+  // Threads (four per slot plus keep-alive and stderr)
+  void InputThread(int index);
+  void RelayReadThread(int index);
+  void RelayWriteThread(int index);
+  void OutputThread(int index);
+  void KeepAliveThread();
+  void ErrorReadThread();
+
+  // Pad one slot with silence up to 'targetFrames' (caller holds inputMutex)
+  void PadWithSilence(SlotState& slot, uint64_t targetFrames);
+
+  void Log(const std::string& message);
+
+  FFmpegPipeManager::Config mConfig;
+  std::string mKey;
+  uint32_t mSerial;
+
+  std::vector<std::unique_ptr<SlotState>> mSlots;
+  std::atomic<int> mSlotsInUse{0};
+
+  PROCESS_INFORMATION mEncoderProcessInfo;
+  PROCESS_INFORMATION mDecoderProcessInfo;
+  HANDLE mJobObject;
+  HANDLE mErrorRead;
+  HANDLE mErrorWrite;
+
+  std::atomic<bool> mRunning{false};
+  std::thread mKeepAliveThread;
+  std::thread mErrorThread;
+};
+
+//==============================================================================
+// SharedFFmpegSlot
+// One instance's lease on a shared worker (released on destruction)
+//==============================================================================
+class SharedFFmpegSlot
+{
+public:
+  ~SharedFFmpegSlot();
+
+  // Non-copyable
+  SharedFFmpegSlot(const SharedFFmpegSlot&) = delete;
+  SharedFFmpegSlot& operator=(const SharedFFmpegSlot&) = delete;
+
+  // Same semantics as the FFmpegPipeManager methods of the same name
+  bool WriteSamples(const float* data, size_t numSamples);
+  size_t ReadSamples(float* data, size_t numSamples, DWORD timeout = 0);
+  size_t AvailableOutputSamples() const;
+  bool HasFirstAudioArrived() const;
+  void SetParked(bool parked);
+
+  // False once the shared processes have died
+  bool IsAlive() const;
+
+private:
+  friend class SharedFFmpegWorker;
+  SharedFFmpegSlot(std::shared_ptr<SharedFFmpegWorker> worker, int index)
+    : mWorker(std::move(worker)), mIndex(index) {}
+
+  std::shared_ptr<SharedFFmpegWorker> mWorker;
+  int mIndex;
+};
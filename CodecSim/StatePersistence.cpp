@@ -0,0 +1,195 @@
+//==============================================================================
+// StatePersistence.cpp
+// Debounced background writer implementation
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "StatePersistence.h"
+#include "DebugLog.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define DebugLogPersistence(msg) CODECSIM_LOG(LogLevel::Debug, "StatePersistence", msg)
+
+//==============================================================================
+// Constructor/Destructor
+//==============================================================================
+
+StatePersistence::StatePersistence(const std::string& directory, const std::string& fileName,
+                                   std::chrono::milliseconds quietPeriod)
+  : mDirectory(directory)
+  , mPath(directory + fileName)
+  , mQuietTicks(std::chrono::duration_cast<std::chrono::steady_clock::duration>(quietPeriod).count())
+{
+  mThread = std::thread(&StatePersistence::WriterThread, this);
+}
+
+StatePersistence::~StatePersistence()
+{
+  {
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    mStopping.store(true);
+  }
+  mWakeCv.notify_one();
+  if (mThread.joinable())
+    mThread.join();
+
+  // Final write of anything still pending
+  Flush();
+}
+
+//==============================================================================
+// Public API
+//==============================================================================
+
+void StatePersistence::Submit(std::vector<uint8_t>&& state)
+{
+  {
+    std::lock_guard<std::mutex> lock(mSubmitMutex);
+    mSubmitted = std::move(state);
+    mLastChangeTicks.store(NowTicks(), std::memory_order_relaxed);
+    mDirtyGeneration.fetch_add(1, std::memory_order_release);
+  }
+  // Deliberately no lock: a wakeup lost to the race is picked up by the
+  // writer's periodic timeout.
+  mWakeCv.notify_one();
+}
+
+void StatePersistence::Flush()
+{
+  std::lock_guard<std::mutex> lock(mWriteMutex);
+  uint64_t gen = mDirtyGeneration.load(std::memory_order_acquire);
+  if (gen == mWrittenGeneration)
+    return;
+  if (WriteNow())
+    mWrittenGeneration = gen;
+}
+
+//==============================================================================
+// Writer thread
+//==============================================================================
+
+void StatePersistence::WriterThread()
+{
+  std::unique_lock<std::mutex> wakeLock(mWakeMutex);
+
+  while (!mStopping.load())
+  {
+    uint64_t gen = mDirtyGeneration.load(std::memory_order_acquire);
+    bool dirty;
+    {
+      std::lock_guard<std::mutex> lock(mWriteMutex);
+      dirty = (gen != mWrittenGeneration);
+    }
+
+    if (!dirty)
+    {
+      mWakeCv.wait_for(wakeLock, std::chrono::seconds(1));
+      continue;
+    }
+
+    // Debounce: wait until no change has arrived for the quiet period
+    int64_t sinceChange = NowTicks() - mLastChangeTicks.load(std::memory_order_relaxed);
+    if (sinceChange < mQuietTicks)
+    {
+      mWakeCv.wait_for(wakeLock, std::chrono::steady_clock::duration(mQuietTicks - sinceChange));
+      continue;
+    }
+
+    wakeLock.unlock();
+    Flush();
+    wakeLock.lock();
+  }
+}
+
+bool StatePersistence::WriteNow()
+{
+  {
+    std::lock_guard<std::mutex> lock(mSubmitMutex);
+    mScratch = mSubmitted;
+  }
+  if (mScratch.empty())
+  {
+    DebugLogPersistence("nothing submitted");
+    return false;
+  }
+
+  if (!CreateDirectories(mDirectory))
+  {
+    DebugLogPersistence("could not create " + mDirectory);
+    return false;
+  }
+
+  const std::string tmpPath = mPath + ".tmp";
+  FILE* f = fopen(tmpPath.c_str(), "wb");
+  if (!f)
+  {
+    DebugLogPersistence("failed to open " + tmpPath);
+    return false;
+  }
+  bool ok = (fwrite(mScratch.data(), 1, mScratch.size(), f) == mScratch.size());
+  ok = (fflush(f) == 0) && ok;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok)
+  {
+    DebugLogPersistence("short write to " + tmpPath);
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+#ifdef _WIN32
+  ok = MoveFileExA(tmpPath.c_str(), mPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  ok = rename(tmpPath.c_str(), mPath.c_str()) == 0;
+#endif
+  if (!ok)
+  {
+    DebugLogPersistence("rename failed for " + mPath);
+    remove(tmpPath.c_str());
+    return false;
+  }
+
+  DebugLogPersistence("wrote " + std::to_string(mScratch.size()) + " bytes to " + mPath);
+  return true;
+}
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+bool StatePersistence::CreateDirectories(const std::string& directory)
+{
+  // Create each path component in turn (mkdir -p equivalent). Intermediate
+  // failures are ignored (existing or protected parents); only the result counts.
+  for (size_t pos = directory.find_first_of("\\/", 1); pos != std::string::npos;
+       pos = directory.find_first_of("\\/", pos + 1))
+  {
+    std::string partial = directory.substr(0, pos);
+    if (partial.back() == ':')
+      continue; // drive root
+#ifdef _WIN32
+    CreateDirectoryA(partial.c_str(), NULL);
+#else
+    mkdir(partial.c_str(), 0755);
+#endif
+  }
+#ifdef _WIN32
+  CreateDirectoryA(directory.c_str(), NULL);
+  DWORD attr = GetFileAttributesA(directory.c_str());
+  return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  mkdir(directory.c_str(), 0755);
+  struct stat st;
+  return stat(directory.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+int64_t StatePersistence::NowTicks()
+{
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
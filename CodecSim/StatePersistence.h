@@ -0,0 +1,70 @@
+#pragma once
+
+//==============================================================================
+// StatePersistence.h
+// Debounced background writer for standalone state files
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// StatePersistence
+// Takes finished state snapshots and writes the latest one on a background
+// thread once submissions have been quiet for a while. The file is written to
+// "<path>.tmp" and atomically renamed over the target, so a crash mid-write
+// never leaves a truncated state file.
+//
+// The writer only ever sees the bytes handed to Submit(): the owner serializes
+// on its own thread, so no live state is read concurrently. Submit() does no
+// file I/O but does take a short lock; host callbacks should defer to idle.
+//==============================================================================
+class StatePersistence
+{
+public:
+  StatePersistence(const std::string& directory, const std::string& fileName,
+                   std::chrono::milliseconds quietPeriod = std::chrono::milliseconds(750));
+  ~StatePersistence(); // Writes any pending change before returning
+
+  // Non-copyable
+  StatePersistence(const StatePersistence&) = delete;
+  StatePersistence& operator=(const StatePersistence&) = delete;
+
+  // Replace the state to persist (written after the quiet period)
+  void Submit(std::vector<uint8_t>&& state);
+
+  // Write the latest submission now and wait for completion (not for host callbacks)
+  void Flush();
+
+  const std::string& GetPath() const { return mPath; }
+
+private:
+  void WriterThread();
+  bool WriteNow();
+  static bool CreateDirectories(const std::string& directory);
+  static int64_t NowTicks();
+
+  std::string mDirectory;
+  std::string mPath;
+  const int64_t mQuietTicks;
+
+  std::atomic<uint64_t> mDirtyGeneration{0};
+  std::atomic<int64_t> mLastChangeTicks{0};
+  uint64_t mWrittenGeneration = 0; // writer thread / Flush only (under mWriteMutex)
+
+  std::atomic<bool> mStopping{false};
+  std::mutex mWakeMutex;
+  std::condition_variable mWakeCv;
+  std::mutex mWriteMutex;
+  std::mutex mSubmitMutex;
+  std::vector<uint8_t> mSubmitted; // latest snapshot (under mSubmitMutex)
+  std::vector<uint8_t> mScratch;   // snapshot being written (under mWriteMutex)
+  std::thread mThread;
+};
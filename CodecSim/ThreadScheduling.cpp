@@ -0,0 +1,270 @@
+//==============================================================================
+// ThreadScheduling.cpp
+// Scheduling policy implementation (Windows + POSIX)
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "ThreadScheduling.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+
+//==============================================================================
+// MMCSS (avrt.dll exports, resolved at runtime)
+//==============================================================================
+
+using AvSetMmThreadCharacteristicsFn = HANDLE (WINAPI*)(LPCSTR, DWORD*);
+using AvRevertMmThreadCharacteristicsFn = BOOL (WINAPI*)(HANDLE);
+
+struct AvrtFunctions
+{
+  AvSetMmThreadCharacteristicsFn set = nullptr;
+  AvRevertMmThreadCharacteristicsFn revert = nullptr;
+};
+
+static const AvrtFunctions& GetAvrt()
+{
+  static const AvrtFunctions sAvrt = []() {
+    AvrtFunctions f;
+    if (HMODULE avrt = LoadLibraryA("avrt.dll"))
+    {
+      f.set = reinterpret_cast<AvSetMmThreadCharacteristicsFn>(GetProcAddress(avrt, "AvSetMmThreadCharacteristicsA"));
+      f.revert = reinterpret_cast<AvRevertMmThreadCharacteristicsFn>(GetProcAddress(avrt, "AvRevertMmThreadCharacteristics"));
+    }
+    return f;
+  }();
+  return sAvrt;
+}
+
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//==============================================================================
+// POSIX helpers
+//==============================================================================
+
+static int ClampRealTimePriority(int policy, int priority)
+{
+  return std::clamp(priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+}
+
+#ifdef __linux__
+static cpu_set_t MaskToCpuSet(uint64_t mask)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu = 0; cpu < 64; ++cpu)
+  {
+    if (mask & (uint64_t(1) << cpu))
+      CPU_SET(cpu, &set);
+  }
+  return set;
+}
+#endif
+
+// I/O priority only matters for file access (the CLI reading stems), not for
+// pipes, but it is cheap to set alongside the CPU class
+static void SetIoPriority(int who, bool realTime)
+{
+#if defined(__linux__) && defined(SYS_ioprio_set)
+  constexpr int kWhoProcess = 1, kClassRealTime = 1, kClassBestEffort = 2, kClassShift = 13;
+  if (realTime && syscall(SYS_ioprio_set, kWhoProcess, who, (kClassRealTime << kClassShift) | 4) == 0)
+    return;
+  syscall(SYS_ioprio_set, kWhoProcess, who, (kClassBestEffort << kClassShift) | 0);
+#else
+  (void)who;
+  (void)realTime;
+#endif
+}
+
+static int CurrentThreadId()
+{
+#if defined(__linux__)
+  return static_cast<int>(syscall(SYS_gettid));
+#else
+  return 0;  // setpriority(PRIO_PROCESS, 0) targets the calling process elsewhere
+#endif
+}
+#endif
+
+//==============================================================================
+// ScopedThreadScheduling
+//==============================================================================
+
+ScopedThreadScheduling::ScopedThreadScheduling(const SchedulingPolicy& policy)
+{
+#ifdef _WIN32
+  if (policy.threadAffinity)
+    SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(policy.threadAffinity));
+
+  switch (policy.threads)
+  {
+    case SchedulingClass::RealTime:
+      if (GetAvrt().set)
+      {
+        DWORD taskIndex = 0;
+        mMmcssHandle = GetAvrt().set("Pro Audio", &taskIndex);
+        if (mMmcssHandle)
+        {
+          mEffective = SchedulingClass::RealTime;
+          break;
+        }
+      }
+      [[fallthrough]];
+    case SchedulingClass::Raised:
+      if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST))
+        mEffective = SchedulingClass::Raised;
+      break;
+    case SchedulingClass::Default:
+      break;
+  }
+#else
+#ifdef __linux__
+  if (policy.threadAffinity)
+  {
+    cpu_set_t set = MaskToCpuSet(policy.threadAffinity);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+#endif
+
+  switch (policy.threads)
+  {
+    case SchedulingClass::RealTime:
+    {
+      sched_param param = {};
+      param.sched_priority = ClampRealTimePriority(SCHED_FIFO, policy.realTimePriority);
+      if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+      {
+        SetIoPriority(CurrentThreadId(), true);
+        mEffective = SchedulingClass::RealTime;
+        break;
+      }
+    }
+      [[fallthrough]];
+    case SchedulingClass::Raised:
+      if (setpriority(PRIO_PROCESS, CurrentThreadId(), policy.niceValue) == 0)
+      {
+        SetIoPriority(CurrentThreadId(), false);
+        mEffective = SchedulingClass::Raised;
+      }
+      break;
+    case SchedulingClass::Default:
+      break;
+  }
+#endif
+}
+
+ScopedThreadScheduling::~ScopedThreadScheduling()
+{
+#ifdef _WIN32
+  if (mMmcssHandle && GetAvrt().revert)
+    GetAvrt().revert(mMmcssHandle);
+#endif
+}
+
+//==============================================================================
+// Process scheduling
+//==============================================================================
+
+SchedulingClass ApplyProcessScheduling(const SchedulingPolicy& policy, NativeProcessHandle process)
+{
+#ifdef _WIN32
+  if (!process)
+    return SchedulingClass::Default;
+
+  if (policy.processAffinity)
+  {
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+    {
+      DWORD_PTR mask = static_cast<DWORD_PTR>(policy.processAffinity) & systemMask;
+      if (mask)
+        SetProcessAffinityMask(process, mask);
+    }
+  }
+
+  switch (policy.processes)
+  {
+    case SchedulingClass::RealTime:
+      if (SetPriorityClass(process, HIGH_PRIORITY_CLASS))
+        return SchedulingClass::RealTime;
+      [[fallthrough]];
+    case SchedulingClass::Raised:
+      if (SetPriorityClass(process, ABOVE_NORMAL_PRIORITY_CLASS))
+        return SchedulingClass::Raised;
+      break;
+    case SchedulingClass::Default:
+      break;
+  }
+  return SchedulingClass::Default;
+#else
+  if (process <= 0)
+    return SchedulingClass::Default;
+
+#ifdef __linux__
+  if (policy.processAffinity)
+  {
+    cpu_set_t set = MaskToCpuSet(policy.processAffinity);
+    sched_setaffinity(process, sizeof(set), &set);
+  }
+#endif
+
+  // Threads the child creates later inherit its main thread's settings
+  switch (policy.processes)
+  {
+    case SchedulingClass::RealTime:
+    {
+      sched_param param = {};
+      param.sched_priority = ClampRealTimePriority(SCHED_RR, policy.realTimePriority);
+      if (sched_setscheduler(process, SCHED_RR, &param) == 0)
+      {
+        SetIoPriority(process, true);
+        return SchedulingClass::RealTime;
+      }
+    }
+      [[fallthrough]];
+    case SchedulingClass::Raised:
+      if (setpriority(PRIO_PROCESS, process, policy.niceValue) == 0)
+      {
+        SetIoPriority(process, false);
+        return SchedulingClass::Raised;
+      }
+      break;
+    case SchedulingClass::Default:
+      break;
+  }
+  return SchedulingClass::Default;
+#endif
+}
+
+//==============================================================================
+// Names
+//==============================================================================
+
+const char* SchedulingClassName(SchedulingClass schedulingClass)
+{
+  switch (schedulingClass)
+  {
+    case SchedulingClass::Raised: return "raised";
+    case SchedulingClass::RealTime: return "realtime";
+    default: return "default";
+  }
+}
+
+bool ParseSchedulingClass(const std::string& name, SchedulingClass& out)
+{
+  for (SchedulingClass c : {SchedulingClass::Default, SchedulingClass::Raised, SchedulingClass::RealTime})
+  {
+    if (name == SchedulingClassName(c))
+    {
+      out = c;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+//==============================================================================
+// ThreadScheduling.h
+// Scheduling policy for pipeline I/O threads and ffmpeg child processes
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <cstdint>
+#include <string>
+
+//==============================================================================
+// SchedulingClass
+//==============================================================================
+enum class SchedulingClass
+{
+  Default,   // Leave the OS default untouched
+  Raised,    // Windows: highest thread priority / above-normal class; POSIX: negative nice
+  RealTime   // Windows: MMCSS "Pro Audio" / high class; POSIX: SCHED_FIFO threads, SCHED_RR processes
+};
+
+//==============================================================================
+// SchedulingPolicy
+// Requests that need privileges the process does not have (SCHED_FIFO without
+// CAP_SYS_NICE, negative nice, ...) fall back to the next weaker class rather
+// than failing the pipeline. Both classes default to the OS default: raising
+// them is opt-in until codecsim-bench-scheduling shows a win with a real ffmpeg.
+//==============================================================================
+struct SchedulingPolicy
+{
+  SchedulingClass threads = SchedulingClass::Default;     // Pipe I/O threads
+  SchedulingClass processes = SchedulingClass::Default;   // ffmpeg children
+  uint64_t threadAffinity = 0;    // CPU bit mask for I/O threads (0 = any CPU)
+  uint64_t processAffinity = 0;   // CPU bit mask for ffmpeg children (0 = any CPU)
+  int realTimePriority = 10;      // POSIX SCHED_FIFO/SCHED_RR priority (1-99)
+  int niceValue = -10;            // POSIX nice for Raised (and RealTime fallback)
+};
+
+#ifdef _WIN32
+using NativeProcessHandle = void*;  // HANDLE
+#else
+using NativeProcessHandle = int;    // pid_t
+#endif
+
+//==============================================================================
+// ScopedThreadScheduling
+// Applies the thread half of a policy to the calling thread. Meant for the
+// dedicated pipe threads: the MMCSS registration (Windows) is reverted on
+// destruction, everything else simply ends with the thread.
+//==============================================================================
+class ScopedThreadScheduling
+{
+public:
+  explicit ScopedThreadScheduling(const SchedulingPolicy& policy);
+  ~ScopedThreadScheduling();
+
+  // Non-copyable
+  ScopedThreadScheduling(const ScopedThreadScheduling&) = delete;
+  ScopedThreadScheduling& operator=(const ScopedThreadScheduling&) = delete;
+
+  // Class actually in effect after fallbacks
+  SchedulingClass GetEffectiveClass() const { return mEffective; }
+
+private:
+  void* mMmcssHandle = nullptr;
+  SchedulingClass mEffective = SchedulingClass::Default;
+};
+
+// Apply the process half of a policy to a child; returns the class in effect
+SchedulingClass ApplyProcessScheduling(const SchedulingPolicy& policy, NativeProcessHandle process);
+
+// "default" / "raised" / "realtime"
+const char* SchedulingClassName(SchedulingClass schedulingClass);
+bool ParseSchedulingClass(const std::string& name, SchedulingClass& out);
@@ -0,0 +1,213 @@
+//==============================================================================
+// TraceRecorder.cpp
+// Per-thread event rings for timing dropouts, exported as Chrome trace JSON
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+thread_local TraceRecorder::ThreadRing* TraceRecorder::tRing = nullptr;
+
+namespace
+{
+
+std::mutex& RegistryMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+uint64_t sNextThreadId = 1;  // Under RegistryMutex()
+
+// Escape a name for a JSON string (names are literals, but keep the file valid)
+void WriteJsonString(FILE* file, const char* text)
+{
+  std::fputc('"', file);
+  for (const char* c = text ? text : ""; *c; ++c)
+  {
+    if (*c == '"' || *c == '\\')
+      std::fputc('\\', file);
+    if (static_cast<unsigned char>(*c) >= 0x20)
+      std::fputc(*c, file);
+  }
+  std::fputc('"', file);
+}
+
+} // namespace
+
+// Marks the thread's ring as reusable when the thread exits
+struct TraceThreadExit
+{
+  TraceRecorder::ThreadRing* ring = nullptr;
+  ~TraceThreadExit()
+  {
+    if (ring)
+      ring->exited.store(true, std::memory_order_release);
+  }
+};
+
+std::vector<std::unique_ptr<TraceRecorder::ThreadRing>>& TraceRecorder::Rings()
+{
+  static std::vector<std::unique_ptr<ThreadRing>> rings;
+  return rings;
+}
+
+TraceRecorder::ThreadRing* TraceRecorder::AttachThread()
+{
+  thread_local TraceThreadExit exitHook;
+
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  auto& rings = Rings();
+
+  ThreadRing* ring = nullptr;
+  if (rings.size() >= kMaxThreads)
+  {
+    // Recycle the ring of an exited thread (its events are lost)
+    for (auto& candidate : rings)
+    {
+      if (candidate->exited.load(std::memory_order_acquire))
+      {
+        ring = candidate.get();
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->exited.store(false, std::memory_order_relaxed);
+        ring->name[0] = '\0';
+        break;
+      }
+    }
+  }
+  if (!ring)
+  {
+    rings.push_back(std::make_unique<ThreadRing>());
+    ring = rings.back().get();
+    ring->events = std::make_unique<TraceEvent[]>(kEventsPerThread);
+  }
+
+  ring->threadId = sNextThreadId++;
+  exitHook.ring = ring;
+  tRing = ring;
+  return ring;
+}
+
+void TraceRecorder::SetThreadName(const char* name)
+{
+  ThreadRing* ring = tRing ? tRing : AttachThread();
+  if (ring->name[0] != '\0')
+    return;
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+  std::strncpy(ring->name, name, sizeof(ring->name) - 1);
+}
+
+bool TraceRecorder::WriteChromeTrace(const std::string& path, std::string& error)
+{
+  std::lock_guard<std::mutex> lock(RegistryMutex());
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file)
+  {
+    error = "Cannot open " + path + " for writing";
+    return false;
+  }
+
+  // Chrome wants microseconds; start the timeline at the oldest event
+  std::vector<TraceEvent> events;
+  uint64_t origin = UINT64_MAX;
+  struct ThreadEvents { const ThreadRing* ring; size_t begin; size_t end; };
+  std::vector<ThreadEvents> threads;
+
+  for (const auto& ring : Rings())
+  {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    const uint64_t first = head > kEventsPerThread ? head - kEventsPerThread : 0;
+
+    const size_t begin = events.size();
+    for (uint64_t i = first; i < head; ++i)
+      events.push_back(ring->events[i & (kEventsPerThread - 1)]);
+
+    // Slots the writer lapped while they were copied are unreliable
+    const uint64_t headAfter = ring->head.load(std::memory_order_acquire);
+    const uint64_t firstValid = headAfter > kEventsPerThread ? headAfter - kEventsPerThread : 0;
+    size_t keepFrom = begin;
+    if (firstValid > first)
+      keepFrom = begin + static_cast<size_t>(std::min<uint64_t>(firstValid - first, head - first));
+
+    if (keepFrom < events.size())
+      origin = std::min(origin, events[keepFrom].timestampNs);
+    threads.push_back({ring.get(), keepFrom, events.size()});
+  }
+  if (origin == UINT64_MAX)
+    origin = 0;
+
+  std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool firstLine = true;
+  auto separator = [&]() {
+    if (!firstLine)
+      std::fputs(",\n", file);
+    firstLine = false;
+  };
+
+  for (const auto& thread : threads)
+  {
+    const unsigned long long tid = thread.ring->threadId;
+    if (thread.ring->name[0] != '\0')
+    {
+      separator();
+      std::fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":", tid);
+      WriteJsonString(file, thread.ring->name);
+      std::fputs("}}", file);
+    }
+
+    // An End whose Begin was overwritten would close an unrelated scope
+    int depth = 0;
+    for (size_t i = thread.begin; i < thread.end; ++i)
+    {
+      const TraceEvent& event = events[i];
+      const double ts = (event.timestampNs - origin) / 1000.0;
+      const long long value = static_cast<long long>(event.value);
+
+      switch (event.type)
+      {
+        case TraceEventType::Begin:
+          ++depth;
+          separator();
+          std::fputs("{\"ph\":\"B\",\"name\":", file);
+          WriteJsonString(file, event.name);
+          std::fprintf(file, ",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"args\":{\"value\":%lld}}", tid, ts, value);
+          break;
+        case TraceEventType::End:
+          if (depth == 0)
+            break;
+          --depth;
+          separator();
+          std::fputs("{\"ph\":\"E\",\"name\":", file);
+          WriteJsonString(file, event.name);
+          std::fprintf(file, ",\"pid\":1,\"tid\":%llu,\"ts\":%.3f}", tid, ts);
+          break;
+        case TraceEventType::Instant:
+          separator();
+          std::fputs("{\"ph\":\"i\",\"s\":\"t\",\"name\":", file);
+          WriteJsonString(file, event.name);
+          std::fprintf(file, ",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"args\":{\"value\":%lld}}", tid, ts, value);
+          break;
+        case TraceEventType::Counter:
+          separator();
+          std::fputs("{\"ph\":\"C\",\"name\":", file);
+          WriteJsonString(file, event.name);
+          std::fprintf(file, ",\"pid\":1,\"tid\":%llu,\"ts\":%.3f,\"args\":{\"value\":%lld}}", tid, ts, value);
+          break;
+      }
+    }
+  }
+
+  std::fputs("\n]}\n", file);
+  const bool ok = std::ferror(file) == 0;
+  if (std::fclose(file) != 0 || !ok)
+  {
+    error = "Failed writing " + path;
+    return false;
+  }
+  return true;
+}
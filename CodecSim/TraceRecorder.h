@@ -0,0 +1,136 @@
+#pragma once
+
+//==============================================================================
+// TraceRecorder.h
+// Per-thread event rings for timing dropouts, exported as Chrome trace JSON
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Compile-time switch: with CODECSIM_TRACE=0 (default) every CODECSIM_TRACE_*
+// macro expands to nothing. CMake: -DCODECSIM_TRACE=ON.
+#ifndef CODECSIM_TRACE
+#define CODECSIM_TRACE 0
+#endif
+
+enum class TraceEventType : uint8_t
+{
+  Begin,    // Scope start (value = argument)
+  End,      // Scope end
+  Instant,  // Point event (value = argument)
+  Counter   // Sampled value
+};
+
+// 32 bytes; names must be string literals (only the pointer is stored)
+struct TraceEvent
+{
+  uint64_t timestampNs;
+  const char* name;
+  int64_t value;
+  TraceEventType type;
+};
+
+//==============================================================================
+// TraceRecorder - every thread writes into its own ring (single writer, no
+// locks, no allocation after the thread's first event); the oldest events are
+// overwritten. Rings outlive their threads so a dump after a pipeline restart
+// still shows the previous pipeline's threads.
+//==============================================================================
+class TraceRecorder
+{
+public:
+  static constexpr size_t kEventsPerThread = 1 << 15;  // 1 MB per thread
+  static constexpr size_t kMaxThreads = 64;            // Rings of exited threads are recycled beyond this
+
+  /**
+   * Append an event to the calling thread's ring (tens of nanoseconds).
+   * The first call on a thread allocates its ring.
+   */
+  static void Record(TraceEventType type, const char* name, int64_t value = 0)
+  {
+    ThreadRing* ring = tRing ? tRing : AttachThread();
+    const uint64_t head = ring->head.load(std::memory_order_relaxed);
+    TraceEvent& event = ring->events[head & (kEventsPerThread - 1)];
+    event.timestampNs = NowNs();
+    event.name = name;
+    event.value = value;
+    event.type = type;
+    ring->head.store(head + 1, std::memory_order_release);
+  }
+
+  // Label the calling thread in the trace (first name wins until the thread exits)
+  static void SetThreadName(const char* name);
+
+  /**
+   * Write every recorded event as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+   * Safe while other threads keep recording; events overwritten during the copy are dropped.
+   * @return false with error set if the file cannot be written
+   */
+  static bool WriteChromeTrace(const std::string& path, std::string& error);
+
+private:
+  struct ThreadRing
+  {
+    std::atomic<uint64_t> head{0};
+    uint64_t threadId = 0;
+    char name[32] = {};
+    std::atomic<bool> exited{false};
+    std::unique_ptr<TraceEvent[]> events;
+  };
+
+  static ThreadRing* AttachThread();
+  static std::vector<std::unique_ptr<ThreadRing>>& Rings();  // Under the registry mutex
+
+  static uint64_t NowNs()
+  {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  static thread_local ThreadRing* tRing;
+
+  friend struct TraceThreadExit;
+};
+
+// RAII Begin/End pair
+class TraceScope
+{
+public:
+  explicit TraceScope(const char* name, int64_t value = 0) : mName(name)
+  {
+    TraceRecorder::Record(TraceEventType::Begin, name, value);
+  }
+  ~TraceScope() { TraceRecorder::Record(TraceEventType::End, mName); }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char* mName;
+};
+
+#define CODECSIM_TRACE_CONCAT_INNER(a, b) a##b
+#define CODECSIM_TRACE_CONCAT(a, b) CODECSIM_TRACE_CONCAT_INNER(a, b)
+
+#if CODECSIM_TRACE
+#define CODECSIM_TRACE_SCOPE(name) TraceScope CODECSIM_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define CODECSIM_TRACE_SCOPE_VALUE(name, value) \
+  TraceScope CODECSIM_TRACE_CONCAT(traceScope_, __LINE__)(name, static_cast<int64_t>(value))
+#define CODECSIM_TRACE_INSTANT(name, value) \
+  TraceRecorder::Record(TraceEventType::Instant, name, static_cast<int64_t>(value))
+#define CODECSIM_TRACE_COUNTER(name, value) \
+  TraceRecorder::Record(TraceEventType::Counter, name, static_cast<int64_t>(value))
+#define CODECSIM_TRACE_THREAD_NAME(name) TraceRecorder::SetThreadName(name)
+#else
+#define CODECSIM_TRACE_SCOPE(name) ((void)0)
+#define CODECSIM_TRACE_SCOPE_VALUE(name, value) ((void)0)
+#define CODECSIM_TRACE_INSTANT(name, value) ((void)0)
+#define CODECSIM_TRACE_COUNTER(name, value) ((void)0)
+#define CODECSIM_TRACE_THREAD_NAME(name) ((void)0)
+#endif
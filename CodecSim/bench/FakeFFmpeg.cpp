@@ -0,0 +1,434 @@
+//==============================================================================
+// FakeFFmpeg.cpp
+// Deterministic ffmpeg stand-in speaking the pipe protocol (tests, benchmarks)
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: point FFmpegPipeManager::Config::ffmpegPath (or codecsim-cli
+// --ffmpeg) at codecsim-fake-ffmpeg. It accepts the command lines
+// FFmpegPipeManager builds:
+//
+//   -encoders                          List every encoder in CodecRegistry
+//   [-f FMT] [-ar HZ] [-ac N] -i pipe:0 ... [-f FMT] [-ar HZ] [-ac N] pipe:1
+//
+// Options before -i describe the input, options after it the output; all
+// others are ignored. Audio is s16le at both ends and passes through
+// unchanged by default, so the "encoded" stream between a fake encoder and a
+// fake decoder is PCM too. The process with -f s16le on its input is the
+// encoder, the one with -f s16le on its output the decoder.
+//
+// Behaviour is set through the environment (inherited by pipeline children):
+//
+//   CODECSIM_FAKE_FFMPEG="key=value,key=value,..."
+//
+//   stage=decoder|encoder|both   Process the settings below apply to (default: decoder)
+//   gain=DB                      Gain applied to every sample (saturating)
+//   delay=FRAMES                 Silence prepended to the output (codec priming)
+//   latency=MS                   Each input chunk is held this long before output
+//   burst=BYTES                  Output is written only in chunks of this size
+//                                (the rest at end of input), like container pages
+//   speed=X                      Output paced at X times real time (0 = unpaced)
+//   stall=BYTES:MS               After BYTES of output, stop for MS (0 = forever);
+//                                input backs up into the pipe meanwhile
+//   queue=BYTES                  Input read ahead of the output (default 262144); 0
+//                                reads one chunk at a time, so a stalled encoder
+//                                stops its stdin almost at once, like a wedged ffmpeg
+//   crash=BYTES                  Exit with status 134 after exactly BYTES of output
+//   encoders=NAME;NAME...        Encoders listed by -encoders (default: all registered)
+//
+// A process whose stage is not selected is a plain passthrough. Given the
+// same input and settings the output bytes are always identical; only the
+// timing settings (latency, speed, stall) depend on the clock.
+//==============================================================================
+
+#include "../CodecRegistry.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+
+constexpr int kCrashExitCode = 134;          // What a shell reports for SIGABRT
+constexpr size_t kReadChunkBytes = 4096;
+constexpr size_t kDefaultQueuedBytes = 256 * 1024;  // Beyond this, input backs up into the pipe
+
+using Clock = std::chrono::steady_clock;
+
+struct FakeSettings
+{
+  std::string stage = "decoder";
+  double gainDb = 0.0;
+  int delayFrames = 0;
+  double latencyMs = 0.0;
+  size_t burstBytes = 0;
+  double speed = 0.0;
+  uint64_t stallAfterBytes = UINT64_MAX;
+  double stallMs = 0.0;
+  uint64_t crashAfterBytes = UINT64_MAX;
+  size_t maxQueuedBytes = kDefaultQueuedBytes;
+  std::string encoders;                      // ';'-separated, empty = every registered encoder
+};
+
+struct StreamArgs
+{
+  bool listEncoders = false;
+  std::string inputFormat;
+  std::string outputFormat;
+  int sampleRate = 48000;
+  int channels = 2;
+};
+
+bool ParseSettings(const char* spec, FakeSettings& settings)
+{
+  if (!spec)
+    return true;
+
+  std::string text = spec;
+  size_t pos = 0;
+  while (pos < text.size())
+  {
+    size_t end = text.find(',', pos);
+    if (end == std::string::npos)
+      end = text.size();
+    const std::string item = text.substr(pos, end - pos);
+    pos = end + 1;
+    if (item.empty())
+      continue;
+
+    const size_t eq = item.find('=');
+    if (eq == std::string::npos)
+      return false;
+    const std::string key = item.substr(0, eq);
+    const std::string value = item.substr(eq + 1);
+    const char* v = value.c_str();
+
+    if (key == "stage") settings.stage = value;
+    else if (key == "gain") settings.gainDb = std::atof(v);
+    else if (key == "delay") settings.delayFrames = std::max(0, std::atoi(v));
+    else if (key == "latency") settings.latencyMs = std::max(0.0, std::atof(v));
+    else if (key == "burst") settings.burstBytes = std::strtoull(v, nullptr, 10);
+    else if (key == "speed") settings.speed = std::max(0.0, std::atof(v));
+    else if (key == "crash") settings.crashAfterBytes = std::strtoull(v, nullptr, 10);
+    else if (key == "queue") settings.maxQueuedBytes = std::strtoull(v, nullptr, 10);
+    else if (key == "encoders") settings.encoders = value;
+    else if (key == "stall")
+    {
+      const size_t colon = value.find(':');
+      if (colon == std::string::npos)
+        return false;
+      settings.stallAfterBytes = std::strtoull(v, nullptr, 10);
+      settings.stallMs = std::max(0.0, std::atof(v + colon + 1));
+    }
+    else
+      return false;
+  }
+  return settings.stage == "decoder" || settings.stage == "encoder" || settings.stage == "both";
+}
+
+void ParseArgs(int argc, char** argv, StreamArgs& args)
+{
+  bool afterInput = false;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : "";
+    if (arg == "-encoders") args.listEncoders = true;
+    else if (arg == "-i") { afterInput = true; ++i; }
+    else if (arg == "-f") { (afterInput ? args.outputFormat : args.inputFormat) = value; ++i; }
+    else if (arg == "-ar") { args.sampleRate = std::max(1, std::atoi(value)); ++i; }
+    else if (arg == "-ac") { args.channels = std::max(1, std::atoi(value)); ++i; }
+  }
+}
+
+void ListEncoders(const FakeSettings& settings)
+{
+  std::printf("Encoders:\n ------\n");
+  if (!settings.encoders.empty())
+  {
+    size_t pos = 0;
+    while (pos <= settings.encoders.size())
+    {
+      size_t end = settings.encoders.find(';', pos);
+      if (end == std::string::npos)
+        end = settings.encoders.size();
+      if (end > pos)
+        std::printf(" A..... %-20s fake\n", settings.encoders.substr(pos, end - pos).c_str());
+      pos = end + 1;
+    }
+    return;
+  }
+  for (const CodecInfo& codec : CodecRegistry::Instance().GetAll())
+    std::printf(" A..... %-20s fake\n", std::string(codec.encoderName).c_str());
+}
+
+//==============================================================================
+// ChunkQueue - reader -> writer hand-off. Bounded, so a stalled writer stops
+// the reader and the upstream pipe fills the way it would for a wedged ffmpeg.
+// The reader always gets one chunk in, even with a limit of 0.
+//==============================================================================
+class ChunkQueue
+{
+public:
+  explicit ChunkQueue(size_t maxQueuedBytes) : mMaxQueuedBytes(maxQueuedBytes) {}
+
+  struct Chunk
+  {
+    Clock::time_point due;
+    std::vector<char> bytes;
+  };
+
+  void Push(Chunk chunk)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mSpace.wait(lock, [&] { return mQueuedBytes == 0 || mQueuedBytes < mMaxQueuedBytes; });
+    mQueuedBytes += chunk.bytes.size();
+    mChunks.push_back(std::move(chunk));
+    mReady.notify_one();
+  }
+
+  void Close()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+    mReady.notify_one();
+  }
+
+  // false once the queue is closed and drained
+  bool Pop(Chunk& chunk)
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mReady.wait(lock, [&] { return !mChunks.empty() || mClosed; });
+    if (mChunks.empty())
+      return false;
+    chunk = std::move(mChunks.front());
+    mChunks.pop_front();
+    mQueuedBytes -= chunk.bytes.size();
+    mSpace.notify_one();
+    return true;
+  }
+
+private:
+  std::mutex mMutex;
+  std::condition_variable mReady;
+  std::condition_variable mSpace;
+  std::deque<Chunk> mChunks;
+  const size_t mMaxQueuedBytes;
+  size_t mQueuedBytes = 0;
+  bool mClosed = false;
+};
+
+//==============================================================================
+// OutputWriter - stdout with the burst/pacing/stall/crash behaviour
+//==============================================================================
+class OutputWriter
+{
+public:
+  OutputWriter(const FakeSettings& settings, const StreamArgs& args)
+    : mSettings(settings), mStart(Clock::now())
+  {
+    if (settings.speed > 0.0)
+      mBytesPerSecond = static_cast<double>(args.sampleRate) * args.channels * 2 * settings.speed;
+  }
+
+  // Buffers into whole bursts when burst= is set
+  void Write(const char* data, size_t size)
+  {
+    if (mSettings.burstBytes == 0)
+    {
+      Emit(data, size);
+      return;
+    }
+    mPending.insert(mPending.end(), data, data + size);
+    size_t offset = 0;
+    while (mPending.size() - offset >= mSettings.burstBytes)
+    {
+      Emit(mPending.data() + offset, mSettings.burstBytes);
+      offset += mSettings.burstBytes;
+    }
+    mPending.erase(mPending.begin(), mPending.begin() + offset);
+  }
+
+  void Finish()
+  {
+    if (!mPending.empty())
+      Emit(mPending.data(), mPending.size());
+    mPending.clear();
+  }
+
+  bool Failed() const { return mFailed; }
+
+private:
+  void Emit(const char* data, size_t size)
+  {
+    while (size > 0 && !mFailed)
+    {
+      uint64_t limit = size;
+      if (mSettings.crashAfterBytes != UINT64_MAX)
+        limit = std::min<uint64_t>(limit, mSettings.crashAfterBytes - mWritten);
+      if (!mStalled && mSettings.stallAfterBytes != UINT64_MAX)
+        limit = std::min<uint64_t>(limit, mSettings.stallAfterBytes - mWritten);
+
+      const size_t n = static_cast<size_t>(limit);
+      if (n > 0)
+      {
+        Pace(n);
+        mFailed = std::fwrite(data, 1, n, stdout) != n || std::fflush(stdout) != 0;
+        mWritten += n;
+        data += n;
+        size -= n;
+      }
+
+      if (mWritten >= mSettings.crashAfterBytes)
+      {
+        std::fflush(stdout);
+        std::_Exit(kCrashExitCode);
+      }
+      if (!mStalled && mWritten >= mSettings.stallAfterBytes)
+      {
+        mStalled = true;
+        if (mSettings.stallMs <= 0.0)
+        {
+          while (true)
+            std::this_thread::sleep_for(std::chrono::hours(1));
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(mSettings.stallMs));
+        mStart = Clock::now() - std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(mWritten / std::max(1.0, mBytesPerSecond)));
+      }
+    }
+  }
+
+  // Hold the output to speed x real time
+  void Pace(size_t bytes)
+  {
+    if (mBytesPerSecond <= 0.0)
+      return;
+    const auto due = mStart + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>((mWritten + bytes) / mBytesPerSecond));
+    std::this_thread::sleep_until(due);
+  }
+
+  const FakeSettings& mSettings;
+  Clock::time_point mStart;
+  double mBytesPerSecond = 0.0;
+  std::vector<char> mPending;
+  uint64_t mWritten = 0;
+  bool mStalled = false;
+  bool mFailed = false;
+};
+
+// Saturating s16le gain; 'carry' holds an odd trailing byte between reads
+void ApplyGain(std::vector<char>& bytes, float gain, std::vector<char>& carry)
+{
+  if (!carry.empty())
+  {
+    bytes.insert(bytes.begin(), carry.begin(), carry.end());
+    carry.clear();
+  }
+  if (bytes.size() % 2)
+  {
+    carry.push_back(bytes.back());
+    bytes.pop_back();
+  }
+  for (size_t i = 0; i + 1 < bytes.size(); i += 2)
+  {
+    const int16_t in = static_cast<int16_t>(static_cast<uint8_t>(bytes[i]) | (static_cast<uint8_t>(bytes[i + 1]) << 8));
+    const long out = std::lround(in * gain);
+    const int16_t clamped = static_cast<int16_t>(std::clamp<long>(out, -32768, 32767));
+    bytes[i] = static_cast<char>(clamped & 0xFF);
+    bytes[i + 1] = static_cast<char>((clamped >> 8) & 0xFF);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  FakeSettings settings;
+  if (!ParseSettings(std::getenv("CODECSIM_FAKE_FFMPEG"), settings))
+  {
+    std::fprintf(stderr, "codecsim-fake-ffmpeg: invalid CODECSIM_FAKE_FFMPEG\n");
+    return 2;
+  }
+
+  StreamArgs args;
+  ParseArgs(argc, argv, args);
+  if (args.listEncoders)
+  {
+    ListEncoders(settings);
+    return 0;
+  }
+
+#ifdef _WIN32
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+  const bool isEncoder = args.inputFormat == "s16le" && args.outputFormat != "s16le";
+  const bool isDecoder = args.outputFormat == "s16le" && args.inputFormat != "s16le";
+  const bool active = settings.stage == "both" || (settings.stage == "encoder" && isEncoder) ||
+                      (settings.stage == "decoder" && isDecoder);
+  if (!active)
+    settings = FakeSettings();
+
+  const float gain = static_cast<float>(std::pow(10.0, settings.gainDb / 20.0));
+  const auto latency = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<double, std::milli>(settings.latencyMs));
+
+  ChunkQueue queue(settings.maxQueuedBytes);
+  std::thread reader([&] {
+    std::vector<char> carry;
+    std::vector<char> buffer(kReadChunkBytes);
+    size_t n;
+    while ((n = std::fread(buffer.data(), 1, buffer.size(), stdin)) > 0)
+    {
+      ChunkQueue::Chunk chunk{Clock::now() + latency, std::vector<char>(buffer.begin(), buffer.begin() + n)};
+      if (settings.gainDb != 0.0)
+        ApplyGain(chunk.bytes, gain, carry);
+      queue.Push(std::move(chunk));
+    }
+    if (!carry.empty())
+      queue.Push({Clock::now() + latency, carry});
+    queue.Close();
+  });
+
+  OutputWriter writer(settings, args);
+  if (settings.delayFrames > 0)
+  {
+    const std::vector<char> silence(static_cast<size_t>(settings.delayFrames) * args.channels * 2, 0);
+    writer.Write(silence.data(), silence.size());
+  }
+
+  ChunkQueue::Chunk chunk;
+  while (!writer.Failed() && queue.Pop(chunk))
+  {
+    std::this_thread::sleep_until(chunk.due);
+    writer.Write(chunk.bytes.data(), chunk.bytes.size());
+  }
+  if (!writer.Failed())
+    writer.Finish();
+
+  // A closed downstream pipe leaves the reader blocked on input; exit like ffmpeg would
+  if (writer.Failed())
+  {
+    reader.detach();
+    std::_Exit(1);
+  }
+  reader.join();
+  return 0;
+}
@@ -0,0 +1,149 @@
+//==============================================================================
+// MetricsRead.cpp
+// Prints the live pipeline metrics exported by running CodecSim instances
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: codecsim-metrics-read [--watch MS] (--pid PID | SEGMENT...)
+//
+// SEGMENT is a name shown in the plugin's Metrics tab (see PipelineMetrics.h).
+// --pid probes the instance numbers of one host process. --watch repeats the
+// read every MS milliseconds until interrupted.
+//==============================================================================
+
+#include "../PipelineMetrics.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+constexpr int kMaxProbedInstances = 256;
+
+// Read-only view of one segment; false if it does not exist
+bool ReadSegment(const std::string& name, PipelineMetricsSnapshot& snapshot, uint64_t& publishCount)
+{
+  const PipelineMetricsSegment* segment = nullptr;
+#ifdef _WIN32
+  HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name.c_str());
+  if (!mapping)
+    return false;
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(PipelineMetricsSegment));
+  if (!view)
+  {
+    CloseHandle(mapping);
+    return false;
+  }
+  segment = static_cast<const PipelineMetricsSegment*>(view);
+#else
+  const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  void* view = mmap(nullptr, sizeof(PipelineMetricsSegment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED)
+    return false;
+  segment = static_cast<const PipelineMetricsSegment*>(view);
+#endif
+
+  const bool ok = ReadMetricsSegment(segment, snapshot);
+  publishCount = ok ? segment->publishCount : 0;
+
+#ifdef _WIN32
+  UnmapViewOfFile(view);
+  CloseHandle(mapping);
+#else
+  munmap(view, sizeof(PipelineMetricsSegment));
+#endif
+  return ok;
+}
+
+void PrintSnapshot(const std::string& name, const PipelineMetricsSnapshot& m, uint64_t publishCount)
+{
+  const double rate = m.sampleRate > 0 ? m.sampleRate : 48000.0;
+  auto ms = [rate](uint64_t frames) { return frames * 1000.0 / rate; };
+
+  std::printf("%s  [%s %d Hz %d ch, publish #%llu]\n", name.c_str(), m.codecId, m.sampleRate, m.channels,
+              static_cast<unsigned long long>(publishCount));
+  std::printf("  queues ms     in %.1f  out %.1f  decoded %.1f  first audio %.1f\n",
+              ms(m.inputQueueFrames), ms(m.outputQueueFrames), ms(m.decodedBufferFrames),
+              m.timeToFirstAudioUs / 1000.0);
+  std::printf("  underruns     %llu (%.1f ms)  overruns %llu  restarts %llu (watchdog %llu)\n",
+              static_cast<unsigned long long>(m.underruns), ms(m.underrunFrames),
+              static_cast<unsigned long long>(m.overruns),
+              static_cast<unsigned long long>(m.starts > 0 ? m.starts - 1 : 0),
+              static_cast<unsigned long long>(m.watchdogRestarts));
+  std::printf("  pipe KB/s     in %.1f  out %.1f\n", m.inputBytesPerSecond / 1024.0, m.outputBytesPerSecond / 1024.0);
+  std::printf("  encoder       %.1f%% CPU  %.1f MB\n", m.encoderCpuPercent, m.encoderRssBytes / (1024.0 * 1024.0));
+  std::printf("  decoder       %.1f%% CPU  %.1f MB\n", m.decoderCpuPercent, m.decoderRssBytes / (1024.0 * 1024.0));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  int watchMs = 0;
+  unsigned long pid = 0;
+  std::vector<std::string> names;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    if (arg == "--watch" && i + 1 < argc) watchMs = std::atoi(argv[++i]);
+    else if (arg == "--pid" && i + 1 < argc) pid = std::strtoul(argv[++i], nullptr, 10);
+    else if (!arg.empty() && arg[0] == '-')
+    {
+      std::fprintf(stderr, "Usage: codecsim-metrics-read [--watch MS] (--pid PID | SEGMENT...)\n");
+      return 2;
+    }
+    else names.push_back(arg);
+  }
+
+  if (pid != 0)
+    for (int instance = 1; instance <= kMaxProbedInstances; ++instance)
+      names.push_back(GetMetricsSegmentName(pid, instance));
+
+  if (names.empty())
+  {
+    std::fprintf(stderr, "Usage: codecsim-metrics-read [--watch MS] (--pid PID | SEGMENT...)\n");
+    return 2;
+  }
+
+  for (;;)
+  {
+    int found = 0;
+    for (const auto& name : names)
+    {
+      PipelineMetricsSnapshot snapshot;
+      uint64_t publishCount = 0;
+      if (ReadSegment(name, snapshot, publishCount))
+      {
+        PrintSnapshot(name, snapshot, publishCount);
+        ++found;
+      }
+      else if (pid == 0)
+      {
+        std::fprintf(stderr, "%s: not found or not a CodecSim metrics segment\n", name.c_str());
+      }
+    }
+    if (found == 0 && pid != 0)
+      std::fprintf(stderr, "No CodecSim instances found in process %lu\n", pid);
+
+    if (watchMs <= 0)
+      return found > 0 ? 0 : 1;
+    std::fflush(stdout);
+    std::this_thread::sleep_for(std::chrono::milliseconds(watchMs));
+    std::printf("\n");
+  }
+}
@@ -0,0 +1,319 @@
+//==============================================================================
+// NativeCompare.cpp
+// Checks the in-process codecs against the ffmpeg pipeline, sample for sample
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: codecsim-native-compare [--ffmpeg PATH] [--codecs all|ID,...] [--rate HZ]
+//                                [--channels 1|2] [--seconds N] [--block FRAMES]
+//
+// Renders reference signals (sine, noise, impulses, silence, full-scale square,
+// sweep) through NativeCodecProcessor and GenericCodecProcessor for every codec
+// with a native implementation, lines the two outputs up and counts samples
+// that differ. The native output starts exactly GetLatencySamples() late; the
+// pipeline's delay is found by searching for the offset that matches best.
+// First checks that the s16 <-> float conversions of both paths are exact
+// inverses and agree with each other. Exits 1 if any sample differs, so it
+// can gate a release. Needs a real ffmpeg: codecsim-fake-ffmpeg passes audio
+// through uncoded.
+//==============================================================================
+
+#include "../CodecProcessor.h"
+#include "../CodecRegistry.h"
+#include "../FFmpegPipeManager.h"
+#include "../NativeCodecProcessor.h"
+#include "../NativeCodecs.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+constexpr int kMaxLagFrames = 16384;        // Pipeline delay search range
+constexpr int kFinishTimeoutMs = 10000;
+constexpr int kStallTimeoutMs = 10000;
+
+struct CompareOptions
+{
+  std::string ffmpegPath;
+  std::string codecs = "all";
+  int sampleRate = 48000;
+  int channels = 2;
+  double seconds = 2.0;
+  int blockFrames = 512;
+};
+
+bool ParseArgs(int argc, char** argv, CompareOptions& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char* value = argv[++i];
+    if (arg == "--ffmpeg") options.ffmpegPath = value;
+    else if (arg == "--codecs") options.codecs = value;
+    else if (arg == "--rate") options.sampleRate = std::atoi(value);
+    else if (arg == "--channels") options.channels = std::atoi(value);
+    else if (arg == "--seconds") options.seconds = std::atof(value);
+    else if (arg == "--block") options.blockFrames = std::atoi(value);
+    else return false;
+  }
+  return options.sampleRate > 0 && options.seconds > 0 && options.blockFrames > 0 &&
+         (options.channels == 1 || options.channels == 2);
+}
+
+//==============================================================================
+// Reference signals (interleaved; channel 2 differs so channel mix-ups show)
+//==============================================================================
+struct Signal
+{
+  const char* name;
+  std::vector<float> samples;
+};
+
+std::vector<Signal> MakeSignals(int sampleRate, int channels, size_t frames)
+{
+  const double pi = 3.14159265358979;
+  auto make = [&](const char* name, auto&& value) {
+    Signal signal{name, std::vector<float>(frames * channels)};
+    for (size_t s = 0; s < frames; ++s)
+      for (int c = 0; c < channels; ++c)
+        signal.samples[s * channels + c] = static_cast<float>(value(s, c));
+    return signal;
+  };
+
+  uint32_t noise = 0x2545F491u;
+  const double seconds = static_cast<double>(frames) / sampleRate;
+  std::vector<Signal> signals;
+  signals.push_back(make("sine", [&](size_t s, int c) {
+    return 0.5 * std::sin(2.0 * pi * (c ? 1500.0 : 1000.0) * s / sampleRate);
+  }));
+  signals.push_back(make("noise", [&](size_t, int) {
+    noise = noise * 1664525u + 1013904223u;
+    return 0.7 * (static_cast<double>(noise >> 8) / 8388608.0 - 1.0);
+  }));
+  signals.push_back(make("impulses", [&](size_t s, int c) {
+    return (s + c * 37) % 4801 == 0 ? 0.9 : 0.0;
+  }));
+  signals.push_back(make("silence", [](size_t, int) { return 0.0; }));
+  signals.push_back(make("full-scale", [&](size_t s, int c) {
+    return ((s / 24 + c) % 2) ? 1.0 : -1.0;  // Clips to the s16 limits
+  }));
+  signals.push_back(make("sweep", [&](size_t s, int) {
+    const double t = static_cast<double>(s) / sampleRate;
+    return 0.8 * std::sin(2.0 * pi * (20.0 * t + (sampleRate / 2.0 - 20.0) * t * t / (2.0 * seconds)));
+  }));
+  return signals;
+}
+
+//==============================================================================
+// Rendering
+//==============================================================================
+
+// Everything the processor returns for the signal, including its leading delay
+bool Render(ICodecProcessor& processor, const CompareOptions& options, const std::vector<float>& input,
+            std::vector<float>& output)
+{
+  const size_t ch = static_cast<size_t>(options.channels);
+  const size_t frames = input.size() / ch;
+  const int maxOut = options.blockFrames + kMaxLagFrames;
+  std::vector<float> block(static_cast<size_t>(maxOut) * ch);
+  output.clear();
+
+  auto append = [&](int got) { output.insert(output.end(), block.begin(), block.begin() + got * ch); };
+  for (size_t pos = 0; pos < frames; pos += options.blockFrames)
+  {
+    const int n = static_cast<int>(std::min(frames - pos, static_cast<size_t>(options.blockFrames)));
+    append(processor.ProcessBlocking(input.data() + pos * ch, n, block.data(), 0, maxOut, kStallTimeoutMs));
+  }
+  if (!processor.Finish(kFinishTimeoutMs))
+    return false;
+  int got;
+  while ((got = processor.Process(nullptr, 0, block.data(), maxOut)) > 0)
+    append(got);
+  return true;
+}
+
+struct Comparison
+{
+  size_t compared = 0;    // Samples
+  size_t mismatched = 0;
+  int pipelineDelay = -1; // Frames
+  float maxDiff = 0.0f;
+};
+
+// 'native' starts nativeDelay frames late; the pipeline's delay is searched for
+Comparison Compare(const std::vector<float>& native, int nativeDelay, const std::vector<float>& pipeline,
+                   size_t frames, int channels)
+{
+  Comparison result;
+  const size_t ch = static_cast<size_t>(channels);
+  const size_t nativeStart = static_cast<size_t>(nativeDelay) * ch;
+  if (native.size() < nativeStart + frames * ch)
+    return result;
+  const float* ref = native.data() + nativeStart;
+
+  // Best offset over the first block's worth of frames (exact matches count)
+  const size_t probe = std::min<size_t>(frames, 4096) * ch;
+  size_t bestMatches = 0;
+  for (int lag = 0; lag <= kMaxLagFrames; ++lag)
+  {
+    const size_t start = static_cast<size_t>(lag) * ch;
+    if (pipeline.size() < start + probe)
+      break;
+    size_t matches = 0;
+    for (size_t i = 0; i < probe; ++i)
+      matches += ref[i] == pipeline[start + i];
+    if (result.pipelineDelay < 0 || matches > bestMatches)
+    {
+      bestMatches = matches;
+      result.pipelineDelay = lag;
+    }
+  }
+  if (result.pipelineDelay < 0)
+    return result;
+
+  const size_t start = static_cast<size_t>(result.pipelineDelay) * ch;
+  result.compared = std::min(frames * ch, pipeline.size() - start);
+  result.mismatched = frames * ch - result.compared;  // Missing tail counts as different
+  for (size_t i = 0; i < result.compared; ++i)
+  {
+    const float diff = std::fabs(ref[i] - pipeline[start + i]);
+    if (diff != 0.0f)
+    {
+      ++result.mismatched;
+      result.maxDiff = std::max(result.maxDiff, diff);
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+// Sample conversion
+//==============================================================================
+
+// Every s16 value must survive s16 -> float -> s16 through both the pipe's and
+// the native conversion, and the two float -> s16 paths must agree on any
+// input (ties, out of range, NaN); returns the number of failures
+size_t CheckS16Conversions()
+{
+  std::vector<int16_t> all(65536);
+  for (size_t i = 0; i < all.size(); ++i)
+    all[i] = static_cast<int16_t>(static_cast<int>(i) - 32768);
+
+  std::vector<float> pipeFloat(all.size()), nativeFloat(all.size());
+  std::vector<int16_t> pipeBack(all.size()), nativeBack(all.size());
+  FFmpegPipeManager::S16LEToFloat(all.data(), pipeFloat.data(), all.size());
+  FFmpegPipeManager::FloatToS16LE(pipeFloat.data(), pipeBack.data(), all.size());
+  NativeCodecs::S16ToFloat(all.data(), nativeFloat.data(), all.size());
+  NativeCodecs::FloatToS16(nativeFloat.data(), nativeBack.data(), all.size());
+
+  size_t failures = 0;
+  for (size_t i = 0; i < all.size(); ++i)
+    failures += pipeBack[i] != all[i] || nativeBack[i] != all[i] || pipeFloat[i] != nativeFloat[i];
+
+  std::vector<float> probe;
+  for (int i = -70000; i <= 70000; ++i)
+    probe.push_back(static_cast<float>(i) / 65536.0f);  // Half-LSB steps: every other one is a tie
+  probe.insert(probe.end(), {-4.0f, 4.0f, std::nanf("")});
+  std::vector<int16_t> pipeS16(probe.size()), nativeS16(probe.size());
+  FFmpegPipeManager::FloatToS16LE(probe.data(), pipeS16.data(), probe.size());
+  NativeCodecs::FloatToS16(probe.data(), nativeS16.data(), probe.size());
+  for (size_t i = 0; i < probe.size(); ++i)
+    failures += pipeS16[i] != nativeS16[i];
+  return failures;
+}
+
+std::vector<const CodecInfo*> SelectNativeCodecs(const std::string& spec)
+{
+  std::vector<const CodecInfo*> codecs;
+  CodecRegistry& registry = CodecRegistry::Instance();
+  for (const CodecInfo* codec : registry.GetAvailable())
+  {
+    if (codec->native == NativeCodec::None)
+      continue;
+    if (codec->native == NativeCodec::Opus)
+      continue;  // Lossy and not bit-exact with ffmpeg's own Opus decoder
+    if (spec == "all" || ("," + spec + ",").find("," + std::string(codec->id) + ",") != std::string::npos)
+      codecs.push_back(codec);
+  }
+  return codecs;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  CompareOptions options;
+  if (!ParseArgs(argc, argv, options))
+  {
+    std::fprintf(stderr, "usage: %s [--ffmpeg PATH] [--codecs all|ID,...] [--rate HZ] [--channels 1|2]\n"
+                         "          [--seconds N] [--block FRAMES]\n", argv[0]);
+    return 2;
+  }
+  if (options.ffmpegPath.empty())
+    options.ffmpegPath = FFmpegPipeManager::ResolveFFmpegPath();
+  CodecRegistry::Instance().DetectAvailable(options.ffmpegPath);
+
+  const size_t conversionFailures = CheckS16Conversions();
+  std::printf("s16 conversion: %s (%zu failures)\n\n", conversionFailures == 0 ? "exact" : "MISMATCH",
+              conversionFailures);
+
+  const size_t frames = static_cast<size_t>(options.seconds * options.sampleRate);
+  bool allMatch = conversionFailures == 0;
+  int compared = 0;
+
+  std::printf("%-14s %-11s %8s %8s %12s %10s\n", "codec", "signal", "native", "ffmpeg", "mismatched", "max diff");
+  for (const CodecInfo* codec : SelectNativeCodecs(options.codecs))
+  {
+    const std::string id(codec->id);
+    const int channels = codec->monoOnly ? 1 : options.channels;
+    CompareOptions run = options;
+    run.channels = channels;
+
+    for (const Signal& signal : MakeSignals(options.sampleRate, channels, frames))
+    {
+      std::unique_ptr<ICodecProcessor> native = CreateNativeCodecProcessor(*codec);
+      GenericCodecProcessor pipeline(*codec);
+      pipeline.SetFFmpegPath(options.ffmpegPath);
+      if (!native->Initialize(options.sampleRate, channels) || !pipeline.Initialize(options.sampleRate, channels))
+      {
+        std::printf("%-14s %-11s cannot start\n", id.c_str(), signal.name);
+        allMatch = false;
+        continue;
+      }
+
+      std::vector<float> nativeOut, pipelineOut;
+      const bool rendered = Render(*native, run, signal.samples, nativeOut) &&
+                            Render(pipeline, run, signal.samples, pipelineOut);
+      pipeline.Shutdown();
+      if (!rendered)
+      {
+        std::printf("%-14s %-11s render failed\n", id.c_str(), signal.name);
+        allMatch = false;
+        continue;
+      }
+
+      const Comparison c = Compare(nativeOut, native->GetLatencySamples(), pipelineOut, frames, channels);
+      std::printf("%-14s %-11s %8d %8d %12zu %10.6f\n", id.c_str(), signal.name, native->GetLatencySamples(),
+                  c.pipelineDelay, c.mismatched, c.maxDiff);
+      allMatch = allMatch && c.pipelineDelay >= 0 && c.mismatched == 0;
+      ++compared;
+    }
+  }
+
+  if (compared == 0)
+  {
+    std::fprintf(stderr, "no native codec available in %s\n", options.ffmpegPath.c_str());
+    return 2;
+  }
+  std::printf("\n%s\n", allMatch ? "all outputs identical" : "MISMATCH");
+  return allMatch ? 0 : 1;
+}
@@ -0,0 +1,787 @@
+//==============================================================================
+// PipelineBench.cpp
+// Real-time path benchmarks: conversions, pipe I/O, ProcessBlock, round trip
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: codecsim-bench-pipeline [--ffmpeg PATH] [--json FILE] [--block FRAMES]
+//                                [--channels 1|2] [--rate HZ] [--iterations N]
+//                                [--seconds N] [--codecs all|ID,...] [--kernels-only]
+//                                [--trace FILE]
+//
+// Kernels (no processes, --iterations blocks each):
+//   FloatToS16LE / S16LEToFloat   FFmpegPipeManager's sample conversions
+//   native-alaw/mulaw/dfpwm       NativeCodecs round trips (in-process codec, float in/out)
+//   native-adpcm_*                NativeCodecProcessor::Process for the ADPCM block codecs
+//                                 (a whole block is coded on the call that completes it,
+//                                 so p99/max show the block cost)
+//   native-opus-*                 LibOpusProcessor::Process at 2.5 / 20 ms frames (CODECSIM_LIBOPUS builds)
+//   interleave                    InterleaveHostBlock (host planar double -> float)
+//   deque-output                  AccumulateDecoded + DrainToHostBlock, steady state
+//   trace-event                   TraceRecorder::Record (CODECSIM_TRACE builds; "ns/frame"
+//                                 is ns/event, 64 events per block)
+//
+// Pipeline (real-time paced host loop for --seconds each):
+//   WriteSamples / ReadSamples    FFmpegPipeManager calls on the host thread
+//   process-block                 Interleave + GenericCodecProcessor::Process + deque
+//                                 output, as in CodecSim::ProcessBlock
+//   round-trip                    Per codec: start-up time, time to first audio and
+//                                 the measured delay of a click (frames and wall time)
+//
+// Every timed stage reports ns/frame, p50/p99/p99.9/max block time and heap
+// allocations per block on the host thread. --json writes the same figures
+// with the version and block setup, so runs can be compared across releases.
+// Without a real ffmpeg, point --ffmpeg at codecsim-fake-ffmpeg: the pipeline
+// stages then measure the plumbing alone (round trip = pipe + pacing only).
+// --trace writes the pipeline's trace events (CODECSIM_TRACE builds) as
+// Chrome trace JSON.
+//==============================================================================
+
+#include "../BlockBuffers.h"
+#include "../CodecProcessor.h"
+#include "../CodecRegistry.h"
+#include "../FFmpegPipeManager.h"
+#include "../NativeCodecProcessor.h"
+#include "../NativeCodecs.h"
+#include "../TraceRecorder.h"
+#include "../config.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//==============================================================================
+// Heap allocation counter (host thread only: each thread counts its own)
+//==============================================================================
+namespace
+{
+thread_local uint64_t tAllocations = 0;
+}
+
+void* operator new(size_t size)
+{
+  ++tAllocations;
+  if (void* p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxBlockFrames = 8192;       // CodecSim::ProcessBlock's clamp
+constexpr int kRoundTripTimeoutMs = 10000;  // Per codec: first audio + click
+constexpr float kClickLevel = 0.8f;
+constexpr int kClickFrames = 32;
+
+struct BenchOptions
+{
+  std::string ffmpegPath;
+  std::string jsonPath;
+  std::string tracePath;
+  std::string codecs = "all";
+  int blockFrames = 256;
+  int channels = 2;
+  int sampleRate = 48000;
+  int iterations = 20000;
+  double seconds = 3.0;
+  bool kernelsOnly = false;
+};
+
+bool ParseArgs(int argc, char** argv, BenchOptions& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--kernels-only")
+    {
+      options.kernelsOnly = true;
+      continue;
+    }
+    if (i + 1 >= argc)
+      return false;
+    const char* value = argv[++i];
+    if (arg == "--ffmpeg") options.ffmpegPath = value;
+    else if (arg == "--json") options.jsonPath = value;
+    else if (arg == "--trace") options.tracePath = value;
+    else if (arg == "--codecs") options.codecs = value;
+    else if (arg == "--block") options.blockFrames = std::atoi(value);
+    else if (arg == "--channels") options.channels = std::atoi(value);
+    else if (arg == "--rate") options.sampleRate = std::atoi(value);
+    else if (arg == "--iterations") options.iterations = std::atoi(value);
+    else if (arg == "--seconds") options.seconds = std::atof(value);
+    else return false;
+  }
+  return options.blockFrames > 0 && options.blockFrames <= kMaxBlockFrames && options.iterations > 0 &&
+         options.seconds > 0 && options.sampleRate > 0 && (options.channels == 1 || options.channels == 2);
+}
+
+//==============================================================================
+// Timing statistics
+//==============================================================================
+struct StageResult
+{
+  std::string name;
+  std::string codec;                // Pipeline stages only
+  long blocks = 0;
+  double nsPerFrame = 0.0;
+  double p50Ns = 0.0, p99Ns = 0.0, p999Ns = 0.0, maxNs = 0.0;
+  double allocationsPerBlock = 0.0;
+};
+
+// Block timings are stored up front so recording never allocates
+class BlockTimer
+{
+public:
+  BlockTimer(std::string name, size_t capacity) : mName(std::move(name)) { mSamples.reserve(capacity); }
+
+  void Begin()
+  {
+    mAllocationsAtBegin = tAllocations;
+    mBegin = Clock::now();
+  }
+
+  void End()
+  {
+    const auto elapsed = Clock::now() - mBegin;
+    mAllocations += tAllocations - mAllocationsAtBegin;
+    if (mSamples.size() < mSamples.capacity())
+      mSamples.push_back(std::chrono::duration<double, std::nano>(elapsed).count());
+  }
+
+  StageResult Finish(int framesPerBlock)
+  {
+    StageResult r;
+    r.name = mName;
+    r.blocks = static_cast<long>(mSamples.size());
+    if (mSamples.empty())
+      return r;
+    double total = 0.0;
+    for (double ns : mSamples)
+      total += ns;
+    std::sort(mSamples.begin(), mSamples.end());
+    auto percentile = [&](double p) {
+      const size_t index = static_cast<size_t>(std::ceil(p * mSamples.size())) - 1;
+      return mSamples[std::min(index, mSamples.size() - 1)];
+    };
+    r.nsPerFrame = total / (static_cast<double>(mSamples.size()) * framesPerBlock);
+    r.p50Ns = percentile(0.50);
+    r.p99Ns = percentile(0.99);
+    r.p999Ns = percentile(0.999);
+    r.maxNs = mSamples.back();
+    r.allocationsPerBlock = static_cast<double>(mAllocations) / mSamples.size();
+    return r;
+  }
+
+private:
+  std::string mName;
+  std::vector<double> mSamples;
+  Clock::time_point mBegin;
+  uint64_t mAllocationsAtBegin = 0;
+  uint64_t mAllocations = 0;
+};
+
+// Deterministic test signal (a 440 Hz tone with a little noise)
+void FillSignal(float* dst, int frames, int channels, uint64_t& position, int sampleRate)
+{
+  uint32_t noise = 0x12345678u ^ static_cast<uint32_t>(position);
+  for (int s = 0; s < frames; ++s, ++position)
+  {
+    noise = noise * 1664525u + 1013904223u;
+    const float v = 0.3f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 440.0 * position / sampleRate)) +
+                    0.01f * (static_cast<float>(noise >> 8) / 8388608.0f - 1.0f);
+    for (int c = 0; c < channels; ++c)
+      dst[s * channels + c] = v;
+  }
+}
+
+// Keeps the optimiser from discarding benchmarked work
+volatile float gSink = 0.0f;
+
+//==============================================================================
+// Kernels
+//==============================================================================
+std::vector<StageResult> RunKernels(const BenchOptions& options)
+{
+  std::vector<StageResult> results;
+  const int frames = options.blockFrames;
+  const int ch = options.channels;
+  const size_t samples = static_cast<size_t>(frames) * ch;
+
+  std::vector<float> floats(samples);
+  std::vector<int16_t> shorts(samples);
+  uint64_t position = 0;
+  FillSignal(floats.data(), frames, ch, position, options.sampleRate);
+
+  {
+    BlockTimer timer("FloatToS16LE", options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      FFmpegPipeManager::FloatToS16LE(floats.data(), shorts.data(), samples);
+      timer.End();
+      gSink = gSink + shorts[i % samples];
+    }
+    results.push_back(timer.Finish(frames));
+  }
+  {
+    BlockTimer timer("S16LEToFloat", options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      FFmpegPipeManager::S16LEToFloat(shorts.data(), floats.data(), samples);
+      timer.End();
+      gSink = gSink + floats[i % samples];
+    }
+    results.push_back(timer.Finish(frames));
+  }
+  {
+    // In-process codecs: the whole encode + decode a native processor runs per block
+    std::vector<float> decoded(samples);
+    NativeCodecs::DfpwmEncoder encoder;
+    NativeCodecs::DfpwmDecoder decoder;
+    const std::pair<const char*, std::function<void()>> natives[] = {
+      {"native-alaw", [&] { NativeCodecs::G711RoundTrip(NativeCodecs::G711Law::ALaw, floats.data(), decoded.data(), samples); }},
+      {"native-mulaw", [&] { NativeCodecs::G711RoundTrip(NativeCodecs::G711Law::MuLaw, floats.data(), decoded.data(), samples); }},
+      {"native-dfpwm", [&] { NativeCodecs::DfpwmRoundTrip(encoder, decoder, floats.data(), decoded.data(), samples); }},
+    };
+    for (const auto& native : natives)
+    {
+      native.second();  // Builds the tables outside the timing
+      BlockTimer timer(native.first, options.iterations);
+      for (int i = 0; i < options.iterations; ++i)
+      {
+        timer.Begin();
+        native.second();
+        timer.End();
+        gSink = gSink + decoded[i % samples];
+      }
+      results.push_back(timer.Finish(frames));
+    }
+  }
+  for (const char* id : {"adpcm_ima", "adpcm_ms", "adpcm_yamaha"})
+  {
+    const CodecInfo* codec = CodecRegistry::Instance().GetById(id);
+    NativeCodecProcessor processor(*codec);
+    if (!processor.Initialize(options.sampleRate, ch))
+      continue;
+    std::vector<float> decoded(samples);
+    BlockTimer timer(std::string("native-") + id, options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      processor.Process(floats.data(), frames, decoded.data(), frames);
+      timer.End();
+      gSink = gSink + decoded[i % samples];
+    }
+    results.push_back(timer.Finish(frames));
+  }
+#if CODECSIM_HAS_LIBOPUS
+  // libopus at the shortest and the default frame duration (needs a rate libopus runs at)
+  for (const auto& [name, frameChoice] : {std::pair<const char*, int>{"native-opus-2.5ms", 0}, {"native-opus-20ms", 3}})
+  {
+    const CodecInfo* codec = CodecRegistry::Instance().GetById("opus");
+    std::unique_ptr<ICodecProcessor> processor =
+      CreateNativeCodecProcessor(*codec, {{"opus_frame", frameChoice}}, 0, options.sampleRate);
+    if (!processor || !processor->Initialize(options.sampleRate, ch))
+      continue;
+    std::vector<float> decoded(samples);
+    BlockTimer timer(name, options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      processor->Process(floats.data(), frames, decoded.data(), frames);
+      timer.End();
+      gSink = gSink + decoded[i % samples];
+    }
+    results.push_back(timer.Finish(frames));
+  }
+#endif
+
+  // Host-side buffers as iPlug2 hands them over (planar double, stereo)
+  std::vector<double> planar[2] = {std::vector<double>(frames), std::vector<double>(frames)};
+  double* host[2] = {planar[0].data(), planar[1].data()};
+  for (int s = 0; s < frames; ++s)
+  {
+    planar[0][s] = floats[static_cast<size_t>(s) * ch];
+    planar[1][s] = floats[static_cast<size_t>(s) * ch + ch - 1];
+  }
+
+  {
+    BlockTimer timer("interleave", options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      InterleaveHostBlock(host, 2, frames, ch, floats.data());
+      timer.End();
+      gSink = gSink + floats[i % samples];
+    }
+    results.push_back(timer.Finish(frames));
+  }
+  {
+    // Steady state: one block in, one block out, a block of slack buffered
+    std::deque<float> decoded;
+    AccumulateDecoded(decoded, floats.data(), frames, ch);
+    BlockTimer timer("deque-output", options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      AccumulateDecoded(decoded, floats.data(), frames, ch);
+      DrainToHostBlock(decoded, host, 2, frames, ch);
+      timer.End();
+      gSink = gSink + static_cast<float>(host[0][i % frames]);
+    }
+    results.push_back(timer.Finish(frames));
+  }
+#if CODECSIM_TRACE
+  // On its own thread (own ring), so --trace keeps the host thread's events.
+  // Batches, so the timer's own clock reads do not dominate.
+  std::thread([&]() {
+    constexpr int kEventsPerBlock = 64;
+    CODECSIM_TRACE_THREAD_NAME("trace-bench");  // Ring allocation is not timed
+    BlockTimer timer("trace-event", options.iterations);
+    for (int i = 0; i < options.iterations; ++i)
+    {
+      timer.Begin();
+      for (int e = 0; e < kEventsPerBlock; ++e)
+        TraceRecorder::Record(TraceEventType::Counter, "trace-bench", e);
+      timer.End();
+    }
+    results.push_back(timer.Finish(kEventsPerBlock));
+  }).join();
+#endif
+  return results;
+}
+
+//==============================================================================
+// Pipeline stages (paced like a host callback)
+//==============================================================================
+class BlockClock
+{
+public:
+  BlockClock(int blockFrames, int sampleRate)
+    : mPeriod(std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(blockFrames) / sampleRate))),
+      mNext(Clock::now())
+  {
+  }
+
+  void Wait()
+  {
+    mNext += mPeriod;
+    std::this_thread::sleep_until(mNext);
+  }
+
+private:
+  Clock::duration mPeriod;
+  Clock::time_point mNext;
+};
+
+const CodecInfo* FirstLossyCodec(const std::vector<const CodecInfo*>& codecs)
+{
+  for (const CodecInfo* codec : codecs)
+  {
+    if (!codec->isLossless && !codec->monoOnly)
+      return codec;
+  }
+  return codecs.empty() ? nullptr : codecs.front();
+}
+
+std::vector<StageResult> RunPipeIO(const BenchOptions& options, const CodecInfo& codec)
+{
+  std::vector<StageResult> results;
+  const int frames = options.blockFrames;
+  const int ch = codec.monoOnly ? 1 : options.channels;
+
+  FFmpegPipeManager::Config config;
+  config.ffmpegPath = options.ffmpegPath;
+  config.codecName = std::string(codec.encoderName);
+  config.muxerFormat = std::string(codec.muxerFormat);
+  config.demuxerFormat = std::string(codec.demuxerFormat);
+  config.additionalArgs = std::string(codec.additionalArgs);
+  config.sampleRate = options.sampleRate;
+  config.channels = ch;
+  config.bitrate = codec.defaultBitrate * 1000;
+
+  FFmpegPipeManager pipeline;
+  if (!pipeline.Start(config))
+  {
+    std::fprintf(stderr, "pipe-io: failed to start %s: %s\n", config.codecName.c_str(),
+                 pipeline.GetLastErrorMessage().c_str());
+    return results;
+  }
+
+  const long blocks = static_cast<long>(options.seconds * options.sampleRate / frames);
+  std::vector<float> input(static_cast<size_t>(frames) * ch);
+  std::vector<float> output(static_cast<size_t>(kMaxBlockFrames) * ch);
+  uint64_t position = 0;
+  BlockTimer writeTimer("WriteSamples", blocks);
+  BlockTimer readTimer("ReadSamples", blocks);
+  BlockClock clock(frames, options.sampleRate);
+
+  for (long b = 0; b < blocks; ++b)
+  {
+    FillSignal(input.data(), frames, ch, position, options.sampleRate);
+    writeTimer.Begin();
+    pipeline.WriteSamples(input.data(), frames);
+    writeTimer.End();
+    readTimer.Begin();
+    pipeline.ReadSamples(output.data(), kMaxBlockFrames, 0);
+    readTimer.End();
+    clock.Wait();
+  }
+  pipeline.Stop();
+
+  for (BlockTimer* timer : {&writeTimer, &readTimer})
+  {
+    StageResult r = timer->Finish(frames);
+    r.codec = std::string(codec.id);
+    results.push_back(r);
+  }
+  return results;
+}
+
+StageResult RunProcessBlock(const BenchOptions& options, const CodecInfo& codec)
+{
+  StageResult result;
+  const int frames = options.blockFrames;
+  const int ch = codec.monoOnly ? 1 : options.channels;
+
+  GenericCodecProcessor processor(codec);
+  processor.SetFFmpegPath(options.ffmpegPath);
+  if (!processor.Initialize(options.sampleRate, ch))
+  {
+    std::fprintf(stderr, "process-block: failed to start %s\n", std::string(codec.id).c_str());
+    return result;
+  }
+
+  // CodecSim::ProcessBlock's buffers: planar host I/O, interleaved scratch, deque
+  std::vector<double> planarIn[2] = {std::vector<double>(frames), std::vector<double>(frames)};
+  std::vector<double> planarOut[2] = {std::vector<double>(frames), std::vector<double>(frames)};
+  double* inputs[2] = {planarIn[0].data(), planarIn[1].data()};
+  double* outputs[2] = {planarOut[0].data(), planarOut[1].data()};
+  std::vector<float> signal(static_cast<size_t>(frames) * 2);
+  std::vector<float> inBuf(static_cast<size_t>(kMaxBlockFrames) * 2);
+  std::vector<float> outBuf(static_cast<size_t>(kMaxBlockFrames) * 2);
+  std::deque<float> decoded;
+  uint64_t position = 0;
+
+  const long blocks = static_cast<long>(options.seconds * options.sampleRate / frames);
+  BlockTimer timer("process-block", blocks);
+  BlockClock clock(frames, options.sampleRate);
+
+  for (long b = 0; b < blocks; ++b)
+  {
+    FillSignal(signal.data(), frames, 2, position, options.sampleRate);
+    for (int s = 0; s < frames; ++s)
+    {
+      inputs[0][s] = signal[static_cast<size_t>(s) * 2];
+      inputs[1][s] = signal[static_cast<size_t>(s) * 2 + 1];
+    }
+
+    timer.Begin();
+    for (int c = 0; c < 2; ++c)
+      std::fill(outputs[c], outputs[c] + frames, 0.0);
+    InterleaveHostBlock(inputs, 2, frames, ch, inBuf.data());
+    const int got = processor.Process(inBuf.data(), frames, outBuf.data(), kMaxBlockFrames);
+    AccumulateDecoded(decoded, outBuf.data(), got, ch);
+    DrainToHostBlock(decoded, outputs, 2, frames, ch);
+    timer.End();
+    clock.Wait();
+  }
+  processor.Shutdown();
+
+  result = timer.Finish(frames);
+  result.codec = std::string(codec.id);
+  return result;
+}
+
+//==============================================================================
+// Round trip
+//==============================================================================
+struct RoundTripResult
+{
+  std::string codec;
+  bool ok = false;
+  std::string error;
+  int reportedLatency = 0;          // GetLatencySamples()
+  long measuredLatency = -1;        // Click position out - in (frames)
+  double startupMs = 0.0;           // Initialize()
+  double firstAudioMs = 0.0;        // First write -> first decoded frame
+  double clickWallMs = 0.0;         // Click written -> click read back
+};
+
+RoundTripResult RunRoundTrip(const BenchOptions& options, const CodecInfo& codec)
+{
+  RoundTripResult result;
+  result.codec = std::string(codec.id);
+  const int frames = options.blockFrames;
+  const int ch = codec.monoOnly ? 1 : options.channels;
+
+  GenericCodecProcessor processor(codec);
+  processor.SetFFmpegPath(options.ffmpegPath);
+  const auto startTime = Clock::now();
+  if (!processor.Initialize(options.sampleRate, ch))
+  {
+    result.error = "failed to start";
+    return result;
+  }
+  const auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+  result.startupMs = ms(Clock::now() - startTime);
+  result.reportedLatency = processor.GetLatencySamples();
+
+  std::vector<float> input(static_cast<size_t>(frames) * ch, 0.0f);
+  std::vector<float> output(static_cast<size_t>(kMaxBlockFrames) * ch);
+  BlockClock clock(frames, options.sampleRate);
+
+  // Silence until the pipeline delivers, then a quarter second more, then the click
+  const auto firstWrite = Clock::now();
+  const long silenceAfterFirstAudio = options.sampleRate / 4;
+  int64_t written = 0, read = 0, clickAt = -1;
+  int64_t firstAudioAt = -1;
+  Clock::time_point clickTime;
+
+  while (ms(Clock::now() - firstWrite) < kRoundTripTimeoutMs)
+  {
+    std::fill(input.begin(), input.end(), 0.0f);
+    if (clickAt < 0 && firstAudioAt >= 0 && written >= firstAudioAt + silenceAfterFirstAudio)
+    {
+      clickAt = written;
+      clickTime = Clock::now();
+      for (int s = 0; s < std::min(kClickFrames, frames); ++s)
+        for (int c = 0; c < ch; ++c)
+          input[static_cast<size_t>(s) * ch + c] = kClickLevel;
+    }
+
+    const int got = processor.Process(input.data(), frames, output.data(), kMaxBlockFrames);
+    written += frames;
+    if (got > 0 && firstAudioAt < 0)
+    {
+      firstAudioAt = written;
+      result.firstAudioMs = ms(Clock::now() - firstWrite);
+    }
+    if (clickAt >= 0)
+    {
+      for (int s = 0; s < got; ++s)
+      {
+        if (std::fabs(output[static_cast<size_t>(s) * ch]) > kClickLevel * 0.3f)
+        {
+          result.measuredLatency = static_cast<long>(read + s - clickAt);
+          result.clickWallMs = ms(Clock::now() - clickTime);
+          result.ok = true;
+          break;
+        }
+      }
+    }
+    read += got;
+    if (result.ok)
+      break;
+    clock.Wait();
+  }
+  processor.Shutdown();
+
+  if (!result.ok)
+    result.error = firstAudioAt < 0 ? "no decoded output" : "click not found in output";
+  return result;
+}
+
+//==============================================================================
+// Reporting
+//==============================================================================
+void PrintStages(const std::vector<StageResult>& stages)
+{
+  std::printf("%-20s %-10s %8s %10s %10s %10s %10s %10s %8s\n", "stage", "codec", "blocks", "ns/frame", "p50 us",
+              "p99 us", "p99.9 us", "max us", "allocs");
+  for (const StageResult& r : stages)
+  {
+    std::printf("%-20s %-10s %8ld %10.2f %10.2f %10.2f %10.2f %10.2f %8.2f\n", r.name.c_str(),
+                r.codec.empty() ? "-" : r.codec.c_str(), r.blocks, r.nsPerFrame, r.p50Ns / 1000.0, r.p99Ns / 1000.0,
+                r.p999Ns / 1000.0, r.maxNs / 1000.0, r.allocationsPerBlock);
+  }
+}
+
+void PrintRoundTrips(const std::vector<RoundTripResult>& trips)
+{
+  if (trips.empty())
+    return;
+  std::printf("\n%-14s %10s %10s %10s %12s %10s\n", "round-trip", "reported", "measured", "startup ms",
+              "first audio", "click ms");
+  for (const RoundTripResult& r : trips)
+  {
+    if (!r.ok)
+    {
+      std::printf("%-14s FAIL %s\n", r.codec.c_str(), r.error.c_str());
+      continue;
+    }
+    std::printf("%-14s %10d %10ld %10.1f %12.1f %10.1f\n", r.codec.c_str(), r.reportedLatency, r.measuredLatency,
+                r.startupMs, r.firstAudioMs, r.clickWallMs);
+  }
+}
+
+std::string JsonString(const std::string& value)
+{
+  std::string out = "\"";
+  for (char c : value)
+  {
+    if (c == '"' || c == '\\')
+      out += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20)
+      out += c;
+  }
+  return out + "\"";
+}
+
+bool WriteJson(const std::string& path, const BenchOptions& options, const std::vector<StageResult>& stages,
+               const std::vector<RoundTripResult>& trips)
+{
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  char timestamp[32] = {};
+  const std::time_t now = std::time(nullptr);
+  std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  std::fprintf(file, "{\n  \"version\": %s,\n  \"timestamp\": %s,\n  \"ffmpeg\": %s,\n", JsonString(PLUG_VERSION_STR).c_str(),
+               JsonString(timestamp).c_str(), JsonString(options.ffmpegPath).c_str());
+  std::fprintf(file, "  \"block_frames\": %d,\n  \"channels\": %d,\n  \"sample_rate\": %d,\n  \"hardware_threads\": %u,\n",
+               options.blockFrames, options.channels, options.sampleRate, std::thread::hardware_concurrency());
+
+  std::fprintf(file, "  \"stages\": [\n");
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    const StageResult& r = stages[i];
+    std::fprintf(file,
+                 "    {\"name\": %s, \"codec\": %s, \"blocks\": %ld, \"ns_per_frame\": %.3f, \"p50_ns\": %.0f, "
+                 "\"p99_ns\": %.0f, \"p999_ns\": %.0f, \"max_ns\": %.0f, \"allocations_per_block\": %.3f}%s\n",
+                 JsonString(r.name).c_str(), JsonString(r.codec).c_str(), r.blocks, r.nsPerFrame, r.p50Ns, r.p99Ns,
+                 r.p999Ns, r.maxNs, r.allocationsPerBlock, i + 1 < stages.size() ? "," : "");
+  }
+  std::fprintf(file, "  ],\n  \"round_trip\": [\n");
+  for (size_t i = 0; i < trips.size(); ++i)
+  {
+    const RoundTripResult& r = trips[i];
+    std::fprintf(file,
+                 "    {\"codec\": %s, \"ok\": %s, \"reported_latency\": %d, \"measured_latency\": %ld, "
+                 "\"startup_ms\": %.2f, \"first_audio_ms\": %.2f, \"click_ms\": %.2f, \"error\": %s}%s\n",
+                 JsonString(r.codec).c_str(), r.ok ? "true" : "false", r.reportedLatency, r.measuredLatency,
+                 r.startupMs, r.firstAudioMs, r.clickWallMs, JsonString(r.error).c_str(),
+                 i + 1 < trips.size() ? "," : "");
+  }
+  std::fprintf(file, "  ]\n}\n");
+  return std::fclose(file) == 0;
+}
+
+std::vector<const CodecInfo*> SelectCodecs(const std::string& spec)
+{
+  std::vector<const CodecInfo*> codecs;
+  CodecRegistry& registry = CodecRegistry::Instance();
+  if (spec == "all")
+  {
+    for (const CodecInfo* codec : registry.GetAvailable())
+      codecs.push_back(codec);
+    return codecs;
+  }
+  size_t pos = 0;
+  while (pos <= spec.size())
+  {
+    size_t end = spec.find(',', pos);
+    if (end == std::string::npos)
+      end = spec.size();
+    const std::string id = spec.substr(pos, end - pos);
+    if (const CodecInfo* codec = registry.GetById(id); codec && registry.IsAvailable(id))
+      codecs.push_back(codec);
+    else if (!id.empty())
+      std::fprintf(stderr, "skipping unavailable codec: %s\n", id.c_str());
+    pos = end + 1;
+  }
+  return codecs;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+  if (!ParseArgs(argc, argv, options))
+  {
+    std::fprintf(stderr, "usage: %s [--ffmpeg PATH] [--json FILE] [--block FRAMES] [--channels 1|2]\n"
+                         "          [--rate HZ] [--iterations N] [--seconds N] [--codecs all|ID,...]\n"
+                         "          [--kernels-only] [--trace FILE]\n", argv[0]);
+    return 2;
+  }
+  if (!CODECSIM_TRACE && !options.tracePath.empty())
+  {
+    std::fprintf(stderr, "--trace needs a build with -DCODECSIM_TRACE=ON\n");
+    return 2;
+  }
+  CODECSIM_TRACE_THREAD_NAME("host");
+  if (options.ffmpegPath.empty())
+    options.ffmpegPath = FFmpegPipeManager::ResolveFFmpegPath();
+
+  std::printf("%d-frame blocks, %d ch @ %d Hz\n\n", options.blockFrames, options.channels, options.sampleRate);
+  std::vector<StageResult> stages = RunKernels(options);
+  std::vector<RoundTripResult> trips;
+
+  if (!options.kernelsOnly)
+  {
+    CodecRegistry::Instance().DetectAvailable(options.ffmpegPath);
+    const std::vector<const CodecInfo*> codecs = SelectCodecs(options.codecs);
+    if (const CodecInfo* codec = FirstLossyCodec(codecs))
+    {
+      for (const StageResult& r : RunPipeIO(options, *codec))
+        stages.push_back(r);
+      StageResult block = RunProcessBlock(options, *codec);
+      if (block.blocks > 0)
+        stages.push_back(block);
+    }
+    else
+      std::fprintf(stderr, "no codec available in %s: pipeline stages skipped\n", options.ffmpegPath.c_str());
+
+    for (const CodecInfo* codec : codecs)
+    {
+      trips.push_back(RunRoundTrip(options, *codec));
+      std::fprintf(stderr, "round trip %s: %s\n", trips.back().codec.c_str(),
+                   trips.back().ok ? "ok" : trips.back().error.c_str());
+    }
+  }
+
+  PrintStages(stages);
+  PrintRoundTrips(trips);
+
+  if (!options.jsonPath.empty() && !WriteJson(options.jsonPath, options, stages, trips))
+  {
+    std::fprintf(stderr, "cannot write %s\n", options.jsonPath.c_str());
+    return 1;
+  }
+  std::string traceError;
+  if (!options.tracePath.empty() && !TraceRecorder::WriteChromeTrace(options.tracePath, traceError))
+  {
+    std::fprintf(stderr, "%s\n", traceError.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,216 @@
+//==============================================================================
+// SchedulingBench.cpp
+// Pipeline underruns under synthetic CPU contention, per scheduling policy
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: codecsim-bench-scheduling [--seconds N] [--load THREADS] [--block FRAMES]
+//                                  [--codec NAME] [--muxer FMT] [--demuxer FMT]
+//                                  [--bitrate BPS] [--affinity MASK]
+//
+// For each policy (default, raised, realtime) a pipeline is started, THREADS
+// busy-looping threads are spun up at normal priority, and a simulated host
+// callback writes and reads one block per block period, accumulating output
+// the way CodecSim::ProcessBlock does. Once the first decoded audio has been
+// consumed, every block that cannot be filled completely counts as an underrun.
+//==============================================================================
+
+#include "../FFmpegPipeManager.h"
+#include "../ThreadScheduling.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct BenchOptions
+{
+  double seconds = 20.0;
+  int loadThreads = static_cast<int>(std::thread::hardware_concurrency()) * 2;
+  int blockFrames = 256;
+  int sampleRate = 48000;
+  int channels = 2;
+  std::string codec = "libmp3lame";
+  std::string muxer = "mp3";
+  std::string demuxer = "mp3";
+  int bitrate = 128000;
+  uint64_t affinity = 0;
+};
+
+struct BenchResult
+{
+  long blocks = 0;
+  long underruns = 0;
+  long underrunFrames = 0;
+  SchedulingClass hostClass = SchedulingClass::Default;
+};
+
+bool ParseArgs(int argc, char** argv, BenchOptions& options)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (i + 1 >= argc)
+      return false;
+    const char* value = argv[++i];
+    if (arg == "--seconds") options.seconds = std::atof(value);
+    else if (arg == "--load") options.loadThreads = std::atoi(value);
+    else if (arg == "--block") options.blockFrames = std::atoi(value);
+    else if (arg == "--codec") options.codec = value;
+    else if (arg == "--muxer") options.muxer = value;
+    else if (arg == "--demuxer") options.demuxer = value;
+    else if (arg == "--bitrate") options.bitrate = std::atoi(value);
+    else if (arg == "--affinity") options.affinity = std::strtoull(value, nullptr, 0);
+    else return false;
+  }
+  return options.seconds > 0 && options.blockFrames > 0;
+}
+
+// Normal-priority threads that keep every core busy
+class CpuContention
+{
+public:
+  explicit CpuContention(int numThreads)
+  {
+    for (int i = 0; i < numThreads; ++i)
+      mThreads.emplace_back([this, i]() {
+        volatile double x = 1.0 + i;
+        while (!mStop.load(std::memory_order_relaxed))
+          x = std::sqrt(x * 1.000001 + 0.5);
+      });
+  }
+
+  ~CpuContention()
+  {
+    mStop = true;
+    for (auto& t : mThreads)
+      t.join();
+  }
+
+private:
+  std::atomic<bool> mStop{false};
+  std::vector<std::thread> mThreads;
+};
+
+// The simulated host callback: one block in and out per block period. It
+// always runs real-time, as a DAW's would; the policy ends with the thread.
+void HostCallbackThread(const BenchOptions& options, FFmpegPipeManager& pipeline, BenchResult& result)
+{
+  SchedulingPolicy hostPolicy;
+  hostPolicy.threads = SchedulingClass::RealTime;
+  ScopedThreadScheduling hostScheduling(hostPolicy);
+  result.hostClass = hostScheduling.GetEffectiveClass();
+
+  const int block = options.blockFrames;
+  const int ch = options.channels;
+  std::vector<float> input(static_cast<size_t>(block) * ch);
+  std::vector<float> output(static_cast<size_t>(block) * ch);
+  std::deque<float> decoded;
+  double phase = 0.0;
+  bool primed = false;
+
+  const auto period = std::chrono::duration<double>(static_cast<double>(block) / options.sampleRate);
+  const long totalBlocks = static_cast<long>(options.seconds * options.sampleRate / block);
+  auto next = std::chrono::steady_clock::now();
+
+  for (long b = 0; b < totalBlocks; ++b)
+  {
+    for (int s = 0; s < block; ++s)
+    {
+      float v = 0.25f * static_cast<float>(std::sin(phase));
+      phase += 2.0 * 3.14159265358979 * 440.0 / options.sampleRate;
+      for (int c = 0; c < ch; ++c)
+        input[static_cast<size_t>(s) * ch + c] = v;
+    }
+
+    pipeline.WriteSamples(input.data(), block);
+    size_t got = pipeline.ReadSamples(output.data(), block, 0);
+    decoded.insert(decoded.end(), output.begin(), output.begin() + got * ch);
+
+    const size_t needed = static_cast<size_t>(block) * ch;
+    if (decoded.size() >= needed)
+    {
+      decoded.erase(decoded.begin(), decoded.begin() + needed);
+      primed = true;
+    }
+    else if (primed)
+    {
+      ++result.underruns;
+      result.underrunFrames += block - static_cast<long>(decoded.size() / ch);
+      decoded.clear();
+    }
+    if (primed)
+      ++result.blocks;
+
+    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+    std::this_thread::sleep_until(next);
+  }
+}
+
+BenchResult RunPolicy(const BenchOptions& options, SchedulingClass schedulingClass)
+{
+  BenchResult result;
+
+  FFmpegPipeManager::Config config;
+  config.codecName = options.codec;
+  config.muxerFormat = options.muxer;
+  config.demuxerFormat = options.demuxer;
+  config.sampleRate = options.sampleRate;
+  config.channels = options.channels;
+  config.bitrate = options.bitrate;
+  config.scheduling.threads = schedulingClass;
+  config.scheduling.processes = schedulingClass;
+  config.scheduling.threadAffinity = options.affinity;
+  config.scheduling.processAffinity = options.affinity;
+
+  FFmpegPipeManager pipeline;
+  if (!pipeline.Start(config))
+  {
+    std::fprintf(stderr, "failed to start pipeline: %s\n", pipeline.GetLastErrorMessage().c_str());
+    return result;
+  }
+
+  CpuContention contention(options.loadThreads);
+
+  // On its own thread: real-time scheduling on this one would carry over into
+  // the next policy's load threads and ffmpeg children
+  std::thread host(HostCallbackThread, std::cref(options), std::ref(pipeline), std::ref(result));
+  host.join();
+
+  pipeline.Stop();
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  BenchOptions options;
+  if (!ParseArgs(argc, argv, options))
+  {
+    std::fprintf(stderr, "usage: %s [--seconds N] [--load THREADS] [--block FRAMES] [--codec NAME]\n"
+                         "          [--muxer FMT] [--demuxer FMT] [--bitrate BPS] [--affinity MASK]\n", argv[0]);
+    return 2;
+  }
+
+  std::printf("%s @ %d bps, %d-frame blocks, %d load threads, %.0f s per policy\n\n",
+              options.codec.c_str(), options.bitrate, options.blockFrames, options.loadThreads, options.seconds);
+  std::printf("%-10s %10s %10s %14s %10s\n", "policy", "blocks", "underruns", "lost frames", "host");
+
+  for (SchedulingClass c : {SchedulingClass::Default, SchedulingClass::Raised, SchedulingClass::RealTime})
+  {
+    BenchResult r = RunPolicy(options, c);
+    std::printf("%-10s %10ld %10ld %14ld %10s\n", SchedulingClassName(c), r.blocks, r.underruns,
+                r.underrunFrames, SchedulingClassName(r.hostClass));
+  }
+  return 0;
+}
@@ -0,0 +1,391 @@
+//==============================================================================
+// AudioFile.cpp
+// Streaming audio file reader/writer implementation
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "AudioFile.h"
+#include "NativeCodecs.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+namespace
+{
+
+constexpr uint16_t kWaveFormatPcm = 0x0001;
+constexpr uint16_t kWaveFormatFloat = 0x0003;
+constexpr uint16_t kWaveFormatExtensible = 0xFFFE;
+constexpr uint64_t kUntilEof = std::numeric_limits<uint64_t>::max();
+
+// Quote one argument for the platform shell used by popen
+std::string QuoteArg(const std::string& arg)
+{
+#ifdef _WIN32
+  return "\"" + arg + "\"";
+#else
+  std::string quoted = "'";
+  for (char c : arg)
+  {
+    if (c == '\'')
+      quoted += "'\\''";
+    else
+      quoted += c;
+  }
+  return quoted + "'";
+#endif
+}
+
+uint16_t ReadLE16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t ReadLE32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+
+void WriteLE16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+void WriteLE32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (v >> (8 * i)) & 0xFF; }
+
+// Canonical 44-byte PCM header
+void BuildWavHeader(uint8_t* header, int sampleRate, int channels, uint32_t dataBytes)
+{
+  const uint16_t blockAlign = static_cast<uint16_t>(channels * 2);
+  std::memcpy(header, "RIFF", 4);
+  WriteLE32(header + 4, dataBytes > 0xFFFFFFFFu - 36 ? 0xFFFFFFFFu : dataBytes + 36);
+  std::memcpy(header + 8, "WAVEfmt ", 8);
+  WriteLE32(header + 16, 16);
+  WriteLE16(header + 20, kWaveFormatPcm);
+  WriteLE16(header + 22, static_cast<uint16_t>(channels));
+  WriteLE32(header + 24, static_cast<uint32_t>(sampleRate));
+  WriteLE32(header + 28, static_cast<uint32_t>(sampleRate) * blockAlign);
+  WriteLE16(header + 32, blockAlign);
+  WriteLE16(header + 34, 16);
+  std::memcpy(header + 36, "data", 4);
+  WriteLE32(header + 40, dataBytes);
+}
+
+} // namespace
+
+std::string GetFileExtension(const std::string& path)
+{
+  size_t dot = path.find_last_of('.');
+  size_t sep = path.find_last_of("/\\");
+  if (dot == std::string::npos || (sep != std::string::npos && dot < sep))
+    return std::string();
+  std::string ext = path.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return ext;
+}
+
+//==============================================================================
+// AudioReader
+//==============================================================================
+
+AudioReader::~AudioReader()
+{
+  Close();
+}
+
+bool AudioReader::Open(const std::string& path, const std::string& ffmpegPath, int sampleRate)
+{
+  Close();
+
+  // WAV at the requested rate is read directly; the header tells us the rate,
+  // so a mismatch reopens the file through ffmpeg
+  if (GetFileExtension(path) == "wav")
+  {
+    mFile = std::fopen(path.c_str(), "rb");
+    if (!mFile)
+    {
+      mLastError = "cannot open " + path;
+      return false;
+    }
+    mIsPipe = false;
+    if (ParseHeader() && (sampleRate <= 0 || sampleRate == mSampleRate))
+      return true;
+    Close();
+  }
+
+  std::string command = QuoteArg(ffmpegPath) + " -hide_banner -loglevel error -nostdin -i " + QuoteArg(path);
+  if (sampleRate > 0)
+    command += " -ar " + std::to_string(sampleRate);
+  command += " -c:a pcm_f32le -f wav -";
+#ifdef _WIN32
+  mFile = popen(command.c_str(), "rb");
+#else
+  mFile = popen(command.c_str(), "r");
+#endif
+  if (!mFile)
+  {
+    mLastError = "cannot start ffmpeg to decode " + path;
+    return false;
+  }
+  mIsPipe = true;
+  if (!ParseHeader())
+  {
+    mLastError = "ffmpeg could not decode " + path;
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool AudioReader::ReadBytes(void* data, size_t size)
+{
+  return std::fread(data, 1, size, mFile) == size;
+}
+
+bool AudioReader::ParseHeader()
+{
+  uint8_t riff[12];
+  if (!ReadBytes(riff, sizeof(riff)) ||
+      (std::memcmp(riff, "RIFF", 4) != 0 && std::memcmp(riff, "RF64", 4) != 0) ||
+      std::memcmp(riff + 8, "WAVE", 4) != 0)
+  {
+    mLastError = "not a RIFF/WAVE stream";
+    return false;
+  }
+
+  bool haveFormat = false;
+  while (true)
+  {
+    uint8_t chunk[8];
+    if (!ReadBytes(chunk, sizeof(chunk)))
+    {
+      mLastError = "no data chunk";
+      return false;
+    }
+    uint32_t size = ReadLE32(chunk + 4);
+
+    if (std::memcmp(chunk, "fmt ", 4) == 0)
+    {
+      std::vector<uint8_t> fmt(size + (size & 1));
+      if (size < 16 || !ReadBytes(fmt.data(), fmt.size()))
+      {
+        mLastError = "truncated fmt chunk";
+        return false;
+      }
+      uint16_t format = ReadLE16(fmt.data());
+      mChannels = ReadLE16(fmt.data() + 2);
+      mSampleRate = static_cast<int>(ReadLE32(fmt.data() + 4));
+      mBitsPerSample = ReadLE16(fmt.data() + 14);
+      if (format == kWaveFormatExtensible && size >= 26)
+        format = ReadLE16(fmt.data() + 24);  // First two bytes of the sub-format GUID
+
+      mIsFloat = (format == kWaveFormatFloat);
+      const bool supported = (format == kWaveFormatPcm && (mBitsPerSample == 8 || mBitsPerSample == 16 ||
+                                                           mBitsPerSample == 24 || mBitsPerSample == 32)) ||
+                             (mIsFloat && (mBitsPerSample == 32 || mBitsPerSample == 64));
+      if (!supported || mChannels <= 0 || mSampleRate <= 0)
+      {
+        mLastError = "unsupported WAV format " + std::to_string(format) + "/" + std::to_string(mBitsPerSample) + " bit";
+        return false;
+      }
+      haveFormat = true;
+    }
+    else if (std::memcmp(chunk, "data", 4) == 0)
+    {
+      if (!haveFormat)
+      {
+        mLastError = "data chunk before fmt chunk";
+        return false;
+      }
+      // Streamed WAV (ffmpeg on a pipe, RF64) carries a placeholder size
+      mDataRemaining = (mIsPipe || size == 0xFFFFFFFFu || size == 0) ? kUntilEof : size;
+      return true;
+    }
+    else
+    {
+      // Skip unknown chunk by reading (pipes cannot seek)
+      uint8_t skip[4096];
+      uint64_t remaining = size + (size & 1);
+      while (remaining > 0)
+      {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(skip)));
+        if (!ReadBytes(skip, n))
+        {
+          mLastError = "truncated chunk";
+          return false;
+        }
+        remaining -= n;
+      }
+    }
+  }
+}
+
+size_t AudioReader::Read(float* data, size_t numFrames)
+{
+  if (!mFile || mDataRemaining == 0)
+    return 0;
+
+  const size_t bytesPerSample = static_cast<size_t>(mBitsPerSample / 8);
+  const size_t frameBytes = bytesPerSample * mChannels;
+  size_t wanted = numFrames * frameBytes;
+  if (mDataRemaining != kUntilEof)
+    wanted = static_cast<size_t>(std::min<uint64_t>(wanted, mDataRemaining));
+
+  mRawBuffer.resize(wanted);
+  size_t got = std::fread(mRawBuffer.data(), 1, wanted, mFile);
+  const size_t frames = got / frameBytes;
+  if (mDataRemaining != kUntilEof)
+    mDataRemaining -= got;
+  if (got < wanted)
+    mDataRemaining = 0;
+
+  const uint8_t* p = mRawBuffer.data();
+  const size_t count = frames * mChannels;
+  for (size_t i = 0; i < count; ++i, p += bytesPerSample)
+  {
+    float v = 0.f;
+    if (mIsFloat)
+    {
+      if (mBitsPerSample == 32)
+      {
+        uint32_t bits = ReadLE32(p);
+        std::memcpy(&v, &bits, sizeof(v));
+      }
+      else
+      {
+        uint64_t bits = ReadLE32(p) | (static_cast<uint64_t>(ReadLE32(p + 4)) << 32);
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        v = static_cast<float>(d);
+      }
+    }
+    else
+    {
+      switch (mBitsPerSample)
+      {
+        case 8:  v = (static_cast<int>(p[0]) - 128) / 128.0f; break;
+        case 16: v = static_cast<int16_t>(ReadLE16(p)) / 32768.0f; break;
+        case 24: v = static_cast<int32_t>((p[0] << 8) | (p[1] << 16) | (static_cast<uint32_t>(p[2]) << 24)) / 2147483648.0f; break;
+        case 32: v = static_cast<int32_t>(ReadLE32(p)) / 2147483648.0f; break;
+      }
+    }
+    data[i] = v;
+  }
+  return frames;
+}
+
+void AudioReader::Close()
+{
+  if (mFile)
+  {
+    if (mIsPipe)
+      pclose(mFile);
+    else
+      std::fclose(mFile);
+    mFile = nullptr;
+  }
+  mDataRemaining = 0;
+}
+
+//==============================================================================
+// AudioWriter
+//==============================================================================
+
+AudioWriter::~AudioWriter()
+{
+  Close();
+}
+
+bool AudioWriter::Open(const std::string& path, const std::string& ffmpegPath, int sampleRate, int channels)
+{
+  Close();
+  mChannels = channels;
+  mDataBytes = 0;
+  mLastError.clear();
+
+  if (GetFileExtension(path) == "wav")
+  {
+    mFile = std::fopen(path.c_str(), "wb");
+    mIsPipe = false;
+    if (!mFile)
+    {
+      mLastError = "cannot create " + path;
+      return false;
+    }
+    // Sizes are patched in Close()
+    uint8_t header[44];
+    BuildWavHeader(header, sampleRate, channels, 0);
+    if (std::fwrite(header, 1, sizeof(header), mFile) != sizeof(header))
+    {
+      mLastError = "cannot write " + path;
+      return false;
+    }
+    return true;
+  }
+
+  std::string command = QuoteArg(ffmpegPath) + " -hide_banner -loglevel error -y -f s16le" +
+                        " -ar " + std::to_string(sampleRate) + " -ac " + std::to_string(channels) +
+                        " -i - " + QuoteArg(path);
+#ifdef _WIN32
+  mFile = popen(command.c_str(), "wb");
+#else
+  mFile = popen(command.c_str(), "w");
+#endif
+  mIsPipe = true;
+  if (!mFile)
+  {
+    mLastError = "cannot start ffmpeg to encode " + path;
+    return false;
+  }
+  return true;
+}
+
+bool AudioWriter::Write(const float* data, size_t numFrames)
+{
+  if (!mFile)
+    return false;
+
+  const size_t count = numFrames * mChannels;
+  mS16Buffer.resize(count);
+  // The plugin's own conversion (x32768, round, clamp): inverse of the s16
+  // reader, so s16 input written back unprocessed is bit-identical
+  NativeCodecs::FloatToS16(data, mS16Buffer.data(), count);
+  // Host is little-endian on every supported platform
+  if (std::fwrite(mS16Buffer.data(), sizeof(int16_t), count, mFile) != count)
+  {
+    mLastError = "write failed";
+    return false;
+  }
+  mDataBytes += count * sizeof(int16_t);
+  return true;
+}
+
+bool AudioWriter::Close()
+{
+  if (!mFile)
+    return mLastError.empty();
+
+  bool ok = mLastError.empty();
+  if (mIsPipe)
+  {
+    if (pclose(mFile) != 0 && ok)
+    {
+      mLastError = "ffmpeg failed to encode the output";
+      ok = false;
+    }
+  }
+  else
+  {
+    uint8_t sizes[4];
+    const uint32_t dataBytes = static_cast<uint32_t>(std::min<uint64_t>(mDataBytes, 0xFFFFFFFFu));
+    WriteLE32(sizes, dataBytes > 0xFFFFFFFFu - 36 ? 0xFFFFFFFFu : dataBytes + 36);
+    ok = ok && std::fseek(mFile, 4, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, mFile) == 4;
+    WriteLE32(sizes, dataBytes);
+    ok = ok && std::fseek(mFile, 40, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, mFile) == 4;
+    ok = (std::fclose(mFile) == 0) && ok;
+    if (!ok && mLastError.empty())
+      mLastError = "cannot finalize WAV header";
+  }
+  mFile = nullptr;
+  return ok;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+//==============================================================================
+// AudioFile.h
+// Streaming audio file reader/writer for the headless CLI
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// AudioReader
+// WAV (PCM 8/16/24/32, float 32/64, WAVE_FORMAT_EXTENSIBLE) is parsed
+// directly; anything else (FLAC, ...) and any file that needs resampling is
+// decoded by ffmpeg into a WAV stream on a pipe, so both paths share the
+// same parser and never load the whole file into memory.
+//==============================================================================
+class AudioReader
+{
+public:
+  AudioReader() = default;
+  ~AudioReader();
+
+  // Non-copyable
+  AudioReader(const AudioReader&) = delete;
+  AudioReader& operator=(const AudioReader&) = delete;
+
+  /**
+   * Open a file for reading
+   * @param path Input file
+   * @param ffmpegPath ffmpeg used for non-WAV input and resampling
+   * @param sampleRate Desired rate (0 = keep the file's rate)
+   * @return true if the stream is ready; GetLastError() otherwise
+   */
+  bool Open(const std::string& path, const std::string& ffmpegPath, int sampleRate);
+
+  /**
+   * Read interleaved float frames in the file's channel layout
+   * @return Frames read (0 at end of stream)
+   */
+  size_t Read(float* data, size_t numFrames);
+
+  void Close();
+
+  int GetSampleRate() const { return mSampleRate; }
+  int GetChannels() const { return mChannels; }
+  const std::string& GetLastError() const { return mLastError; }
+
+private:
+  bool ParseHeader();
+  bool ReadBytes(void* data, size_t size);
+
+  FILE* mFile = nullptr;
+  bool mIsPipe = false;
+  int mSampleRate = 0;
+  int mChannels = 0;
+  int mBitsPerSample = 0;
+  bool mIsFloat = false;
+  uint64_t mDataRemaining = 0;  // Bytes left in the data chunk (UINT64_MAX = until EOF)
+  std::vector<uint8_t> mRawBuffer;
+  std::string mLastError;
+};
+
+//==============================================================================
+// AudioWriter
+// 16-bit output (the pipeline's own resolution, so nothing is lost): .wav is
+// written directly, any other extension is encoded by ffmpeg from a pipe.
+//==============================================================================
+class AudioWriter
+{
+public:
+  AudioWriter() = default;
+  ~AudioWriter();
+
+  // Non-copyable
+  AudioWriter(const AudioWriter&) = delete;
+  AudioWriter& operator=(const AudioWriter&) = delete;
+
+  bool Open(const std::string& path, const std::string& ffmpegPath, int sampleRate, int channels);
+
+  // Interleaved float frames
+  bool Write(const float* data, size_t numFrames);
+
+  // Finalizes the header / waits for the encoder; false on any write error
+  bool Close();
+
+  const std::string& GetLastError() const { return mLastError; }
+
+private:
+  FILE* mFile = nullptr;
+  bool mIsPipe = false;
+  int mChannels = 0;
+  uint64_t mDataBytes = 0;
+  std::vector<int16_t> mS16Buffer;
+  std::string mLastError;
+};
+
+// Lowercase extension without the dot ("" if none)
+std::string GetFileExtension(const std::string& path);
@@ -0,0 +1,361 @@
+//==============================================================================
+// BatchRenderer.cpp
+// Offline render of one file through the encoder -> decoder pipeline
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "BatchRenderer.h"
+#include "AudioFile.h"
+#include "CodecProcessor.h"
+#include "NativeCodecProcessor.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace
+{
+
+constexpr int kBlockFrames = 4096;           // Frames fed per Process call
+constexpr int kMaxDrainFrames = 65536;       // Frames read back per call
+constexpr int kStallTimeoutMs = 10000;       // No decoded output for this long = hung pipeline
+constexpr int kFinishTimeoutMs = 30000;      // Encoder/decoder flush after end of input
+
+// Map the file's channel layout onto the pipeline's (mono: average, stereo:
+// first two channels, mono input duplicated)
+void MapChannels(const float* in, int inChannels, float* out, int outChannels, size_t frames)
+{
+  for (size_t f = 0; f < frames; ++f)
+  {
+    const float* src = in + f * inChannels;
+    float* dst = out + f * outChannels;
+    if (outChannels == 1)
+    {
+      float sum = 0.f;
+      for (int c = 0; c < inChannels; ++c)
+        sum += src[c];
+      dst[0] = sum / inChannels;
+    }
+    else
+    {
+      dst[0] = src[0];
+      dst[1] = (inChannels > 1) ? src[1] : src[0];
+    }
+  }
+}
+
+} // namespace
+
+//==============================================================================
+// Decoded stream -> output file, with the latency trimmed off the front and
+// the length capped to the input's. With a QualityMetrics attached, every
+// frame written is scored against the input frame it lines up with.
+//==============================================================================
+class TrimmedOutput
+{
+public:
+  // writer == nullptr: frames are only scored, not written
+  TrimmedOutput(AudioWriter* writer, int channels, int64_t skipFrames, QualityMetrics* metrics)
+    : mWriter(writer), mChannels(channels), mSkip(skipFrames), mMetrics(metrics) {}
+
+  // Pipeline input, in order; held only until the matching output is written
+  void PushReference(const float* data, size_t frames)
+  {
+    if (mMetrics)
+      mReference.insert(mReference.end(), data, data + frames * mChannels);
+  }
+
+  // 'limit' = input frames known so far; decoded frames past it are held
+  bool Push(const float* data, size_t frames, int64_t limit)
+  {
+    const size_t skip = static_cast<size_t>(std::min<int64_t>(mSkip, static_cast<int64_t>(frames)));
+    mSkip -= skip;
+    mPending.insert(mPending.end(), data + skip * mChannels, data + frames * mChannels);
+    return Flush(limit);
+  }
+
+  bool Flush(int64_t limit)
+  {
+    const int64_t pendingFrames = static_cast<int64_t>(mPending.size()) / mChannels;
+    const int64_t frames = std::min(pendingFrames, limit - mWritten);
+    if (frames <= 0)
+      return true;
+    if (!Write(mPending.data(), static_cast<size_t>(frames)))
+      return false;
+    mPending.erase(mPending.begin(), mPending.begin() + frames * mChannels);
+    return true;
+  }
+
+  // Pad with silence up to 'total' frames (decoder delivered less than the input)
+  bool PadTo(int64_t total)
+  {
+    std::vector<float> silence(static_cast<size_t>(kBlockFrames) * mChannels, 0.f);
+    while (mWritten < total)
+    {
+      const int64_t frames = std::min<int64_t>(kBlockFrames, total - mWritten);
+      if (!Write(silence.data(), static_cast<size_t>(frames)))
+        return false;
+    }
+    return true;
+  }
+
+  int64_t GetWritten() const { return mWritten; }
+
+private:
+  bool Write(const float* data, size_t frames)
+  {
+    if (mWriter && !mWriter->Write(data, frames))
+      return false;
+    if (mMetrics)
+    {
+      const size_t samples = frames * mChannels;
+      mReferenceBlock.assign(mReference.begin(), mReference.begin() + samples);
+      mReference.erase(mReference.begin(), mReference.begin() + samples);
+      mMetrics->Process(mReferenceBlock.data(), data, frames);
+    }
+    mWritten += static_cast<int64_t>(frames);
+    return true;
+  }
+
+  AudioWriter* mWriter;
+  int mChannels;
+  int64_t mSkip;
+  int64_t mWritten = 0;
+  std::vector<float> mPending;
+  QualityMetrics* mMetrics;
+  std::deque<float> mReference;
+  std::vector<float> mReferenceBlock;
+};
+
+//==============================================================================
+// Shared render loop: frames from 'read' (file layout) -> pipeline -> output.
+// Sets result.error and returns false on failure.
+//==============================================================================
+using FrameSource = std::function<size_t(float* data, size_t numFrames)>;
+
+static bool RenderStream(const RenderSettings& settings, int sampleRate, int inChannels, const FrameSource& read,
+                         const std::string& outputPath, const RenderLogFunc& log, RenderResult& result)
+{
+  auto fail = [&](const std::string& error) {
+    result.error = error;
+    return false;
+  };
+
+  int channels = settings.channels > 0 ? settings.channels : std::min(inChannels, 2);
+  if (settings.codec->monoOnly)
+    channels = 1;
+  result.sampleRate = sampleRate;
+  result.channels = channels;
+
+  // In-process codec first; the ffmpeg pipeline is the fallback
+  std::unique_ptr<ICodecProcessor> processor;
+  if (settings.preferNative)
+    processor = CreateNativeCodecProcessor(*settings.codec, settings.options, settings.bitrateKbps,
+                                           result.sampleRate);
+  if (processor)
+  {
+    if (log)
+      processor->SetLogCallback(log);
+    if (!processor->Initialize(result.sampleRate, channels))
+      processor.reset();
+  }
+  if (!processor)
+  {
+    auto pipeline = std::make_unique<GenericCodecProcessor>(*settings.codec);
+    if (log)
+      pipeline->SetLogCallback(log);
+    if (!settings.codec->isLossless && settings.bitrateKbps > 0)
+      pipeline->SetBitrate(settings.bitrateKbps);
+    pipeline->SetAdditionalArgs(BuildCodecArgs(*settings.codec, settings.options));
+    pipeline->SetFFmpegPath(settings.ffmpegPath);
+    pipeline->SetSchedulingPolicy(settings.scheduling);
+    if (!pipeline->Initialize(result.sampleRate, channels))
+      return fail("failed to start the ffmpeg pipeline");
+    processor = std::move(pipeline);
+  }
+
+  result.latencyFrames = settings.latencyOverride >= 0 ? settings.latencyOverride : processor->GetLatencySamples();
+
+  AudioWriter writer;
+  const bool writeFile = !outputPath.empty();
+  if (writeFile && !writer.Open(outputPath, settings.ffmpegPath, result.sampleRate, channels))
+    return fail(writer.GetLastError());
+  QualityMetrics metrics;
+  const bool measure = settings.measureQuality && metrics.Configure(result.sampleRate, channels);
+  TrimmedOutput output(writeFile ? &writer : nullptr, channels, result.latencyFrames, measure ? &metrics : nullptr);
+
+  std::vector<float> fileBlock(static_cast<size_t>(kBlockFrames) * inChannels);
+  std::vector<float> inBlock(static_cast<size_t>(kBlockFrames) * channels);
+  std::vector<float> decoded(static_cast<size_t>(kMaxDrainFrames) * channels);
+  int64_t decodedFrames = 0;
+
+  // Keep at most ~2 s (plus the codec's own delay) in flight so memory stays
+  // bounded however long the file is
+  const int64_t maxInFlight = 2 * static_cast<int64_t>(result.sampleRate) + result.latencyFrames;
+
+  while (true)
+  {
+    const size_t frames = read(fileBlock.data(), kBlockFrames);
+    if (frames == 0)
+      break;
+    MapChannels(fileBlock.data(), inChannels, inBlock.data(), channels, frames);
+    result.inputFrames += static_cast<int64_t>(frames);
+    output.PushReference(inBlock.data(), frames);
+
+    const int64_t backlog = result.inputFrames - decodedFrames;
+    const int needed = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(backlog - maxInFlight, kMaxDrainFrames)));
+    int got = processor->ProcessBlocking(inBlock.data(), static_cast<int>(frames), decoded.data(),
+                                         needed, kMaxDrainFrames, kStallTimeoutMs);
+    if (got < needed)
+      return fail("pipeline stalled or exited (no decoded output for " + std::to_string(kStallTimeoutMs / 1000) + " s)");
+    while (got > 0)
+    {
+      decodedFrames += got;
+      if (!output.Push(decoded.data(), static_cast<size_t>(got), result.inputFrames))
+        return fail(writer.GetLastError());
+      got = (got == kMaxDrainFrames) ? processor->Process(nullptr, 0, decoded.data(), kMaxDrainFrames) : 0;
+    }
+  }
+
+  // End of input: let the encoder flush and collect the decoded tail
+  if (!processor->Finish(kFinishTimeoutMs))
+    return fail("pipeline did not finish within " + std::to_string(kFinishTimeoutMs / 1000) + " s");
+  int got;
+  while ((got = processor->Process(nullptr, 0, decoded.data(), kMaxDrainFrames)) > 0)
+  {
+    decodedFrames += got;
+    if (!output.Push(decoded.data(), static_cast<size_t>(got), result.inputFrames))
+      return fail(writer.GetLastError());
+  }
+
+  result.paddedFrames = result.inputFrames - output.GetWritten();
+  if (!output.PadTo(result.inputFrames))
+    return fail(writer.GetLastError());
+
+  processor->Shutdown();
+  if (writeFile && !writer.Close())
+    return fail(writer.GetLastError());
+
+  if (measure)
+  {
+    result.hasQuality = true;
+    result.quality = metrics.GetReport();
+  }
+  return true;
+}
+
+int CodecProcessCount(const RenderSettings& settings)
+{
+  return (settings.preferNative && HasNativeProcessor(*settings.codec, settings.options, settings.sampleRate)) ? 0 : 2;
+}
+
+//==============================================================================
+// RenderFile / RenderBuffer
+//==============================================================================
+
+RenderResult RenderFile(const RenderSettings& settings, const std::string& inputPath,
+                        const std::string& outputPath, const RenderLogFunc& log)
+{
+  CODECSIM_TRACE_SCOPE("RenderFile");
+  RenderResult result;
+  const auto startTime = std::chrono::steady_clock::now();
+
+  if (!settings.codec)
+    result.error = "no codec selected";
+  else
+  {
+    AudioReader reader;
+    if (!reader.Open(inputPath, settings.ffmpegPath, settings.sampleRate))
+      result.error = reader.GetLastError();
+    else
+    {
+      auto read = [&reader](float* data, size_t numFrames) { return reader.Read(data, numFrames); };
+      result.ok = RenderStream(settings, reader.GetSampleRate(), reader.GetChannels(), read, outputPath, log, result);
+    }
+  }
+
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  return result;
+}
+
+RenderResult RenderBuffer(const RenderSettings& settings, const AudioBuffer& input,
+                          const std::string& outputPath, const RenderLogFunc& log)
+{
+  CODECSIM_TRACE_SCOPE("RenderBuffer");
+  RenderResult result;
+  const auto startTime = std::chrono::steady_clock::now();
+
+  if (!settings.codec)
+    result.error = "no codec selected";
+  else if (input.channels <= 0 || input.sampleRate <= 0)
+    result.error = "empty input buffer";
+  else
+  {
+    size_t position = 0;
+    auto read = [&input, &position](float* data, size_t numFrames) {
+      const size_t frames = std::min(numFrames, static_cast<size_t>(input.GetFrames()) - position);
+      std::copy_n(input.samples.data() + position * input.channels, frames * input.channels, data);
+      position += frames;
+      return frames;
+    };
+    result.ok = RenderStream(settings, input.sampleRate, input.channels, read, outputPath, log, result);
+  }
+
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  return result;
+}
+
+//==============================================================================
+// LoadAudioFile
+//==============================================================================
+
+bool LoadAudioFile(const std::string& path, const std::string& ffmpegPath, int sampleRate,
+                   AudioBuffer& buffer, std::string& error)
+{
+  AudioReader reader;
+  if (!reader.Open(path, ffmpegPath, sampleRate))
+  {
+    error = reader.GetLastError();
+    return false;
+  }
+
+  buffer.sampleRate = reader.GetSampleRate();
+  buffer.channels = reader.GetChannels();
+  buffer.samples.clear();
+
+  std::vector<float> block(static_cast<size_t>(kBlockFrames) * buffer.channels);
+  size_t frames;
+  while ((frames = reader.Read(block.data(), kBlockFrames)) > 0)
+    buffer.samples.insert(buffer.samples.end(), block.begin(), block.begin() + frames * buffer.channels);
+  buffer.samples.shrink_to_fit();
+  return true;
+}
+
+//==============================================================================
+// BuildOutputPath
+//==============================================================================
+
+std::string BuildOutputPath(const std::string& inputPath, const std::string& outDir, const std::string& format,
+                            const RenderSettings& settings)
+{
+  size_t sep = inputPath.find_last_of("/\\");
+  std::string dir = (sep == std::string::npos) ? std::string() : inputPath.substr(0, sep + 1);
+  std::string name = (sep == std::string::npos) ? inputPath : inputPath.substr(sep + 1);
+  size_t dot = name.find_last_of('.');
+  if (dot != std::string::npos && dot > 0)
+    name.resize(dot);
+
+  if (!outDir.empty())
+  {
+    dir = outDir;
+    if (dir.back() != '/' && dir.back() != '\\')
+      dir += '/';
+  }
+
+  std::string tag = std::string(settings.codec->id);
+  if (!settings.codec->isLossless)
+    tag += "-" + std::to_string(settings.bitrateKbps > 0 ? settings.bitrateKbps : settings.codec->defaultBitrate) + "k";
+  return dir + name + "." + tag + "." + format;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+//==============================================================================
+// BatchRenderer.h
+// Offline render of one file through the encoder -> decoder pipeline
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "CodecRegistry.h"
+#include "QualityMetrics.h"
+#include "ThreadScheduling.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// RenderSettings - codec configuration shared by every file in a batch
+//==============================================================================
+struct RenderSettings
+{
+  const CodecInfo* codec = nullptr;
+  int bitrateKbps = 0;              // 0 = codec default (ignored for lossless codecs)
+  CodecOptionValues options;        // Codec-specific options (see BuildCodecArgs)
+  int sampleRate = 0;               // 0 = input file's rate
+  int channels = 0;                 // 0 = input file's (stereo at most; mono-only codecs force 1)
+  int latencyOverride = -1;         // Frames trimmed from the decoded start (-1 = codec latency)
+  std::string ffmpegPath;
+  SchedulingPolicy scheduling;      // Default: leave the OS scheduler alone
+  bool measureQuality = false;      // Score the output against the input (RenderResult::quality)
+  bool preferNative = true;         // In-process codec where there is one (CodecInfo::native)
+};
+
+// ffmpeg processes a render's codec runs (encoder + decoder, 0 when it runs in-process)
+int CodecProcessCount(const RenderSettings& settings);
+
+//==============================================================================
+// RenderResult
+//==============================================================================
+struct RenderResult
+{
+  bool ok = false;
+  std::string error;
+  int sampleRate = 0;
+  int channels = 0;
+  int latencyFrames = 0;            // Frames trimmed from the decoded start
+  int64_t inputFrames = 0;
+  int64_t paddedFrames = 0;         // Output frames the decoder did not deliver (written as silence)
+  double seconds = 0.0;             // Wall-clock render time
+  bool hasQuality = false;
+  QualityReport quality;            // Output vs input, as written (trimmed, padded)
+};
+
+//==============================================================================
+// AudioBuffer - a whole decoded input, so one decode can feed many renders
+//==============================================================================
+struct AudioBuffer
+{
+  int sampleRate = 0;
+  int channels = 0;
+  std::vector<float> samples;       // Interleaved, in the file's channel layout
+
+  int64_t GetFrames() const { return channels > 0 ? static_cast<int64_t>(samples.size()) / channels : 0; }
+};
+
+using RenderLogFunc = std::function<void(const std::string&)>;
+
+/**
+ * Render one file: stream it through a private encoder/decoder pair and
+ * write the decoded result with the pipeline latency removed, so output
+ * frame n lines up with input frame n and both have the same length
+ * @param settings Codec configuration
+ * @param inputPath Any file ffmpeg can decode (WAV is read directly)
+ * @param outputPath .wav is written directly, other extensions via ffmpeg;
+ *        empty = discard (useful with measureQuality)
+ * @param log Optional pipeline log sink
+ */
+RenderResult RenderFile(const RenderSettings& settings, const std::string& inputPath,
+                        const std::string& outputPath, const RenderLogFunc& log = nullptr);
+
+/**
+ * Render already-decoded input; same output contract as RenderFile.
+ * settings.sampleRate is not applied here (decode at the wanted rate)
+ */
+RenderResult RenderBuffer(const RenderSettings& settings, const AudioBuffer& input,
+                          const std::string& outputPath, const RenderLogFunc& log = nullptr);
+
+/**
+ * Decode a whole file into memory
+ * @param sampleRate Desired rate (0 = keep the file's rate)
+ * @return false with 'error' set if the file could not be opened
+ */
+bool LoadAudioFile(const std::string& path, const std::string& ffmpegPath, int sampleRate,
+                   AudioBuffer& buffer, std::string& error);
+
+/**
+ * Default output name: <dir>/<stem>.<codec>[-<kbps>k].<format>, where dir is
+ * outDir if given, else the input's directory
+ */
+std::string BuildOutputPath(const std::string& inputPath, const std::string& outDir, const std::string& format,
+                            const RenderSettings& settings);
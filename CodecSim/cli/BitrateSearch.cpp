@@ -0,0 +1,458 @@
+//==============================================================================
+// BitrateSearch.cpp
+// Lowest bitrate per codec that meets an objective quality target
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "BitrateSearch.h"
+#include "AudioFile.h"
+#include "ProcessLimiter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+//==============================================================================
+// QualityTarget
+//==============================================================================
+
+bool QualityTarget::IsSet() const
+{
+  return std::isfinite(minSnrDb) || std::isfinite(minSegmentalSnrDb) || std::isfinite(maxLsdDb) ||
+         std::isfinite(maxLufsDelta);
+}
+
+bool QualityTarget::IsMetBy(const QualityReport& report) const
+{
+  return report.snrDb >= minSnrDb && report.segmentalSnrDb >= minSegmentalSnrDb && report.lsdDb <= maxLsdDb &&
+         std::fabs(report.lufsDelta) <= maxLufsDelta;
+}
+
+std::string QualityTarget::Describe() const
+{
+  std::string text;
+  char buf[64];
+  auto add = [&](const char* format, double value) {
+    std::snprintf(buf, sizeof(buf), format, value);
+    text += (text.empty() ? "" : ", ") + std::string(buf);
+  };
+  if (std::isfinite(minSnrDb)) add("SNR >= %.2f dB", minSnrDb);
+  if (std::isfinite(minSegmentalSnrDb)) add("segSNR >= %.2f dB", minSegmentalSnrDb);
+  if (std::isfinite(maxLsdDb)) add("LSD <= %.3f dB", maxLsdDb);
+  if (std::isfinite(maxLufsDelta)) add("|loudness| <= %.2f LU", maxLufsDelta);
+  return text;
+}
+
+namespace
+{
+
+std::string BaseName(const std::string& path)
+{
+  size_t sep = path.find_last_of("/\\");
+  return (sep == std::string::npos) ? path : path.substr(sep + 1);
+}
+
+// Candidate bitrates in ascending order
+std::vector<int> CandidateBitrates(const CodecInfo& codec, int resolutionKbps)
+{
+  std::vector<int> candidates = GetValidBitrates(codec);
+  if (!candidates.empty())
+    return candidates;
+
+  const int step = std::max(1, resolutionKbps);
+  for (int kbps = codec.minBitrate; kbps < codec.maxBitrate; kbps += step)
+    candidates.push_back(kbps);
+  candidates.push_back(codec.maxBitrate);
+  return candidates;
+}
+
+// Loudest windowSeconds of the input (1 s hops): the hardest material is
+// usually the densest, so a pass here rarely fails on the whole file
+bool ExtractScreeningWindow(const AudioBuffer& input, double windowSeconds, AudioBuffer& window)
+{
+  const int64_t windowFrames = static_cast<int64_t>(windowSeconds * input.sampleRate);
+  const int64_t totalFrames = input.GetFrames();
+  if (windowFrames <= 0 || totalFrames < windowFrames * 3 / 2)
+    return false;  // Screening would save little over the whole file
+
+  const int64_t hop = std::max<int64_t>(1, input.sampleRate);
+  std::vector<double> hopEnergy;
+  for (int64_t start = 0; start < totalFrames; start += hop)
+  {
+    const int64_t end = std::min(totalFrames, start + hop) * input.channels;
+    double energy = 0.0;
+    for (int64_t i = start * input.channels; i < end; ++i)
+      energy += static_cast<double>(input.samples[i]) * input.samples[i];
+    hopEnergy.push_back(energy);
+  }
+
+  const int64_t hopsPerWindow = std::max<int64_t>(1, windowFrames / hop);
+  int64_t bestStart = 0;
+  double best = -1.0, running = 0.0;
+  for (int64_t h = 0; h < static_cast<int64_t>(hopEnergy.size()); ++h)
+  {
+    running += hopEnergy[h];
+    if (h >= hopsPerWindow)
+      running -= hopEnergy[h - hopsPerWindow];
+    const int64_t start = (h + 1 - hopsPerWindow) * hop;
+    if (start >= 0 && start + windowFrames <= totalFrames && running > best)
+    {
+      best = running;
+      bestStart = start;
+    }
+  }
+
+  window.sampleRate = input.sampleRate;
+  window.channels = input.channels;
+  const auto first = input.samples.begin() + bestStart * input.channels;
+  window.samples.assign(first, first + windowFrames * input.channels);
+  return true;
+}
+
+//==============================================================================
+// CodecSearch - one input x codec. Rounds are synchronous; the renders in a
+// round run on their own threads, gated by the shared limiters.
+//==============================================================================
+class CodecSearch
+{
+public:
+  CodecSearch(const SearchSpec& spec, const SweepCodec& entry, const std::string& input,
+              std::shared_ptr<const AudioBuffer> buffer, ProcessLimiter& renders, ProcessLimiter& processes,
+              int candidatesPerRound, std::mutex& logMutex)
+    : mSpec(spec), mEntry(entry), mInput(input), mBuffer(std::move(buffer)), mRenders(renders),
+      mProcesses(processes), mPerRound(std::max(1, candidatesPerRound)), mLogMutex(logMutex)
+  {
+    mCandidates = CandidateBitrates(*entry.codec, spec.resolutionKbps);
+  }
+
+  SearchResult Run()
+  {
+    const auto startTime = std::chrono::steady_clock::now();
+    mResult.input = mInput;
+    mResult.codecId = std::string(mEntry.codec->id);
+
+    const int last = static_cast<int>(mCandidates.size()) - 1;
+    int found = -1;
+
+    AudioBuffer window;
+    if (ExtractScreeningWindow(*mBuffer, mSpec.windowSeconds, window))
+    {
+      const int hint = Bisect(window, false, -1, last);
+      if (hint >= 0)
+      {
+        // Confirm the screened bitrate; if the whole file needs more, search upward from it
+        if (Evaluate(*mBuffer, true, {hint})[0])
+          found = hint;
+        else if (hint < last)
+          found = Bisect(*mBuffer, true, hint, last);
+      }
+      else
+        found = Bisect(*mBuffer, true, -1, last);  // Excerpt unreachable: let the whole file decide
+    }
+    else
+      found = Bisect(*mBuffer, true, -1, last);
+
+    if (found >= 0)
+    {
+      const FullRender& chosen = mFullRenders[found];
+      mResult.reached = true;
+      mResult.bitrateKbps = mCandidates[found];
+      mResult.output = chosen.output;
+      mResult.quality = chosen.result.quality;
+    }
+    else
+    {
+      auto it = mFullRenders.find(last);
+      if (it != mFullRenders.end())
+      {
+        mResult.bitrateKbps = mCandidates[last];
+        mResult.quality = it->second.result.quality;
+        if (!it->second.result.ok)
+          mResult.error = it->second.result.error;
+      }
+    }
+
+    // Only the winning render is kept
+    for (const auto& [index, render] : mFullRenders)
+    {
+      if (index != found && !render.output.empty())
+        std::remove(render.output.c_str());
+    }
+
+    mResult.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return mResult;
+  }
+
+private:
+  struct FullRender
+  {
+    RenderResult result;
+    std::string output;
+  };
+
+  /**
+   * Lowest passing candidate in (lo, hi]. hi itself is assumed to pass
+   * unless it has not been rendered on this buffer yet.
+   * @return Candidate index, or -1 if even hi fails
+   */
+  int Bisect(const AudioBuffer& buffer, bool full, int lo, int hi)
+  {
+    bool hiKnown = false;
+    while (true)
+    {
+      std::vector<int> round;
+      if (!hiKnown)
+        round.push_back(hi);
+      const int points = mPerRound - static_cast<int>(round.size());
+      for (int j = 1; j <= points; ++j)
+      {
+        const int index = lo + static_cast<int>(static_cast<int64_t>(hi - lo) * j / (points + 1));
+        if (index > lo && index < hi && std::find(round.begin(), round.end(), index) == round.end())
+          round.push_back(index);
+      }
+      if (round.empty())
+        return hi;
+
+      std::sort(round.begin(), round.end());
+      const std::vector<bool> passed = Evaluate(buffer, full, round);
+
+      if (!hiKnown)
+      {
+        if (!passed.back())
+          return -1;
+        hiKnown = true;
+      }
+      for (size_t i = 0; i < round.size(); ++i)
+      {
+        if (passed[i])
+          hi = std::min(hi, round[i]);
+      }
+      for (size_t i = 0; i < round.size(); ++i)
+      {
+        if (!passed[i] && round[i] < hi)
+          lo = std::max(lo, round[i]);
+      }
+      if (hi - lo <= 1)
+        return hi;
+    }
+  }
+
+  // Render the given candidates concurrently; true where the target is met
+  std::vector<bool> Evaluate(const AudioBuffer& buffer, bool full, const std::vector<int>& indices)
+  {
+    std::vector<RenderResult> results(indices.size());
+    std::vector<std::string> outputs(indices.size());
+    std::vector<std::thread> threads;
+    const int outputProcesses = full && !mSpec.outDir.empty() && GetFileExtension("x." + mSpec.format) != "wav";
+
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      RenderSettings settings = mSpec.base;
+      settings.codec = mEntry.codec;
+      settings.options = mEntry.options;
+      settings.bitrateKbps = mCandidates[indices[i]];
+      settings.measureQuality = true;
+      if (full && !mSpec.outDir.empty())
+        outputs[i] = BuildOutputPath(mInput, mSpec.outDir, mSpec.format, settings);
+
+      const int processesPerRender = CodecProcessCount(settings) + outputProcesses;
+      threads.emplace_back([this, &buffer, &results, &outputs, settings, i, processesPerRender] {
+        ProcessSlots render(mRenders, 1);
+        ProcessSlots processes(mProcesses, processesPerRender);
+        results[i] = RenderBuffer(settings, buffer, outputs[i]);
+      });
+    }
+    for (auto& t : threads)
+      t.join();
+
+    std::vector<bool> passed(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      const RenderResult& r = results[i];
+      passed[i] = r.ok && r.hasQuality && mSpec.target.IsMetBy(r.quality);
+      (full ? mResult.fullRenders : mResult.screenRenders)++;
+      if (full)
+      {
+        if (!r.ok && !outputs[i].empty())
+          std::remove(outputs[i].c_str());
+        mFullRenders[indices[i]] = {r, r.ok ? outputs[i] : std::string()};
+      }
+
+      if (mSpec.verbose || !r.ok)
+      {
+        std::lock_guard<std::mutex> lock(mLogMutex);
+        std::fprintf(stderr, "[%s %s] %s %d kbps: ", BaseName(mInput).c_str(), mResult.codecId.c_str(),
+                     full ? "full  " : "screen", mCandidates[indices[i]]);
+        if (r.ok)
+          std::fprintf(stderr, "SNR %.1f dB, segSNR %.1f dB, LSD %.2f dB, loudness %+.2f LU -> %s\n",
+                       r.quality.snrDb, r.quality.segmentalSnrDb, r.quality.lsdDb, r.quality.lufsDelta,
+                       passed[i] ? "pass" : "fail");
+        else
+          std::fprintf(stderr, "FAIL %s\n", r.error.c_str());
+      }
+    }
+    return passed;
+  }
+
+  const SearchSpec& mSpec;
+  const SweepCodec& mEntry;
+  const std::string& mInput;
+  std::shared_ptr<const AudioBuffer> mBuffer;
+  ProcessLimiter& mRenders;
+  ProcessLimiter& mProcesses;
+  const int mPerRound;
+  std::mutex& mLogMutex;
+
+  std::vector<int> mCandidates;
+  std::map<int, FullRender> mFullRenders;
+  SearchResult mResult;
+};
+
+} // namespace
+
+//==============================================================================
+// RunBitrateSearch
+//==============================================================================
+
+std::vector<SearchResult> RunBitrateSearch(const SearchSpec& spec)
+{
+  std::vector<SearchResult> results;
+
+  std::vector<const SweepCodec*> codecs;
+  for (const SweepCodec& entry : spec.codecs)
+  {
+    if (!entry.codec->isLossless)
+      codecs.push_back(&entry);
+  }
+  if (codecs.empty())
+    return results;
+
+  const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int workers = spec.workers > 0 ? spec.workers : hardware;
+  // Spread the workers over the codecs searched side by side
+  const int perRound = std::max(1, (workers + static_cast<int>(codecs.size()) - 1) / static_cast<int>(codecs.size()));
+
+  ProcessLimiter renders(workers);
+  ProcessLimiter processes(spec.maxProcesses);
+  std::mutex logMutex;
+
+  // One input at a time (one decoded buffer in memory), its codecs in parallel
+  for (const std::string& input : spec.inputs)
+  {
+    auto buffer = std::make_shared<AudioBuffer>();
+    std::string error;
+    if (!LoadAudioFile(input, spec.base.ffmpegPath, spec.base.sampleRate, *buffer, error))
+    {
+      for (const SweepCodec* entry : codecs)
+      {
+        SearchResult failed;
+        failed.input = input;
+        failed.codecId = std::string(entry->codec->id);
+        failed.error = error;
+        results.push_back(std::move(failed));
+      }
+      continue;
+    }
+
+    std::vector<SearchResult> inputResults(codecs.size());
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < codecs.size(); ++c)
+    {
+      threads.emplace_back([&, c] {
+        CodecSearch search(spec, *codecs[c], input, buffer, renders, processes, perRound, logMutex);
+        inputResults[c] = search.Run();
+        std::lock_guard<std::mutex> lock(logMutex);
+        const SearchResult& r = inputResults[c];
+        if (r.reached)
+          std::fprintf(stderr, "done %s %s: %d kbps (%d screen + %d full renders, %.1f s)\n", BaseName(input).c_str(),
+                       r.codecId.c_str(), r.bitrateKbps, r.screenRenders, r.fullRenders, r.seconds);
+        else
+          std::fprintf(stderr, "done %s %s: target not reached\n", BaseName(input).c_str(), r.codecId.c_str());
+      });
+    }
+    for (auto& t : threads)
+      t.join();
+    results.insert(results.end(), inputResults.begin(), inputResults.end());
+  }
+  return results;
+}
+
+//==============================================================================
+// Results
+//==============================================================================
+
+void PrintSearchTable(const std::vector<SearchResult>& results, const QualityTarget& target)
+{
+  size_t inputWidth = 5;
+  for (const SearchResult& r : results)
+    inputWidth = std::max(inputWidth, BaseName(r.input).size());
+
+  std::printf("target: %s\n\n", target.Describe().c_str());
+  std::printf("%-*s  %-14s %6s %7s %7s %6s %6s %7s %8s\n", static_cast<int>(inputWidth), "INPUT", "CODEC", "KBPS",
+              "SNR", "SEGSNR", "LSD", "dLUFS", "RENDERS", "SECONDS");
+  for (const SearchResult& r : results)
+  {
+    std::printf("%-*s  %-14s ", static_cast<int>(inputWidth), BaseName(r.input).c_str(), r.codecId.c_str());
+    if (!r.error.empty())
+    {
+      std::printf("FAIL   %s\n", r.error.c_str());
+      continue;
+    }
+    const std::string kbps = r.reached ? std::to_string(r.bitrateKbps) : "-";
+    std::printf("%6s %7.1f %7.1f %6.2f %+6.2f %3d+%-3d %8.1f%s\n", kbps.c_str(), r.quality.snrDb,
+                r.quality.segmentalSnrDb, r.quality.lsdDb, r.quality.lufsDelta, r.screenRenders, r.fullRenders,
+                r.seconds, r.reached ? "" : "  (not reached at max bitrate)");
+  }
+}
+
+bool WriteSearchResults(const std::vector<SearchResult>& results, const std::string& path, std::string& error)
+{
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (!file)
+  {
+    error = "cannot create " + path;
+    return false;
+  }
+
+  const bool json = GetFileExtension(path) == "json";
+  if (json)
+    std::fprintf(file, "[\n");
+  else
+    std::fprintf(file, "input,codec,reached,bitrate_kbps,output,snr_db,seg_snr_db,lsd_db,lufs_delta,"
+                       "screen_renders,full_renders,seconds,error\n");
+
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const SearchResult& r = results[i];
+    const QualityReport& q = r.quality;
+    if (json)
+    {
+      std::fprintf(file,
+                   "  {\"input\": %s, \"codec\": %s, \"reached\": %s, \"bitrate_kbps\": %d, \"output\": %s, "
+                   "\"snr_db\": %.3f, \"seg_snr_db\": %.3f, \"lsd_db\": %.4f, \"lufs_delta\": %.3f, "
+                   "\"screen_renders\": %d, \"full_renders\": %d, \"seconds\": %.3f, \"error\": %s}%s\n",
+                   JsonString(r.input).c_str(), JsonString(r.codecId).c_str(), r.reached ? "true" : "false",
+                   r.bitrateKbps, JsonString(r.output).c_str(), q.snrDb, q.segmentalSnrDb, q.lsdDb, q.lufsDelta,
+                   r.screenRenders, r.fullRenders, r.seconds, JsonString(r.error).c_str(),
+                   i + 1 < results.size() ? "," : "");
+    }
+    else
+    {
+      std::fprintf(file, "%s,%s,%d,%d,%s,%.3f,%.3f,%.4f,%.3f,%d,%d,%.3f,%s\n", CsvField(r.input).c_str(),
+                   CsvField(r.codecId).c_str(), r.reached ? 1 : 0, r.bitrateKbps, CsvField(r.output).c_str(),
+                   q.snrDb, q.segmentalSnrDb, q.lsdDb, q.lufsDelta, r.screenRenders, r.fullRenders, r.seconds,
+                   CsvField(r.error).c_str());
+    }
+  }
+  if (json)
+    std::fprintf(file, "]\n");
+
+  const bool ok = std::fclose(file) == 0;
+  if (!ok)
+    error = "write error on " + path;
+  return ok;
+}
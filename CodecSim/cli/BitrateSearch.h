@@ -0,0 +1,79 @@
+#pragma once
+
+//==============================================================================
+// BitrateSearch.h
+// Lowest bitrate per codec that meets an objective quality target
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "BatchRenderer.h"
+#include "SweepRunner.h"
+#include <limits>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// QualityTarget - every bound that is set must hold
+//==============================================================================
+struct QualityTarget
+{
+  double minSnrDb = -std::numeric_limits<double>::infinity();
+  double minSegmentalSnrDb = -std::numeric_limits<double>::infinity();
+  double maxLsdDb = std::numeric_limits<double>::infinity();
+  double maxLufsDelta = std::numeric_limits<double>::infinity();  // |decoded - reference|
+
+  bool IsSet() const;
+  bool IsMetBy(const QualityReport& report) const;
+  std::string Describe() const;
+};
+
+//==============================================================================
+// SearchSpec
+//==============================================================================
+struct SearchSpec
+{
+  std::vector<std::string> inputs;
+  std::vector<SweepCodec> codecs;   // SweepCodec::bitrates is ignored; lossless codecs are skipped
+  RenderSettings base;              // Rate/channels/latency/ffmpeg shared by every render
+  QualityTarget target;
+  double windowSeconds = 10.0;      // Screening excerpt (0 = always render the whole file)
+  int resolutionKbps = 1;           // Step for codecs without a fixed bitrate set
+  int workers = 0;                  // Concurrent renders (0 = CPU cores)
+  int maxProcesses = 0;             // Concurrent ffmpeg processes (0 = bounded only by workers)
+  std::string outDir;               // Keep the winning full render here (empty = discard)
+  std::string format = "wav";
+  bool verbose = false;
+};
+
+//==============================================================================
+// SearchResult - one input x codec
+//==============================================================================
+struct SearchResult
+{
+  std::string input;
+  std::string codecId;
+  bool reached = false;             // Some bitrate met the target on the whole file
+  int bitrateKbps = 0;              // Lowest bitrate that did
+  std::string output;               // Its render (if SearchSpec::outDir is set)
+  QualityReport quality;            // Whole-file scores at bitrateKbps (or at the maximum if not reached)
+  int screenRenders = 0;            // Renders of the excerpt
+  int fullRenders = 0;              // Renders of the whole file
+  double seconds = 0.0;
+  std::string error;
+};
+
+/**
+ * For each input and codec, find the lowest bitrate whose decode meets the
+ * target. Candidates are the codec's valid bitrates (GetValidBitrates) or
+ * minBitrate..maxBitrate in resolution steps. Each round renders several
+ * candidates concurrently and narrows the bracket (k-ary bisection; quality
+ * is assumed to rise with bitrate). The search first runs on the loudest
+ * excerpt of windowSeconds, then confirms on the whole file, searching
+ * upward on the whole file if the confirmation fails.
+ */
+std::vector<SearchResult> RunBitrateSearch(const SearchSpec& spec);
+
+void PrintSearchTable(const std::vector<SearchResult>& results, const QualityTarget& target);
+
+// .json writes an array of objects, anything else CSV
+bool WriteSearchResults(const std::vector<SearchResult>& results, const std::string& path, std::string& error);
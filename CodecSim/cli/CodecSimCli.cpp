@@ -0,0 +1,542 @@
+//==============================================================================
+// CodecSimCli.cpp
+// codecsim-cli: headless batch renderer (no iPlug2)
+// Copyright 2025 MouseSoft
+//==============================================================================
+//
+// Usage: codecsim-cli --codec ID [options] INPUT...
+//        codecsim-cli sweep [--codecs LIST] [--bitrates SPEC] [options] INPUT...
+//        codecsim-cli search --target-METRIC VALUE... [--codecs LIST] [options] INPUT...
+//
+//   --codec ID            Codec id as listed by --list-codecs (e.g. mp3, aac, opus)
+//   --bitrate KBPS        Bitrate (default: the codec's default)
+//   --option KEY=VALUE    Codec option; VALUE is a choice label/argument, index or integer
+//   --rate HZ             Pipeline sample rate (default: input rate, resampled by ffmpeg)
+//   --channels 1|2        Pipeline channels (default: input, stereo at most)
+//   --latency FRAMES      Frames trimmed from the decoded start (default: codec latency)
+//   --out-dir DIR         Output directory (default: next to each input)
+//   -o FILE               Output file (single input only)
+//   --format EXT          Output extension when -o is not given (default: wav)
+//   --jobs N              Files rendered concurrently (default: CPU cores)
+//   --ffmpeg PATH         ffmpeg binary (default: next to codecsim-cli, then PATH)
+//   --no-native           Run G.711/DFPWM through ffmpeg instead of in-process
+//   --metrics             Score each output against its input (SNR, segmental SNR,
+//                         log-spectral distance, loudness difference)
+//   --verbose             Print pipeline logs
+//   --trace FILE          Write a Chrome trace of the run (builds with -DCODECSIM_TRACE=ON)
+//   --list-codecs         List codecs available in this ffmpeg and exit
+//
+// sweep renders every input through a codec x bitrate matrix instead of one
+// codec (--codec, --bitrate and -o do not apply):
+//
+//   --codecs all|ID,...   Codecs (default: all available)
+//   --bitrates SPEC       ladder (per-codec presets + default), presets, or KBPS,...
+//                         (default: ladder; lossless codecs render once)
+//   --max-processes N     Cap on concurrent ffmpeg processes (default: no cap)
+//   --results FILE        Results table as .json or CSV
+//
+// --jobs sets the sweep's worker count; --option applies to every codec
+// that has the option.
+//
+// search finds, per input and codec, the lowest bitrate whose decode meets
+// every given target (at least one is required):
+//
+//   --target-snr DB       Minimum SNR
+//   --target-segsnr DB    Minimum segmental SNR
+//   --target-lsd DB       Maximum log-spectral distance
+//   --target-lufs LU      Maximum absolute loudness difference
+//   --codecs all|ID,...   Codecs (default: all available; lossless ones are skipped)
+//   --window SECONDS      Screening excerpt, loudest part of the input (default: 10, 0 = off)
+//   --resolution KBPS     Step for codecs without a fixed bitrate set (default: 1)
+//   --max-processes N     Cap on concurrent ffmpeg processes (default: no cap)
+//   --results FILE        Results table as .json or CSV
+//
+// --jobs caps concurrent renders; --out-dir keeps the winning render of each
+// input and codec (otherwise nothing is written).
+//
+// Each input is streamed through its own encoder/decoder pair. Output has
+// the input's length with the pipeline latency removed. Exit status is 0
+// only if every file rendered.
+//==============================================================================
+
+#include "BatchRenderer.h"
+#include "BitrateSearch.h"
+#include "FFmpegPipeManager.h"
+#include "SweepRunner.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+struct CliOptions
+{
+  std::string codecId;
+  int bitrateKbps = 0;
+  std::vector<std::string> optionArgs;  // KEY=VALUE, resolved once the codec is known
+  int sampleRate = 0;
+  int channels = 0;
+  int latency = -1;
+  std::string outDir;
+  std::string outFile;
+  std::string format = "wav";
+  int jobs = 0;
+  std::string ffmpegPath;
+  bool verbose = false;
+  bool metrics = false;
+  bool noNative = false;
+  bool listCodecs = false;
+  std::string tracePath;
+  std::vector<std::string> inputs;
+
+  // sweep
+  bool sweep = false;
+  std::string codecsSpec = "all";
+  std::string bitratesSpec = "ladder";
+  int maxProcesses = 0;
+  std::string resultsPath;
+
+  // search
+  bool search = false;
+  QualityTarget target;
+  double windowSeconds = 10.0;
+  int resolutionKbps = 1;
+};
+
+void PrintUsage(const char* argv0)
+{
+  std::fprintf(stderr,
+               "usage: %s --codec ID [--bitrate KBPS] [--option KEY=VALUE]... [--rate HZ]\n"
+               "          [--channels 1|2] [--latency FRAMES] [--out-dir DIR | -o FILE] [--format EXT]\n"
+               "          [--jobs N] [--ffmpeg PATH] [--metrics] [--verbose] INPUT...\n"
+               "       %s sweep [--codecs all|ID,...] [--bitrates ladder|presets|KBPS,...]\n"
+               "          [--max-processes N] [--results FILE] [--option KEY=VALUE]... [--rate HZ]\n"
+               "          [--channels 1|2] [--latency FRAMES] [--out-dir DIR] [--format EXT]\n"
+               "          [--jobs N] [--ffmpeg PATH] [--metrics] [--verbose] INPUT...\n"
+"       %s search [--target-snr DB] [--target-segsnr DB] [--target-lsd DB] [--target-lufs LU]\n"
+               "          [--codecs all|ID,...] [--window SECONDS] [--resolution KBPS] [--max-processes N]\n"
+               "          [--results FILE] [--option KEY=VALUE]... [--rate HZ] [--channels 1|2]\n"
+               "          [--latency FRAMES] [--out-dir DIR] [--format EXT] [--jobs N] [--ffmpeg PATH]\n"
+               "          [--verbose] INPUT...\n"
+               "       %s --list-codecs [--ffmpeg PATH]\n"
+               "       (every mode also accepts --no-native and --trace FILE)\n", argv0, argv0, argv0, argv0);
+}
+
+bool ParseArgs(int argc, char** argv, CliOptions& options)
+{
+  int first = 1;
+  if (argc > 1 && std::string(argv[1]) == "sweep")
+  {
+    options.sweep = true;
+    first = 2;
+  }
+  else if (argc > 1 && std::string(argv[1]) == "search")
+  {
+    options.search = true;
+    first = 2;
+  }
+  const bool matrix = options.sweep || options.search;
+
+  for (int i = first; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+    if (arg == "--verbose") options.verbose = true;
+    else if (arg == "--metrics") options.metrics = true;
+    else if (arg == "--no-native") options.noNative = true;
+    else if (arg == "--list-codecs") options.listCodecs = true;
+    else if (arg.size() > 1 && arg[0] == '-' && arg != "-")
+    {
+      const char* v = value();
+      if (!v)
+        return false;
+      if (arg == "--codec") options.codecId = v;
+      else if (arg == "--bitrate") options.bitrateKbps = std::atoi(v);
+      else if (arg == "--option") options.optionArgs.push_back(v);
+      else if (arg == "--rate") options.sampleRate = std::atoi(v);
+      else if (arg == "--channels") options.channels = std::atoi(v);
+      else if (arg == "--latency") options.latency = std::atoi(v);
+      else if (arg == "--out-dir") options.outDir = v;
+      else if (arg == "-o") options.outFile = v;
+      else if (arg == "--format") options.format = v;
+      else if (arg == "--jobs") options.jobs = std::atoi(v);
+      else if (arg == "--ffmpeg") options.ffmpegPath = v;
+      else if (arg == "--trace") options.tracePath = v;
+      else if (matrix && arg == "--codecs") options.codecsSpec = v;
+      else if (options.sweep && arg == "--bitrates") options.bitratesSpec = v;
+      else if (matrix && arg == "--max-processes") options.maxProcesses = std::atoi(v);
+      else if (matrix && arg == "--results") options.resultsPath = v;
+      else if (options.search && arg == "--target-snr") options.target.minSnrDb = std::atof(v);
+      else if (options.search && arg == "--target-segsnr") options.target.minSegmentalSnrDb = std::atof(v);
+      else if (options.search && arg == "--target-lsd") options.target.maxLsdDb = std::atof(v);
+      else if (options.search && arg == "--target-lufs") options.target.maxLufsDelta = std::atof(v);
+      else if (options.search && arg == "--window") options.windowSeconds = std::atof(v);
+      else if (options.search && arg == "--resolution") options.resolutionKbps = std::atoi(v);
+      else return false;
+    }
+    else
+      options.inputs.push_back(arg);
+  }
+
+  if (options.listCodecs)
+    return true;
+  if (options.search && (!options.target.IsSet() || options.metrics || options.resolutionKbps < 1))
+    return false;
+  if (matrix)
+    return !options.inputs.empty() && options.codecId.empty() && options.outFile.empty() &&
+           options.channels >= 0 && options.channels <= 2;
+  if (options.codecId.empty() || options.inputs.empty())
+    return false;
+  if (!options.outFile.empty() && options.inputs.size() != 1)
+    return false;
+  return options.channels >= 0 && options.channels <= 2;
+}
+
+// KEY=VALUE -> option index/value, matching the plugin's stored values
+bool ResolveOption(const CodecInfo& codec, const std::string& arg, CodecOptionValues& values, std::string& error)
+{
+  size_t eq = arg.find('=');
+  if (eq == std::string::npos)
+  {
+    error = "expected KEY=VALUE: " + arg;
+    return false;
+  }
+  const std::string key = arg.substr(0, eq);
+  const std::string value = arg.substr(eq + 1);
+
+  for (const CodecOptionDef& opt : codec.options)
+  {
+    if (opt.key != key)
+      continue;
+    if (opt.type == CodecOptionType::Choice)
+    {
+      for (size_t c = 0; c < opt.choices.size(); ++c)
+      {
+        if (opt.choices[c].label == value || opt.choices[c].argValue == value)
+        {
+          values[key] = static_cast<int>(c);
+          return true;
+        }
+      }
+    }
+    char* end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (end && *end == '\0' && !value.empty())
+    {
+      values[key] = static_cast<int>(number);
+      return true;
+    }
+    error = "invalid value for " + key + ": " + value;
+    return false;
+  }
+  error = "codec " + std::string(codec.id) + " has no option " + key;
+  return false;
+}
+
+void ListCodecs()
+{
+  for (const CodecInfo* codec : CodecRegistry::Instance().GetAvailable())
+  {
+    std::printf("%-14s %-24s", std::string(codec->id).c_str(), std::string(codec->displayName).c_str());
+    if (codec->isLossless)
+      std::printf(" lossless");
+    else
+      std::printf(" %d-%d kbps (default %d)", codec->minBitrate, codec->maxBitrate, codec->defaultBitrate);
+    std::printf("%s\n", codec->monoOnly ? ", mono" : "");
+    for (const CodecOptionDef& opt : codec->options)
+    {
+      std::printf("    %s:", std::string(opt.key).c_str());
+      if (opt.type == CodecOptionType::Choice)
+      {
+        for (const CodecOptionChoice& choice : opt.choices)
+          std::printf(" \"%s\"", std::string(choice.label).c_str());
+      }
+      else if (opt.type == CodecOptionType::Toggle)
+        std::printf(" 0|1");
+      else
+        std::printf(" %d..%d", opt.minValue, opt.maxValue);
+      std::printf("\n");
+    }
+  }
+}
+
+std::string OutputPathFor(const CliOptions& options, const std::string& input, const RenderSettings& settings)
+{
+  if (!options.outFile.empty())
+    return options.outFile;
+  return BuildOutputPath(input, options.outDir, options.format, settings);
+}
+
+// --option applies to every codec in the matrix that defines the key
+bool ApplyMatrixOptions(const CliOptions& options, std::vector<SweepCodec>& matrix, std::string& error)
+{
+  for (const std::string& arg : options.optionArgs)
+  {
+    const std::string key = arg.substr(0, arg.find('='));
+    bool used = false;
+    for (SweepCodec& entry : matrix)
+    {
+      bool hasKey = false;
+      for (const CodecOptionDef& opt : entry.codec->options)
+        hasKey = hasKey || opt.key == key;
+      if (!hasKey)
+        continue;
+      if (!ResolveOption(*entry.codec, arg, entry.options, error))
+        return false;
+      used = true;
+    }
+    if (!used)
+    {
+      error = "no selected codec has option " + key;
+      return false;
+    }
+  }
+  return true;
+}
+
+int RunSweepCommand(const CliOptions& options)
+{
+  SweepSpec spec;
+  std::string error;
+  if (!ParseSweepMatrix(options.codecsSpec, options.bitratesSpec, spec.matrix, error) ||
+      !ApplyMatrixOptions(options, spec.matrix, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 2;
+  }
+
+  spec.inputs = options.inputs;
+  spec.base.sampleRate = options.sampleRate;
+  spec.base.channels = options.channels;
+  spec.base.latencyOverride = options.latency;
+  spec.base.ffmpegPath = options.ffmpegPath;
+  spec.base.preferNative = !options.noNative;
+  spec.base.measureQuality = options.metrics;
+  spec.outDir = options.outDir;
+  spec.format = options.format;
+  spec.workers = options.jobs;
+  spec.maxProcesses = options.maxProcesses;
+  spec.verbose = options.verbose;
+
+  SweepSummary summary = RunSweep(spec);
+  PrintSweepTable(summary);
+
+  if (!options.resultsPath.empty() && !WriteSweepResults(summary, options.resultsPath, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  return summary.failures > 0 ? 1 : 0;
+}
+
+int RunSearchCommand(const CliOptions& options)
+{
+  SearchSpec spec;
+  std::string error;
+  // The matrix's bitrate lists are unused; the search builds its own candidates
+  if (!ParseSweepMatrix(options.codecsSpec, "ladder", spec.codecs, error) ||
+      !ApplyMatrixOptions(options, spec.codecs, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 2;
+  }
+
+  spec.inputs = options.inputs;
+  spec.base.sampleRate = options.sampleRate;
+  spec.base.channels = options.channels;
+  spec.base.latencyOverride = options.latency;
+  spec.base.ffmpegPath = options.ffmpegPath;
+  spec.base.preferNative = !options.noNative;
+  spec.target = options.target;
+  spec.windowSeconds = options.windowSeconds;
+  spec.resolutionKbps = options.resolutionKbps;
+  spec.workers = options.jobs;
+  spec.maxProcesses = options.maxProcesses;
+  spec.outDir = options.outDir;
+  spec.format = options.format;
+  spec.verbose = options.verbose;
+
+  std::vector<SearchResult> results = RunBitrateSearch(spec);
+  if (results.empty())
+  {
+    std::fprintf(stderr, "no lossy codec to search\n");
+    return 2;
+  }
+  PrintSearchTable(results, spec.target);
+
+  if (!options.resultsPath.empty() && !WriteSearchResults(results, options.resultsPath, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  bool failed = false;
+  for (const SearchResult& r : results)
+    failed = failed || !r.error.empty();
+  return failed ? 1 : 0;
+}
+
+// Writes the trace when main returns, whichever command ran
+class TraceDump
+{
+public:
+  explicit TraceDump(const std::string& path) : mPath(path) {}
+  ~TraceDump()
+  {
+    if (mPath.empty())
+      return;
+    std::string error;
+    if (TraceRecorder::WriteChromeTrace(mPath, error))
+      std::fprintf(stderr, "trace written to %s\n", mPath.c_str());
+    else
+      std::fprintf(stderr, "%s\n", error.c_str());
+  }
+
+private:
+  std::string mPath;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  CliOptions options;
+  if (!ParseArgs(argc, argv, options))
+  {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  if (!CODECSIM_TRACE && !options.tracePath.empty())
+  {
+    std::fprintf(stderr, "--trace needs a build with -DCODECSIM_TRACE=ON\n");
+    return 2;
+  }
+  CODECSIM_TRACE_THREAD_NAME("main");
+  TraceDump traceDump(options.tracePath);
+
+#ifndef _WIN32
+  // A dying ffmpeg must surface as a write error, not end the batch
+  std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+  if (options.ffmpegPath.empty())
+    options.ffmpegPath = FFmpegPipeManager::ResolveFFmpegPath();
+
+  CodecRegistry& registry = CodecRegistry::Instance();
+  registry.DetectAvailable(options.ffmpegPath);
+  if (options.listCodecs)
+  {
+    ListCodecs();
+    return 0;
+  }
+
+  if (!options.outDir.empty())
+  {
+    std::error_code ec;
+    std::filesystem::create_directories(options.outDir, ec);
+  }
+
+  if (options.sweep)
+    return RunSweepCommand(options);
+  if (options.search)
+    return RunSearchCommand(options);
+
+  RenderSettings settings;
+  settings.codec = registry.GetById(options.codecId);
+  if (!settings.codec)
+  {
+    std::fprintf(stderr, "unknown codec: %s (see --list-codecs)\n", options.codecId.c_str());
+    return 2;
+  }
+  if (!registry.IsAvailable(options.codecId))
+  {
+    std::fprintf(stderr, "%s is not supported by %s\n", std::string(settings.codec->encoderName).c_str(),
+                 options.ffmpegPath.c_str());
+    return 2;
+  }
+  for (const std::string& arg : options.optionArgs)
+  {
+    std::string error;
+    if (!ResolveOption(*settings.codec, arg, settings.options, error))
+    {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 2;
+    }
+  }
+  settings.bitrateKbps = options.bitrateKbps;
+  settings.sampleRate = options.sampleRate;
+  settings.channels = options.channels;
+  settings.latencyOverride = options.latency;
+  settings.ffmpegPath = options.ffmpegPath;
+  settings.preferNative = !options.noNative;
+  settings.measureQuality = options.metrics;
+
+  // Bounded worker pool: each worker owns one encoder/decoder pair at a time
+  const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int numFiles = static_cast<int>(options.inputs.size());
+  const int numWorkers = std::min(options.jobs > 0 ? options.jobs : hardware, numFiles);
+
+  std::atomic<int> nextFile{0};
+  std::atomic<int> failures{0};
+  std::mutex outputMutex;
+
+  auto worker = [&]() {
+    for (int index = nextFile++; index < numFiles; index = nextFile++)
+    {
+      const std::string& input = options.inputs[index];
+      const std::string output = OutputPathFor(options, input, settings);
+
+      RenderLogFunc log;
+      if (options.verbose)
+      {
+        log = [&outputMutex, &input](const std::string& msg) {
+          std::lock_guard<std::mutex> lock(outputMutex);
+          std::fprintf(stderr, "[%s] %s\n", input.c_str(), msg.c_str());
+        };
+      }
+
+      RenderResult result = RenderFile(settings, input, output, log);
+      if (!result.ok)
+        std::remove(output.c_str());
+
+      std::lock_guard<std::mutex> lock(outputMutex);
+      if (result.ok)
+      {
+        const double audioSeconds = result.sampleRate > 0 ? double(result.inputFrames) / result.sampleRate : 0.0;
+        std::printf("ok    %s -> %s (%.1f s audio in %.1f s, latency %d", input.c_str(), output.c_str(),
+                    audioSeconds, result.seconds, result.latencyFrames);
+        if (result.paddedFrames > 0)
+          std::printf(", %lld frames padded", static_cast<long long>(result.paddedFrames));
+        if (result.hasQuality)
+          std::printf(", SNR %.1f dB, segSNR %.1f dB, LSD %.2f dB, loudness %+.2f LU", result.quality.snrDb,
+                      result.quality.segmentalSnrDb, result.quality.lsdDb, result.quality.lufsDelta);
+        std::printf(")\n");
+      }
+      else
+      {
+        ++failures;
+        std::printf("FAIL  %s: %s\n", input.c_str(), result.error.c_str());
+      }
+      std::fflush(stdout);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numWorkers; ++i)
+    workers.emplace_back(worker);
+  for (auto& t : workers)
+    t.join();
+
+  if (failures > 0)
+    std::fprintf(stderr, "%d of %d files failed\n", failures.load(), numFiles);
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+//==============================================================================
+// ProcessLimiter.h
+// Counting semaphore over concurrently running ffmpeg processes
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+
+//==============================================================================
+// ProcessLimiter - a job takes all of its slots at once (encoder + decoder
+// [+ output encoder]) so two jobs can never each hold half of what they need
+//==============================================================================
+class ProcessLimiter
+{
+public:
+  // capacity <= 0: unlimited
+  explicit ProcessLimiter(int capacity) : mCapacity(capacity > 0 ? capacity : INT_MAX), mAvailable(mCapacity) {}
+
+  // Blocks until 'count' slots are free (clamped to the capacity); returns the slots taken
+  int Acquire(int count)
+  {
+    count = std::min(count, mCapacity);
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCv.wait(lock, [&] { return mAvailable >= count; });
+    mAvailable -= count;
+    return count;
+  }
+
+  void Release(int count)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mAvailable += count;
+    }
+    mCv.notify_all();
+  }
+
+private:
+  const int mCapacity;
+  int mAvailable;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+};
+
+// Scoped ProcessLimiter slots
+class ProcessSlots
+{
+public:
+  ProcessSlots(ProcessLimiter& limiter, int count) : mLimiter(limiter), mCount(limiter.Acquire(count)) {}
+  ~ProcessSlots() { mLimiter.Release(mCount); }
+
+  ProcessSlots(const ProcessSlots&) = delete;
+  ProcessSlots& operator=(const ProcessSlots&) = delete;
+
+private:
+  ProcessLimiter& mLimiter;
+  int mCount;
+};
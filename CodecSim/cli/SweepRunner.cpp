@@ -0,0 +1,483 @@
+//==============================================================================
+// SweepRunner.cpp
+// Codec x bitrate matrix sweep over a set of stems
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "SweepRunner.h"
+#include "AudioFile.h"
+#include "ProcessLimiter.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+std::vector<std::string> SplitList(const std::string& spec)
+{
+  std::vector<std::string> items;
+  size_t start = 0;
+  while (start <= spec.size())
+  {
+    size_t comma = spec.find(',', start);
+    if (comma == std::string::npos)
+      comma = spec.size();
+    if (comma > start)
+      items.push_back(spec.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return items;
+}
+
+std::string BaseName(const std::string& path)
+{
+  size_t sep = path.find_last_of("/\\");
+  return (sep == std::string::npos) ? path : path.substr(sep + 1);
+}
+
+//==============================================================================
+// StemCache - decodes each stem on first use and shares the buffer with the
+// rest of its jobs; the buffer is dropped once the stem's last job is done
+//==============================================================================
+class StemCache
+{
+public:
+  StemCache(const SweepSpec& spec, ProcessLimiter& limiter, int jobsPerStem)
+    : mSpec(spec), mLimiter(limiter), mEntries(spec.inputs.size())
+  {
+    for (auto& entry : mEntries)
+    {
+      entry = std::make_unique<Entry>();
+      entry->remaining = jobsPerStem;
+    }
+  }
+
+  std::shared_ptr<const AudioBuffer> Acquire(size_t stem, std::string& error)
+  {
+    Entry& entry = *mEntries[stem];
+    std::lock_guard<std::mutex> lock(entry.mutex);  // Later jobs wait here for the first decode
+    if (!entry.buffer && entry.error.empty())
+    {
+      // Non-WAV input or resampling runs an ffmpeg decoder
+      const bool usesFFmpeg = GetFileExtension(mSpec.inputs[stem]) != "wav" || mSpec.base.sampleRate > 0;
+      ProcessSlots slots(mLimiter, usesFFmpeg ? 1 : 0);
+      auto buffer = std::make_shared<AudioBuffer>();
+      if (LoadAudioFile(mSpec.inputs[stem], mSpec.base.ffmpegPath, mSpec.base.sampleRate, *buffer, entry.error))
+        entry.buffer = std::move(buffer);
+      ++mDecodes;
+    }
+    error = entry.error;
+    return entry.buffer;
+  }
+
+  void Release(size_t stem)
+  {
+    Entry& entry = *mEntries[stem];
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (--entry.remaining == 0)
+      entry.buffer.reset();  // Jobs still rendering keep their own reference
+  }
+
+  int GetDecodes() const { return mDecodes.load(); }
+
+private:
+  struct Entry
+  {
+    std::mutex mutex;
+    std::shared_ptr<const AudioBuffer> buffer;
+    std::string error;
+    int remaining = 0;
+  };
+
+  const SweepSpec& mSpec;
+  ProcessLimiter& mLimiter;
+  std::vector<std::unique_ptr<Entry>> mEntries;
+  std::atomic<int> mDecodes{0};
+};
+
+double AudioSeconds(const RenderResult& result)
+{
+  return result.sampleRate > 0 ? double(result.inputFrames) / result.sampleRate : 0.0;
+}
+
+double RealtimeFactor(const RenderResult& result)
+{
+  return result.seconds > 0.0 ? AudioSeconds(result) / result.seconds : 0.0;
+}
+
+} // namespace
+
+//==============================================================================
+// Result formatting
+//==============================================================================
+
+std::string CsvField(const std::string& value)
+{
+  if (value.find_first_of(",\"\n") == std::string::npos)
+    return value;
+  std::string quoted = "\"";
+  for (char c : value)
+  {
+    if (c == '"')
+      quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+std::string JsonString(const std::string& value)
+{
+  std::string escaped = "\"";
+  for (char c : value)
+  {
+    switch (c)
+    {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\r': escaped += "\\r"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          escaped += buf;
+        }
+        else
+          escaped += c;
+    }
+  }
+  return escaped + "\"";
+}
+
+//==============================================================================
+// Matrix spec
+//==============================================================================
+
+bool ParseSweepMatrix(const std::string& codecsSpec, const std::string& bitratesSpec,
+                      std::vector<SweepCodec>& matrix, std::string& error)
+{
+  CodecRegistry& registry = CodecRegistry::Instance();
+  std::vector<const CodecInfo*> codecs;
+  if (codecsSpec.empty() || codecsSpec == "all")
+    codecs = registry.GetAvailable();
+  else
+  {
+    for (const std::string& id : SplitList(codecsSpec))
+    {
+      const CodecInfo* codec = registry.GetById(id);
+      if (!codec)
+      {
+        error = "unknown codec: " + id + " (see --list-codecs)";
+        return false;
+      }
+      if (!registry.IsAvailable(id))
+      {
+        error = std::string(codec->encoderName) + " is not supported by this ffmpeg";
+        return false;
+      }
+      codecs.push_back(codec);
+    }
+  }
+
+  std::vector<int> explicitRates;
+  const bool useLadder = bitratesSpec.empty() || bitratesSpec == "ladder";
+  const bool usePresets = bitratesSpec == "presets";
+  if (!useLadder && !usePresets)
+  {
+    for (const std::string& item : SplitList(bitratesSpec))
+    {
+      const int kbps = std::atoi(item.c_str());
+      if (kbps <= 0)
+      {
+        error = "invalid bitrate: " + item;
+        return false;
+      }
+      explicitRates.push_back(kbps);
+    }
+  }
+
+  matrix.clear();
+  for (const CodecInfo* codec : codecs)
+  {
+    SweepCodec entry;
+    entry.codec = codec;
+    if (codec->isLossless)
+      entry.bitrates.push_back(0);
+    else if (useLadder)
+      entry.bitrates = GetBitrateLadder(*codec);
+    else
+    {
+      const std::vector<int> candidates = usePresets
+        ? std::vector<int>(std::begin(kBitratePresets), std::end(kBitratePresets))
+        : explicitRates;
+      for (int kbps : candidates)
+      {
+        if (kbps >= codec->minBitrate && kbps <= codec->maxBitrate)
+          entry.bitrates.push_back(kbps);
+      }
+      // Narrow-band codecs no preset fits still get their own ladder
+      if (usePresets && entry.bitrates.empty())
+        entry.bitrates = GetBitrateLadder(*codec);
+    }
+
+    std::sort(entry.bitrates.begin(), entry.bitrates.end());
+    entry.bitrates.erase(std::unique(entry.bitrates.begin(), entry.bitrates.end()), entry.bitrates.end());
+    if (!entry.bitrates.empty())
+      matrix.push_back(std::move(entry));
+  }
+
+  if (matrix.empty())
+  {
+    error = "the codec x bitrate matrix is empty";
+    return false;
+  }
+  return true;
+}
+
+//==============================================================================
+// RunSweep
+//==============================================================================
+
+SweepSummary RunSweep(const SweepSpec& spec)
+{
+  SweepSummary summary;
+  const auto startTime = std::chrono::steady_clock::now();
+
+  // Stem-major job order: neighbouring jobs share a decoded buffer
+  int jobsPerStem = 0;
+  for (const SweepCodec& entry : spec.matrix)
+    jobsPerStem += static_cast<int>(entry.bitrates.size());
+
+  for (const std::string& input : spec.inputs)
+  {
+    for (const SweepCodec& entry : spec.matrix)
+    {
+      for (int kbps : entry.bitrates)
+      {
+        SweepRow row;
+        row.input = input;
+        row.codecId = std::string(entry.codec->id);
+        row.bitrateKbps = kbps;
+        summary.rows.push_back(std::move(row));
+      }
+    }
+  }
+
+  const int numJobs = static_cast<int>(summary.rows.size());
+  if (numJobs == 0)
+    return summary;
+
+  const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  const int numWorkers = std::min(spec.workers > 0 ? spec.workers : hardware, numJobs);
+  const int outputProcesses = GetFileExtension("x." + spec.format) != "wav" ? 1 : 0;
+
+  ProcessLimiter limiter(spec.maxProcesses);
+  StemCache stems(spec, limiter, jobsPerStem);
+  std::mutex outputMutex;
+  int completed = 0;
+
+  auto runJob = [&](int index) {
+    SweepRow& row = summary.rows[index];
+    const size_t stem = static_cast<size_t>(index / jobsPerStem);
+
+    // Locate the matrix entry for this job
+    int offset = index % jobsPerStem;
+    const SweepCodec* entry = nullptr;
+    for (const SweepCodec& candidate : spec.matrix)
+    {
+      if (offset < static_cast<int>(candidate.bitrates.size()))
+      {
+        entry = &candidate;
+        break;
+      }
+      offset -= static_cast<int>(candidate.bitrates.size());
+    }
+
+    RenderSettings settings = spec.base;
+    settings.codec = entry->codec;
+    settings.options = entry->options;
+    settings.bitrateKbps = row.bitrateKbps;
+    row.output = BuildOutputPath(row.input, spec.outDir, spec.format, settings);
+
+    RenderLogFunc log;
+    if (spec.verbose)
+    {
+      log = [&outputMutex, &row](const std::string& msg) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::fprintf(stderr, "[%s %s] %s\n", row.input.c_str(), row.codecId.c_str(), msg.c_str());
+      };
+    }
+
+    std::string error;
+    std::shared_ptr<const AudioBuffer> buffer = stems.Acquire(stem, error);
+    if (buffer)
+    {
+      ProcessSlots slots(limiter, CodecProcessCount(settings) + outputProcesses);
+      row.result = RenderBuffer(settings, *buffer, row.output, log);
+      if (!row.result.ok)
+        std::remove(row.output.c_str());
+    }
+    else
+      row.result.error = error;
+    buffer.reset();
+    stems.Release(stem);
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    ++completed;
+    std::fprintf(stderr, "[%d/%d] %-4s %s %s", completed, numJobs, row.result.ok ? "ok" : "FAIL",
+                 BaseName(row.input).c_str(), row.codecId.c_str());
+    if (row.bitrateKbps > 0)
+      std::fprintf(stderr, " %d kbps", row.bitrateKbps);
+    if (row.result.ok)
+      std::fprintf(stderr, " (%.1fx realtime)\n", RealtimeFactor(row.result));
+    else
+      std::fprintf(stderr, ": %s\n", row.result.error.c_str());
+  };
+
+  // Contiguous slices per worker; stealing evens out codecs that run slower
+  {
+    WorkStealingPool pool(numWorkers);
+    for (int w = 0; w < numWorkers; ++w)
+    {
+      const int begin = static_cast<int>(static_cast<int64_t>(numJobs) * w / numWorkers);
+      const int end = static_cast<int>(static_cast<int64_t>(numJobs) * (w + 1) / numWorkers);
+      for (int index = begin; index < end; ++index)
+        pool.Submit(w, [&runJob, index] { runJob(index); });
+    }
+    pool.Wait();
+    summary.steals = pool.GetStealCount();
+  }
+
+  for (const SweepRow& row : summary.rows)
+  {
+    if (!row.result.ok)
+      ++summary.failures;
+    summary.renderSeconds += row.result.seconds;
+  }
+  summary.decodes = stems.GetDecodes();
+  summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  return summary;
+}
+
+//==============================================================================
+// Results
+//==============================================================================
+
+void PrintSweepTable(const SweepSummary& summary)
+{
+  size_t inputWidth = 5;
+  for (const SweepRow& row : summary.rows)
+    inputWidth = std::max(inputWidth, BaseName(row.input).size());
+
+  bool quality = false;
+  for (const SweepRow& row : summary.rows)
+    quality = quality || row.result.hasQuality;
+
+  std::printf("%-*s  %-14s %5s  %-6s %7s %7s %8s %7s", static_cast<int>(inputWidth), "INPUT", "CODEC", "KBPS",
+              "STATUS", "LATENCY", "PADDED", "SECONDS", "xRT");
+  if (quality)
+    std::printf(" %7s %7s %6s %6s", "SNR", "SEGSNR", "LSD", "dLUFS");
+  std::printf("\n");
+  for (const SweepRow& row : summary.rows)
+  {
+    const std::string kbps = row.bitrateKbps > 0 ? std::to_string(row.bitrateKbps) : "-";
+    std::printf("%-*s  %-14s %5s  ", static_cast<int>(inputWidth), BaseName(row.input).c_str(), row.codecId.c_str(),
+                kbps.c_str());
+    if (row.result.ok)
+    {
+      std::printf("%-6s %7d %7lld %8.2f %7.1f", "ok", row.result.latencyFrames,
+                  static_cast<long long>(row.result.paddedFrames), row.result.seconds, RealtimeFactor(row.result));
+      const QualityReport& q = row.result.quality;
+      if (row.result.hasQuality)
+        std::printf(" %7.1f %7.1f %6.2f %+6.2f", q.snrDb, q.segmentalSnrDb, q.lsdDb, q.lufsDelta);
+      std::printf("\n");
+    }
+    else
+      std::printf("%-6s %s\n", "FAIL", row.result.error.c_str());
+  }
+
+  const double speedup = summary.wallSeconds > 0.0 ? summary.renderSeconds / summary.wallSeconds : 0.0;
+  std::printf("\n%zu jobs, %d failed, %d input decodes, %llu steals; wall %.2f s, render %.2f s (%.1fx concurrency)\n",
+              summary.rows.size(), summary.failures, summary.decodes, static_cast<unsigned long long>(summary.steals),
+              summary.wallSeconds, summary.renderSeconds, speedup);
+}
+
+bool WriteSweepResults(const SweepSummary& summary, const std::string& path, std::string& error)
+{
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (!file)
+  {
+    error = "cannot create " + path;
+    return false;
+  }
+
+  const bool json = GetFileExtension(path) == "json";
+  if (json)
+    std::fprintf(file, "[\n");
+  else
+    std::fprintf(file, "input,codec,bitrate_kbps,status,output,sample_rate,channels,latency_frames,"
+                       "input_frames,padded_frames,render_seconds,realtime_factor,snr_db,seg_snr_db,lsd_db,"
+                       "reference_lufs,decoded_lufs,lufs_delta,error\n");
+
+  for (size_t i = 0; i < summary.rows.size(); ++i)
+  {
+    const SweepRow& row = summary.rows[i];
+    const RenderResult& r = row.result;
+    const QualityReport& q = r.quality;
+    if (json)
+    {
+      std::fprintf(file,
+                   "  {\"input\": %s, \"codec\": %s, \"bitrate_kbps\": %d, \"status\": \"%s\", \"output\": %s, "
+                   "\"sample_rate\": %d, \"channels\": %d, \"latency_frames\": %d, \"input_frames\": %lld, "
+                   "\"padded_frames\": %lld, \"render_seconds\": %.3f, \"realtime_factor\": %.2f, ",
+                   JsonString(row.input).c_str(), JsonString(row.codecId).c_str(), row.bitrateKbps,
+                   r.ok ? "ok" : "failed", JsonString(r.ok ? row.output : std::string()).c_str(), r.sampleRate,
+                   r.channels, r.latencyFrames, static_cast<long long>(r.inputFrames),
+                   static_cast<long long>(r.paddedFrames), r.seconds, RealtimeFactor(r));
+      if (r.hasQuality)
+      {
+        std::fprintf(file,
+                     "\"quality\": {\"snr_db\": %.3f, \"seg_snr_db\": %.3f, \"lsd_db\": %.4f, "
+                     "\"reference_lufs\": %.2f, \"decoded_lufs\": %.2f, \"lufs_delta\": %.3f, \"bands\": [",
+                     q.snrDb, q.segmentalSnrDb, q.lsdDb, q.referenceLufs, q.decodedLufs, q.lufsDelta);
+        for (size_t b = 0; b < q.bands.size(); ++b)
+        {
+          std::fprintf(file, "%s{\"low_hz\": %.1f, \"high_hz\": %.1f, \"signal_db\": %.2f, \"noise_db\": %.2f}",
+                       b > 0 ? ", " : "", q.bands[b].lowHz, q.bands[b].highHz, q.bands[b].signalDb, q.bands[b].noiseDb);
+        }
+        std::fprintf(file, "]}, ");
+      }
+      std::fprintf(file, "\"error\": %s}%s\n", JsonString(r.error).c_str(), i + 1 < summary.rows.size() ? "," : "");
+    }
+    else
+    {
+      std::fprintf(file, "%s,%s,%d,%s,%s,%d,%d,%d,%lld,%lld,%.3f,%.2f,", CsvField(row.input).c_str(),
+                   CsvField(row.codecId).c_str(), row.bitrateKbps, r.ok ? "ok" : "failed",
+                   CsvField(r.ok ? row.output : std::string()).c_str(), r.sampleRate, r.channels, r.latencyFrames,
+                   static_cast<long long>(r.inputFrames), static_cast<long long>(r.paddedFrames), r.seconds,
+                   RealtimeFactor(r));
+      if (r.hasQuality)
+        std::fprintf(file, "%.3f,%.3f,%.4f,%.2f,%.2f,%.3f,", q.snrDb, q.segmentalSnrDb, q.lsdDb, q.referenceLufs,
+                     q.decodedLufs, q.lufsDelta);
+      else
+        std::fprintf(file, ",,,,,,");
+      std::fprintf(file, "%s\n", CsvField(r.error).c_str());
+    }
+  }
+  if (json)
+    std::fprintf(file, "]\n");
+
+  const bool ok = std::fclose(file) == 0;
+  if (!ok)
+    error = "write error on " + path;
+  return ok;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+//==============================================================================
+// SweepRunner.h
+// Codec x bitrate matrix sweep over a set of stems
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "BatchRenderer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//==============================================================================
+// SweepCodec - one row of the matrix: a codec, its options and the bitrates
+// to render it at (a single 0 entry for lossless codecs)
+//==============================================================================
+struct SweepCodec
+{
+  const CodecInfo* codec = nullptr;
+  CodecOptionValues options;
+  std::vector<int> bitrates;        // kbps
+};
+
+/**
+ * Expand the command-line matrix spec against the available codecs
+ * @param codecsSpec "all" (CodecRegistry::GetAvailable()) or comma-separated ids
+ * @param bitratesSpec "ladder" (GetBitrateLadder), "presets" (kBitratePresets
+ *        inside each codec's range) or comma-separated kbps values; values a
+ *        codec cannot take are dropped for that codec
+ * @return false with 'error' set on an unknown/unavailable codec or an empty matrix
+ */
+bool ParseSweepMatrix(const std::string& codecsSpec, const std::string& bitratesSpec,
+                      std::vector<SweepCodec>& matrix, std::string& error);
+
+//==============================================================================
+// SweepSpec
+//==============================================================================
+struct SweepSpec
+{
+  std::vector<std::string> inputs;
+  std::vector<SweepCodec> matrix;
+  RenderSettings base;              // Rate/channels/latency/ffmpeg shared by every job
+  std::string outDir;
+  std::string format = "wav";
+  int workers = 0;                  // 0 = CPU cores
+  int maxProcesses = 0;             // Concurrent ffmpeg processes (0 = bounded only by workers)
+  bool verbose = false;
+};
+
+//==============================================================================
+// SweepRow - one rendered (or failed) job, in matrix order
+//==============================================================================
+struct SweepRow
+{
+  std::string input;
+  std::string codecId;
+  int bitrateKbps = 0;              // 0 for lossless codecs
+  std::string output;
+  RenderResult result;
+};
+
+struct SweepSummary
+{
+  std::vector<SweepRow> rows;
+  int failures = 0;
+  int decodes = 0;                  // Input decodes (one per stem unless it was reloaded)
+  uint64_t steals = 0;              // Jobs rebalanced between workers
+  double wallSeconds = 0.0;
+  double renderSeconds = 0.0;       // Sum of per-job render times
+};
+
+/**
+ * Run every stem x codec x bitrate job. Each stem is decoded once and shared
+ * by all of its jobs; its buffer is freed after its last job finishes.
+ * Progress lines go to stderr as jobs complete.
+ */
+SweepSummary RunSweep(const SweepSpec& spec);
+
+// Fixed-width table on stdout plus a wall-time / throughput footer
+void PrintSweepTable(const SweepSummary& summary);
+
+// Machine-readable results: .json writes an array of objects, anything else CSV
+bool WriteSweepResults(const SweepSummary& summary, const std::string& path, std::string& error);
+
+// Result file helpers: a CSV field (quoted when needed) and a quoted JSON string
+std::string CsvField(const std::string& value);
+std::string JsonString(const std::string& value);
@@ -0,0 +1,120 @@
+//==============================================================================
+// WorkStealingPool.cpp
+// Fixed-size thread pool with per-worker deques and work stealing
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int numWorkers)
+{
+  numWorkers = std::max(1, numWorkers);
+  for (int i = 0; i < numWorkers; ++i)
+    mQueues.push_back(std::make_unique<Queue>());
+  for (int i = 0; i < numWorkers; ++i)
+    mThreads.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    mStopping = true;
+  }
+  mWorkCv.notify_all();
+  for (auto& t : mThreads)
+    t.join();
+}
+
+void WorkStealingPool::Submit(int worker, Task task)
+{
+  Queue& queue = *mQueues[static_cast<size_t>(worker) % mQueues.size()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    ++mQueued;
+    ++mPending;
+  }
+  mWorkCv.notify_all();
+}
+
+void WorkStealingPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mStateMutex);
+  mIdleCv.wait(lock, [this] { return mPending == 0; });
+}
+
+bool WorkStealingPool::PopOwn(int index, Task& task)
+{
+  Queue& queue = *mQueues[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+  task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  return true;
+}
+
+bool WorkStealingPool::Steal(int thief, Task& task)
+{
+  // Victim = the deque with the most work left, so stealing evens out long tails
+  const int numQueues = GetNumWorkers();
+  int victim = -1;
+  size_t most = 0;
+  for (int offset = 1; offset < numQueues; ++offset)
+  {
+    const int i = (thief + offset) % numQueues;
+    std::lock_guard<std::mutex> lock(mQueues[i]->mutex);
+    if (mQueues[i]->tasks.size() > most)
+    {
+      most = mQueues[i]->tasks.size();
+      victim = i;
+    }
+  }
+  if (victim < 0)
+    return false;
+
+  Queue& queue = *mQueues[victim];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;  // Drained between the scan and now; caller rescans
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  ++mSteals;
+  return true;
+}
+
+void WorkStealingPool::WorkerLoop(int index)
+{
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mStateMutex);
+      mWorkCv.wait(lock, [this] { return mStopping || mQueued > 0; });
+      if (mQueued == 0)
+        return;  // Stopping with nothing left
+    }
+
+    Task task;
+    if (!PopOwn(index, task) && !Steal(index, task))
+      continue;
+
+    {
+      std::lock_guard<std::mutex> lock(mStateMutex);
+      --mQueued;
+    }
+    task();
+
+    bool idle;
+    {
+      std::lock_guard<std::mutex> lock(mStateMutex);
+      idle = (--mPending == 0);
+    }
+    if (idle)
+      mIdleCv.notify_all();
+  }
+}
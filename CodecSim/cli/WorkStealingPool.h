@@ -0,0 +1,76 @@
+#pragma once
+
+//==============================================================================
+// WorkStealingPool.h
+// Fixed-size thread pool with per-worker deques and work stealing
+// Copyright 2025 MouseSoft
+//==============================================================================
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//==============================================================================
+// WorkStealingPool
+// Each worker owns a deque and runs it front to back, so a worker keeps
+// working through the neighbouring jobs it was given (same stem, same
+// decoded buffer). An idle worker steals from the back of the fullest other
+// deque, i.e. the work its owner would reach last. Tasks here are whole
+// renders (hundreds of ms and up), so a mutex per deque costs nothing
+// measurable and keeps the pool simple.
+//==============================================================================
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  explicit WorkStealingPool(int numWorkers);
+  ~WorkStealingPool();
+
+  // Non-copyable
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  /**
+   * Queue a task on one worker's deque. Submit consecutive related tasks to
+   * the same worker to keep them together; stealing rebalances the rest.
+   * @param worker Owning worker (taken modulo GetNumWorkers())
+   */
+  void Submit(int worker, Task task);
+
+  // Block until every submitted task has run
+  void Wait();
+
+  int GetNumWorkers() const { return static_cast<int>(mQueues.size()); }
+
+  // Tasks run by a worker other than the one they were submitted to
+  uint64_t GetStealCount() const { return mSteals.load(); }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(int index);
+  bool PopOwn(int index, Task& task);
+  bool Steal(int thief, Task& task);
+
+  std::vector<std::unique_ptr<Queue>> mQueues;
+  std::vector<std::thread> mThreads;
+
+  std::mutex mStateMutex;
+  std::condition_variable mWorkCv;      // Tasks queued or shutting down
+  std::condition_variable mIdleCv;      // mPending reached zero
+  size_t mQueued = 0;                   // Tasks sitting in any deque (guarded by mStateMutex)
+  size_t mPending = 0;                  // Queued + running (guarded by mStateMutex)
+  bool mStopping = false;
+
+  std::atomic<uint64_t> mSteals{0};
+};